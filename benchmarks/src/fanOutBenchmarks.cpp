@@ -0,0 +1,84 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "constants/mediaFrame.h"
+#include "constants/packetType.h"
+#include "logic/meetingFrame.h"
+#include "serverProbes.h"
+#include "wireFixtures.h"
+
+using core::logic::MediaFrameKind;
+using server::constant::PacketType;
+
+namespace
+{
+    // One sender in a meeting of range(0) participants; every iteration routes one packet through
+    // handleReceiveUdp, processMediaJob and NetworkController::sendUdp into the receivers' send
+    // queues, which are emptied again without sending. Frames are v1, built by the client code.
+    server::bench::ServerProbe& probe()
+    {
+        static server::bench::ServerProbe instance;
+        return instance;
+    }
+
+    std::vector<unsigned char> frameFor(MediaFrameKind kind, uint8_t layerByte, bool keyframe, std::size_t payloadSize)
+    {
+        return core::logic::buildMeetingFrame(0, probe().getMeetingId(), probe().getSenderHash(), kind,
+            layerByte, keyframe, 1, 0, bench::makePayload(payloadSize));
+    }
+
+    void runFanOut(benchmark::State& state, const std::vector<std::vector<unsigned char>>& frames, PacketType type)
+    {
+        std::size_t receivers = 0;
+        std::size_t next = 0;
+        for (auto _ : state) {
+            const auto& frame = frames[next];
+            next = next + 1 == frames.size() ? 0 : next + 1;
+            receivers += probe().route(frame.data(), frame.size(), type);
+        }
+        state.counters["receivers"] = benchmark::Counter(static_cast<double>(receivers), benchmark::Counter::kAvgIterations);
+    }
+
+    void BM_FanOutVoice(benchmark::State& state)
+    {
+        probe().createMeeting(static_cast<std::size_t>(state.range(0)));
+        // A loud, active speaker, so the speaker selector lets the voice through.
+        const uint8_t audioLevel = 20 | server::constant::kMeetingFrameVoiceActivityFlag;
+        const std::vector<std::vector<unsigned char>> frames{ frameFor(MediaFrameKind::Voice, audioLevel, false, bench::kVoicePayload) };
+        for (int i = 0; i < 10; ++i) {
+            probe().route(frames[0].data(), frames[0].size(), PacketType::VOICE);
+        }
+        runFanOut(state, frames, PacketType::VOICE);
+    }
+
+    void BM_FanOutCamera(benchmark::State& state)
+    {
+        probe().createMeeting(static_cast<std::size_t>(state.range(0)));
+        // Three simulcast layers per captured frame. A keyframe on each layer first, so every
+        // receiver is already on its layer and no keyframe requests go out while measuring.
+        const std::vector<std::size_t> layerSizes{ 1500, 4500, bench::kCameraPayload };
+        std::vector<std::vector<unsigned char>> frames;
+        for (uint8_t layer = 0; layer < layerSizes.size(); ++layer) {
+            const auto keyframe = frameFor(MediaFrameKind::Camera, layer, true, layerSizes[layer]);
+            probe().route(keyframe.data(), keyframe.size(), PacketType::CAMERA);
+            frames.push_back(frameFor(MediaFrameKind::Camera, layer, false, layerSizes[layer]));
+        }
+        runFanOut(state, frames, PacketType::CAMERA);
+    }
+
+    void BM_FanOutScreen(benchmark::State& state)
+    {
+        probe().createMeeting(static_cast<std::size_t>(state.range(0)));
+        // Screen forwarding to a receiver starts on a keyframe, so one goes out before measuring.
+        const auto keyframe = frameFor(MediaFrameKind::Screen, 0, true, bench::kCameraPayload);
+        probe().route(keyframe.data(), keyframe.size(), PacketType::SCREEN);
+        const std::vector<std::vector<unsigned char>> frames{ frameFor(MediaFrameKind::Screen, 0, false, bench::kCameraPayload) };
+        runFanOut(state, frames, PacketType::SCREEN);
+    }
+}
+
+BENCHMARK(BM_FanOutVoice)->ArgName("participants")->Arg(2)->Arg(5)->Arg(10)->Arg(25)->Arg(50)->MinWarmUpTime(0.2);
+BENCHMARK(BM_FanOutCamera)->ArgName("participants")->Arg(2)->Arg(5)->Arg(10)->Arg(25)->Arg(50)->MinWarmUpTime(0.2);
+BENCHMARK(BM_FanOutScreen)->ArgName("participants")->Arg(2)->Arg(5)->Arg(10)->Arg(25)->Arg(50)->MinWarmUpTime(0.2);
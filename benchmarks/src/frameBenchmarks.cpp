@@ -0,0 +1,80 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "logic/mediaFrameMeta.h"
+#include "logic/meetingFrame.h"
+#include "utilities/crypto.h"
+#include "wireFixtures.h"
+
+using core::logic::MediaFrameKind;
+
+namespace
+{
+    // Range 0 of the frame benchmarks picks the wire format: 1 for v1, 2 for v2.
+    constexpr uint32_t kBenchSessionId = 0x00C0FFEE;
+
+    uint32_t sessionIdFor(const benchmark::State& state)
+    {
+        return state.range(0) == 2 ? kBenchSessionId : 0;
+    }
+
+    std::vector<unsigned char> makeCameraFrame(uint32_t sessionId, std::size_t payloadSize)
+    {
+        const std::string meetingId = server::utilities::crypto::generateUID();
+        const std::string senderHash = server::utilities::crypto::calculateHash("bench-sender");
+        return core::logic::buildMeetingFrame(sessionId, meetingId, senderHash, MediaFrameKind::Camera,
+            1, false, 42, 1000, bench::makePayload(payloadSize));
+    }
+
+    // Server side: routing fields only, read once per forwarded packet.
+    void BM_ParseMediaFrameMeta(benchmark::State& state)
+    {
+        const auto frame = makeCameraFrame(sessionIdFor(state), bench::kCameraPayload);
+
+        for (auto _ : state) {
+            auto meta = server::logic::parseMediaFrameMeta(frame.data(), static_cast<int>(frame.size()));
+            benchmark::DoNotOptimize(meta);
+        }
+    }
+
+    // Client side: the full header, read for every received frame before decryption.
+    void BM_ParseMeetingFrame(benchmark::State& state)
+    {
+        const auto frame = makeCameraFrame(sessionIdFor(state), bench::kCameraPayload);
+
+        for (auto _ : state) {
+            auto parsed = core::logic::parseMeetingFrame(frame.data(), static_cast<int>(frame.size()));
+            benchmark::DoNotOptimize(parsed);
+        }
+    }
+
+    // Client side: framing of an encrypted payload (MediaService::buildMeetingFrame), which
+    // copies the payload once. Range 1 is the payload size.
+    void BM_BuildMeetingFrame(benchmark::State& state)
+    {
+        const uint32_t sessionId = sessionIdFor(state);
+        const std::string meetingId = server::utilities::crypto::generateUID();
+        const std::string senderHash = server::utilities::crypto::calculateHash("bench-sender");
+        const auto payload = bench::makePayload(static_cast<std::size_t>(state.range(1)));
+
+        uint32_t frameSeq = 0;
+        for (auto _ : state) {
+            ++frameSeq;
+            auto framed = core::logic::buildMeetingFrame(sessionId, meetingId, senderHash, MediaFrameKind::Camera,
+                2, false, frameSeq, frameSeq * 33, payload);
+            benchmark::DoNotOptimize(framed.data());
+        }
+
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * payload.size()));
+    }
+}
+
+BENCHMARK(BM_ParseMediaFrameMeta)->ArgName("version")->Arg(1)->Arg(2);
+BENCHMARK(BM_ParseMeetingFrame)->ArgName("version")->Arg(1)->Arg(2);
+BENCHMARK(BM_BuildMeetingFrame)
+    ->ArgNames({ "version", "bytes" })
+    ->ArgsProduct({ { 1, 2 }, { bench::kVoicePayload, bench::kCameraPayload } })
+    ->MinWarmUpTime(0.2);
@@ -0,0 +1,20 @@
+#include <benchmark/benchmark.h>
+
+#include <filesystem>
+
+#include "utilities/logger.h"
+
+int main(int argc, char** argv)
+{
+    // The server sources log to logs/server.log; only warnings and up, so logging stays off the measured paths.
+    std::filesystem::create_directories("logs");
+    server::utilities::log::set_level(spdlog::level::warn);
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
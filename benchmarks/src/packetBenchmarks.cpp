@@ -0,0 +1,69 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "constants/packetType.h"
+#include "network/packet.h"
+#include "network/udp/packetReceiver.h"
+#include "network/udp/packetSender.h"
+#include "wireFixtures.h"
+
+using server::constant::PacketType;
+
+namespace
+{
+    // One packet per iteration, chunk by chunk through the receiver's reassembly, the completed
+    // packet assembled and handed on as the processing thread would.
+    void BM_PacketReceiverReassembly(benchmark::State& state)
+    {
+        const auto payload = bench::makePayload(static_cast<std::size_t>(state.range(0)));
+        std::array<unsigned char, 32> senderHash{};
+        senderHash.fill(0x5A);
+        auto chunks = bench::makeClientChunks(senderHash, 1, static_cast<uint32_t>(PacketType::CAMERA), payload);
+        const asio::ip::udp::endpoint endpoint(asio::ip::make_address_v4("127.0.0.1"), 40000);
+
+        server::network::udp::PacketReceiver receiver;
+
+        uint64_t packetId = 1;
+        std::size_t reassembled = 0;
+        for (auto _ : state) {
+            ++packetId;
+            for (auto& chunk : chunks) {
+                bench::setPacketId(chunk, packetId);
+                receiver.processDatagram(chunk.data(), chunk.size(), endpoint);
+            }
+            reassembled += receiver.processPending();
+        }
+
+        if (reassembled != static_cast<std::size_t>(state.iterations())) {
+            state.SkipWithError("packets were not reassembled");
+        }
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * payload.size()));
+        state.counters["chunks"] = static_cast<double>(chunks.size());
+    }
+
+    // Chunking of one server-built payload into wire-ready datagrams (PacketSender::splitPacket).
+    void BM_PacketSenderSplit(benchmark::State& state)
+    {
+        const auto payload = bench::makePayload(static_cast<std::size_t>(state.range(0)));
+
+        uint64_t packetId = 1;
+        for (auto _ : state) {
+            auto datagrams = server::network::udp::PacketSender::splitPayload(
+                packetId++, static_cast<uint32_t>(PacketType::CAMERA), payload.data(), payload.size());
+            benchmark::DoNotOptimize(datagrams.data());
+        }
+
+        state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * payload.size()));
+    }
+}
+
+BENCHMARK(BM_PacketReceiverReassembly)
+    ->Arg(bench::kVoicePayload)->Arg(bench::kCameraPayload)->Arg(bench::kScreenPayload)
+    ->MinWarmUpTime(0.2);
+
+BENCHMARK(BM_PacketSenderSplit)
+    ->Arg(bench::kVoicePayload)->Arg(bench::kCameraPayload)->Arg(bench::kScreenPayload)
+    ->MinWarmUpTime(0.2);
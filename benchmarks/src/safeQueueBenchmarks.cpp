@@ -0,0 +1,44 @@
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+
+#include "utilities/safeQueue.h"
+
+namespace
+{
+    // Same bound the TCP control queues use.
+    constexpr std::size_t kQueueLimit = 1024;
+
+    server::utilities::SafeQueue<uint64_t> g_queue;
+
+    // Even threads push the way connections feed the control queues, odd threads pop. Pops do
+    // not wait, so a consumer that outruns its producer only spins on the lock; every thread
+    // counts the items it actually moved.
+    void BM_SafeQueueContended(benchmark::State& state)
+    {
+        if (state.thread_index() == 0) {
+            g_queue.clear();
+        }
+        const bool producer = state.thread_index() % 2 == 0;
+
+        int64_t moved = 0;
+        uint64_t value = 0;
+        for (auto _ : state) {
+            if (producer) {
+                g_queue.push_with_limit(++value, kQueueLimit);
+                ++moved;
+            }
+            else if (auto item = g_queue.try_pop()) {
+                benchmark::DoNotOptimize(*item);
+                ++moved;
+            }
+        }
+
+        state.SetItemsProcessed(moved);
+        if (state.thread_index() == 0) {
+            g_queue.clear();
+        }
+    }
+}
+
+BENCHMARK(BM_SafeQueueContended)->ThreadRange(2, 8)->UseRealTime()->MinWarmUpTime(0.2);
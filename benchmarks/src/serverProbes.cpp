@@ -0,0 +1,94 @@
+#include "serverProbes.h"
+
+#include "models/meeting.h"
+#include "utilities/crypto.h"
+
+namespace server::bench
+{
+    namespace
+    {
+        ServerConfig probeConfig()
+        {
+            ServerConfig config;
+            config.tcpPort = "0";
+            config.udpPort = "0";
+            // Reassembled packets are what handleReceiveUdp gets; the retransmission cache stays on,
+            // since forward() stores into it for every video packet.
+            config.udpCutThrough = false;
+            config.udpSegmentationOffload = false;
+            config.metricsPort = "0";
+            config.udpHoldSending = true;
+            return config;
+        }
+    }
+
+    ServerProbe::ServerProbe()
+        : m_userRepository(std::make_shared<logic::UserRepository>())
+        , m_meetingManager(std::make_shared<logic::MeetingManager>())
+        , m_server(std::make_unique<Server>(probeConfig(), m_userRepository, m_meetingManager))
+    {
+    }
+
+    ServerProbe::~ServerProbe()
+    {
+        removeMeeting();
+        m_server->discardQueuedUdpSends();
+    }
+
+    void ServerProbe::createMeeting(std::size_t participantCount)
+    {
+        removeMeeting();
+
+        // Fresh names per meeting: a stale snapshot entry must never match a new participant.
+        const std::string prefix = "bench-" + std::to_string(++m_meetingCount) + "-";
+        m_meetingId = utilities::crypto::generateUID();
+
+        for (std::size_t i = 0; i < participantCount; ++i) {
+            const std::string nicknameHash = utilities::crypto::calculateHash(prefix + std::to_string(i));
+            const asio::ip::udp::endpoint endpoint(asio::ip::make_address_v4("127.0.0.1"), static_cast<unsigned short>(40000 + i));
+            auto user = std::make_shared<User>(nicknameHash, utilities::crypto::generateUID(), CryptoPP::RSA::PublicKey{}, endpoint, []() {});
+            m_userRepository->addUser(user);
+            m_participants.push_back(Participant{ user, endpoint });
+        }
+
+        const UserPtr& owner = m_participants.front().user;
+        m_meeting = m_meetingManager->createMeeting(m_meetingId, utilities::crypto::calculateHash(m_meetingId), owner);
+        for (const auto& participant : m_participants) {
+            participant.user->setMeeting(m_meeting);
+            m_meeting->addParticipant(participant.user, std::string());
+            m_meeting->addCameraSharer(participant.user->getNicknameHash());
+        }
+    }
+
+    const std::string& ServerProbe::getMeetingId() const
+    {
+        return m_meetingId;
+    }
+
+    const std::string& ServerProbe::getSenderHash() const
+    {
+        return m_participants.front().user->getNicknameHash();
+    }
+
+    std::size_t ServerProbe::route(const unsigned char* data, std::size_t size, constant::PacketType type)
+    {
+        const Participant& sender = m_participants.front();
+        m_server->handleReceiveUdp(data, static_cast<int>(size), static_cast<uint32_t>(type), sender.endpoint,
+            sender.user->getNicknameHashBinary());
+        m_server->runPendingMediaJobs();
+        return m_server->discardQueuedUdpSends();
+    }
+
+    void ServerProbe::removeMeeting()
+    {
+        if (m_meeting) {
+            m_meetingManager->endMeeting(m_meeting);
+        }
+        for (const auto& participant : m_participants) {
+            participant.user->resetMeeting();
+            m_userRepository->removeUser(participant.user->getNicknameHash());
+        }
+        m_participants.clear();
+        m_meeting.reset();
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "server.h"
+#include "logic/userRepository.h"
+#include "logic/meetingManager.h"
+
+namespace server::bench
+{
+    // A Server whose sockets are bound to ephemeral ports, whose media workers are never started
+    // and whose UDP sending is held, holding one meeting built straight into the repositories it
+    // was given. route() is handleReceiveUdp, then the queued media job on the calling thread,
+    // through NetworkController::sendUdp into the send queues, which it empties again.
+    class ServerProbe {
+    public:
+        ServerProbe();
+        ~ServerProbe();
+
+        // Replaces the meeting with one of participantCount users; participant 0 is the sender
+        // and every participant shares its camera.
+        void createMeeting(std::size_t participantCount);
+
+        const std::string& getMeetingId() const;
+        const std::string& getSenderHash() const;
+
+        // Returns how many receivers the packet was queued to.
+        std::size_t route(const unsigned char* data, std::size_t size, constant::PacketType type);
+
+    private:
+        struct Participant {
+            UserPtr user;
+            asio::ip::udp::endpoint endpoint;
+        };
+
+        void removeMeeting();
+
+        std::shared_ptr<logic::UserRepository> m_userRepository;
+        std::shared_ptr<logic::MeetingManager> m_meetingManager;
+        std::unique_ptr<Server> m_server;
+        MeetingPtr m_meeting;
+        std::string m_meetingId;
+        std::vector<Participant> m_participants;
+        uint64_t m_meetingCount = 0;
+    };
+}
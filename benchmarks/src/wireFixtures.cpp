@@ -0,0 +1,62 @@
+#include "wireFixtures.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace bench
+{
+    namespace
+    {
+        constexpr std::size_t kHeaderSize = 50;
+        constexpr std::size_t kPacketIdOffset = 32;
+        constexpr std::size_t kMaxChunkPayload = 1300;
+
+        unsigned char* writeBE(unsigned char* out, uint64_t value, std::size_t bytes)
+        {
+            for (std::size_t i = 0; i < bytes; ++i) {
+                out[i] = static_cast<unsigned char>(value >> (8 * (bytes - 1 - i)));
+            }
+            return out + bytes;
+        }
+    }
+
+    std::vector<unsigned char> makePayload(std::size_t size)
+    {
+        std::vector<unsigned char> payload(size);
+        uint32_t state = 0x9E3779B9u;
+        for (auto& byte : payload) {
+            state = state * 1664525u + 1013904223u;
+            byte = static_cast<unsigned char>(state >> 24);
+        }
+        return payload;
+    }
+
+    std::vector<std::vector<unsigned char>> makeClientChunks(const std::array<unsigned char, 32>& senderHash,
+        uint64_t packetId, uint32_t type, const std::vector<unsigned char>& payload)
+    {
+        const std::size_t totalChunks = std::max<std::size_t>(1, (payload.size() + kMaxChunkPayload - 1) / kMaxChunkPayload);
+        std::vector<std::vector<unsigned char>> chunks;
+        chunks.reserve(totalChunks);
+        for (std::size_t chunkIndex = 0; chunkIndex < totalChunks; ++chunkIndex) {
+            const std::size_t offset = chunkIndex * kMaxChunkPayload;
+            const std::size_t length = std::min(kMaxChunkPayload, payload.size() - offset);
+            std::vector<unsigned char> chunk(kHeaderSize + length);
+            unsigned char* out = chunk.data();
+            std::memcpy(out, senderHash.data(), senderHash.size());
+            out += senderHash.size();
+            out = writeBE(out, packetId, 8);
+            out = writeBE(out, chunkIndex, 2);
+            out = writeBE(out, totalChunks, 2);
+            out = writeBE(out, length, 2);
+            out = writeBE(out, type, 4);
+            std::memcpy(out, payload.data() + offset, length);
+            chunks.push_back(std::move(chunk));
+        }
+        return chunks;
+    }
+
+    void setPacketId(std::vector<unsigned char>& chunk, uint64_t packetId)
+    {
+        writeBE(chunk.data() + kPacketIdOffset, packetId, 8);
+    }
+}
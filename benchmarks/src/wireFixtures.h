@@ -0,0 +1,27 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace bench
+{
+    // Payload sizes the media benchmarks run at: an Opus voice frame, one full chunk,
+    // a 720p camera P-frame and a screen-share keyframe.
+    inline constexpr std::size_t kVoicePayload = 160;
+    inline constexpr std::size_t kChunkPayload = 1300;
+    inline constexpr std::size_t kCameraPayload = 12000;
+    inline constexpr std::size_t kScreenPayload = 100000;
+
+    // Deterministic filler, so every run feeds the same bytes.
+    std::vector<unsigned char> makePayload(std::size_t size);
+
+    // The v1 client chunks of one packet, as the client packet sender cuts them: 32-byte sender
+    // hash, packetId u64, chunkIndex u16, totalChunks u16, payloadLength u16, type u32, payload.
+    std::vector<std::vector<unsigned char>> makeClientChunks(const std::array<unsigned char, 32>& senderHash,
+        uint64_t packetId, uint32_t type, const std::vector<unsigned char>& payload);
+
+    // Rewrites the packet id of a chunk built by makeClientChunks in place.
+    void setPacketId(std::vector<unsigned char>& chunk, uint64_t packetId);
+}
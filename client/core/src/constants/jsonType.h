@@ -36,6 +36,14 @@ namespace core::constant
     static constexpr const char* NICKNAME = "nickname";
     static constexpr const char* IS_OWNER = "is_owner";
     static constexpr const char* MAX_LAYER = "max_layer";
+    static constexpr const char* LAST_N = "last_n";
+    static constexpr const char* PINNED_NICKNAME_HASHES = "pinned_nickname_hashes";
+    static constexpr const char* WIRE_VERSION = "wire_version";
+    static constexpr const char* SESSION_ID = "session_id";
+    static constexpr const char* MEETING_SESSIONS = "meeting_sessions";
+    static constexpr const char* COMPACT_MEDIA_FRAMES = "compact_media_frames";
+    static constexpr const char* MEDIA_KIND = "media_kind";
+    static constexpr const char* LAYER_ID = "layer_id";
     static constexpr const char* LOSS_PCT = "loss_pct";
     static constexpr const char* JITTER_MS = "jitter_ms";
     static constexpr const char* RTT_MS = "rtt_ms";
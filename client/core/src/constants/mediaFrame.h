@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace core::constant {
+
+// Meeting frame layer byte: the low bits carry the simulcast layer id, the top bit marks a frame
+// the decoder can start from (IDR). The server only switches a receiver to a new layer on such a frame.
+constexpr uint8_t kMeetingFrameKeyframeFlag = 0x80;
+constexpr uint8_t kMeetingFrameLayerMask = 0x7F;
+
+// Voice frames have no layers; the same byte carries the audio level instead: the low bits are
+// the level in -dBov (0 loudest, 127 silence) and the top bit is the local voice activity.
+// The server forwards only the loudest voices of a meeting based on it.
+constexpr uint8_t kMeetingFrameVoiceActivityFlag = 0x80;
+constexpr uint8_t kMeetingFrameAudioLevelMask = 0x7F;
+constexpr uint8_t kMeetingFrameSilentAudioLevel = 127;
+
+// Wire format v2, used once the server assigned a media session id at authorization. The chunk
+// header carries that id instead of the 32-byte nickname hash: marker, version, sessionId u32,
+// packetId u32, chunkIndex u16, totalChunks u16, payloadLength u16, type u16.
+constexpr uint8_t kWireVersion2 = 2;
+constexpr uint8_t kCompactChunkHeaderMarker = 0xC2;
+constexpr std::size_t kCompactChunkHeaderSize = 18;
+
+// v2 meeting frame: version, mediaKind, layer byte, reserved, senderSessionId u32, frameSeq u32,
+// timestampMs u32. Receivers map the session id to a participant with MEETING_SESSION_MAP. Sent only
+// while the server allows it (MEDIA_FRAME_FORMAT), i.e. while every receiver negotiated v2.
+constexpr uint8_t kMeetingFrameVersion1 = 1;
+constexpr uint8_t kMeetingFrameVersion2 = 2;
+constexpr std::size_t kCompactMeetingFrameHeaderSize = 16;
+
+}
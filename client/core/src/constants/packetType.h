@@ -63,6 +63,24 @@ namespace core::constant
         CONNECTION_DOWN_WITH_USER,
         CONNECTION_RESTORED_WITH_USER,
         USER_LOGOUT,
+
+        // media transport (UDP), only send
+        MEDIA_NACK,
+
+        // send and receive
+        MEDIA_KEYFRAME_REQUEST,
+
+        // only receive
+        MEETING_DOMINANT_SPEAKER,
+
+        // only send
+        MEETING_VIDEO_CONFIG,
+
+        // only receive
+        MEETING_SESSION_MAP,
+
+        // only receive
+        MEDIA_FRAME_FORMAT,
     };
 
     inline std::string packetTypeToString(PacketType type) {
@@ -118,6 +136,24 @@ namespace core::constant
             case PacketType::CONNECTION_RESTORED_WITH_USER: return "CONNECTION_RESTORED_WITH_USER";
             case PacketType::USER_LOGOUT: return "USER_LOGOUT";
 
+            // media transport (UDP), only send
+            case PacketType::MEDIA_NACK: return "MEDIA_NACK";
+
+            // send and receive
+            case PacketType::MEDIA_KEYFRAME_REQUEST: return "MEDIA_KEYFRAME_REQUEST";
+
+            // only receive
+            case PacketType::MEETING_DOMINANT_SPEAKER: return "MEETING_DOMINANT_SPEAKER";
+
+            // only send
+            case PacketType::MEETING_VIDEO_CONFIG: return "MEETING_VIDEO_CONFIG";
+
+            // only receive
+            case PacketType::MEETING_SESSION_MAP: return "MEETING_SESSION_MAP";
+
+            // only receive
+            case PacketType::MEDIA_FRAME_FORMAT: return "MEDIA_FRAME_FORMAT";
+
             default: return "UNKNOWN";
         }
     }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 
 namespace core::constant {
 
@@ -10,6 +11,10 @@ constexpr float kSpeakingRmsThreshold = 0.005f;
 // Number of consecutive low-RMS frames before switching to "not speaking" (~500-600 ms at typical callback rate).
 constexpr int kSpeakingSilenceFrames = 30;
 
+// A remote meeting speaker whose voice frames stopped arriving for this long is treated as silent.
+// The server only forwards the loudest voices, so a quiet one may simply stop coming.
+constexpr int kSpeakingFrameTimeoutMs = 600;
+
 // EMA coefficient: lower = more smoothing, higher = more responsive.
 // 0.15 gives ~100 ms half-life at 20 ms frame intervals, bridging natural speech micro-pauses.
 constexpr float kSpeakingRmsAlpha = 0.15f;
@@ -25,6 +30,15 @@ inline float computeRms(const float* data, int length) {
     return static_cast<float>(std::sqrt(sumSq / length));
 }
 
+// Audio level for the meeting frame header: -dBov of the buffer RMS, 0 (loudest) .. 127 (silence).
+inline uint8_t audioLevelFromRms(float rms) {
+    if (rms <= 0.f) return 127;
+    const float dbov = 20.f * std::log10(rms);
+    if (dbov >= 0.f) return 0;
+    if (dbov <= -127.f) return 127;
+    return static_cast<uint8_t>(std::lround(-dbov));
+}
+
 // Exponential moving average for RMS to avoid flickering on natural speech micro-pauses.
 inline float smoothRms(float previousSmoothed, float currentRms) {
     return kSpeakingRmsAlpha * currentRms + (1.f - kSpeakingRmsAlpha) * previousSmoothed;
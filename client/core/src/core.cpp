@@ -160,6 +160,12 @@ namespace core
             if (!m_stateManager->isAuthorized()) {
                 return core::constant::make_error_code(core::constant::ErrorCode::network_error);
             }
+            const uint32_t sessionId = m_stateManager->getMediaSessionId();
+            if (sessionId != 0) {
+                return m_networkController->sendUDP(data, type, sessionId)
+                    ? std::error_code{}
+                    : core::constant::make_error_code(core::constant::ErrorCode::network_error);
+            }
             auto hashOpt = core::utilities::crypto::hashToBinary(
                 core::utilities::crypto::calculateHash(m_stateManager->getMyNickname()));
             
@@ -476,6 +482,14 @@ namespace core
         return m_meetingService ? m_meetingService->declineJoinMeetingRequest(friendNickname) : make_error_code(ErrorCode::network_error);
     }
 
+    std::error_code Core::setMeetingVideoPins(const std::vector<std::string>& pinnedNicknames) {
+        return m_meetingService ? m_meetingService->setVideoPins(pinnedNicknames) : make_error_code(ErrorCode::network_error);
+    }
+
+    std::error_code Core::setMeetingLastN(std::size_t lastN) {
+        return m_meetingService ? m_meetingService->setLastN(lastN) : make_error_code(ErrorCode::network_error);
+    }
+
     std::error_code Core::endMeeting() {
         if (!m_meetingService) return make_error_code(ErrorCode::network_error);
         if (m_mediaService) {
@@ -96,6 +96,8 @@ namespace core
         std::error_code declineJoinMeetingRequest(const std::string& friendNickname);
         std::error_code endMeeting();
         std::error_code leaveMeeting();
+        std::error_code setMeetingVideoPins(const std::vector<std::string>& pinnedNicknames);
+        std::error_code setMeetingLastN(std::size_t lastN);
         std::error_code startScreenSharing(const media::Screen& target);
         std::error_code stopScreenSharing();
         std::error_code startCameraSharing(std::string deviceName);
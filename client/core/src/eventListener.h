@@ -56,6 +56,7 @@ namespace core
         virtual void onMeetingParticipantConnectionDown(const std::string& nickname) = 0;
         virtual void onMeetingParticipantConnectionRestored(const std::string& nickname) = 0;
         virtual void onMeetingParticipantSpeaking(const std::string& nickname, bool speaking) = 0;
+        virtual void onMeetingDominantSpeakerChanged(const std::string& nickname) = 0;
         virtual void onMeetingParticipantMuted(const std::string& nickname, bool muted) = 0;
         virtual void onMeetingRosterResynced(const std::vector<std::string>& participants) = 0;
 
@@ -178,6 +178,30 @@ namespace core::logic
         m_myToken.clear();
     }
 
+    uint32_t ClientStateManager::getMediaSessionId() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_mediaSessionId;
+    }
+
+    void ClientStateManager::setMediaSessionId(uint32_t sessionId)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_mediaSessionId = sessionId;
+    }
+
+    bool ClientStateManager::isCompactMediaFramesAllowed() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_compactMediaFramesAllowed;
+    }
+
+    void ClientStateManager::setCompactMediaFramesAllowed(bool value)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_compactMediaFramesAllowed = value;
+    }
+
     void ClientStateManager::setActiveCall(const std::string& nickname,
         const CryptoPP::RSA::PublicKey& publicKey, const CryptoPP::SecByteBlock& callKey)
     {
@@ -189,11 +213,13 @@ namespace core::logic
 
         m_outgoingCall = std::nullopt;
         m_activeCall.emplace(nickname, publicKey, callKey);
+        m_compactMediaFramesAllowed = false;
     }
 
     void ClientStateManager::resetActiveCall() {
         std::lock_guard<std::mutex> lock(m_mutex);
         m_activeCall = std::nullopt;
+        m_compactMediaFramesAllowed = false;
     }
 
     void ClientStateManager::resetOutgoingCall() {
@@ -271,6 +297,7 @@ namespace core::logic
     {
         std::lock_guard<std::mutex> lock(m_mutex);
         m_activeMeeting.emplace(meetingId, meetingKey);
+        m_compactMediaFramesAllowed = false;
     }
 
     void ClientStateManager::addMeetingParticipant(const core::User& user, bool isOwner)
@@ -302,10 +329,34 @@ namespace core::logic
         return out;
     }
 
+    void ClientStateManager::setMeetingParticipantSession(uint32_t sessionId, const std::string& nicknameHash)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (sessionId == 0) return;
+        m_meetingSessionToNicknameHash[sessionId] = nicknameHash;
+    }
+
+    void ClientStateManager::removeMeetingParticipantSession(const std::string& nicknameHash)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        std::erase_if(m_meetingSessionToNicknameHash, [&nicknameHash](const auto& entry) {
+            return entry.second == nicknameHash;
+        });
+    }
+
+    std::string ClientStateManager::getMeetingParticipantHashBySession(uint32_t sessionId) const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_meetingSessionToNicknameHash.find(sessionId);
+        return it != m_meetingSessionToNicknameHash.end() ? it->second : std::string();
+    }
+
     void ClientStateManager::resetActiveMeeting()
     {
         std::lock_guard<std::mutex> lock(m_mutex);
         m_activeMeeting = std::nullopt;
+        m_meetingSessionToNicknameHash.clear();
+        m_compactMediaFramesAllowed = false;
         m_viewingRemoteScreen = false;
         m_remoteCameraSenderHashes.clear();
     }
@@ -348,6 +399,8 @@ namespace core::logic
         std::lock_guard<std::mutex> lock(m_mutex);
         m_myNickname.clear();
         m_myToken.clear();
+        m_mediaSessionId = 0;
+        m_compactMediaFramesAllowed = false;
         m_incomingCalls.clear();
 
         if (m_outgoingCall.has_value()) {
@@ -367,6 +420,7 @@ namespace core::logic
         m_mediaState[media::MediaType::Audio] = media::MediaState::Stopped;
 
         m_activeMeeting = std::nullopt;
+        m_meetingSessionToNicknameHash.clear();
         if (m_outgoingJoinMeetingRequest.has_value()) {
             m_outgoingJoinMeetingRequest->stop();
         }
@@ -39,6 +39,13 @@ namespace core::logic
         const std::string& getMyToken() const;
         void setMyToken(const std::string& token);
         void resetMyToken();
+        // Assigned by the server when wire format v2 was negotiated; 0 means v1 framing.
+        uint32_t getMediaSessionId() const;
+        void setMediaSessionId(uint32_t sessionId);
+        // Whether the server allowed v2 meeting frames in the current call or meeting (MEDIA_FRAME_FORMAT).
+        // Cleared whenever a call or meeting starts or ends, so every one starts on v1 frames.
+        bool isCompactMediaFramesAllowed() const;
+        void setCompactMediaFramesAllowed(bool value);
 
         // ——— Media state ———
         const media::MediaState getMediaState(media::MediaType type) const;
@@ -103,6 +110,10 @@ namespace core::logic
         void addMeetingParticipant(const core::User& user, bool isOwner);
         void removeMeetingParticipant(const std::string& nickname);
         std::vector<std::string> getMeetingParticipantNicknames() const;
+        void setMeetingParticipantSession(uint32_t sessionId, const std::string& nicknameHash);
+        void removeMeetingParticipantSession(const std::string& nicknameHash);
+        // Nickname hash of the participant sending v2 frames with sessionId, empty when unknown.
+        std::string getMeetingParticipantHashBySession(uint32_t sessionId) const;
         void resetActiveMeeting();
 
         // ——— Outgoing join meeting request ———
@@ -139,12 +150,15 @@ namespace core::logic
         std::unordered_set<std::string> m_remoteCameraSenderHashes;
         std::string m_myNickname; 
         std::string m_myToken;
+        uint32_t m_mediaSessionId = 0;
+        bool m_compactMediaFramesAllowed = false;
 
         std::optional<core::Call> m_activeCall;
         std::optional<core::OutgoingCall> m_outgoingCall;
         std::unordered_map<std::string, core::IncomingCall> m_incomingCalls;
 
         std::optional<core::Meeting> m_activeMeeting;
+        std::unordered_map<uint32_t, std::string> m_meetingSessionToNicknameHash;
         std::optional<core::OutgoingJoinMeetingRequest> m_outgoingJoinMeetingRequest;
         std::unordered_map<std::string, core::IncomingJoinMeetingRequest> m_incomingMeetingJoinRequests;
     };
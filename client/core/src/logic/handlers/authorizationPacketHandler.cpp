@@ -36,6 +36,9 @@ namespace core::logic
 
             m_stateManager->setMyNickname(nickname);
             m_stateManager->setMyToken(token);
+            m_stateManager->setMediaSessionId(jsonObject.contains(SESSION_ID) && jsonObject[SESSION_ID].is_number_unsigned()
+                ? jsonObject[SESSION_ID].get<uint32_t>()
+                : 0);
             m_stateManager->setAuthorized(true);
 
             if (m_eventListener)
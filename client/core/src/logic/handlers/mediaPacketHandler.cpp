@@ -1,7 +1,9 @@
 #include "mediaPacketHandler.h"
+#include "logic/meetingFrame.h"
 #include "logic/clientStateManager.h"
 #include "constants/jsonType.h"
 #include "constants/speakingVad.h"
+#include "constants/mediaFrame.h"
 #include "media/mediaType.h"
 #include "utilities/crypto.h"
 
@@ -18,63 +20,24 @@ namespace core::logic
 {
     namespace
     {
-        struct MeetingFrame {
-            uint8_t version = 0;
-            std::string meetingId;
-            std::string senderHash;
-            uint8_t mediaKind = 0;
-            uint8_t layerId = 0;
-            uint32_t frameSeq = 0;
-            uint32_t timestampMs = 0;
-            const unsigned char* payload = nullptr;
-            int payloadLen = 0;
-        };
-
-        std::optional<MeetingFrame> parseMeetingFrame(const unsigned char* data, int length) {
-            if (length < 1 + 2) return std::nullopt;
-            const uint8_t version = data[0];
-            if (version != 1) return std::nullopt;
-
-            const size_t meetingLenOffset = 1;
-            const uint16_t meetingIdLen = (static_cast<uint16_t>(data[meetingLenOffset]) << 8)
-                | static_cast<uint16_t>(data[meetingLenOffset + 1]);
-            if (length < static_cast<int>(meetingLenOffset + 2 + meetingIdLen + 2)) return std::nullopt;
-            const size_t meetingIdOffset = meetingLenOffset + 2;
-            const std::string meetingId(reinterpret_cast<const char*>(data + meetingIdOffset), meetingIdLen);
-
-            const size_t senderLenOffset = meetingIdOffset + meetingIdLen;
-            const uint16_t senderHashLen = (static_cast<uint16_t>(data[senderLenOffset]) << 8)
-                | static_cast<uint16_t>(data[senderLenOffset + 1]);
-            const size_t senderOffset = senderLenOffset + 2;
-            if (length < static_cast<int>(senderOffset + senderHashLen + 1 + 1 + 4 + 4)) return std::nullopt;
-            const std::string senderHash(reinterpret_cast<const char*>(data + senderOffset), senderHashLen);
-
-            const size_t metaOffset = senderOffset + senderHashLen;
-            const uint8_t mediaKind = data[metaOffset];
-            const uint8_t layerId = data[metaOffset + 1];
-            const uint32_t frameSeq = (static_cast<uint32_t>(data[metaOffset + 2]) << 24)
-                | (static_cast<uint32_t>(data[metaOffset + 3]) << 16)
-                | (static_cast<uint32_t>(data[metaOffset + 4]) << 8)
-                | static_cast<uint32_t>(data[metaOffset + 5]);
-            const uint32_t timestampMs = (static_cast<uint32_t>(data[metaOffset + 6]) << 24)
-                | (static_cast<uint32_t>(data[metaOffset + 7]) << 16)
-                | (static_cast<uint32_t>(data[metaOffset + 8]) << 8)
-                | static_cast<uint32_t>(data[metaOffset + 9]);
-            const unsigned char* payload = data + metaOffset + 10;
-            const int payloadLen = length - static_cast<int>(metaOffset + 10);
-            MeetingFrame frame;
-            frame.version = version;
-            frame.meetingId = meetingId;
-            frame.senderHash = senderHash;
-            frame.mediaKind = mediaKind;
-            frame.layerId = layerId;
-            frame.frameSeq = frameSeq;
-            frame.timestampMs = timestampMs;
-            frame.payload = payload;
-            frame.payloadLen = payloadLen;
-            return frame;
+        // Nickname hash of the participant that sent a frame of the given meeting, empty when the
+        // frame belongs to another meeting or a v2 sender is not in the session map yet.
+        std::string meetingFrameSenderHash(
+            const std::shared_ptr<ClientStateManager>& stateManager,
+            const MeetingFrame& frame,
+            const core::Meeting& meeting)
+        {
+            if (frame.version == kMeetingFrameVersion2) {
+                return stateManager->getMeetingParticipantHashBySession(frame.senderSessionId);
+            }
+            if (frame.meetingId.empty() || frame.meetingId != meeting.getMeetingId()) {
+                return {};
+            }
+            return std::string(frame.senderHash);
         }
 
+        constexpr auto kKeyframeRequestInterval = std::chrono::milliseconds(500);
+
         uint32_t elapsedMs(const std::chrono::steady_clock::time_point& from, const std::chrono::steady_clock::time_point& to)
         {
             return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(to - from).count());
@@ -231,6 +194,7 @@ namespace core::logic
 
             const float rms = core::constant::computeRms(audioFrame.data(), static_cast<int>(audioFrame.size()));
             RemoteParticipantSpeakingState& state = m_remoteParticipantSpeakingState[nickname];
+            state.lastFrameAt = std::chrono::steady_clock::now();
             state.smoothedRms = core::constant::smoothRms(state.smoothedRms, rms);
 
             if (state.smoothedRms > core::constant::kSpeakingRmsThreshold) {
@@ -293,21 +257,35 @@ namespace core::logic
 
         const MeetingFrame& frame = *frameOpt;
         auto meetingOpt = m_stateManager->getActiveMeeting();
-        if (frame.meetingId.empty() || !meetingOpt || frame.meetingId != meetingOpt->get().getMeetingId()) return;
-        if (frame.mediaKind != 0) return;
+        if (!meetingOpt || frame.mediaKind != 0) return;
+        const std::string senderHash = meetingFrameSenderHash(m_stateManager, frame, meetingOpt->get());
+        if (senderHash.empty()) return;
+
+        if (m_eventListener) {
+            const auto now = std::chrono::steady_clock::now();
+            for (auto& [nickname, state] : m_remoteParticipantSpeakingState) {
+                if (state.speaking && now - state.lastFrameAt > std::chrono::milliseconds(core::constant::kSpeakingFrameTimeoutMs)) {
+                    state.speaking = false;
+                    state.silenceCount = core::constant::kSpeakingSilenceFrames;
+                    m_eventListener->onMeetingParticipantSpeaking(nickname, false);
+                }
+            }
+        }
 
         const auto& meetingKey = meetingOpt->get().getMeetingKey();
         if (meetingKey.empty()) return;
 
         auto decryptedData = m_mediaProcessingService->decryptData(frame.payload, frame.payloadLen, meetingKey);
         if (decryptedData.empty()) return;
-        updateMetricsFromFrame(makeStreamMetricsKey(frame.senderHash, "voice", frame.layerId), frame.frameSeq, frame.timestampMs, frame.payloadLen);
+        // Voice frames carry the audio level in the layer byte, and the server drops quiet voices,
+        // so neither the key nor sequence gaps can follow the video streams here.
+        updateMetricsFromFrame(makeStreamMetricsKey(senderHash, "voice", 0), frame.frameSeq, frame.timestampMs, frame.payloadLen, false);
         auto audioFrame = m_mediaProcessingService->decodeAudioFrame(decryptedData.data(), static_cast<int>(decryptedData.size()));
         if (!audioFrame.empty()) {
             m_audioEngine->playAudio(audioFrame.data(), static_cast<int>(audioFrame.size()));
         }
-        if (!frame.senderHash.empty() && m_eventListener) {
-            const std::string nickname = meetingParticipantNicknameByHash(m_stateManager, frame.senderHash);
+        if (m_eventListener) {
+            const std::string nickname = meetingParticipantNicknameByHash(m_stateManager, senderHash);
             if (!nickname.empty()) {
                 updateSpeakingState(nickname, audioFrame, false);
             }
@@ -323,6 +301,10 @@ namespace core::logic
 
         auto activeOpt = m_stateManager->getActiveCall();
         std::vector<unsigned char> decryptedData;
+        std::string senderHash;
+        uint8_t layerId = 0;
+        bool keyframe = false;
+        bool framesMissing = false;
         if (activeOpt) {
             auto frameOpt = parseMeetingFrame(data, length);
             const unsigned char* payload = data;
@@ -330,8 +312,10 @@ namespace core::logic
             if (frameOpt && frameOpt->mediaKind == 1) {
                 payload = frameOpt->payload;
                 payloadLen = frameOpt->payloadLen;
-                const std::string senderHash = core::utilities::crypto::calculateHash(activeOpt->get().getNickname());
-                updateMetricsFromFrame(makeCallMetricsKey(senderHash, "screen"), frameOpt->frameSeq, frameOpt->timestampMs, frameOpt->payloadLen);
+                senderHash = core::utilities::crypto::calculateHash(activeOpt->get().getNickname());
+                layerId = frameOpt->layerId;
+                keyframe = frameOpt->keyframe;
+                framesMissing = updateMetricsFromFrame(makeCallMetricsKey(senderHash, "screen"), frameOpt->frameSeq, frameOpt->timestampMs, frameOpt->payloadLen);
             }
             decryptedData = m_mediaProcessingService->decryptData(payload, payloadLen, activeOpt->get().getCallKey());
         } else {
@@ -340,18 +324,25 @@ namespace core::logic
             if (!frameOpt) return;
             const MeetingFrame& frame = *frameOpt;
             auto meetingOpt = m_stateManager->getActiveMeeting();
-            if (frame.meetingId.empty() || !meetingOpt || frame.meetingId != meetingOpt->get().getMeetingId()) return;
-            if (frame.mediaKind != 1) return;
+            if (!meetingOpt || frame.mediaKind != 1) return;
+            senderHash = meetingFrameSenderHash(m_stateManager, frame, meetingOpt->get());
+            if (senderHash.empty()) return;
             const auto& meetingKey = meetingOpt->get().getMeetingKey();
             if (meetingKey.empty()) return;
             decryptedData = m_mediaProcessingService->decryptData(frame.payload, frame.payloadLen, meetingKey);
-            updateMetricsFromFrame(makeStreamMetricsKey(frame.senderHash, "screen", frame.layerId), frame.frameSeq, frame.timestampMs, frame.payloadLen);
+            layerId = frame.layerId;
+            keyframe = frame.keyframe;
+            framesMissing = updateMetricsFromFrame(makeStreamMetricsKey(senderHash, "screen", frame.layerId), frame.frameSeq, frame.timestampMs, frame.payloadLen);
         }
         if (decryptedData.empty()) return;
         const auto videoFrame = m_mediaProcessingService->decodeVideoFrame(MediaType::Screen, decryptedData.data(), static_cast<int>(decryptedData.size()));
         if (!videoFrame.isEmpty() && m_eventListener) {
             m_eventListener->onIncomingScreen(videoFrame);
         }
+        // A keyframe repairs the loss by itself; anything else after a gap decodes against missing references.
+        if ((framesMissing && !keyframe) || videoFrame.isEmpty()) {
+            sendKeyframeRequest(senderHash, 1, layerId);
+        }
         sendRttPingIfNeeded();
         sendStatsIfNeeded();
     }
@@ -368,6 +359,9 @@ namespace core::logic
         std::vector<unsigned char> decryptedData;
         std::string senderNickname;
         std::string senderStreamKey;
+        uint8_t layerId = 0;
+        bool keyframe = false;
+        bool framesMissing = false;
         if (activeOpt) {
             auto frameOpt = parseMeetingFrame(data, length);
             const unsigned char* payload = data;
@@ -376,7 +370,9 @@ namespace core::logic
                 payload = frameOpt->payload;
                 payloadLen = frameOpt->payloadLen;
                 const std::string senderHash = core::utilities::crypto::calculateHash(activeOpt->get().getNickname());
-                updateMetricsFromFrame(makeCallMetricsKey(senderHash, "camera"), frameOpt->frameSeq, frameOpt->timestampMs, frameOpt->payloadLen);
+                layerId = frameOpt->layerId;
+                keyframe = frameOpt->keyframe;
+                framesMissing = updateMetricsFromFrame(makeCallMetricsKey(senderHash, "camera"), frameOpt->frameSeq, frameOpt->timestampMs, frameOpt->payloadLen);
             }
             decryptedData = m_mediaProcessingService->decryptData(payload, payloadLen, activeOpt->get().getCallKey());
             if (!decryptedData.empty()) {
@@ -397,15 +393,17 @@ namespace core::logic
             if (!frameOpt) return;
             const MeetingFrame& frame = *frameOpt;
             auto meetingOpt = m_stateManager->getActiveMeeting();
-            if (frame.meetingId.empty() || !meetingOpt || frame.meetingId != meetingOpt->get().getMeetingId()) return;
-            if (frame.mediaKind != 2) return;
+            if (!meetingOpt || frame.mediaKind != 2) return;
+            senderStreamKey = meetingFrameSenderHash(m_stateManager, frame, meetingOpt->get());
+            if (senderStreamKey.empty()) return;
             const auto& meetingKey = meetingOpt->get().getMeetingKey();
             if (meetingKey.empty()) return;
             decryptedData = m_mediaProcessingService->decryptData(frame.payload, frame.payloadLen, meetingKey);
             if (decryptedData.empty()) return;
-            senderNickname = meetingParticipantNicknameByHash(m_stateManager, frame.senderHash);
-            senderStreamKey = frame.senderHash;
-            updateMetricsFromFrame(makeStreamMetricsKey(frame.senderHash, "camera", frame.layerId), frame.frameSeq, frame.timestampMs, frame.payloadLen);
+            senderNickname = meetingParticipantNicknameByHash(m_stateManager, senderStreamKey);
+            layerId = frame.layerId;
+            keyframe = frame.keyframe;
+            framesMissing = updateMetricsFromFrame(makeStreamMetricsKey(senderStreamKey, "camera", frame.layerId), frame.frameSeq, frame.timestampMs, frame.payloadLen);
         }
         if (decryptedData.empty() || senderNickname.empty() || senderStreamKey.empty()) return;
         const auto videoFrame = m_mediaProcessingService->decodeVideoFrame(
@@ -416,6 +414,9 @@ namespace core::logic
         if (!videoFrame.isEmpty() && m_eventListener) {
             m_eventListener->onIncomingCamera(videoFrame, senderNickname);
         }
+        if ((framesMissing && !keyframe) || videoFrame.isEmpty()) {
+            sendKeyframeRequest(senderStreamKey, 2, layerId);
+        }
         sendRttPingIfNeeded();
         sendStatsIfNeeded();
     }
@@ -451,7 +452,8 @@ namespace core::logic
         m_pendingPings.erase(it);
     }
 
-    void MediaPacketHandler::updateMetricsFromFrame(const std::string& streamKey, uint32_t frameSeq, uint32_t timestampMs, int payloadLen)
+    bool MediaPacketHandler::updateMetricsFromFrame(const std::string& streamKey, uint32_t frameSeq, uint32_t timestampMs, int payloadLen,
+        bool countGapsAsLoss)
     {
         auto& metrics = m_streamMetrics[streamKey];
         const auto now = std::chrono::steady_clock::now();
@@ -462,27 +464,27 @@ namespace core::logic
             metrics.lastRemoteTsMs = timestampMs;
             metrics.lastArrival = now;
             metrics.hasTiming = true;
-            return;
+            return false;
         }
 
         // If stream was paused (layer switch/restart), re-baseline sequence to avoid fake loss spikes.
         if (elapsedMs(metrics.lastArrival, now) > 1500) {
+            const bool framesMissing = frameSeq != metrics.lastSeq + 1;
             metrics.lastSeq = frameSeq;
             metrics.lastRemoteTsMs = timestampMs;
             metrics.lastArrival = now;
             metrics.warmupFramesLeft = 10;
             metrics.hasTiming = true;
-            return;
+            return framesMissing;
         }
 
         metrics.received++;
         if (payloadLen > 0) {
             metrics.bytes += static_cast<uint64_t>(payloadLen);
         }
-        if (frameSeq > metrics.lastSeq + 1) {
-            if (metrics.warmupFramesLeft <= 0) {
-                metrics.lost += (frameSeq - metrics.lastSeq - 1);
-            }
+        const bool framesMissing = frameSeq > metrics.lastSeq + 1;
+        if (framesMissing && countGapsAsLoss && metrics.warmupFramesLeft <= 0) {
+            metrics.lost += (frameSeq - metrics.lastSeq - 1);
         }
         metrics.lastSeq = frameSeq;
         if (metrics.warmupFramesLeft > 0) {
@@ -498,6 +500,64 @@ namespace core::logic
         metrics.lastArrival = now;
         metrics.lastRemoteTsMs = timestampMs;
         metrics.hasTiming = true;
+        return framesMissing;
+    }
+
+    void MediaPacketHandler::handleKeyframeRequest(const nlohmann::json& jsonObject)
+    {
+        const int mediaKind = jsonObject.value(MEDIA_KIND, 0);
+        const int layerId = jsonObject.value(LAYER_ID, 0);
+        if (mediaKind == 1) {
+            m_mediaProcessingService->requestKeyframe(MediaType::Screen);
+        } else if (mediaKind == 2) {
+            using CameraLayer = media::MediaProcessingService::CameraLayer;
+            m_mediaProcessingService->requestCameraKeyframe(static_cast<CameraLayer>(std::clamp(layerId, 0, 2)));
+        }
+    }
+
+    void MediaPacketHandler::handleDominantSpeaker(const nlohmann::json& jsonObject)
+    {
+        if (!m_eventListener || !m_stateManager->isActiveMeeting() || !jsonObject.contains(SENDER_NICKNAME_HASH)) return;
+
+        const std::string speakerHash = jsonObject[SENDER_NICKNAME_HASH].get<std::string>();
+        std::string nickname = m_stateManager->getMyNickname();
+        if (core::utilities::crypto::calculateHash(nickname) != speakerHash) {
+            nickname = meetingParticipantNicknameByHash(m_stateManager, speakerHash);
+        }
+        if (nickname.empty()) return;
+
+        m_eventListener->onMeetingDominantSpeakerChanged(nickname);
+    }
+
+    void MediaPacketHandler::handleMediaFrameFormat(const nlohmann::json& jsonObject)
+    {
+        if (!m_stateManager->isActiveCall() && !m_stateManager->isActiveMeeting()) return;
+        if (!jsonObject.contains(COMPACT_MEDIA_FRAMES) || !jsonObject[COMPACT_MEDIA_FRAMES].is_boolean()) return;
+
+        m_stateManager->setCompactMediaFramesAllowed(jsonObject[COMPACT_MEDIA_FRAMES].get<bool>());
+    }
+
+    void MediaPacketHandler::sendKeyframeRequest(const std::string& senderHash, uint8_t mediaKind, uint8_t layerId)
+    {
+        if (!m_sendPacket || senderHash.empty()) {
+            return;
+        }
+        // The sender answers with one IDR per request; asking again before it can arrive only costs bandwidth.
+        const auto now = std::chrono::steady_clock::now();
+        auto& requestedAt = m_keyframeRequestedAt[senderHash + "|" + std::to_string(mediaKind) + "|L" + std::to_string(layerId)];
+        if (requestedAt.time_since_epoch().count() != 0 && now - requestedAt < kKeyframeRequestInterval) {
+            return;
+        }
+        requestedAt = now;
+
+        nlohmann::json request{
+            { SENDER_NICKNAME_HASH, core::utilities::crypto::calculateHash(m_stateManager->getMyNickname()) },
+            { RECEIVER_NICKNAME_HASH, senderHash },
+            { MEDIA_KIND, mediaKind },
+            { LAYER_ID, layerId }
+        };
+        const std::string payload = request.dump();
+        (void)m_sendPacket(std::vector<unsigned char>(payload.begin(), payload.end()), PacketType::MEDIA_KEYFRAME_REQUEST);
     }
 
     void MediaPacketHandler::sendRttPingIfNeeded()
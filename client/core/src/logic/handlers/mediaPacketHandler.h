@@ -23,6 +23,7 @@ namespace core::logic
         bool speaking = false;
         int silenceCount = 0;
         float smoothedRms = 0.f;
+        std::chrono::steady_clock::time_point lastFrameAt{};
     };
 
     struct NetworkStreamMetrics {
@@ -57,9 +58,16 @@ namespace core::logic
         void handleIncomingCamera(const unsigned char* data, int length);
         void handleAdaptCommand(const nlohmann::json& jsonObject);
         void handleRttPong(const nlohmann::json& jsonObject);
+        void handleKeyframeRequest(const nlohmann::json& jsonObject);
+        void handleDominantSpeaker(const nlohmann::json& jsonObject);
+        void handleMediaFrameFormat(const nlohmann::json& jsonObject);
 
     private:
-        void updateMetricsFromFrame(const std::string& streamKey, uint32_t frameSeq, uint32_t timestampMs, int payloadLen);
+        // Returns true when frames of the stream were skipped, i.e. the decoder lost its references.
+        // countGapsAsLoss is false for streams the server thins out on purpose.
+        bool updateMetricsFromFrame(const std::string& streamKey, uint32_t frameSeq, uint32_t timestampMs, int payloadLen,
+            bool countGapsAsLoss = true);
+        void sendKeyframeRequest(const std::string& senderHash, uint8_t mediaKind, uint8_t layerId);
         void sendStatsIfNeeded();
         void sendRttPingIfNeeded();
 
@@ -74,6 +82,7 @@ namespace core::logic
         std::chrono::steady_clock::time_point m_lastPingSentAt{};
         uint64_t m_nextPingId = 1;
         std::map<uint64_t, std::chrono::steady_clock::time_point> m_pendingPings;
+        std::map<std::string, std::chrono::steady_clock::time_point> m_keyframeRequestedAt;
         int m_lastRttMs = 0;
     };
 }
\ No newline at end of file
@@ -256,6 +256,7 @@ namespace core::logic
         if (!meetingOpt || !jsonObject.contains(NICKNAME_HASH)) return;
 
         const std::string nicknameHash = jsonObject[NICKNAME_HASH].get<std::string>();
+        m_stateManager->removeMeetingParticipantSession(nicknameHash);
         std::string nickname;
         for (const auto& participant : meetingOpt->get().getParticipants()) {
             const auto& candidateNickname = participant.getUser().getNickname();
@@ -317,4 +318,16 @@ namespace core::logic
             m_eventListener->onMeetingParticipantConnectionRestored(nickname);
         }
     }
+
+    void MeetingPacketHandler::handleMeetingSessionMap(const nlohmann::json& jsonObject) {
+        if (!m_stateManager->isAuthorized() || !m_stateManager->isActiveMeeting()) return;
+        if (!jsonObject.contains(MEETING_SESSIONS) || !jsonObject[MEETING_SESSIONS].is_array()) return;
+
+        for (const auto& entry : jsonObject[MEETING_SESSIONS]) {
+            if (!entry.contains(NICKNAME_HASH) || !entry.contains(SESSION_ID) || !entry[SESSION_ID].is_number_unsigned()) {
+                continue;
+            }
+            m_stateManager->setMeetingParticipantSession(entry[SESSION_ID].get<uint32_t>(), entry[NICKNAME_HASH].get<std::string>());
+        }
+    }
 }
@@ -34,6 +34,7 @@ namespace core::logic
         void handleMeetingParticipantLeft(const nlohmann::json& jsonObject);
         void handleMeetingParticipantConnectionDown(const nlohmann::json& jsonObject);
         void handleMeetingParticipantConnectionRestored(const nlohmann::json& jsonObject);
+        void handleMeetingSessionMap(const nlohmann::json& jsonObject);
 
     private:
         std::shared_ptr<ClientStateManager> m_stateManager;
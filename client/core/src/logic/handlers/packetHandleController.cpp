@@ -130,8 +130,12 @@ namespace core::logic
         });
         m_packetHandlers.emplace(PacketType::MEETING_PARTICIPANT_JOINED, [this](const nlohmann::json& json) { m_meetingPacketHandler->handleMeetingParticipantJoined(json); });
         m_packetHandlers.emplace(PacketType::MEETING_PARTICIPANT_LEFT, [this](const nlohmann::json& json) { m_meetingPacketHandler->handleMeetingParticipantLeft(json); });
+        m_packetHandlers.emplace(PacketType::MEETING_SESSION_MAP, [this](const nlohmann::json& json) { m_meetingPacketHandler->handleMeetingSessionMap(json); });
         m_packetHandlers.emplace(PacketType::MEDIA_ADAPT_COMMAND, [this](const nlohmann::json& json) { m_mediaPacketHandler->handleAdaptCommand(json); });
         m_packetHandlers.emplace(PacketType::MEDIA_RTT_PONG, [this](const nlohmann::json& json) { m_mediaPacketHandler->handleRttPong(json); });
+        m_packetHandlers.emplace(PacketType::MEDIA_KEYFRAME_REQUEST, [this](const nlohmann::json& json) { m_mediaPacketHandler->handleKeyframeRequest(json); });
+        m_packetHandlers.emplace(PacketType::MEETING_DOMINANT_SPEAKER, [this](const nlohmann::json& json) { m_mediaPacketHandler->handleDominantSpeaker(json); });
+        m_packetHandlers.emplace(PacketType::MEDIA_FRAME_FORMAT, [this](const nlohmann::json& json) { m_mediaPacketHandler->handleMediaFrameFormat(json); });
     }
 
     PacketHandleController::~PacketHandleController() = default;
@@ -38,6 +38,11 @@ namespace core::logic
         if (reconnected) {
             LOG_INFO("Connection restored successfully");
 
+            // The server keeps the session across reconnects; an older server sends none.
+            m_stateManager->setMediaSessionId(jsonObject.contains(SESSION_ID) && jsonObject[SESSION_ID].is_number_unsigned()
+                ? jsonObject[SESSION_ID].get<uint32_t>()
+                : 0);
+
             m_eventListener->onConnectionEstablished();
 
             bool activeCall = jsonObject[IS_ACTIVE_CALL].get<bool>();
@@ -0,0 +1,117 @@
+#include "meetingFrame.h"
+#include "constants/mediaFrame.h"
+
+#include <cstddef>
+
+using namespace core::constant;
+
+namespace core::logic
+{
+    namespace
+    {
+        uint32_t readU32BE(const unsigned char* data) {
+            return (static_cast<uint32_t>(data[0]) << 24)
+                | (static_cast<uint32_t>(data[1]) << 16)
+                | (static_cast<uint32_t>(data[2]) << 8)
+                | static_cast<uint32_t>(data[3]);
+        }
+
+        void appendU16BE(std::vector<unsigned char>& out, uint16_t value)
+        {
+            out.push_back(static_cast<unsigned char>((value >> 8) & 0xFF));
+            out.push_back(static_cast<unsigned char>(value & 0xFF));
+        }
+
+        void appendU32BE(std::vector<unsigned char>& out, uint32_t value)
+        {
+            out.push_back(static_cast<unsigned char>((value >> 24) & 0xFF));
+            out.push_back(static_cast<unsigned char>((value >> 16) & 0xFF));
+            out.push_back(static_cast<unsigned char>((value >> 8) & 0xFF));
+            out.push_back(static_cast<unsigned char>(value & 0xFF));
+        }
+    }
+
+    std::optional<MeetingFrame> parseMeetingFrame(const unsigned char* data, int length) {
+        if (length < 1 + 2) return std::nullopt;
+        MeetingFrame frame;
+        frame.version = data[0];
+
+        if (frame.version == kMeetingFrameVersion2) {
+            if (length < static_cast<int>(kCompactMeetingFrameHeaderSize)) return std::nullopt;
+            frame.mediaKind = data[1];
+            frame.layerId = data[2] & kMeetingFrameLayerMask;
+            frame.keyframe = (data[2] & kMeetingFrameKeyframeFlag) != 0;
+            frame.senderSessionId = readU32BE(data + 4);
+            frame.frameSeq = readU32BE(data + 8);
+            frame.timestampMs = readU32BE(data + 12);
+            frame.payload = data + kCompactMeetingFrameHeaderSize;
+            frame.payloadLen = length - static_cast<int>(kCompactMeetingFrameHeaderSize);
+            return frame;
+        }
+        if (frame.version != kMeetingFrameVersion1) return std::nullopt;
+
+        const size_t meetingLenOffset = 1;
+        const uint16_t meetingIdLen = (static_cast<uint16_t>(data[meetingLenOffset]) << 8)
+            | static_cast<uint16_t>(data[meetingLenOffset + 1]);
+        if (length < static_cast<int>(meetingLenOffset + 2 + meetingIdLen + 2)) return std::nullopt;
+        const size_t meetingIdOffset = meetingLenOffset + 2;
+        frame.meetingId = std::string_view(reinterpret_cast<const char*>(data + meetingIdOffset), meetingIdLen);
+
+        const size_t senderLenOffset = meetingIdOffset + meetingIdLen;
+        const uint16_t senderHashLen = (static_cast<uint16_t>(data[senderLenOffset]) << 8)
+            | static_cast<uint16_t>(data[senderLenOffset + 1]);
+        const size_t senderOffset = senderLenOffset + 2;
+        if (length < static_cast<int>(senderOffset + senderHashLen + 1 + 1 + 4 + 4)) return std::nullopt;
+        frame.senderHash = std::string_view(reinterpret_cast<const char*>(data + senderOffset), senderHashLen);
+
+        const size_t metaOffset = senderOffset + senderHashLen;
+        frame.mediaKind = data[metaOffset];
+        frame.layerId = data[metaOffset + 1] & kMeetingFrameLayerMask;
+        frame.keyframe = (data[metaOffset + 1] & kMeetingFrameKeyframeFlag) != 0;
+        frame.frameSeq = readU32BE(data + metaOffset + 2);
+        frame.timestampMs = readU32BE(data + metaOffset + 6);
+        frame.payload = data + metaOffset + 10;
+        frame.payloadLen = length - static_cast<int>(metaOffset + 10);
+        return frame;
+    }
+
+    std::vector<unsigned char> buildMeetingFrame(uint32_t sessionId,
+        const std::string& meetingId,
+        const std::string& senderHash,
+        MediaFrameKind kind,
+        uint8_t layerId,
+        bool keyframe,
+        uint32_t frameSeq,
+        uint32_t timestampMs,
+        const std::vector<unsigned char>& encryptedPayload)
+    {
+        std::vector<unsigned char> framed;
+        if (sessionId != 0) {
+            // v2: the server routes by the chunk header and receivers map the session id to the
+            // sender, so neither the meeting id nor the hex hash has to ride along.
+            framed.reserve(kCompactMeetingFrameHeaderSize + encryptedPayload.size());
+            framed.push_back(kMeetingFrameVersion2);
+            framed.push_back(static_cast<uint8_t>(kind));
+            framed.push_back(static_cast<uint8_t>((layerId & kMeetingFrameLayerMask) | (keyframe ? kMeetingFrameKeyframeFlag : 0)));
+            framed.push_back(0);
+            appendU32BE(framed, sessionId);
+            appendU32BE(framed, frameSeq);
+            appendU32BE(framed, timestampMs);
+            framed.insert(framed.end(), encryptedPayload.begin(), encryptedPayload.end());
+            return framed;
+        }
+
+        framed.reserve(1 + 2 + meetingId.size() + 2 + senderHash.size() + 1 + 1 + 4 + 4 + encryptedPayload.size());
+        framed.push_back(kMeetingFrameVersion1);
+        appendU16BE(framed, static_cast<uint16_t>(meetingId.size()));
+        framed.insert(framed.end(), meetingId.begin(), meetingId.end());
+        appendU16BE(framed, static_cast<uint16_t>(senderHash.size()));
+        framed.insert(framed.end(), senderHash.begin(), senderHash.end());
+        framed.push_back(static_cast<uint8_t>(kind));
+        framed.push_back(static_cast<uint8_t>((layerId & kMeetingFrameLayerMask) | (keyframe ? kMeetingFrameKeyframeFlag : 0)));
+        appendU32BE(framed, frameSeq);
+        appendU32BE(framed, timestampMs);
+        framed.insert(framed.end(), encryptedPayload.begin(), encryptedPayload.end());
+        return framed;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace core::logic
+{
+    enum class MediaFrameKind : uint8_t {
+        Voice = 0,
+        Screen = 1,
+        Camera = 2,
+    };
+
+    // Views into the datagram: parsing copies nothing, for v1 the ids are left in place.
+    struct MeetingFrame {
+        uint8_t version = 0;
+        std::string_view meetingId;
+        std::string_view senderHash;
+        uint32_t senderSessionId = 0;
+        uint8_t mediaKind = 0;
+        uint8_t layerId = 0;
+        bool keyframe = false;
+        uint32_t frameSeq = 0;
+        uint32_t timestampMs = 0;
+        const unsigned char* payload = nullptr;
+        int payloadLen = 0;
+    };
+
+    std::optional<MeetingFrame> parseMeetingFrame(const unsigned char* data, int length);
+
+    // A nonzero sessionId builds a v2 frame, which leaves out meetingId and senderHash.
+    // For voice, layerId and keyframe carry the audio level and voice activity.
+    std::vector<unsigned char> buildMeetingFrame(uint32_t sessionId,
+        const std::string& meetingId,
+        const std::string& senderHash,
+        MediaFrameKind kind,
+        uint8_t layerId,
+        bool keyframe,
+        uint32_t frameSeq,
+        uint32_t timestampMs,
+        const std::vector<unsigned char>& encryptedPayload);
+}
@@ -1,5 +1,6 @@
 #include "packetFactory.h"
 #include "constants/jsonType.h"
+#include "constants/mediaFrame.h"
 
 #include <nlohmann/json.hpp>
 
@@ -44,6 +45,7 @@ namespace core::logic
         jsonObject[PUBLIC_KEY] = serializePublicKey(myPublicKey);
         jsonObject[UDP_PORT] = myUdpPort;
         jsonObject[PACKET_KEY] = RSAEncryptAESKey(myPublicKey, packetKey);
+        jsonObject[WIRE_VERSION] = kWireVersion2;
 
         return toBytes(jsonObject.dump());
     }
@@ -253,4 +255,22 @@ namespace core::logic
     std::vector<unsigned char> PacketFactory::getMeetingEndPacket(const std::string& myNickname) {
         return createBasePacketBytes(myNickname);
     }
+
+    std::vector<unsigned char> PacketFactory::getMeetingVideoPinsPacket(const std::string& myNickname, const std::vector<std::string>& pinnedNicknames) {
+        std::string uid = generateUID();
+        nlohmann::json jsonObject = createBasePacket(uid, myNickname);
+        nlohmann::json pinnedHashes = nlohmann::json::array();
+        for (const auto& nickname : pinnedNicknames) {
+            pinnedHashes.push_back(calculateHash(nickname));
+        }
+        jsonObject[PINNED_NICKNAME_HASHES] = std::move(pinnedHashes);
+        return toBytes(jsonObject.dump());
+    }
+
+    std::vector<unsigned char> PacketFactory::getMeetingLastNPacket(const std::string& myNickname, std::size_t lastN) {
+        std::string uid = generateUID();
+        nlohmann::json jsonObject = createBasePacket(uid, myNickname);
+        jsonObject[LAST_N] = lastN;
+        return toBytes(jsonObject.dump());
+    }
 }
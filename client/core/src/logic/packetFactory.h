@@ -69,5 +69,7 @@ namespace core::logic
         static std::vector<unsigned char> getMeetingJoinDeclinePacket(const std::string& myNickname, const std::string& friendNickname);
         static std::vector<unsigned char> getMeetingLeavePacket(const std::string& myNickname);
         static std::vector<unsigned char> getMeetingEndPacket(const std::string& myNickname);
+        static std::vector<unsigned char> getMeetingVideoPinsPacket(const std::string& myNickname, const std::vector<std::string>& pinnedNicknames);
+        static std::vector<unsigned char> getMeetingLastNPacket(const std::string& myNickname, std::size_t lastN);
     };
 }
\ No newline at end of file
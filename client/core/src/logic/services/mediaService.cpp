@@ -14,23 +14,6 @@ using namespace core::media;
 
 namespace core::logic
 {
-    namespace
-    {
-        void appendU16BE(std::vector<unsigned char>& out, uint16_t value)
-        {
-            out.push_back(static_cast<unsigned char>((value >> 8) & 0xFF));
-            out.push_back(static_cast<unsigned char>(value & 0xFF));
-        }
-
-        void appendU32BE(std::vector<unsigned char>& out, uint32_t value)
-        {
-            out.push_back(static_cast<unsigned char>((value >> 24) & 0xFF));
-            out.push_back(static_cast<unsigned char>((value >> 16) & 0xFF));
-            out.push_back(static_cast<unsigned char>((value >> 8) & 0xFF));
-            out.push_back(static_cast<unsigned char>(value & 0xFF));
-        }
-    }
-
     MediaService::MediaService(
         std::shared_ptr<ClientStateManager> stateManager,
         std::shared_ptr<media::AudioEngine> audioEngine,
@@ -288,8 +271,8 @@ namespace core::logic
             auto meetingOpt = m_stateManager->getActiveMeeting();
 
             if (!meetingOpt) return;
+            const float rmsVal = core::constant::computeRms(data, length);
             {
-                const float rmsVal = core::constant::computeRms(data, length);
                 m_localSmoothedRms = core::constant::smoothRms(m_localSmoothedRms, rmsVal);
                 if (m_localSmoothedRms > core::constant::kSpeakingRmsThreshold) {
                     m_silenceFramesCount = 0;
@@ -342,7 +325,10 @@ namespace core::logic
             const uint32_t ts = static_cast<uint32_t>(
                 std::chrono::duration_cast<std::chrono::milliseconds>(
                     std::chrono::steady_clock::now().time_since_epoch()).count() & 0xFFFFFFFF);
-            std::vector<unsigned char> framed = buildMeetingFrame(meetingId, senderHash, MediaFrameKind::Voice, 0, frameSeq, ts, encryptedAudio);
+            // Voice has no layers: that header byte carries the audio level and voice activity instead,
+            // so the server can forward only the loudest speakers without decrypting anything.
+            const uint8_t audioLevel = core::constant::audioLevelFromRms(rmsVal);
+            std::vector<unsigned char> framed = buildMeetingFrame(meetingId, senderHash, MediaFrameKind::Voice, audioLevel, m_localParticipantSpeaking, frameSeq, ts, encryptedAudio);
             if (!framed.empty()) {
                 m_sendMediaFrame(framed, PacketType::VOICE);
             }
@@ -361,7 +347,7 @@ namespace core::logic
         const uint32_t ts = static_cast<uint32_t>(
             std::chrono::duration_cast<std::chrono::milliseconds>(
                 std::chrono::steady_clock::now().time_since_epoch()).count() & 0xFFFFFFFF);
-        std::vector<unsigned char> framed = buildMeetingFrame(std::string(), senderHash, MediaFrameKind::Voice, 0, frameSeq, ts, encryptedAudio);
+        std::vector<unsigned char> framed = buildMeetingFrame(std::string(), senderHash, MediaFrameKind::Voice, 0, false, frameSeq, ts, encryptedAudio);
         if (!framed.empty()) {
             m_sendMediaFrame(framed, PacketType::VOICE);
         }
@@ -415,7 +401,7 @@ namespace core::logic
             if (isActiveCall) {
                 const auto& selectedLayer = layers.back().first;
                 const auto& encodedVideo = layers.back().second;
-                auto encryptedVideo = encryptWithCallKey(encodedVideo);
+                auto encryptedVideo = encryptWithCallKey(encodedVideo.data);
                 if (!encryptedVideo.empty()) {
                     const std::string senderHash = core::utilities::crypto::calculateHash(m_stateManager->getMyNickname());
                     if (senderHash.size() > 0xFFFF) {
@@ -426,6 +412,7 @@ namespace core::logic
                         senderHash,
                         MediaFrameKind::Camera,
                         static_cast<uint8_t>(selectedLayer),
+                        encodedVideo.keyframe,
                         frameSeq,
                         ts,
                         encryptedVideo);
@@ -447,8 +434,8 @@ namespace core::logic
 
             for (const auto& [layer, encodedVideo] : layers) {
                 auto encryptedVideo = m_mediaProcessingService->encryptData(
-                    encodedVideo.data(),
-                    static_cast<int>(encodedVideo.size()),
+                    encodedVideo.data.data(),
+                    static_cast<int>(encodedVideo.data.size()),
                     keyVec
                 );
                 if (encryptedVideo.empty()) {
@@ -459,6 +446,7 @@ namespace core::logic
                     senderHash,
                     MediaFrameKind::Camera,
                     static_cast<uint8_t>(layer),
+                    encodedVideo.keyframe,
                     frameSeq,
                     ts,
                     encryptedVideo);
@@ -475,7 +463,7 @@ namespace core::logic
             return;
         }
         if (isActiveCall) {
-            auto encryptedVideo = encryptWithCallKey(encodedVideo);
+            auto encryptedVideo = encryptWithCallKey(encodedVideo.data);
             if (encryptedVideo.empty()) {
                 return;
             }
@@ -488,6 +476,7 @@ namespace core::logic
                 senderHash,
                 MediaFrameKind::Screen,
                 0,
+                encodedVideo.keyframe,
                 frameSeq,
                 ts,
                 encryptedVideo);
@@ -505,8 +494,8 @@ namespace core::logic
 
         std::vector<unsigned char> keyVec(meetingKey.begin(), meetingKey.end());
         auto encryptedVideo = m_mediaProcessingService->encryptData(
-            encodedVideo.data(),
-            static_cast<int>(encodedVideo.size()),
+            encodedVideo.data.data(),
+            static_cast<int>(encodedVideo.data.size()),
             keyVec
         );
         if (encryptedVideo.empty()) {
@@ -526,6 +515,7 @@ namespace core::logic
             senderHash,
             MediaFrameKind::Screen,
             0,
+            encodedVideo.keyframe,
             frameSeq,
             ts,
             encryptedVideo);
@@ -538,23 +528,15 @@ namespace core::logic
         const std::string& senderHash,
         MediaFrameKind kind,
         uint8_t layerId,
+        bool keyframe,
         uint32_t frameSeq,
         uint32_t timestampMs,
         const std::vector<unsigned char>& encryptedPayload)
     {
-        std::vector<unsigned char> framed;
-        framed.reserve(1 + 2 + meetingId.size() + 2 + senderHash.size() + 1 + 1 + 4 + 4 + encryptedPayload.size());
-        framed.push_back(1); // protocol version
-        appendU16BE(framed, static_cast<uint16_t>(meetingId.size()));
-        framed.insert(framed.end(), meetingId.begin(), meetingId.end());
-        appendU16BE(framed, static_cast<uint16_t>(senderHash.size()));
-        framed.insert(framed.end(), senderHash.begin(), senderHash.end());
-        framed.push_back(static_cast<uint8_t>(kind));
-        framed.push_back(layerId);
-        appendU32BE(framed, frameSeq);
-        appendU32BE(framed, timestampMs);
-        framed.insert(framed.end(), encryptedPayload.begin(), encryptedPayload.end());
-        return framed;
+        // v2 frames only once the server confirmed every receiver parses them.
+        const uint32_t sessionId = m_stateManager->isCompactMediaFramesAllowed() ? m_stateManager->getMediaSessionId() : 0;
+        return logic::buildMeetingFrame(sessionId, meetingId, senderHash, kind,
+            layerId, keyframe, frameSeq, timestampMs, encryptedPayload);
     }
 
     uint32_t MediaService::nextFrameSeq(media::MediaType type)
@@ -14,6 +14,7 @@
 #include "media/camera/cameraCaptureService.h"
 #include "media/processing/mediaProcessingService.h"
 #include "logic/clientStateManager.h"
+#include "logic/meetingFrame.h"
 #include "constants/packetType.h"
 #include "constants/speakingVad.h"
 #include "eventListener.h"
@@ -23,13 +24,6 @@
 namespace core::logic
 {
     class MediaService {
-    private:
-        enum class MediaFrameKind : uint8_t {
-            Voice = 0,
-            Screen = 1,
-            Camera = 2,
-        };
-
     public:
         MediaService(
             std::shared_ptr<ClientStateManager> stateManager,
@@ -63,6 +57,7 @@ namespace core::logic
             const std::string& senderHash,
             MediaFrameKind kind,
             uint8_t layerId,
+            bool keyframe,
             uint32_t frameSeq,
             uint32_t timestampMs,
             const std::vector<unsigned char>& encryptedPayload);
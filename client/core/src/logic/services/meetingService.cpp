@@ -155,4 +155,24 @@ namespace core::logic
         return {};
     }
 
+    std::error_code MeetingService::setVideoPins(const std::vector<std::string>& pinnedNicknames) {
+        if (m_stateManager->isConnectionDown()) return make_error_code(ErrorCode::connection_down);
+        if (!m_stateManager->isAuthorized()) return make_error_code(ErrorCode::not_authorized);
+        if (!m_stateManager->isActiveMeeting()) return make_error_code(ErrorCode::not_in_meeting);
+
+        auto packet = PacketFactory::getMeetingVideoPinsPacket(m_stateManager->getMyNickname(), pinnedNicknames);
+        return m_sendPacket(packet, PacketType::MEETING_VIDEO_CONFIG);
+    }
+
+    std::error_code MeetingService::setLastN(std::size_t lastN) {
+        if (m_stateManager->isConnectionDown()) return make_error_code(ErrorCode::connection_down);
+        if (!m_stateManager->isAuthorized()) return make_error_code(ErrorCode::not_authorized);
+        auto meetingOpt = m_stateManager->getActiveMeeting();
+        if (!meetingOpt) return make_error_code(ErrorCode::not_in_meeting);
+        auto owner = meetingOpt->get().getOwner();
+        if (!owner.has_value() || owner->getUser().getNickname() != m_stateManager->getMyNickname()) return make_error_code(ErrorCode::not_meeting_owner);
+
+        auto packet = PacketFactory::getMeetingLastNPacket(m_stateManager->getMyNickname(), lastN);
+        return m_sendPacket(packet, PacketType::MEETING_VIDEO_CONFIG);
+    }
 }
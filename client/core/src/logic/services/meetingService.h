@@ -10,6 +10,7 @@
 #include <memory>
 #include <string>
 #include <system_error>
+#include <vector>
 
 namespace core::logic
 {
@@ -29,6 +30,8 @@ namespace core::logic
         std::error_code leaveMeeting();
         std::error_code acceptJoinMeetingRequest(const std::string& friendNickname);
         std::error_code declineJoinMeetingRequest(const std::string& friendNickname);
+        std::error_code setVideoPins(const std::vector<std::string>& pinnedNicknames);
+        std::error_code setLastN(std::size_t lastN);
 
     private:
         static constexpr std::chrono::seconds kJoinMeetingRequestTimeout{60};
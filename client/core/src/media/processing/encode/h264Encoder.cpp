@@ -13,6 +13,8 @@ namespace core::media
         , m_height(0)
         , m_fps(30)
         , m_bitrate(2000000)
+        , m_keyframeInterval(10)
+        , m_forceKeyframe(false)
     {
     }
 
@@ -21,7 +23,7 @@ namespace core::media
         cleanup();
     }
 
-    bool H264Encoder::initialize(int width, int height, int fps, int bitrate)
+    bool H264Encoder::initialize(int width, int height, int fps, int bitrate, int keyframeInterval)
     {
         if (m_initialized) {
             cleanup();
@@ -31,6 +33,7 @@ namespace core::media
         m_height = height;
         m_fps = fps;
         m_bitrate = bitrate;
+        m_keyframeInterval = keyframeInterval > 0 ? keyframeInterval : 10;
 
         // Find H.264 encoder
         const AVCodec* codec = avcodec_find_encoder(AV_CODEC_ID_H264);
@@ -55,7 +58,7 @@ namespace core::media
         m_codecContext->framerate.num = fps;
         m_codecContext->framerate.den = 1;
         m_codecContext->bit_rate = bitrate;
-        m_codecContext->gop_size = 10;
+        m_codecContext->gop_size = m_keyframeInterval;
         m_codecContext->max_b_frames = 0;
         m_codecContext->pix_fmt = AV_PIX_FMT_YUV420P;
 
@@ -63,6 +66,9 @@ namespace core::media
         if (codec->id == AV_CODEC_ID_H264) {
             av_opt_set(m_codecContext->priv_data, "preset", "fast", 0);
             av_opt_set(m_codecContext->priv_data, "tune", "zerolatency", 0);
+            // Frames forced to I by requestKeyframe() must be IDRs, otherwise a receiver that lost
+            // its references still cannot start decoding from them.
+            av_opt_set(m_codecContext->priv_data, "forced-idr", "1", 0);
         }
 
         // Open codec
@@ -138,7 +144,7 @@ namespace core::media
             std::cout << "Encoder resolution changed from " << m_width << "x" << m_height
                       << " to " << frame.width << "x" << frame.height << ", reinitializing" << std::endl;
             auto callback = m_encodedCallback;
-            if (!initialize(frame.width, frame.height, m_fps, m_bitrate)) {
+            if (!initialize(frame.width, frame.height, m_fps, m_bitrate, m_keyframeInterval)) {
                 std::cerr << "Failed to reinitialize encoder for new resolution" << std::endl;
                 return false;
             }
@@ -152,6 +158,7 @@ namespace core::media
 
         // Set frame timestamp
         m_frame->pts = frame.pts;
+        m_frame->pict_type = m_forceKeyframe ? AV_PICTURE_TYPE_I : AV_PICTURE_TYPE_NONE;
 
         // Send frame to encoder
         int ret = avcodec_send_frame(m_codecContext, m_frame);
@@ -159,6 +166,7 @@ namespace core::media
             std::cerr << "Error sending frame to encoder: error code " << ret << std::endl;
             return false;
         }
+        m_forceKeyframe = false;
 
         // Receive packets from encoder
         while (ret >= 0) {
@@ -173,7 +181,7 @@ namespace core::media
 
             // Call callback with encoded data
             if (m_encodedCallback) {
-                m_encodedCallback(m_packet->data, m_packet->size, m_packet->pts);
+                m_encodedCallback(m_packet->data, m_packet->size, m_packet->pts, (m_packet->flags & AV_PKT_FLAG_KEY) != 0);
             }
 
             av_packet_unref(m_packet);
@@ -229,6 +237,11 @@ namespace core::media
         return true;
     }
 
+    void H264Encoder::requestKeyframe()
+    {
+        m_forceKeyframe = true;
+    }
+
     void H264Encoder::setEncodedDataCallback(EncodedDataCallback callback)
     {
         m_encodedCallback = callback;
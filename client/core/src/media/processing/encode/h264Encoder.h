@@ -20,14 +20,16 @@ namespace core::media
     class H264Encoder
     {
     public:
-        using EncodedDataCallback = std::function<void(const uint8_t* data, size_t size, int64_t pts)>;
+        using EncodedDataCallback = std::function<void(const uint8_t* data, size_t size, int64_t pts, bool keyframe)>;
 
         H264Encoder();
         ~H264Encoder();
 
-        bool initialize(int width, int height, int fps = 30, int bitrate = 2000000);
+        bool initialize(int width, int height, int fps = 30, int bitrate = 2000000, int keyframeInterval = 10);
         void cleanup();
         bool encodeFrame(const Frame& frame);
+        // Makes the next encoded frame an IDR, so receivers can start decoding from it.
+        void requestKeyframe();
         void setEncodedDataCallback(EncodedDataCallback callback);
         bool isInitialized() const;
 
@@ -46,6 +48,8 @@ namespace core::media
         int m_height;
         int m_fps;
         int m_bitrate;
+        int m_keyframeInterval;
+        bool m_forceKeyframe;
             
         bool convertFrame(const Frame& inputFrame);
     };
@@ -22,6 +22,7 @@ namespace core::media
             decoder.reset();
         }
         lastEncodedFrame.clear();
+        lastEncodedKeyframe = false;
         lastViewFrame = core::VideoFrameBuffer{};
         width = 0;
         height = 0;
@@ -124,6 +125,36 @@ namespace core::media
         m_cameraTargetLayer = layer;
     }
 
+    void MediaProcessingService::setLongGopEnabled(bool enabled)
+    {
+        m_longGopEnabled = enabled;
+    }
+
+    void MediaProcessingService::requestKeyframe(MediaType type)
+    {
+        if (type == MediaType::Screen) {
+            m_screenKeyframeRequested.store(true, std::memory_order_relaxed);
+        }
+        else if (type == MediaType::Camera) {
+            for (auto& requested : m_cameraKeyframeRequested) {
+                requested.store(true, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void MediaProcessingService::requestCameraKeyframe(CameraLayer layer)
+    {
+        const auto index = static_cast<std::size_t>(layer);
+        if (index < m_cameraKeyframeRequested.size()) {
+            m_cameraKeyframeRequested[index].store(true, std::memory_order_relaxed);
+        }
+    }
+
+    int MediaProcessingService::keyframeInterval(int fps) const
+    {
+        return m_longGopEnabled ? std::max(1, fps) * m_longGopSeconds : m_shortGopFrames;
+    }
+
     void MediaProcessingService::cleanupAudio()
     {
         m_audioEncoder.reset();
@@ -236,7 +267,7 @@ namespace core::media
         return m_audioDecoder->isInitialized();
     }
 
-    std::vector<unsigned char> MediaProcessingService::encodeVideoFrame(MediaType type, const unsigned char* rawData, int width, int height)
+    MediaProcessingService::EncodedVideoFrame MediaProcessingService::encodeVideoFrame(MediaType type, const unsigned char* rawData, int width, int height)
     {
         auto it = m_videoPipelines.find(type);
         if (it == m_videoPipelines.end() || !it->second.initialized || !it->second.encoder) {
@@ -256,17 +287,22 @@ namespace core::media
                 targetHeight = std::min(height, m_screenBaseProfile.height);
                 targetFps = m_screenBaseProfile.fps;
             }
-            if (!pipeline.encoder->initialize(targetWidth, targetHeight, targetFps, pipeline.bitrate)) {
+            if (!pipeline.encoder->initialize(targetWidth, targetHeight, targetFps, pipeline.bitrate, keyframeInterval(targetFps))) {
                 return {};
             }
         }
+        if (type == MediaType::Screen && m_screenKeyframeRequested.exchange(false, std::memory_order_relaxed)) {
+            pipeline.encoder->requestKeyframe();
+        }
             
         // Очищаем предыдущий результат
         pipeline.lastEncodedFrame.clear();
+        pipeline.lastEncodedKeyframe = false;
             
         // Устанавливаем callback для получения закодированных данных
-        pipeline.encoder->setEncodedDataCallback([&pipeline](const uint8_t* data, size_t size, int64_t pts) {
+        pipeline.encoder->setEncodedDataCallback([&pipeline](const uint8_t* data, size_t size, int64_t pts, bool keyframe) {
             pipeline.lastEncodedFrame.assign(data, data + size);
+            pipeline.lastEncodedKeyframe = keyframe;
         });
             
         // Создаем FrameData (AV_PIX_FMT_RGB24 обязателен для sws_scale)
@@ -281,15 +317,15 @@ namespace core::media
         pipeline.width = pipeline.encoder->getWidth();
         pipeline.height = pipeline.encoder->getHeight();
              
-        return pipeline.lastEncodedFrame;
+        return EncodedVideoFrame{ pipeline.lastEncodedFrame, pipeline.lastEncodedKeyframe };
     }
 
-    std::vector<std::pair<MediaProcessingService::CameraLayer, std::vector<unsigned char>>> MediaProcessingService::encodeCameraSimulcastFrames(
+    std::vector<std::pair<MediaProcessingService::CameraLayer, MediaProcessingService::EncodedVideoFrame>> MediaProcessingService::encodeCameraSimulcastFrames(
         const unsigned char* rawData,
         int width,
         int height)
     {
-        std::vector<std::pair<CameraLayer, std::vector<unsigned char>>> out;
+        std::vector<std::pair<CameraLayer, EncodedVideoFrame>> out;
         auto encodeLayer = [&](CameraLayer layer, const VideoProfile& profile) {
             auto it = m_cameraEncodePipelines.find(layer);
             if (it == m_cameraEncodePipelines.end()) return;
@@ -297,17 +333,22 @@ namespace core::media
             if (!pipeline.initialized || !pipeline.encoder) return;
 
             pipeline.lastEncodedFrame.clear();
-            pipeline.encoder->setEncodedDataCallback([&pipeline](const uint8_t* data, size_t size, int64_t pts) {
+            pipeline.lastEncodedKeyframe = false;
+            pipeline.encoder->setEncodedDataCallback([&pipeline](const uint8_t* data, size_t size, int64_t pts, bool keyframe) {
                 pipeline.lastEncodedFrame.assign(data, data + size);
+                pipeline.lastEncodedKeyframe = keyframe;
             });
 
             const int targetWidth = std::min(width, profile.width);
             const int targetHeight = std::min(height, profile.height);
             if (!pipeline.encoder->isInitialized()) {
-                if (!pipeline.encoder->initialize(targetWidth, targetHeight, profile.fps, profile.bitrate)) {
+                if (!pipeline.encoder->initialize(targetWidth, targetHeight, profile.fps, profile.bitrate, keyframeInterval(profile.fps))) {
                     return;
                 }
             }
+            if (m_cameraKeyframeRequested[static_cast<std::size_t>(layer)].exchange(false, std::memory_order_relaxed)) {
+                pipeline.encoder->requestKeyframe();
+            }
 
             Frame frame(rawData, width * height * 3, width, height, AV_PIX_FMT_RGB24);
             if (!pipeline.encoder->encodeFrame(frame)) {
@@ -316,16 +357,22 @@ namespace core::media
             pipeline.width = pipeline.encoder->getWidth();
             pipeline.height = pipeline.encoder->getHeight();
             if (!pipeline.lastEncodedFrame.empty()) {
-                out.emplace_back(layer, pipeline.lastEncodedFrame);
+                out.emplace_back(layer, EncodedVideoFrame{ pipeline.lastEncodedFrame, pipeline.lastEncodedKeyframe });
             }
         };
 
+        // A paused layer's encoder still references frames its receivers never got,
+        // so it has to restart with an IDR when it is resumed.
         encodeLayer(CameraLayer::Low, m_cameraLowProfile);
         if (m_cameraTargetLayer >= CameraLayer::Mid) {
             encodeLayer(CameraLayer::Mid, m_cameraMidProfile);
+        } else {
+            requestCameraKeyframe(CameraLayer::Mid);
         }
         if (m_cameraTargetLayer >= CameraLayer::High) {
             encodeLayer(CameraLayer::High, m_cameraHighProfile);
+        } else {
+            requestCameraKeyframe(CameraLayer::High);
         }
         return out;
     }
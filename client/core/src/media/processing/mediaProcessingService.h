@@ -2,6 +2,8 @@
 
 #include <vector>
 #include <memory>
+#include <array>
+#include <atomic>
 #include <cstdint>
 #include <mutex>
 #include <string>
@@ -32,12 +34,19 @@ namespace core::media
             Mid = 1,
             High = 2,
         };
+        struct EncodedVideoFrame {
+            std::vector<unsigned char> data;
+            bool keyframe = false;
+
+            bool empty() const { return data.empty(); }
+        };
 
     private:
         struct VideoPipeline {
             std::unique_ptr<H264Encoder> encoder;
             std::unique_ptr<H264Decoder> decoder;
             std::vector<unsigned char> lastEncodedFrame;
+            bool lastEncodedKeyframe = false;
             core::VideoFrameBuffer lastViewFrame;
             int width = 0;
             int height = 0;
@@ -65,6 +74,12 @@ namespace core::media
         void setCameraQualityProfiles(const VideoProfile& low, const VideoProfile& mid, const VideoProfile& high);
         void setScreenQualityProfile(const VideoProfile& baseProfile, const VideoProfile& minProfile);
         void setCameraTargetLayer(CameraLayer layer);
+        // Long GOP: periodic keyframes only as a slow safety net, everything else is an IDR on request.
+        void setLongGopEnabled(bool enabled);
+
+        // Thread-safe; the IDR is produced by the next encode call of that stream.
+        void requestKeyframe(MediaType type);
+        void requestCameraKeyframe(CameraLayer layer);
             
         void cleanupAudio();
         void cleanupVideo(MediaType type);
@@ -72,8 +87,8 @@ namespace core::media
         std::vector<unsigned char> encodeAudioFrame(const float* pcmData);
         std::vector<float> decodeAudioFrame(const unsigned char* opusData, int dataSize);
 
-        std::vector<unsigned char> encodeVideoFrame(MediaType type, const unsigned char* rawData, int width, int height);
-        std::vector<std::pair<CameraLayer, std::vector<unsigned char>>> encodeCameraSimulcastFrames(const unsigned char* rawData, int width, int height);
+        EncodedVideoFrame encodeVideoFrame(MediaType type, const unsigned char* rawData, int width, int height);
+        std::vector<std::pair<CameraLayer, EncodedVideoFrame>> encodeCameraSimulcastFrames(const unsigned char* rawData, int width, int height);
         core::VideoFrameBuffer decodeVideoFrame(MediaType type, const unsigned char* h264Data, int dataSize);
         core::VideoFrameBuffer decodeVideoFrame(MediaType type, const std::string& streamKey, const unsigned char* h264Data, int dataSize);
         
@@ -106,6 +121,12 @@ namespace core::media
         VideoProfile m_screenBaseProfile{ 1920, 1080, 30, 3500000 };
         VideoProfile m_screenMinProfile{ 1280, 720, 20, 1800000 };
         CameraLayer m_cameraTargetLayer = CameraLayer::High;
+        bool m_longGopEnabled = true;
+        std::atomic<bool> m_screenKeyframeRequested{ false };
+        std::array<std::atomic<bool>, 3> m_cameraKeyframeRequested{};
+
+        static constexpr int m_shortGopFrames = 10;
+        static constexpr int m_longGopSeconds = 10;
 
         int m_sampleRate;
         int m_channels;
@@ -116,5 +137,6 @@ namespace core::media
         bool initializeAudioDecoder(int sampleRate, int channels);
 
         VideoPipeline& getPipeline(MediaType type);
+        int keyframeInterval(int fps) const;
     };
 }
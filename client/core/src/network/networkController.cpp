@@ -176,6 +176,14 @@ namespace core::network
         return m_udpClient->send(data, static_cast<uint32_t>(type), senderNicknameHash);
     }
 
+    bool NetworkController::sendUDP(const std::vector<unsigned char>& data, PacketType type, uint32_t senderSessionId) {
+        if (!m_udpClient || !m_udpClient->isRunning()) {
+            LOG_WARN("UDP client not running for packet type {}", packetTypeToString(type));
+            return false;
+        }
+        return m_udpClient->send(data, static_cast<uint32_t>(type), senderSessionId);
+    }
+
     bool NetworkController::isTCPConnected() const {
         return m_tcpClient && m_tcpClient->isConnected();
     }
@@ -33,6 +33,7 @@ namespace core::network
         bool sendTCP(const std::vector<unsigned char>& data, core::constant::PacketType type);
         bool sendUDP(const std::vector<unsigned char>& data, core::constant::PacketType type,
             const std::array<unsigned char, 32>& senderNicknameHash);
+        bool sendUDP(const std::vector<unsigned char>& data, core::constant::PacketType type, uint32_t senderSessionId);
 
         bool isTCPConnected() const;
         bool isUDPRunning() const;
@@ -1,6 +1,7 @@
 #include "network/udp/client.h"
 #include "utilities/logger.h"
 #include "utilities/errorCodeForLog.h"
+#include "utilities/bufferPool.h"
 
 #include <thread>
 #include <utility>
@@ -70,7 +71,8 @@ namespace core::network::udp
             if (!errorCode)
                 m_localPort = static_cast<uint16_t>(localEndpoint.port());
 
-            if (!m_packetReceiver.initialize(m_socket, m_onReceive, m_serverEndpoint)) {
+            if (!m_packetReceiver.initialize(m_socket, m_onReceive, m_serverEndpoint,
+                [this](std::vector<unsigned char>&& nack) { sendNack(std::move(nack)); })) {
                 LOG_ERROR("Media failed to initialize packet receiver");
                 return false;
             }
@@ -110,6 +112,11 @@ namespace core::network::udp
             if (errorCode)
                 LOG_WARN("Media failed to close socket: {}", core::utilities::errorCodeForLog(errorCode));
         }
+
+        // Heap allocations far below acquisitions mean the media path ran out of the pool.
+        const auto& bufferPool = core::utilities::BufferPool::shared();
+        LOG_INFO("Media buffer pool: {} acquisitions, {} heap allocations",
+            bufferPool.getAcquisitions(), bufferPool.getHeapAllocations());
     }
 
     bool Client::isRunning() const {
@@ -127,7 +134,7 @@ namespace core::network::udp
         packet.type = type;
         packet.data = data;
         packet.senderNicknameHash = senderNicknameHash;
-        m_packetSender.send(packet);
+        m_packetSender.send(std::move(packet));
         return true;
     }
 
@@ -138,10 +145,29 @@ namespace core::network::udp
         packet.type = type;
         packet.data = std::move(data);
         packet.senderNicknameHash = senderNicknameHash;
-        m_packetSender.send(packet);
+        m_packetSender.send(std::move(packet));
+        return true;
+    }
+
+    bool Client::send(const std::vector<unsigned char>& data, uint32_t type, uint32_t senderSessionId) {
+        Packet packet;
+        packet.id = generateId();
+        packet.type = type;
+        packet.data = data;
+        packet.senderSessionId = senderSessionId;
+        m_packetSender.send(std::move(packet));
         return true;
     }
 
+    void Client::sendNack(std::vector<unsigned char>&& nack) {
+        // The server answers NACKs by source endpoint, so no sender hash is needed.
+        Packet packet;
+        packet.id = generateId();
+        packet.type = static_cast<uint32_t>(constant::PacketType::MEDIA_NACK);
+        packet.data = std::move(nack);
+        m_packetSender.send(std::move(packet));
+    }
+
     uint64_t Client::generateId() {
         return m_nextPacketId.fetch_add(1U, std::memory_order_relaxed);
     }
@@ -33,8 +33,10 @@ namespace core::network::udp
             const std::array<unsigned char, 32>& senderNicknameHash);
         bool send(std::vector<unsigned char>&& data, uint32_t type,
             const std::array<unsigned char, 32>& senderNicknameHash);
+        bool send(const std::vector<unsigned char>& data, uint32_t type, uint32_t senderSessionId);
 
     private:
+        void sendNack(std::vector<unsigned char>&& nack);
         uint64_t generateId();
 
         asio::io_context& m_context;
@@ -11,6 +11,8 @@ struct Packet {
     uint32_t type;
     std::vector<unsigned char> data;
     std::array<unsigned char, 32> senderNicknameHash{};
+    // Nonzero selects the v2 chunk header, which carries this id instead of senderNicknameHash.
+    uint32_t senderSessionId = 0;
 };
 
 }
@@ -2,7 +2,9 @@
 #include "utilities/logger.h"
 #include "utilities/errorCodeForLog.h"
 
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <exception>
 #include <string>
 #include <system_error>
@@ -20,10 +22,12 @@ PacketReceiver::~PacketReceiver() {
 
 bool PacketReceiver::initialize(asio::ip::udp::socket& socket,
     std::function<void(const unsigned char*, int, uint32_t)> onPacketReceived,
-    const asio::ip::udp::endpoint& serverEndpoint)
+    const asio::ip::udp::endpoint& serverEndpoint,
+    std::function<void(std::vector<unsigned char>&&)> onNack)
 {
     m_socket = std::ref(socket);
     m_onPacketReceived = std::move(onPacketReceived);
+    m_onNack = std::move(onNack);
     m_serverEndpoint = serverEndpoint;
     m_running = false;
     m_remoteEndpoint = asio::ip::udp::endpoint();
@@ -150,10 +154,9 @@ void PacketReceiver::processDatagram(std::size_t bytesTransferred) {
     }
 
     if (payloadLength == 0) {
-        ReceivedPacket receivedPacket;
-        receivedPacket.data.clear();
-        receivedPacket.type = packetType;
-        m_receivedPacketsQueue.push_with_limit(std::move(receivedPacket), m_maxReceivedPacketsQueueSize);
+        AssemblyJob job;
+        job.type = packetType;
+        m_assemblyQueue.push_drop_oldest(std::move(job));
         return;
     }
 
@@ -164,6 +167,7 @@ void PacketReceiver::processDatagram(std::size_t bytesTransferred) {
 
     bool packetComplete = false;
     AssemblyJob jobToPush;
+    std::vector<unsigned char> nack;
 
     {
         std::unique_lock<std::mutex> lock(m_stateMutex);
@@ -198,10 +202,26 @@ void PacketReceiver::processDatagram(std::size_t bytesTransferred) {
             LOG_WARN("Media chunk index {} out of range for packet {} ({})", chunkIndex, packetId, packet.chunks.size());
             return;
         }
-        if (packet.chunks[chunkIndex].empty()) {
-            packet.chunks[chunkIndex] = std::vector<unsigned char>(payload, payload + payloadSize);
+        if (!packet.chunks[chunkIndex]) {
+            packet.chunks[chunkIndex] = utilities::BufferPool::shared().acquire(payloadSize);
+            std::memcpy(packet.chunks[chunkIndex].data(), payload, payloadSize);
             packet.receivedChunks++;
         }
+
+        // Chunks of one packet are sent in order, so skipped indices are lost (or reordered, which
+        // only costs a spurious resend). Tails are detected once a packet has gone quiet.
+        if (m_onNack && isNackable(packet.type)) {
+            if (chunkIndex >= packet.nackedUpTo) {
+                appendNack(nack, packet, chunkIndex);
+                packet.nackedUpTo = static_cast<uint16_t>(chunkIndex + 1);
+            }
+            for (auto& [otherId, other] : m_pendingPackets) {
+                if (otherId != packetId && isNackable(other.type) && other.nackedUpTo < other.totalChunks
+                    && now - other.lastUpdated >= m_tailNackDelay && nack.size() < m_maxNackSize) {
+                    appendNack(nack, other, other.totalChunks);
+                }
+            }
+        }
         if (packet.receivedChunks == packet.totalChunks) {
             packetComplete = true;
             jobToPush.chunks = std::move(packet.chunks);
@@ -210,8 +230,42 @@ void PacketReceiver::processDatagram(std::size_t bytesTransferred) {
         }
     }
 
+    if (!nack.empty())
+        m_onNack(std::move(nack));
     if (packetComplete)
-        m_assemblyQueue.push_with_limit(std::move(jobToPush), m_maxAssemblyQueueSize);
+        m_assemblyQueue.push_drop_oldest(std::move(jobToPush));
+}
+
+bool PacketReceiver::isNackable(uint32_t packetType) {
+    return packetType == static_cast<uint32_t>(constant::PacketType::CAMERA)
+        || packetType == static_cast<uint32_t>(constant::PacketType::SCREEN);
+}
+
+void PacketReceiver::appendNack(std::vector<unsigned char>& nack, PendingPacket& packet, uint16_t upTo) {
+    std::vector<uint16_t> missing;
+    for (uint16_t index = packet.nackedUpTo; index < upTo && index < packet.chunks.size(); ++index) {
+        if (packet.chunks[index].empty())
+            missing.push_back(index);
+    }
+    packet.nackedUpTo = std::max(packet.nackedUpTo, upTo);
+    if (missing.empty())
+        return;
+
+    // The NACK must fit into a single datagram.
+    const std::size_t room = nack.size() + 10 < m_maxNackSize ? (m_maxNackSize - nack.size() - 10) / 2 : 0;
+    if (missing.size() > room)
+        missing.resize(room);
+    if (missing.empty())
+        return;
+
+    for (int shift = 56; shift >= 0; shift -= 8)
+        nack.push_back(static_cast<unsigned char>((packet.packetId >> shift) & 0xFF));
+    nack.push_back(static_cast<unsigned char>((missing.size() >> 8) & 0xFF));
+    nack.push_back(static_cast<unsigned char>(missing.size() & 0xFF));
+    for (uint16_t index : missing) {
+        nack.push_back(static_cast<unsigned char>((index >> 8) & 0xFF));
+        nack.push_back(static_cast<unsigned char>(index & 0xFF));
+    }
 }
 
 void PacketReceiver::initPendingPacket(PendingPacket& packet, uint64_t packetId, uint16_t totalChunks, uint32_t packetType,
@@ -258,40 +312,47 @@ uint64_t PacketReceiver::readUint64(const unsigned char* data) {
 
 void PacketReceiver::processReceivedPackets() {
     const auto timeout = std::chrono::milliseconds(100);
-    constexpr int maxAssemblyBatch = 64;
+    constexpr std::size_t maxAssemblyBatch = 64;
+    std::vector<AssemblyJob> jobs;
+    jobs.reserve(maxAssemblyBatch);
 
     while (m_running.load()) {
-        for (int i = 0; i < maxAssemblyBatch; ++i) {
-            auto jobOptional = m_assemblyQueue.try_pop();
-            if (!jobOptional.has_value())
-                break;
+        jobs.clear();
+        // Sleep on the assembly queue itself so a completed packet wakes this thread immediately.
+        m_assemblyQueue.pop_batch_for(jobs, maxAssemblyBatch, timeout);
+
+        for (auto& job : jobs) {
             try {
                 ReceivedPacket receivedPacket;
-                receivedPacket.type = jobOptional->type;
+                receivedPacket.type = job.type;
                 std::size_t totalSize = 0;
-                for (const auto& chunk : jobOptional->chunks)
+                for (const auto& chunk : job.chunks)
                     totalSize += chunk.size();
-                receivedPacket.data.reserve(totalSize);
-                for (const auto& chunk : jobOptional->chunks)
-                    receivedPacket.data.insert(receivedPacket.data.end(), chunk.begin(), chunk.end());
-                m_receivedPacketsQueue.push_with_limit(std::move(receivedPacket), m_maxReceivedPacketsQueueSize);
+                if (totalSize != 0) {
+                    receivedPacket.data = utilities::BufferPool::shared().acquire(totalSize);
+                    unsigned char* out = receivedPacket.data.data();
+                    for (const auto& chunk : job.chunks) {
+                        std::memcpy(out, chunk.data(), chunk.size());
+                        out += chunk.size();
+                    }
+                }
+                m_receivedPacketsQueue.push_drop_oldest(std::move(receivedPacket));
             }
             catch (const std::exception& exception) {
                 LOG_ERROR("Media assembly failed: {}", exception.what());
             }
         }
 
-        auto packetOptional = m_receivedPacketsQueue.pop_for(timeout);
-        if (!packetOptional.has_value())
-            continue;
-        if (!m_onPacketReceived)
-            continue;
-
-        const auto& received = packetOptional.value();
-        if (received.data.empty())
-            m_onPacketReceived(nullptr, 0, received.type);
-        else
-            m_onPacketReceived(received.data.data(), static_cast<int>(received.data.size()), received.type);
+        while (auto packetOptional = m_receivedPacketsQueue.try_pop()) {
+            if (!m_onPacketReceived)
+                continue;
+
+            const auto& received = packetOptional.value();
+            if (received.data.empty())
+                m_onPacketReceived(nullptr, 0, received.type);
+            else
+                m_onPacketReceived(received.data.data(), static_cast<int>(received.data.size()), received.type);
+        }
     }
 }
 
@@ -13,7 +13,8 @@
 #include <vector>
 
 #include "constants/packetType.h"
-#include "utilities/safeQueue.h"
+#include "utilities/bufferPool.h"
+#include "utilities/ringBuffer.h"
 
 namespace core::network::udp {
 
@@ -23,18 +24,20 @@ private:
         uint64_t packetId = 0;
         uint16_t totalChunks = 0;
         std::size_t receivedChunks = 0;
-        std::vector<std::vector<unsigned char>> chunks;
+        utilities::PooledBufferList chunks;
         uint32_t type = 0;
+        // Chunks below this index were either received or already NACKed.
+        uint16_t nackedUpTo = 0;
         std::chrono::steady_clock::time_point lastUpdated{};
     };
 
     struct ReceivedPacket {
-        std::vector<unsigned char> data;
+        utilities::PooledBuffer data;
         uint32_t type;
     };
 
     struct AssemblyJob {
-        std::vector<std::vector<unsigned char>> chunks;
+        utilities::PooledBufferList chunks;
         uint32_t type = 0;
     };
 
@@ -42,16 +45,20 @@ public:
     PacketReceiver();
     ~PacketReceiver();
 
+    // onNack receives MEDIA_NACK payloads (repeated: u64 packetId, u16 count, count x u16 chunkIndex)
+    // for video chunks that went missing, to be sent back to the server.
     bool initialize(asio::ip::udp::socket& socket,
         std::function<void(const unsigned char*, int, uint32_t)> onPacketReceived,
-        const asio::ip::udp::endpoint& serverEndpoint);
+        const asio::ip::udp::endpoint& serverEndpoint,
+        std::function<void(std::vector<unsigned char>&&)> onNack);
 
     void start();
     void stop();
     bool isRunning() const;
 
 private:
-    using PendingPacketMap = std::unordered_map<uint64_t, PendingPacket>;
+    using PendingPacketMap = std::unordered_map<uint64_t, PendingPacket, std::hash<uint64_t>, std::equal_to<uint64_t>,
+        utilities::PoolAllocator<std::pair<const uint64_t, PendingPacket>>>;
 
     void doReceive();
     void processDatagram(std::size_t bytesTransferred);
@@ -59,6 +66,8 @@ private:
     void initPendingPacket(PendingPacket& packet, uint64_t packetId, uint16_t totalChunks, uint32_t packetType,
         std::chrono::steady_clock::time_point now);
     void evictOldestPacket(PendingPacketMap& packets);
+    static bool isNackable(uint32_t packetType);
+    static void appendNack(std::vector<unsigned char>& nack, PendingPacket& packet, uint16_t upTo);
     uint16_t readUint16(const unsigned char* data);
     uint32_t readUint32(const unsigned char* data);
     uint64_t readUint64(const unsigned char* data);
@@ -71,14 +80,18 @@ private:
     std::atomic<bool> m_running;
     std::mutex m_stateMutex;
     PendingPacketMap m_pendingPackets;
-    core::utilities::SafeQueue<ReceivedPacket> m_receivedPacketsQueue;
-    core::utilities::SafeQueue<AssemblyJob> m_assemblyQueue;
+    core::utilities::SpscRingBuffer<ReceivedPacket> m_receivedPacketsQueue{ m_maxReceivedPacketsQueueSize };
+    core::utilities::SpscRingBuffer<AssemblyJob> m_assemblyQueue{ m_maxAssemblyQueueSize };
     std::thread m_processingThread;
     const std::size_t m_headerSize = 18;  // Server forwards payload only and uses 18-byte header
     const std::size_t m_maxPendingPackets = 8;
+    // A packet that got no chunk for this long has lost its tail.
+    static constexpr std::chrono::milliseconds m_tailNackDelay{ 30 };
+    static constexpr std::size_t m_maxNackSize = 1300;
     static constexpr std::size_t m_maxAssemblyQueueSize = 64;
     static constexpr std::size_t m_maxReceivedPacketsQueueSize = 64;
     std::function<void(const unsigned char*, int, uint32_t)> m_onPacketReceived;
+    std::function<void(std::vector<unsigned char>&&)> m_onNack;
     asio::ip::udp::endpoint m_serverEndpoint;
 };
 
@@ -1,13 +1,24 @@
 #include "network/udp/packetSender.h"
+#include "constants/packetType.h"
+#include "constants/mediaFrame.h"
 #include "utilities/logger.h"
 #include "utilities/errorCodeForLog.h"
 
 #include <algorithm>
+#include <cstring>
+
+#if defined(__linux__)
+#include <array>
+#include <cerrno>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#endif
 
 namespace core::network::udp {
 
 PacketSender::PacketSender()
     : m_isSending(false)
+    , m_videoTurn(0)
     , m_currentDatagramIndex(0)
 {
 }
@@ -22,11 +33,35 @@ void PacketSender::initialize(asio::ip::udp::socket& socket, asio::ip::udp::endp
     m_isSending = false;
     m_currentDatagrams.clear();
     m_currentDatagramIndex = 0;
-    m_packetQueue.clear();
+    m_videoTurn = 0;
+#if defined(__linux__) && defined(UDP_SEGMENT)
+    // A zero socket-wide segment size leaves plain sends alone; the size is given per send.
+    int segmentSize = 0;
+    m_segmentationOffload = ::setsockopt(socket.native_handle(), SOL_UDP, UDP_SEGMENT, &segmentSize, sizeof(segmentSize)) == 0;
+#endif
+    clearQueues();
 }
 
 void PacketSender::send(const Packet& packet) {
-    m_packetQueue.push_with_limit(packet, m_maxPacketQueueSize);
+    Packet copy = packet;
+    send(std::move(copy));
+}
+
+void PacketSender::send(Packet&& packet) {
+    switch (classify(packet.type)) {
+    case EgressClass::Voice:
+        m_voiceQueue.push_drop_oldest(std::move(packet));
+        break;
+    case EgressClass::Control:
+        m_controlQueue.push_drop_oldest(std::move(packet));
+        break;
+    case EgressClass::Camera:
+        m_cameraQueue.try_push(std::move(packet));
+        break;
+    case EgressClass::Screen:
+        m_screenQueue.try_push(std::move(packet));
+        break;
+    }
     startSendingIfIdle();
 }
 
@@ -34,7 +69,43 @@ void PacketSender::stop() {
     m_isSending = false;
     m_currentDatagrams.clear();
     m_currentDatagramIndex = 0;
-    m_packetQueue.clear();
+    clearQueues();
+}
+
+PacketSender::EgressClass PacketSender::classify(uint32_t type) {
+    switch (static_cast<constant::PacketType>(type)) {
+    case constant::PacketType::VOICE: return EgressClass::Voice;
+    case constant::PacketType::CAMERA: return EgressClass::Camera;
+    case constant::PacketType::SCREEN: return EgressClass::Screen;
+    default: return EgressClass::Control;
+    }
+}
+
+std::optional<Packet> PacketSender::popScheduled() {
+    if (auto packet = m_voiceQueue.try_pop())
+        return packet;
+    if (auto packet = m_controlQueue.try_pop())
+        return packet;
+
+    // Weighted round robin between the video classes; an empty class yields its turn.
+    const bool cameraTurn = m_videoTurn < m_cameraWeight;
+    m_videoTurn = (m_videoTurn + 1) % (m_cameraWeight + m_screenWeight);
+    auto& preferred = cameraTurn ? m_cameraQueue : m_screenQueue;
+    auto& other = cameraTurn ? m_screenQueue : m_cameraQueue;
+    if (auto packet = preferred.try_pop())
+        return packet;
+    return other.try_pop();
+}
+
+bool PacketSender::hasQueuedPackets() const {
+    return !m_voiceQueue.empty() || !m_controlQueue.empty() || !m_cameraQueue.empty() || !m_screenQueue.empty();
+}
+
+void PacketSender::clearQueues() {
+    m_voiceQueue.clear();
+    m_controlQueue.clear();
+    m_cameraQueue.clear();
+    m_screenQueue.clear();
 }
 
 void PacketSender::startSendingIfIdle() {
@@ -47,21 +118,24 @@ void PacketSender::startSendingIfIdle() {
     processNextPacketFromQueue();
 }
 
-void PacketSender::writeUint16(std::vector<unsigned char>& buffer, uint16_t value) {
-    buffer.push_back(static_cast<unsigned char>((value >> 8) & 0xFF));
-    buffer.push_back(static_cast<unsigned char>(value & 0xFF));
+unsigned char* PacketSender::writeUint16(unsigned char* out, uint16_t value) {
+    *out++ = static_cast<unsigned char>((value >> 8) & 0xFF);
+    *out++ = static_cast<unsigned char>(value & 0xFF);
+    return out;
 }
 
-void PacketSender::writeUint32(std::vector<unsigned char>& buffer, uint32_t value) {
-    buffer.push_back(static_cast<unsigned char>((value >> 24) & 0xFF));
-    buffer.push_back(static_cast<unsigned char>((value >> 16) & 0xFF));
-    buffer.push_back(static_cast<unsigned char>((value >> 8) & 0xFF));
-    buffer.push_back(static_cast<unsigned char>(value & 0xFF));
+unsigned char* PacketSender::writeUint32(unsigned char* out, uint32_t value) {
+    *out++ = static_cast<unsigned char>((value >> 24) & 0xFF);
+    *out++ = static_cast<unsigned char>((value >> 16) & 0xFF);
+    *out++ = static_cast<unsigned char>((value >> 8) & 0xFF);
+    *out++ = static_cast<unsigned char>(value & 0xFF);
+    return out;
 }
 
-void PacketSender::writeUint64(std::vector<unsigned char>& buffer, uint64_t value) {
+unsigned char* PacketSender::writeUint64(unsigned char* out, uint64_t value) {
     for (int shift = 56; shift >= 0; shift -= 8)
-        buffer.push_back(static_cast<unsigned char>((value >> shift) & 0xFF));
+        *out++ = static_cast<unsigned char>((value >> shift) & 0xFF);
+    return out;
 }
 
 void PacketSender::processNextPacketFromQueue() {
@@ -69,10 +143,17 @@ void PacketSender::processNextPacketFromQueue() {
         m_isSending = false;
         return;
     }
-    auto packetOptional = m_packetQueue.try_pop();
+    auto packetOptional = popScheduled();
     if (!packetOptional.has_value()) {
         m_isSending = false;
-        return;
+        // A producer may have pushed between the pop and clearing m_isSending.
+        if (!hasQueuedPackets() || m_isSending.exchange(true))
+            return;
+        packetOptional = popScheduled();
+        if (!packetOptional.has_value()) {
+            m_isSending = false;
+            return;
+        }
     }
     Packet packet = std::move(*packetOptional);
     m_currentDatagrams = splitPacket(packet);
@@ -93,9 +174,15 @@ void PacketSender::sendNextDatagram() {
         return;
     }
     auto& socket = m_socket->get();
+#if defined(__linux__)
+    if (m_segmentationOffload && m_currentDatagrams.size() - m_currentDatagramIndex > 1 && sendSegmentedTrain()) {
+        asio::post(socket.get_executor(), [this]() { sendNextDatagram(); });
+        return;
+    }
+#endif
     auto& datagram = m_currentDatagrams[m_currentDatagramIndex];
 
-    socket.async_send_to(asio::buffer(datagram), m_serverEndpoint,
+    socket.async_send_to(asio::buffer(datagram.data(), datagram.size()), m_serverEndpoint,
         [this](std::error_code errorCode, std::size_t bytesTransferred) {
             if (errorCode) {
                 LOG_ERROR("Media failed to send datagram chunk: {}", core::utilities::errorCodeForLog(errorCode));
@@ -110,35 +197,105 @@ void PacketSender::sendNextDatagram() {
         });
 }
 
-std::vector<std::vector<unsigned char>> PacketSender::splitPacket(const Packet& packetData) {
+#if defined(__linux__)
+// Sends the pending chunks of the current packet in one call. All but the last chunk are full
+// size, which is exactly the layout UDP_SEGMENT expects. False leaves the index untouched.
+bool PacketSender::sendSegmentedTrain() {
+#if defined(UDP_SEGMENT)
+    const std::size_t segmentSize = m_currentDatagrams[m_currentDatagramIndex].size();
+    const std::size_t maxSegments = std::min(m_maxSegmentsPerSend, m_maxSegmentedBytes / std::max<std::size_t>(segmentSize, 1));
+    std::array<iovec, m_maxSegmentsPerSend> iovecs{};
+    std::size_t count = 0;
+    while (m_currentDatagramIndex + count < m_currentDatagrams.size() && count < maxSegments) {
+        auto& datagram = m_currentDatagrams[m_currentDatagramIndex + count];
+        if (datagram.size() > segmentSize || datagram.empty()) {
+            break;
+        }
+        iovecs[count].iov_base = datagram.data();
+        iovecs[count].iov_len = datagram.size();
+        ++count;
+        if (datagram.size() < segmentSize) {
+            break;
+        }
+    }
+    if (count < 2) {
+        return false;
+    }
+
+    std::array<char, CMSG_SPACE(sizeof(uint16_t))> control{};
+    msghdr message{};
+    message.msg_name = m_serverEndpoint.data();
+    message.msg_namelen = static_cast<socklen_t>(m_serverEndpoint.size());
+    message.msg_iov = iovecs.data();
+    message.msg_iovlen = count;
+    message.msg_control = control.data();
+    message.msg_controllen = control.size();
+    cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    const uint16_t size = static_cast<uint16_t>(segmentSize);
+    std::memcpy(CMSG_DATA(cmsg), &size, sizeof(size));
+
+    if (::sendmsg(m_socket->get().native_handle(), &message, MSG_DONTWAIT) < 0) {
+        // EAGAIN: the async path waits for the socket. Anything else: no offload on this route.
+        if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            LOG_WARN("UDP segmentation offload rejected, sending chunks one by one: {}",
+                core::utilities::errorCodeForLog(std::error_code(errno, std::system_category())));
+            m_segmentationOffload = false;
+        }
+        return false;
+    }
+    m_currentDatagramIndex += count;
+    return true;
+#else
+    return false;
+#endif
+}
+#endif
+
+utilities::PooledBufferList PacketSender::splitPacket(const Packet& packetData) {
     const bool hasPayload = !packetData.data.empty();
     const std::size_t totalChunks = hasPayload
         ? static_cast<std::size_t>((packetData.data.size() + m_maxPayloadSize - 1) / m_maxPayloadSize)
         : 1U;
 
-    std::vector<std::vector<unsigned char>> packets;
+    utilities::PooledBufferList packets;
     packets.reserve(totalChunks);
 
-        for (std::size_t chunkIndex = 0; chunkIndex < totalChunks; ++chunkIndex) {
-            const std::size_t offset = chunkIndex * m_maxPayloadSize;
-            const std::size_t payloadSize = hasPayload
-                ? std::min(m_maxPayloadSize, packetData.data.size() - offset)
-                : 0U;
-
-        std::vector<unsigned char> datagram;
-        datagram.reserve(m_headerSize + payloadSize);
-
-            datagram.insert(datagram.end(), packetData.senderNicknameHash.begin(), packetData.senderNicknameHash.end());
-            writeUint64(datagram, packetData.id);
-            writeUint16(datagram, static_cast<uint16_t>(chunkIndex));
-            writeUint16(datagram, static_cast<uint16_t>(totalChunks));
-            writeUint16(datagram, static_cast<uint16_t>(payloadSize));
-            writeUint32(datagram, static_cast<uint32_t>(packetData.type));
-
-            if (payloadSize > 0) {
-            datagram.insert(datagram.end(),
-                packetData.data.begin() + static_cast<std::ptrdiff_t>(offset),
-                packetData.data.begin() + static_cast<std::ptrdiff_t>(offset + payloadSize));
+    for (std::size_t chunkIndex = 0; chunkIndex < totalChunks; ++chunkIndex) {
+        const std::size_t offset = chunkIndex * m_maxPayloadSize;
+        const std::size_t payloadSize = hasPayload
+            ? std::min(m_maxPayloadSize, packetData.data.size() - offset)
+            : 0U;
+
+        const bool compact = packetData.senderSessionId != 0;
+        auto datagram = utilities::BufferPool::shared().acquire(
+            (compact ? constant::kCompactChunkHeaderSize : m_headerSize) + payloadSize);
+        unsigned char* out = datagram.data();
+
+        if (compact) {
+            *out++ = constant::kCompactChunkHeaderMarker;
+            *out++ = constant::kWireVersion2;
+            out = writeUint32(out, packetData.senderSessionId);
+            out = writeUint32(out, static_cast<uint32_t>(packetData.id));
+            out = writeUint16(out, static_cast<uint16_t>(chunkIndex));
+            out = writeUint16(out, static_cast<uint16_t>(totalChunks));
+            out = writeUint16(out, static_cast<uint16_t>(payloadSize));
+            out = writeUint16(out, static_cast<uint16_t>(packetData.type));
+        }
+        else {
+            std::memcpy(out, packetData.senderNicknameHash.data(), packetData.senderNicknameHash.size());
+            out += packetData.senderNicknameHash.size();
+            out = writeUint64(out, packetData.id);
+            out = writeUint16(out, static_cast<uint16_t>(chunkIndex));
+            out = writeUint16(out, static_cast<uint16_t>(totalChunks));
+            out = writeUint16(out, static_cast<uint16_t>(payloadSize));
+            out = writeUint32(out, static_cast<uint32_t>(packetData.type));
+        }
+
+        if (payloadSize > 0) {
+            std::memcpy(out, packetData.data.data() + offset, payloadSize);
         }
         packets.push_back(std::move(datagram));
     }
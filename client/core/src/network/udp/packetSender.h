@@ -6,7 +6,8 @@
 #include <vector>
 
 #include "network/udp/packet.h"
-#include "utilities/safeQueue.h"
+#include "utilities/bufferPool.h"
+#include "utilities/ringBuffer.h"
 #include "asio.hpp"
 
 namespace core::network::udp {
@@ -18,27 +19,62 @@ public:
 
     void initialize(asio::ip::udp::socket& socket, asio::ip::udp::endpoint remoteEndpoint);
     void send(const Packet& packet);
+    void send(Packet&& packet);
     void stop();
 
 private:
+    // Voice is always served first, then control traffic; camera and screen share
+    // split the remaining capacity by weight so neither starves the other.
+    enum class EgressClass {
+        Voice,
+        Control,
+        Camera,
+        Screen
+    };
+
+    static EgressClass classify(uint32_t type);
+    std::optional<Packet> popScheduled();
+    bool hasQueuedPackets() const;
+    void clearQueues();
     void startSendingIfIdle();
     void sendNextDatagram();
     void processNextPacketFromQueue();
-    std::vector<std::vector<unsigned char>> splitPacket(const Packet& packetData);
-    void writeUint16(std::vector<unsigned char>& buffer, uint16_t value);
-    void writeUint32(std::vector<unsigned char>& buffer, uint32_t value);
-    void writeUint64(std::vector<unsigned char>& buffer, uint64_t value);
+#if defined(__linux__)
+    bool sendSegmentedTrain();
+#endif
+    utilities::PooledBufferList splitPacket(const Packet& packetData);
+    unsigned char* writeUint16(unsigned char* out, uint16_t value);
+    unsigned char* writeUint32(unsigned char* out, uint32_t value);
+    unsigned char* writeUint64(unsigned char* out, uint64_t value);
 
 private:
-    core::utilities::SafeQueue<Packet> m_packetQueue;
+    // Fed by the audio and video capture threads. Full voice/control queues evict their oldest
+    // packet; full video queues drop the new frame, so a screen-share burst never evicts voice.
+    core::utilities::MpscRingBuffer<Packet> m_voiceQueue{ m_maxVoiceQueueSize };
+    core::utilities::MpscRingBuffer<Packet> m_controlQueue{ m_maxControlQueueSize };
+    core::utilities::MpscRingBuffer<Packet> m_cameraQueue{ m_maxVideoQueueSize };
+    core::utilities::MpscRingBuffer<Packet> m_screenQueue{ m_maxVideoQueueSize };
     std::atomic<bool> m_isSending;
+    // Position in the camera/screen weighted round robin; only touched by the sending thread.
+    std::size_t m_videoTurn;
     asio::ip::udp::endpoint m_serverEndpoint;
     std::optional<std::reference_wrapper<asio::ip::udp::socket>> m_socket;
-    std::vector<std::vector<unsigned char>> m_currentDatagrams;
+    utilities::PooledBufferList m_currentDatagrams;
     std::size_t m_currentDatagramIndex;
     const std::size_t m_maxPayloadSize = 1300;
     const std::size_t m_headerSize = 50;  // 32 (senderNicknameHash) + 18 (packetId, chunkIndex, etc.)
-    static constexpr std::size_t m_maxPacketQueueSize = 256;  // ~2-5 sec buffer at 50-100 pkt/s
+    static constexpr std::size_t m_maxVoiceQueueSize = 128;    // ~2.5 sec of 20 ms frames
+    static constexpr std::size_t m_maxControlQueueSize = 64;
+    static constexpr std::size_t m_maxVideoQueueSize = 64;     // ~2 sec at 30 fps per video class
+    static constexpr std::size_t m_cameraWeight = 2;
+    static constexpr std::size_t m_screenWeight = 1;
+#if defined(__linux__)
+    // A keyframe's chunks go out as one UDP_SEGMENT send when the kernel supports it; cleared
+    // for good once the kernel or NIC rejects one. Limits are UDP_MAX_SEGMENTS and 64 KB.
+    bool m_segmentationOffload = false;
+    static constexpr std::size_t m_maxSegmentsPerSend = 64;
+    static constexpr std::size_t m_maxSegmentedBytes = 65000;
+#endif
 };
 
 }
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace core
+{
+    namespace utilities
+    {
+        class PooledBuffer;
+
+        /// Size-classed free lists of byte blocks shared by the media path (receive, fan-out, send).
+        /// A block goes back to its class when its last PooledBuffer is released, so once the lists
+        /// are warm, forwarding reuses the same blocks: acquisitions keep growing, heap allocations
+        /// stay flat. Requests larger than the biggest class go to the heap and are counted as well.
+        class BufferPool {
+        public:
+            BufferPool() = default;
+            ~BufferPool();
+
+            BufferPool(const BufferPool&) = delete;
+            BufferPool& operator=(const BufferPool&) = delete;
+
+            /// Process-wide pool. Never destroyed, since handles owned by other statics may outlive it.
+            static BufferPool& shared();
+
+            /// A buffer of exactly size bytes; the contents are uninitialized.
+            PooledBuffer acquire(std::size_t size);
+
+            /// Raw storage for PoolAllocator, from the same classes and counted the same way.
+            void* allocate(std::size_t bytes);
+            void deallocate(void* data) noexcept;
+
+            uint64_t getAcquisitions() const { return m_acquisitions.load(std::memory_order_relaxed); }
+            uint64_t getHeapAllocations() const { return m_heapAllocations.load(std::memory_order_relaxed); }
+
+        private:
+            friend class PooledBuffer;
+
+            struct alignas(std::max_align_t) Block {
+                std::atomic<uint32_t> references{ 0 };
+                std::size_t size = 0;
+                std::size_t capacity = 0;
+                std::size_t sizeClass = 0;
+                BufferPool* owner = nullptr;
+                Block* next = nullptr;
+
+                unsigned char* data() { return reinterpret_cast<unsigned char*>(this + 1); }
+            };
+
+            struct FreeList {
+                std::mutex mutex;
+                Block* head = nullptr;
+                std::size_t count = 0;
+            };
+
+            // Control payloads, voice frames, one wire datagram, then whole reassembled frames.
+            static constexpr std::array<std::size_t, 6> m_classSizes{ 64, 256, 2048, 16384, 131072, 1048576 };
+            // Idle blocks kept per class; releases beyond this go back to the heap.
+            static constexpr std::size_t m_maxFreeBytesPerClass = 16 * 1024 * 1024;
+
+            Block* take(std::size_t bytes);
+            void release(Block* block) noexcept;
+            static std::size_t classFor(std::size_t bytes);
+
+            std::array<FreeList, m_classSizes.size()> m_freeLists;
+            std::atomic<uint64_t> m_acquisitions{ 0 };
+            std::atomic<uint64_t> m_heapAllocations{ 0 };
+        };
+
+        /// Reference-counted handle to a pooled block. Copies share the bytes, so a datagram fanned
+        /// out to many receivers or kept by the replay caches is never duplicated.
+        /// The bytes are written only while building, before the handle is shared.
+        class PooledBuffer {
+        public:
+            PooledBuffer() = default;
+            PooledBuffer(const PooledBuffer& other) noexcept : m_block(other.m_block) { retain(); }
+            PooledBuffer(PooledBuffer&& other) noexcept : m_block(std::exchange(other.m_block, nullptr)) {}
+            ~PooledBuffer() { reset(); }
+
+            PooledBuffer& operator=(const PooledBuffer& other) noexcept {
+                if (this != &other) {
+                    reset();
+                    m_block = other.m_block;
+                    retain();
+                }
+                return *this;
+            }
+
+            PooledBuffer& operator=(PooledBuffer&& other) noexcept {
+                if (this != &other) {
+                    reset();
+                    m_block = std::exchange(other.m_block, nullptr);
+                }
+                return *this;
+            }
+
+            unsigned char* data() noexcept { return m_block ? m_block->data() : nullptr; }
+            const unsigned char* data() const noexcept { return m_block ? m_block->data() : nullptr; }
+            std::size_t size() const noexcept { return m_block ? m_block->size : 0; }
+            std::size_t capacity() const noexcept { return m_block ? m_block->capacity : 0; }
+            bool empty() const noexcept { return size() == 0; }
+            explicit operator bool() const noexcept { return m_block != nullptr; }
+
+            const unsigned char* begin() const noexcept { return data(); }
+            const unsigned char* end() const noexcept { return data() + size(); }
+            unsigned char operator[](std::size_t index) const noexcept { return data()[index]; }
+
+            /// Shrinks or grows within the block's capacity.
+            void resize(std::size_t size) noexcept {
+                if (m_block) {
+                    m_block->size = std::min(size, m_block->capacity);
+                }
+            }
+
+            void reset() noexcept {
+                if (m_block && m_block->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    m_block->owner->release(m_block);
+                }
+                m_block = nullptr;
+            }
+
+        private:
+            friend class BufferPool;
+
+            explicit PooledBuffer(BufferPool::Block* block) noexcept : m_block(block) {}
+
+            void retain() noexcept {
+                if (m_block) {
+                    m_block->references.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+
+            BufferPool::Block* m_block = nullptr;
+        };
+
+        /// Routes container storage (handle arrays, shared_ptr control blocks) through the shared pool.
+        template<typename T>
+        struct PoolAllocator {
+            using value_type = T;
+
+            PoolAllocator() noexcept = default;
+            template<typename U>
+            PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+            T* allocate(std::size_t count) {
+                static_assert(alignof(T) <= alignof(std::max_align_t), "PoolAllocator cannot over-align");
+                return static_cast<T*>(BufferPool::shared().allocate(count * sizeof(T)));
+            }
+
+            void deallocate(T* pointer, std::size_t) noexcept {
+                BufferPool::shared().deallocate(pointer);
+            }
+
+            template<typename U>
+            bool operator==(const PoolAllocator<U>&) const noexcept { return true; }
+        };
+
+        using PooledBufferList = std::vector<PooledBuffer, PoolAllocator<PooledBuffer>>;
+
+        inline BufferPool::~BufferPool() {
+            for (auto& list : m_freeLists) {
+                while (list.head) {
+                    Block* block = std::exchange(list.head, list.head->next);
+                    block->~Block();
+                    ::operator delete(block);
+                }
+            }
+        }
+
+        inline BufferPool& BufferPool::shared() {
+            static BufferPool* pool = new BufferPool();
+            return *pool;
+        }
+
+        inline PooledBuffer BufferPool::acquire(std::size_t size) {
+            Block* block = take(size);
+            block->references.store(1, std::memory_order_relaxed);
+            block->size = size;
+            return PooledBuffer(block);
+        }
+
+        inline void* BufferPool::allocate(std::size_t bytes) {
+            return take(bytes)->data();
+        }
+
+        inline void BufferPool::deallocate(void* data) noexcept {
+            if (!data) {
+                return;
+            }
+            Block* block = reinterpret_cast<Block*>(static_cast<unsigned char*>(data)) - 1;
+            block->owner->release(block);
+        }
+
+        inline std::size_t BufferPool::classFor(std::size_t bytes) {
+            for (std::size_t i = 0; i < m_classSizes.size(); ++i) {
+                if (bytes <= m_classSizes[i]) {
+                    return i;
+                }
+            }
+            return m_classSizes.size();
+        }
+
+        inline BufferPool::Block* BufferPool::take(std::size_t bytes) {
+            m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+
+            const std::size_t sizeClass = classFor(bytes);
+            if (sizeClass < m_classSizes.size()) {
+                FreeList& list = m_freeLists[sizeClass];
+                std::lock_guard<std::mutex> lock(list.mutex);
+                if (list.head) {
+                    --list.count;
+                    return std::exchange(list.head, list.head->next);
+                }
+            }
+
+            m_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+            const std::size_t capacity = sizeClass < m_classSizes.size() ? m_classSizes[sizeClass] : bytes;
+            Block* block = new (::operator new(sizeof(Block) + capacity)) Block();
+            block->capacity = capacity;
+            block->sizeClass = sizeClass;
+            block->owner = this;
+            return block;
+        }
+
+        inline void BufferPool::release(Block* block) noexcept {
+            if (block->sizeClass < m_classSizes.size()) {
+                FreeList& list = m_freeLists[block->sizeClass];
+                std::lock_guard<std::mutex> lock(list.mutex);
+                if ((list.count + 1) * block->capacity <= m_maxFreeBytesPerClass) {
+                    block->next = list.head;
+                    list.head = block;
+                    ++list.count;
+                    return;
+                }
+            }
+            block->~Block();
+            ::operator delete(block);
+        }
+    }
+}
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace core
+{
+    namespace utilities
+    {
+        /// Bounded lock-free ring buffer (per-slot sequence numbers, Vyukov style).
+        /// Full buffer: push evicts the oldest item, so the producer never blocks and media keeps the latest.
+        /// Because the producer may evict, the consumer side is always CAS-based and safe for several
+        /// consumers; MultiProducer only selects whether the producer side needs CAS as well.
+        /// Blocking pops only take the mutex when the buffer is empty and someone actually sleeps.
+        template<typename T, bool MultiProducer>
+        class RingBuffer {
+        public:
+            explicit RingBuffer(std::size_t capacity)
+                : m_capacity(roundUpToPowerOfTwo(capacity < 2 ? 2 : capacity))
+                , m_mask(m_capacity - 1)
+                , m_slots(std::make_unique<Slot[]>(m_capacity))
+            {
+                for (std::size_t i = 0; i < m_capacity; ++i) {
+                    m_slots[i].sequence.store(i, std::memory_order_relaxed);
+                }
+            }
+
+            RingBuffer(const RingBuffer&) = delete;
+            RingBuffer& operator=(const RingBuffer&) = delete;
+
+            /// Returns false when the buffer is full.
+            bool try_push(T&& item) {
+                std::size_t position = m_tail.load(std::memory_order_relaxed);
+                while (true) {
+                    Slot& slot = m_slots[position & m_mask];
+                    const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                    const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position);
+                    if (diff == 0) {
+                        if constexpr (MultiProducer) {
+                            if (!m_tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                                continue;
+                            }
+                        }
+                        else {
+                            m_tail.store(position + 1, std::memory_order_relaxed);
+                        }
+                        slot.value = std::move(item);
+                        slot.sequence.store(position + 1, std::memory_order_release);
+                        wakeConsumer();
+                        return true;
+                    }
+                    if (diff < 0) {
+                        return false;
+                    }
+                    position = m_tail.load(std::memory_order_relaxed);
+                }
+            }
+
+            /// Pushes item, evicting the oldest ones while the buffer is full. Returns how many were dropped.
+            std::size_t push_drop_oldest(T&& item) {
+                std::size_t dropped = 0;
+                while (!try_push(std::move(item))) {
+                    if (try_pop().has_value()) {
+                        ++dropped;
+                    }
+                }
+                if (dropped != 0) {
+                    m_dropped.fetch_add(dropped, std::memory_order_relaxed);
+                }
+                return dropped;
+            }
+
+            std::size_t push_drop_oldest(const T& item) {
+                T copy = item;
+                return push_drop_oldest(std::move(copy));
+            }
+
+            std::optional<T> try_pop() {
+                std::size_t position = m_head.load(std::memory_order_relaxed);
+                while (true) {
+                    Slot& slot = m_slots[position & m_mask];
+                    const std::size_t sequence = slot.sequence.load(std::memory_order_acquire);
+                    const auto diff = static_cast<std::intptr_t>(sequence) - static_cast<std::intptr_t>(position + 1);
+                    if (diff == 0) {
+                        if (!m_head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                            continue;
+                        }
+                        std::optional<T> item(std::move(slot.value));
+                        slot.value = T{};
+                        slot.sequence.store(position + m_capacity, std::memory_order_release);
+                        return item;
+                    }
+                    if (diff < 0) {
+                        return std::nullopt;
+                    }
+                    position = m_head.load(std::memory_order_relaxed);
+                }
+            }
+
+            /// Appends up to maxItems items to out; returns how many were taken.
+            std::size_t pop_batch(std::vector<T>& out, std::size_t maxItems) {
+                std::size_t taken = 0;
+                while (taken < maxItems) {
+                    auto item = try_pop();
+                    if (!item.has_value()) {
+                        break;
+                    }
+                    out.push_back(std::move(*item));
+                    ++taken;
+                }
+                return taken;
+            }
+
+            /// Like pop_batch, but sleeps up to timeout while the buffer is empty.
+            template<typename Rep, typename Period>
+            std::size_t pop_batch_for(std::vector<T>& out, std::size_t maxItems, const std::chrono::duration<Rep, Period>& timeout) {
+                std::size_t taken = pop_batch(out, maxItems);
+                if (taken != 0) {
+                    return taken;
+                }
+                waitNotEmpty(timeout);
+                return pop_batch(out, maxItems);
+            }
+
+            template<typename Rep, typename Period>
+            std::optional<T> pop_for(const std::chrono::duration<Rep, Period>& timeout) {
+                auto item = try_pop();
+                if (item.has_value()) {
+                    return item;
+                }
+                waitNotEmpty(timeout);
+                return try_pop();
+            }
+
+            bool empty() const {
+                return size() == 0;
+            }
+
+            /// Approximate while producers and consumers are running.
+            std::size_t size() const {
+                const std::size_t tail = m_tail.load(std::memory_order_acquire);
+                const std::size_t head = m_head.load(std::memory_order_acquire);
+                return tail > head ? tail - head : 0;
+            }
+
+            std::size_t capacity() const {
+                return m_capacity;
+            }
+
+            std::size_t dropped() const {
+                return m_dropped.load(std::memory_order_relaxed);
+            }
+
+            void clear() {
+                while (try_pop().has_value()) {
+                }
+            }
+
+        private:
+            struct Slot {
+                std::atomic<std::size_t> sequence{ 0 };
+                T value{};
+            };
+
+            static std::size_t roundUpToPowerOfTwo(std::size_t value) {
+                std::size_t result = 1;
+                while (result < value) {
+                    result <<= 1;
+                }
+                return result;
+            }
+
+            void wakeConsumer() {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_waiters.load(std::memory_order_relaxed) != 0) {
+                    { std::lock_guard<std::mutex> lock(m_waitMutex); }
+                    m_waitCondition.notify_one();
+                }
+            }
+
+            template<typename Rep, typename Period>
+            void waitNotEmpty(const std::chrono::duration<Rep, Period>& timeout) {
+                std::unique_lock<std::mutex> lock(m_waitMutex);
+                m_waiters.fetch_add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                m_waitCondition.wait_for(lock, timeout, [this]() { return !empty(); });
+                m_waiters.fetch_sub(1, std::memory_order_relaxed);
+            }
+
+        private:
+            const std::size_t m_capacity;
+            const std::size_t m_mask;
+            std::unique_ptr<Slot[]> m_slots;
+
+            alignas(64) std::atomic<std::size_t> m_head{ 0 };
+            alignas(64) std::atomic<std::size_t> m_tail{ 0 };
+            alignas(64) std::atomic<std::size_t> m_dropped{ 0 };
+            std::atomic<uint32_t> m_waiters{ 0 };
+
+            std::mutex m_waitMutex;
+            std::condition_variable m_waitCondition;
+        };
+
+        template<typename T>
+        using SpscRingBuffer = RingBuffer<T, false>;
+
+        template<typename T>
+        using MpscRingBuffer = RingBuffer<T, true>;
+    }
+}
@@ -491,6 +491,15 @@ void CoreEventListener::onMeetingParticipantSpeaking(const std::string& nickname
     }
 }
 
+void CoreEventListener::onMeetingDominantSpeakerChanged(const std::string& nickname)
+{
+    if (m_meetingManager) {
+        QMetaObject::invokeMethod(m_meetingManager, "onMeetingDominantSpeakerChanged",
+            Qt::QueuedConnection,
+            Q_ARG(QString, QString::fromStdString(nickname)));
+    }
+}
+
 void CoreEventListener::onMeetingParticipantMuted(const std::string& nickname, bool muted)
 {
     if (m_meetingManager) {
@@ -71,6 +71,7 @@ public:
     void onMeetingParticipantConnectionDown(const std::string& nickname) override;
     void onMeetingParticipantConnectionRestored(const std::string& nickname) override;
     void onMeetingParticipantSpeaking(const std::string& nickname, bool speaking) override;
+    void onMeetingDominantSpeakerChanged(const std::string& nickname) override;
     void onMeetingParticipantMuted(const std::string& nickname, bool muted) override;
     void onMeetingRosterResynced(const std::vector<std::string>& participants) override;
 
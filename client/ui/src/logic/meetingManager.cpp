@@ -370,6 +370,20 @@ void MeetingManager::onDeclineJoinMeetingRequestClicked(const QString& friendNic
     }
 }
 
+void MeetingManager::onVideoPinsChanged(const QStringList& pinnedNicknames)
+{
+    if (!m_coreClient) return;
+    std::vector<std::string> nicknames;
+    nicknames.reserve(pinnedNicknames.size());
+    for (const QString& nickname : pinnedNicknames) {
+        nicknames.push_back(nickname.toStdString());
+    }
+    std::error_code ec = m_coreClient->setMeetingVideoPins(nicknames);
+    if (ec && m_notificationController) {
+        m_notificationController->showErrorNotification("Failed to update pinned participants", 2000);
+    }
+}
+
 void MeetingManager::onMeetingJoinRequestReceived(const QString& friendNickname)
 {
     if (m_meetingWidget) {
@@ -719,6 +733,13 @@ void MeetingManager::onMeetingParticipantSpeaking(const QString& nickname, bool
     }
 }
 
+void MeetingManager::onMeetingDominantSpeakerChanged(const QString& nickname)
+{
+    if (m_meetingWidget) {
+        m_meetingWidget->setDominantSpeaker(nickname);
+    }
+}
+
 void MeetingManager::onMeetingParticipantMuted(const QString& nickname, bool muted)
 {
     if (!m_meetingWidget) {
@@ -49,6 +49,7 @@ public slots:
     void onCancelMeetingJoinRequested();
     void onAcceptJoinMeetingRequestClicked(const QString& friendNickname);
     void onDeclineJoinMeetingRequestClicked(const QString& friendNickname);
+    void onVideoPinsChanged(const QStringList& pinnedNicknames);
 
     void onMeetingJoinRequestReceived(const QString& friendNickname);
     void onMeetingJoinRequestCancelled(const QString& friendNickname);
@@ -73,6 +74,7 @@ public slots:
     void onIncomingScreenSharingStarted(const QString& sharerNickname);
     void onIncomingScreenSharingStopped(const QString& sharerNickname);
     void onMeetingParticipantSpeaking(const QString& nickname, bool speaking);
+    void onMeetingDominantSpeakerChanged(const QString& nickname);
     void onMeetingParticipantMuted(const QString& nickname, bool muted);
     void onIncomingCameraSharingStarted(const QString& nickname);
     void onIncomingCameraSharingStopped(const QString& nickname);
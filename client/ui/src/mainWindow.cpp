@@ -395,6 +395,7 @@ void MainWindow::connectWidgetsToManagers() {
     if (m_meetingWidget && m_meetingManager) {
         connect(m_meetingWidget, &MeetingWidget::joinRequestAccepted, m_meetingManager, &MeetingManager::onAcceptJoinMeetingRequestClicked);
         connect(m_meetingWidget, &MeetingWidget::joinRequestDeclined, m_meetingManager, &MeetingManager::onDeclineJoinMeetingRequestClicked);
+        connect(m_meetingWidget, &MeetingWidget::videoPinsChanged, m_meetingManager, &MeetingManager::onVideoPinsChanged);
     }
 
     // Create meeting: only call core; switch to meeting widget when core reports success (meetingCreated)
@@ -3,6 +3,7 @@
 #include "constants/color.h"
 
 #include <QFont>
+#include <QMouseEvent>
 #include <QPainter>
 #include <QVBoxLayout>
 
@@ -347,6 +348,22 @@ void MeetingParticipantWidget::paintEvent(QPaintEvent* event)
         painter.drawRoundedRect(rect().adjusted(1, 1, -1, -1), 11, 11);
     }
 
+    if (m_pinned) {
+        painter.setPen(QPen(QColor(255, 255, 255, 200), 2, Qt::DashLine));
+        painter.setBrush(Qt::NoBrush);
+        painter.drawRoundedRect(rect().adjusted(4, 4, -4, -4), 9, 9);
+    }
+
     painter.setBrush(Qt::NoBrush);
     QWidget::paintEvent(event);
 }
+
+void MeetingParticipantWidget::mouseDoubleClickEvent(QMouseEvent* event)
+{
+    if (event->button() == Qt::LeftButton) {
+        emit pinToggleRequested();
+        event->accept();
+        return;
+    }
+    QWidget::mouseDoubleClickEvent(event);
+}
@@ -37,9 +37,15 @@ public:
     void setSpeaking(bool speaking);
     void setScreenSharing(bool sharing) { m_screenSharing = sharing; update(); }
     void setConnectionDown(bool down);
+    void setPinned(bool pinned) { m_pinned = pinned; update(); }
+    bool isPinned() const { return m_pinned; }
+
+signals:
+    void pinToggleRequested();
 
 protected:
     void paintEvent(QPaintEvent* event) override;
+    void mouseDoubleClickEvent(QMouseEvent* event) override;
 
 private:
     void setupUI();
@@ -53,6 +59,7 @@ private:
     bool m_cameraEnabled = false;
     bool m_compactMode = false;
     bool m_connectionDown = false;
+    bool m_pinned = false;
 
     DisplayMode m_displayMode = DisplayMode::DisplayName;
 
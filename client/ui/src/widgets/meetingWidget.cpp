@@ -1079,6 +1079,7 @@ void MeetingWidget::addParticipant(const QString& nickname) {
 
     MeetingParticipantWidget* participantWidget = new MeetingParticipantWidget(nickname, m_participantsContainer);
     m_participantWidgets[nickname] = participantWidget;
+    connect(participantWidget, &MeetingParticipantWidget::pinToggleRequested, this, [this, nickname]() { toggleParticipantPinned(nickname); });
 
     updateParticipantPanels();
     updateParticipantsContainerSize();
@@ -1100,6 +1101,8 @@ void MeetingWidget::removeParticipant(const QString& nickname) {
         
         widget->deleteLater();
         m_participantWidgets.remove(nickname);
+        // The server drops pins of participants that left on its own.
+        m_pinnedNicknames.removeAll(nickname);
 
         updateParticipantPanels();
         updateParticipantsContainerSize();
@@ -1144,6 +1147,32 @@ void MeetingWidget::setParticipantSpeaking(const QString& nickname, bool speakin
     }
 }
 
+void MeetingWidget::setDominantSpeaker(const QString& nickname) {
+    if (m_dominantSpeakerNickname == nickname) {
+        return;
+    }
+    m_dominantSpeakerNickname = nickname;
+    updateParticipantPanels();
+}
+
+void MeetingWidget::toggleParticipantPinned(const QString& nickname) {
+    MeetingParticipantWidget* widget = m_participantWidgets.value(nickname, nullptr);
+    if (!widget || nickname == m_localParticipantNickname) {
+        return;
+    }
+
+    const bool pinned = !m_pinnedNicknames.contains(nickname);
+    if (pinned) {
+        m_pinnedNicknames.append(nickname);
+    }
+    else {
+        m_pinnedNicknames.removeAll(nickname);
+    }
+    widget->setPinned(pinned);
+    updateParticipantPanels();
+    emit videoPinsChanged(m_pinnedNicknames);
+}
+
 void MeetingWidget::setParticipantScreenSharing(const QString& nickname, bool sharing) {
     if (m_participantWidgets.contains(nickname)) {
         m_participantWidgets[nickname]->setScreenSharing(sharing);
@@ -1168,6 +1197,8 @@ void MeetingWidget::clearParticipants() {
     }
     m_participantWidgets.clear();
     m_localParticipantNickname.clear();
+    m_dominantSpeakerNickname.clear();
+    m_pinnedNicknames.clear();
     
     for (QWidget* panel : m_participantPanels) {
         panel->deleteLater();
@@ -1642,6 +1673,17 @@ void MeetingWidget::updateParticipantPanels() {
     int widgetHeight = isMainScreenVisible ? scale(135) : scale(180);
 
     QList<MeetingParticipantWidget*> widgetsList = m_participantWidgets.values();
+    // Keep pinned participants and the dominant speaker on the first page.
+    for (auto it = m_pinnedNicknames.crbegin(); it != m_pinnedNicknames.crend(); ++it) {
+        if (MeetingParticipantWidget* pinned = m_participantWidgets.value(*it, nullptr)) {
+            widgetsList.removeOne(pinned);
+            widgetsList.prepend(pinned);
+        }
+    }
+    if (MeetingParticipantWidget* dominant = m_participantWidgets.value(m_dominantSpeakerNickname, nullptr)) {
+        widgetsList.removeOne(dominant);
+        widgetsList.prepend(dominant);
+    }
     int widgetIndex = 0;
     
     for (MeetingParticipantWidget* widget : widgetsList) {
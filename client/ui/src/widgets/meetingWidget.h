@@ -106,6 +106,8 @@ public:
     void clearParticipantVideo(const QString& nickname);
     void setParticipantMuted(const QString& nickname, bool muted);
     void setParticipantSpeaking(const QString& nickname, bool speaking);
+    void setDominantSpeaker(const QString& nickname);
+    void toggleParticipantPinned(const QString& nickname);
     void setParticipantScreenSharing(const QString& nickname, bool sharing);
     void setParticipantCameraEnabled(const QString& nickname, bool enabled);
     void setParticipantConnectionDown(const QString& nickname, bool down);
@@ -145,6 +147,7 @@ signals:
     void cameraClicked(bool toggled);
     void joinRequestAccepted(const QString& nickname);
     void joinRequestDeclined(const QString& nickname);
+    void videoPinsChanged(const QStringList& pinnedNicknames);
 
 protected:
     void paintEvent(QPaintEvent* event) override;
@@ -248,6 +251,8 @@ private:
 
     QString m_callName;
     QString m_localParticipantNickname;
+    QString m_dominantSpeakerNickname;
+    QStringList m_pinnedNicknames;
     QMap<QString, MeetingParticipantWidget*> m_participantWidgets;
     bool m_isOwner = true;
 
@@ -0,0 +1,122 @@
+#include "loadConfig.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+namespace loadGenerator
+{
+    namespace
+    {
+        uint64_t parseNumber(const std::string& option, const std::string& text, uint64_t min, uint64_t max) {
+            std::size_t consumed = 0;
+            uint64_t value = 0;
+            try {
+                value = std::stoull(text, &consumed);
+            }
+            catch (const std::exception&) {
+                consumed = 0;
+            }
+            if (consumed != text.size() || text.empty() || text[0] == '-' || value < min || value > max) {
+                throw std::invalid_argument(option + " expects a number from " + std::to_string(min) + " to " + std::to_string(max));
+            }
+            return value;
+        }
+
+        MediaProfile parseProfile(const std::string& text) {
+            if (text == "audio") return MediaProfile::Audio;
+            if (text == "video") return MediaProfile::Video;
+            if (text == "presentation") return MediaProfile::Presentation;
+            throw std::invalid_argument("--profile expects audio, video or presentation");
+        }
+    }
+
+    const char* profileToString(MediaProfile profile) {
+        switch (profile) {
+        case MediaProfile::Audio: return "audio";
+        case MediaProfile::Video: return "video";
+        case MediaProfile::Presentation: return "presentation";
+        default: return "unknown";
+        }
+    }
+
+    void printUsage(std::ostream& out) {
+        out <<
+            "Usage: calliforniaLoadGenerator [options]\n"
+            "\n"
+            "Drives calliforniaServer with simulated meetings and reports forwarding latency,\n"
+            "loss and server CPU.\n"
+            "\n"
+            "  --host ADDRESS             server address (127.0.0.1)\n"
+            "  --tcp-port PORT            control port (8081)\n"
+            "  --udp-port PORT            media port (8081)\n"
+            "  --meetings N               simulated meetings (10)\n"
+            "  --participants N           participants per meeting, owner included (8)\n"
+            "  --last-n N                 camera senders each receiver gets (9)\n"
+            "  --profile NAME             audio, video or presentation (video)\n"
+            "  --voice-kbps N             voice bitrate per participant (32)\n"
+            "  --camera-kbps N            top camera layer bitrate (600)\n"
+            "  --camera-fps N             camera frame rate (30)\n"
+            "  --camera-layers N          simulcast layers, each a quarter of the next (3)\n"
+            "  --screen-kbps N            screen share bitrate (1500)\n"
+            "  --screen-fps N             screen share frame rate (10)\n"
+            "  --keyframe-interval MS     video keyframe interval (2000)\n"
+            "  --ramp SECONDS             spread client logins over this long (10)\n"
+            "  --warmup SECONDS           media sent before measuring starts (5)\n"
+            "  --duration SECONDS         measured time (60)\n"
+            "  --threads N                media threads, 0 = one per hardware thread (0)\n"
+            "  --server-pid PID           server process to sample CPU from (found by name)\n"
+            "  --json                     print the report as JSON\n"
+            "  --help                     show this text\n";
+    }
+
+    std::optional<LoadConfig> parseArguments(int argc, char** argv, std::string& error) {
+        LoadConfig config;
+        try {
+            for (int i = 1; i < argc; ++i) {
+                const std::string option = argv[i];
+                if (option == "--help" || option == "-h") {
+                    return std::nullopt;
+                }
+                if (option == "--json") {
+                    config.json = true;
+                    continue;
+                }
+                if (i + 1 >= argc) {
+                    throw std::invalid_argument(option + " needs a value");
+                }
+                const std::string value = argv[++i];
+
+                if (option == "--host") config.host = value;
+                else if (option == "--tcp-port") config.tcpPort = static_cast<uint16_t>(parseNumber(option, value, 1, 65535));
+                else if (option == "--udp-port") config.udpPort = static_cast<uint16_t>(parseNumber(option, value, 1, 65535));
+                else if (option == "--meetings") config.meetings = parseNumber(option, value, 1, 100000);
+                else if (option == "--participants") config.participants = parseNumber(option, value, 2, 1000);
+                else if (option == "--last-n") config.lastN = parseNumber(option, value, 0, 25);
+                else if (option == "--profile") config.profile = parseProfile(value);
+                else if (option == "--voice-kbps") config.voiceKbps = static_cast<uint32_t>(parseNumber(option, value, 1, 512));
+                else if (option == "--camera-kbps") config.cameraKbps = static_cast<uint32_t>(parseNumber(option, value, 1, 20000));
+                else if (option == "--camera-fps") config.cameraFps = static_cast<uint32_t>(parseNumber(option, value, 1, 120));
+                else if (option == "--camera-layers") config.cameraLayers = static_cast<uint32_t>(parseNumber(option, value, 1, 3));
+                else if (option == "--screen-kbps") config.screenKbps = static_cast<uint32_t>(parseNumber(option, value, 1, 20000));
+                else if (option == "--screen-fps") config.screenFps = static_cast<uint32_t>(parseNumber(option, value, 1, 60));
+                else if (option == "--keyframe-interval") config.keyframeIntervalMs = static_cast<uint32_t>(parseNumber(option, value, 100, 60000));
+                else if (option == "--ramp") config.ramp = std::chrono::seconds(parseNumber(option, value, 0, 3600));
+                else if (option == "--warmup") config.warmup = std::chrono::seconds(parseNumber(option, value, 0, 3600));
+                else if (option == "--duration") config.duration = std::chrono::seconds(parseNumber(option, value, 1, 86400));
+                else if (option == "--threads") config.threads = parseNumber(option, value, 0, 256);
+                else if (option == "--server-pid") config.serverPid = static_cast<int>(parseNumber(option, value, 1, 4194304));
+                else throw std::invalid_argument("Unknown option " + option);
+            }
+        }
+        catch (const std::exception& e) {
+            error = e.what();
+            return std::nullopt;
+        }
+
+        if (config.threads == 0) {
+            config.threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        return config;
+    }
+}
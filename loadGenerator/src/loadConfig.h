@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+
+namespace loadGenerator
+{
+    // What every participant of a simulated meeting sends.
+    enum class MediaProfile {
+        Audio,          // voice only
+        Video,          // voice and camera
+        Presentation    // voice and camera, plus a screen share from the meeting owner
+    };
+
+    struct LoadConfig {
+        std::string host = "127.0.0.1";
+        uint16_t tcpPort = 8081;
+        uint16_t udpPort = 8081;
+
+        std::size_t meetings = 10;
+        std::size_t participants = 8;
+        std::size_t lastN = 9;
+        MediaProfile profile = MediaProfile::Video;
+
+        uint32_t voiceKbps = 32;
+        uint32_t cameraKbps = 600;
+        uint32_t cameraFps = 30;
+        uint32_t cameraLayers = 3;
+        uint32_t screenKbps = 1500;
+        uint32_t screenFps = 10;
+        uint32_t keyframeIntervalMs = 2000;
+
+        std::chrono::seconds ramp{ 10 };
+        std::chrono::seconds warmup{ 5 };
+        std::chrono::seconds duration{ 60 };
+
+        std::size_t threads = 0;
+        int serverPid = 0;
+        bool json = false;
+    };
+
+    // Returns nullopt and fills error on a bad command line; error stays empty for --help.
+    std::optional<LoadConfig> parseArguments(int argc, char** argv, std::string& error);
+    void printUsage(std::ostream& out);
+    const char* profileToString(MediaProfile profile);
+}
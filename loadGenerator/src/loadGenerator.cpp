@@ -0,0 +1,567 @@
+#include "loadGenerator.h"
+
+#include <algorithm>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+#include "constants/jsonType.h"
+#include "utilities/crypto.h"
+
+using namespace server::constant;
+namespace crypto = server::utilities::crypto;
+
+namespace loadGenerator
+{
+    namespace
+    {
+        constexpr std::array<const char*, kMediaKindCount> kMediaKindNames = { "voice", "screen", "camera" };
+
+        std::string randomRunId() {
+            std::random_device device;
+            std::ostringstream out;
+            out << std::hex << std::setw(8) << std::setfill('0') << device();
+            return out.str();
+        }
+
+        double toMilliseconds(uint64_t micros) {
+            return static_cast<double>(micros) / 1000.0;
+        }
+
+        nlohmann::json latencyToJson(const LatencyHistogram& latency) {
+            return {
+                { "count", latency.count() },
+                { "mean", toMilliseconds(static_cast<uint64_t>(latency.mean())) },
+                { "p50", toMilliseconds(latency.quantile(0.5)) },
+                { "p90", toMilliseconds(latency.quantile(0.9)) },
+                { "p99", toMilliseconds(latency.quantile(0.99)) },
+                { "p999", toMilliseconds(latency.quantile(0.999)) },
+                { "max", toMilliseconds(latency.max()) }
+            };
+        }
+
+        double lossPercent(uint64_t received, uint64_t expected) {
+            if (expected == 0 || received >= expected) {
+                return 0.0;
+            }
+            return 100.0 * static_cast<double>(expected - received) / static_cast<double>(expected);
+        }
+    }
+
+    LoadGenerator::LoadGenerator(LoadConfig config)
+        : m_config(std::move(config))
+        , m_controlTimer(m_controlContext)
+    {
+    }
+
+    LoadGenerator::~LoadGenerator() {
+        stopThreads();
+    }
+
+    int LoadGenerator::run() {
+        try {
+            asio::ip::tcp::resolver resolver(m_controlContext);
+            m_controlEndpoint = *resolver.resolve(m_config.host, std::to_string(m_config.tcpPort)).begin();
+            m_mediaEndpoint = asio::ip::udp::endpoint(m_controlEndpoint.address(), m_config.udpPort);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Cannot resolve " << m_config.host << ": " << e.what() << std::endl;
+            return 1;
+        }
+
+        // Every client presents the same public key: the server only stores it and hands it to
+        // other participants, and one 3072-bit key pair already takes a moment to generate.
+        std::cerr << "Generating the client key pair..." << std::endl;
+        CryptoPP::RSA::PrivateKey privateKey;
+        CryptoPP::RSA::PublicKey publicKey;
+        crypto::generateRSAKeyPair(privateKey, publicKey);
+        createClients(crypto::serializePublicKey(publicKey));
+
+        m_serverPid = m_config.serverPid != 0 ? m_config.serverPid : findProcessByName("calliforniaServer");
+        if (m_serverPid == 0) {
+            std::cerr << "Server process not found, server CPU will not be reported (use --server-pid)" << std::endl;
+        }
+
+        startThreads();
+        asio::post(m_controlContext, [this]() {
+            m_rampStartedAt = std::chrono::steady_clock::now();
+            onControlTick();
+        });
+        for (auto& shard : m_shards) {
+            asio::post(m_mediaContext, [this, &shard = *shard]() { scheduleMediaTick(shard); });
+        }
+
+        const bool allJoined = waitForMeetings();
+        if (m_joinedClients.load() == 0) {
+            std::cerr << "No client got into a meeting, is calliforniaServer running on "
+                << m_config.host << ":" << m_config.tcpPort << "?" << std::endl;
+            stopThreads();
+            return 1;
+        }
+
+        for (auto second = std::chrono::seconds(0); second < m_config.warmup; ++second) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            printProgress("warmup");
+        }
+        measure();
+
+        // Stop the senders on the control thread, where startMedia runs, then let the last
+        // forwarded frames arrive before the sockets go away.
+        std::promise<void> stopped;
+        asio::post(m_controlContext, [this, &stopped]() {
+            for (auto& client : m_clients) {
+                client->stopMedia();
+            }
+            stopped.set_value();
+        });
+        stopped.get_future().wait();
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        stopThreads();
+
+        const nlohmann::json report = buildReport();
+        printReport(report);
+        return allJoined ? 0 : 2;
+    }
+
+    void LoadGenerator::createClients(const std::string& publicKey) {
+        const std::string runId = randomRunId();
+        auto onControl = [this](SimulatedClient& client, PacketType type, const nlohmann::json& json) { onControlPacket(client, type, json); };
+        auto onDisconnect = [this](SimulatedClient& client, const std::string& reason) { onDisconnected(client, reason); };
+
+        m_meetings.resize(m_config.meetings);
+        m_clients.reserve(m_config.meetings * m_config.participants);
+        // Clients are created meeting by meeting, owner first, which is also the login order.
+        for (std::size_t meeting = 0; meeting < m_config.meetings; ++meeting) {
+            for (std::size_t slot = 0; slot < m_config.participants; ++slot) {
+                const auto index = static_cast<uint32_t>(m_clients.size());
+                auto client = std::make_unique<SimulatedClient>(m_controlContext, m_mediaContext, m_config, index,
+                    "loadgen-" + runId + "-" + std::to_string(index), publicKey, m_measuring, onControl, onDisconnect);
+                client->meeting = meeting;
+                client->slot = slot;
+                m_meetings[meeting].clients.push_back(index);
+                m_clients.push_back(std::move(client));
+            }
+        }
+
+        for (std::size_t i = 0; i < m_config.threads; ++i) {
+            m_shards.push_back(std::make_unique<MediaShard>(m_mediaContext));
+        }
+        for (std::size_t i = 0; i < m_clients.size(); ++i) {
+            m_shards[i % m_shards.size()]->clients.push_back(m_clients[i].get());
+        }
+    }
+
+    void LoadGenerator::startThreads() {
+        m_controlWork.emplace(asio::make_work_guard(m_controlContext));
+        m_mediaWork.emplace(asio::make_work_guard(m_mediaContext));
+        m_threads.emplace_back([this]() { m_controlContext.run(); });
+        for (std::size_t i = 0; i < m_config.threads; ++i) {
+            m_threads.emplace_back([this]() { m_mediaContext.run(); });
+        }
+    }
+
+    void LoadGenerator::stopThreads() {
+        m_controlWork.reset();
+        m_mediaWork.reset();
+        m_controlContext.stop();
+        m_mediaContext.stop();
+        for (auto& thread : m_threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+        m_threads.clear();
+    }
+
+    void LoadGenerator::onControlTick() {
+        const auto now = std::chrono::steady_clock::now();
+
+        std::size_t target = m_clients.size();
+        if (m_config.ramp.count() > 0) {
+            const double share = std::chrono::duration<double>(now - m_rampStartedAt) / m_config.ramp;
+            target = std::min(m_clients.size(), static_cast<std::size_t>(share * static_cast<double>(m_clients.size())) + 1);
+        }
+        while (m_connectedClients < target) {
+            m_clients[m_connectedClients++]->connect(m_controlEndpoint, m_mediaEndpoint);
+        }
+
+        auto due = std::partition(m_deferred.begin(), m_deferred.end(), [this, now](std::size_t index) {
+            const auto& client = *m_clients[index];
+            return client.joined ? now < client.announceSharingAt : now < client.retryJoinAt;
+        });
+        std::vector<std::size_t> ready(due, m_deferred.end());
+        m_deferred.erase(due, m_deferred.end());
+        for (std::size_t index : ready) {
+            SimulatedClient& client = *m_clients[index];
+            if (!client.joined) {
+                requestJoin(client);
+                continue;
+            }
+            // Sent a little after the join so the server has committed the participant by then;
+            // camera frames of a sender that never announced sharing are outside everyone's Last-N.
+            const nlohmann::json json = { { SENDER_NICKNAME_HASH, client.getNicknameHash() } };
+            if (client.getPlan().camera) {
+                client.sendControl(PacketType::CAMERA_SHARING_BEGIN, json);
+            }
+            if (client.getPlan().screen) {
+                client.sendControl(PacketType::SCREEN_SHARING_BEGIN, json);
+            }
+        }
+
+        m_controlTimer.expires_after(m_controlTickInterval);
+        m_controlTimer.async_wait([this](std::error_code ec) {
+            if (!ec) {
+                onControlTick();
+            }
+        });
+    }
+
+    void LoadGenerator::onControlPacket(SimulatedClient& client, PacketType type, const nlohmann::json& json) {
+        SimulatedMeeting& meeting = m_meetings[client.meeting];
+
+        switch (type) {
+        case PacketType::AUTHORIZATION_RESULT:
+            if (!json.value(RESULT, false)) {
+                std::cerr << "Client " << client.getIndex() << " was refused authorization" << std::endl;
+                ++m_failedClients;
+                return;
+            }
+            client.authorized = true;
+            if (client.slot == 0) {
+                client.sendControl(PacketType::MEETING_CREATE, {
+                    { SENDER_NICKNAME_HASH, client.getNicknameHash() },
+                    { LAST_N, m_config.lastN }
+                });
+            }
+            else if (!meeting.meetingIdHash.empty()) {
+                requestJoin(client);
+            }
+            break;
+
+        case PacketType::MEETING_CREATE_RESULT:
+            if (client.slot != 0 || client.joined) {
+                return;
+            }
+            if (!json.value(RESULT, false) || !json.contains(MEETING_ID)) {
+                std::cerr << "Meeting " << client.meeting << " could not be created" << std::endl;
+                m_failedClients += meeting.clients.size();
+                return;
+            }
+            meeting.meetingId = json[MEETING_ID].get<std::string>();
+            meeting.meetingIdHash = crypto::calculateHash(meeting.meetingId);
+            onJoined(client);
+            for (std::size_t index : meeting.clients) {
+                SimulatedClient& member = *m_clients[index];
+                if (member.slot != 0 && member.authorized && !member.joinRequested) {
+                    requestJoin(member);
+                }
+            }
+            break;
+
+        case PacketType::MEETING_JOIN_REQUEST:
+            // The owner lets everyone in, as a real owner clicking accept would.
+            if (client.slot == 0 && json.contains(SENDER_NICKNAME_HASH)) {
+                client.sendControl(PacketType::MEETING_JOIN_ACCEPT, {
+                    { SENDER_NICKNAME_HASH, client.getNicknameHash() },
+                    { REQUESTER_NICKNAME_HASH, json[SENDER_NICKNAME_HASH] },
+                    { ENCRYPTED_NICKNAME, "load generator" }
+                });
+            }
+            break;
+
+        case PacketType::MEETING_JOIN_ACCEPT:
+            if (client.slot != 0 && !client.joined) {
+                onJoined(client);
+            }
+            break;
+
+        case PacketType::MEETING_JOIN_REJECTED:
+            client.joinRequested = false;
+            if (++client.joinAttempts >= m_maxJoinAttempts) {
+                std::cerr << "Client " << client.getIndex() << " gave up joining meeting " << client.meeting << ": "
+                    << json.dump() << std::endl;
+                ++m_failedClients;
+                return;
+            }
+            client.retryJoinAt = std::chrono::steady_clock::now() + m_joinRetryDelay;
+            m_deferred.push_back(client.getIndex());
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    void LoadGenerator::onDisconnected(SimulatedClient& client, const std::string& reason) {
+        std::cerr << "Client " << client.getIndex() << " disconnected: " << reason << std::endl;
+        if (!client.joined) {
+            ++m_failedClients;
+        }
+    }
+
+    void LoadGenerator::requestJoin(SimulatedClient& client) {
+        client.joinRequested = true;
+        client.sendControl(PacketType::MEETING_JOIN_REQUEST, {
+            { SENDER_NICKNAME_HASH, client.getNicknameHash() },
+            { MEETING_ID_HASH, m_meetings[client.meeting].meetingIdHash }
+        });
+    }
+
+    void LoadGenerator::onJoined(SimulatedClient& client) {
+        client.joined = true;
+        const MediaPlan plan = planFor(client);
+        client.startMedia(m_meetings[client.meeting].meetingId, plan);
+        if (plan.camera || plan.screen) {
+            client.announceSharingAt = std::chrono::steady_clock::now() + std::chrono::milliseconds(250);
+            m_deferred.push_back(client.getIndex());
+        }
+        ++m_joinedClients;
+    }
+
+    MediaPlan LoadGenerator::planFor(const SimulatedClient& client) const {
+        MediaPlan plan;
+        plan.voice = true;
+        plan.camera = m_config.profile != MediaProfile::Audio;
+        plan.screen = m_config.profile == MediaProfile::Presentation && client.slot == 0;
+        // The owner is the loudest, later participants get quieter.
+        plan.audioLevel = static_cast<uint8_t>(std::min<std::size_t>(126, 10 + 4 * client.slot));
+        return plan;
+    }
+
+    void LoadGenerator::scheduleMediaTick(MediaShard& shard) {
+        shard.timer.expires_after(m_mediaTickInterval);
+        shard.timer.async_wait([this, &shard](std::error_code ec) {
+            if (ec) {
+                return;
+            }
+            const auto now = std::chrono::steady_clock::now();
+            for (SimulatedClient* client : shard.clients) {
+                client->sendDueMedia(now);
+            }
+            scheduleMediaTick(shard);
+        });
+    }
+
+    bool LoadGenerator::waitForMeetings() {
+        const std::size_t total = m_clients.size();
+        const auto deadline = std::chrono::steady_clock::now() + m_config.ramp + std::chrono::seconds(30);
+        while (m_joinedClients.load() + m_failedClients.load() < total && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            printProgress("joining");
+        }
+        return m_joinedClients.load() == total;
+    }
+
+    void LoadGenerator::measure() {
+        m_trafficBefore = sumTraffic();
+        if (m_serverPid != 0) {
+            m_serverCpuBefore = readProcessCpuTime(m_serverPid);
+        }
+        m_selfCpuBefore = readProcessCpuTime(0);
+        m_measureStartedAt = std::chrono::steady_clock::now();
+        m_measuring.store(true);
+
+        auto previous = m_serverCpuBefore;
+        for (auto second = std::chrono::seconds(0); second < m_config.duration; ++second) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+            if (previous) {
+                auto current = readProcessCpuTime(m_serverPid);
+                if (current) {
+                    m_serverCpuPeak = std::max(m_serverCpuPeak, getProcessCpuPercent(*previous, *current));
+                }
+                previous = current;
+            }
+            printProgress("measuring");
+        }
+
+        m_measuring.store(false);
+        m_measureEndedAt = std::chrono::steady_clock::now();
+        if (m_serverCpuBefore) {
+            m_serverCpuAfter = readProcessCpuTime(m_serverPid);
+        }
+        m_selfCpuAfter = readProcessCpuTime(0);
+        m_trafficAfter = sumTraffic();
+    }
+
+    LoadGenerator::Traffic LoadGenerator::sumTraffic() const {
+        Traffic traffic;
+        for (const auto& client : m_clients) {
+            traffic.sentDatagrams += client->getSentDatagrams();
+            traffic.sentBytes += client->getSentBytes();
+            traffic.receivedDatagrams += client->getReceivedDatagrams();
+            traffic.receivedBytes += client->getReceivedBytes();
+            traffic.sendErrors += client->getSendErrors();
+            traffic.lateFrames += client->getLateFrames();
+        }
+        return traffic;
+    }
+
+    void LoadGenerator::printProgress(const char* phase) {
+        const auto now = std::chrono::steady_clock::now();
+        const Traffic traffic = sumTraffic();
+        const double seconds = m_lastProgressAt.time_since_epoch().count() == 0
+            ? 0.0 : std::chrono::duration<double>(now - m_lastProgressAt).count();
+
+        std::cerr << "[" << phase << "] joined " << m_joinedClients.load() << "/" << m_clients.size()
+            << ", failed " << m_failedClients.load();
+        if (seconds > 0.0) {
+            std::cerr << std::fixed << std::setprecision(0)
+                << ", out " << static_cast<double>(traffic.sentDatagrams - m_lastProgressSent) / seconds << " datagrams/s"
+                << ", in " << static_cast<double>(traffic.receivedDatagrams - m_lastProgressReceived) / seconds << " datagrams/s";
+        }
+        std::cerr << std::endl;
+
+        m_lastProgressAt = now;
+        m_lastProgressSent = traffic.sentDatagrams;
+        m_lastProgressReceived = traffic.receivedDatagrams;
+    }
+
+    nlohmann::json LoadGenerator::buildReport() const {
+        const double seconds = std::max(std::chrono::duration<double>(m_measureEndedAt - m_measureStartedAt).count(), 1e-3);
+
+        std::array<LatencyHistogram, kMediaKindCount> latency;
+        LatencyHistogram overall;
+        std::array<uint64_t, kMediaKindCount> framesSent{};
+        std::array<uint64_t, kMediaKindCount> framesReceived{};
+        std::array<uint64_t, kMediaKindCount> framesExpected{};
+        uint64_t incompleteFrames = 0;
+        for (const auto& client : m_clients) {
+            const ReceiveStats stats = client->collectReceiveStats();
+            for (std::size_t kind = 0; kind < kMediaKindCount; ++kind) {
+                latency[kind].merge(stats.latency[kind]);
+                overall.merge(stats.latency[kind]);
+                framesSent[kind] += client->getFramesSent()[kind].load(std::memory_order_relaxed);
+                framesReceived[kind] += stats.framesReceived[kind];
+                framesExpected[kind] += stats.framesExpected[kind];
+            }
+            incompleteFrames += stats.incompleteFrames;
+        }
+
+        nlohmann::json report;
+        report["config"] = {
+            { "host", m_config.host },
+            { "meetings", m_config.meetings },
+            { "participants", m_config.participants },
+            { "profile", profileToString(m_config.profile) },
+            { "last_n", m_config.lastN },
+            { "voice_kbps", m_config.voiceKbps },
+            { "camera_kbps", m_config.cameraKbps },
+            { "camera_fps", m_config.cameraFps },
+            { "camera_layers", m_config.cameraLayers },
+            { "screen_kbps", m_config.screenKbps },
+            { "screen_fps", m_config.screenFps },
+            { "duration_seconds", seconds }
+        };
+        report["clients"] = {
+            { "total", m_clients.size() },
+            { "joined", m_joinedClients.load() },
+            { "failed", m_failedClients.load() }
+        };
+
+        uint64_t totalReceived = 0;
+        uint64_t totalExpected = 0;
+        nlohmann::json media = nlohmann::json::object();
+        for (std::size_t kind = 0; kind < kMediaKindCount; ++kind) {
+            if (framesSent[kind] == 0 && framesExpected[kind] == 0) {
+                continue;
+            }
+            media[kMediaKindNames[kind]] = {
+                { "frames_sent", framesSent[kind] },
+                { "frames_received", framesReceived[kind] },
+                { "frames_expected", framesExpected[kind] },
+                { "loss_percent", lossPercent(framesReceived[kind], framesExpected[kind]) },
+                { "latency_ms", latencyToJson(latency[kind]) }
+            };
+            totalReceived += framesReceived[kind];
+            totalExpected += framesExpected[kind];
+        }
+        report["media"] = media;
+        report["overall"] = {
+            { "loss_percent", lossPercent(totalReceived, totalExpected) },
+            { "incomplete_frames", incompleteFrames },
+            { "latency_ms", latencyToJson(overall) }
+        };
+
+        const Traffic& before = m_trafficBefore;
+        const Traffic& after = m_trafficAfter;
+        report["traffic"] = {
+            { "datagrams_sent_per_second", static_cast<double>(after.sentDatagrams - before.sentDatagrams) / seconds },
+            { "datagrams_received_per_second", static_cast<double>(after.receivedDatagrams - before.receivedDatagrams) / seconds },
+            { "megabits_sent_per_second", static_cast<double>(after.sentBytes - before.sentBytes) * 8.0 / 1e6 / seconds },
+            { "megabits_received_per_second", static_cast<double>(after.receivedBytes - before.receivedBytes) * 8.0 / 1e6 / seconds },
+            { "send_errors", after.sendErrors - before.sendErrors },
+            { "frames_skipped_by_generator", after.lateFrames - before.lateFrames }
+        };
+
+        if (m_serverCpuBefore && m_serverCpuAfter) {
+            report["server_cpu"] = {
+                { "pid", m_serverPid },
+                { "average_percent", getProcessCpuPercent(*m_serverCpuBefore, *m_serverCpuAfter) },
+                { "peak_percent", m_serverCpuPeak }
+            };
+        }
+        else {
+            report["server_cpu"] = nullptr;
+        }
+        report["generator_cpu_percent"] = m_selfCpuBefore && m_selfCpuAfter
+            ? nlohmann::json(getProcessCpuPercent(*m_selfCpuBefore, *m_selfCpuAfter)) : nlohmann::json(nullptr);
+        return report;
+    }
+
+    void LoadGenerator::printReport(const nlohmann::json& report) const {
+        if (m_config.json) {
+            std::cout << report.dump(2) << std::endl;
+            return;
+        }
+
+        const auto& config = report["config"];
+        const auto& clients = report["clients"];
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(2);
+        out << "\n"
+            << m_config.meetings << " meetings x " << m_config.participants << " participants (" << m_clients.size()
+            << " clients), profile " << config["profile"].get<std::string>() << ", "
+            << config["duration_seconds"].get<double>() << " s measured\n"
+            << "Clients: " << clients["joined"] << " joined, " << clients["failed"] << " failed\n\n";
+
+        out << std::left << std::setw(9) << "media" << std::right
+            << std::setw(13) << "frames sent" << std::setw(13) << "frames recv" << std::setw(9) << "loss %"
+            << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms" << std::setw(10) << "p99 ms"
+            << std::setw(10) << "p99.9 ms" << std::setw(10) << "max ms" << "\n";
+        auto printRow = [&out](const std::string& name, const nlohmann::json& row, const nlohmann::json& latency) {
+            out << std::left << std::setw(9) << name << std::right
+                << std::setw(13) << (row.contains("frames_sent") ? row["frames_sent"].dump() : std::string("-"))
+                << std::setw(13) << (row.contains("frames_received") ? row["frames_received"].dump() : std::string("-"))
+                << std::setw(9) << row["loss_percent"].get<double>()
+                << std::setw(10) << latency["p50"].get<double>() << std::setw(10) << latency["p90"].get<double>()
+                << std::setw(10) << latency["p99"].get<double>() << std::setw(10) << latency["p999"].get<double>()
+                << std::setw(10) << latency["max"].get<double>() << "\n";
+        };
+        for (const auto& [name, row] : report["media"].items()) {
+            printRow(name, row, row["latency_ms"]);
+        }
+        printRow("all", report["overall"], report["overall"]["latency_ms"]);
+
+        const auto& traffic = report["traffic"];
+        out << "\nTraffic: out " << traffic["megabits_sent_per_second"].get<double>() << " Mbit/s, in "
+            << traffic["megabits_received_per_second"].get<double>() << " Mbit/s; "
+            << traffic["send_errors"] << " send errors, "
+            << traffic["frames_skipped_by_generator"] << " frames skipped by the generator, "
+            << report["overall"]["incomplete_frames"] << " frames incomplete\n";
+
+        if (report["server_cpu"].is_null()) {
+            out << "Server CPU: not sampled\n";
+        }
+        else {
+            out << "Server CPU: " << report["server_cpu"]["average_percent"].get<double>() << "% average, "
+                << report["server_cpu"]["peak_percent"].get<double>() << "% peak of one core (pid "
+                << report["server_cpu"]["pid"] << ")\n";
+        }
+        if (!report["generator_cpu_percent"].is_null()) {
+            out << "Generator CPU: " << report["generator_cpu_percent"].get<double>() << "% of one core\n";
+        }
+        std::cout << out.str() << std::flush;
+    }
+}
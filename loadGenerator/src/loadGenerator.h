@@ -0,0 +1,117 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "asio.hpp"
+#include <nlohmann/json.hpp>
+
+#include "loadConfig.h"
+#include "processCpu.h"
+#include "simulatedClient.h"
+
+namespace loadGenerator
+{
+    // Runs one load test: logs every client in over the ramp, forms the meetings, lets media flow
+    // through the warmup and measured window, then reports on what the clients received.
+    class LoadGenerator {
+    public:
+        explicit LoadGenerator(LoadConfig config);
+        ~LoadGenerator();
+
+        // Returns the process exit code.
+        int run();
+
+    private:
+        struct SimulatedMeeting {
+            std::vector<std::size_t> clients;
+            std::string meetingId;
+            std::string meetingIdHash;
+        };
+
+        // Sums of the clients' counters; the report uses the difference over the measured window.
+        struct Traffic {
+            uint64_t sentDatagrams = 0;
+            uint64_t sentBytes = 0;
+            uint64_t receivedDatagrams = 0;
+            uint64_t receivedBytes = 0;
+            uint64_t sendErrors = 0;
+            uint64_t lateFrames = 0;
+        };
+
+        struct MediaShard {
+            explicit MediaShard(asio::io_context& context) : timer(context) {}
+            asio::steady_timer timer;
+            std::vector<SimulatedClient*> clients;
+        };
+
+        void createClients(const std::string& publicKey);
+        void startThreads();
+        void stopThreads();
+
+        void onControlTick();
+        void onControlPacket(SimulatedClient& client, server::constant::PacketType type, const nlohmann::json& json);
+        void onDisconnected(SimulatedClient& client, const std::string& reason);
+        void requestJoin(SimulatedClient& client);
+        void onJoined(SimulatedClient& client);
+        MediaPlan planFor(const SimulatedClient& client) const;
+
+        void scheduleMediaTick(MediaShard& shard);
+        bool waitForMeetings();
+        void measure();
+        Traffic sumTraffic() const;
+        void printProgress(const char* phase);
+        nlohmann::json buildReport() const;
+        void printReport(const nlohmann::json& report) const;
+
+        static constexpr std::chrono::milliseconds m_controlTickInterval{ 10 };
+        static constexpr std::chrono::milliseconds m_mediaTickInterval{ 2 };
+        static constexpr std::chrono::seconds m_joinRetryDelay{ 1 };
+        static constexpr int m_maxJoinAttempts = 5;
+
+        const LoadConfig m_config;
+        asio::io_context m_controlContext;
+        asio::io_context m_mediaContext;
+        std::optional<asio::executor_work_guard<asio::io_context::executor_type>> m_controlWork;
+        std::optional<asio::executor_work_guard<asio::io_context::executor_type>> m_mediaWork;
+        asio::steady_timer m_controlTimer;
+        std::vector<std::thread> m_threads;
+
+        asio::ip::tcp::endpoint m_controlEndpoint;
+        asio::ip::udp::endpoint m_mediaEndpoint;
+
+        std::vector<std::unique_ptr<SimulatedClient>> m_clients;
+        std::vector<SimulatedMeeting> m_meetings;
+        std::vector<std::unique_ptr<MediaShard>> m_shards;
+        std::chrono::steady_clock::time_point m_rampStartedAt{};
+        std::size_t m_connectedClients = 0;
+        // Clients with a join retry or a sharing announcement still due.
+        std::vector<std::size_t> m_deferred;
+
+        std::atomic<bool> m_measuring{ false };
+        std::atomic<std::size_t> m_joinedClients{ 0 };
+        std::atomic<std::size_t> m_failedClients{ 0 };
+
+        int m_serverPid = 0;
+        std::optional<ProcessCpuTime> m_serverCpuBefore;
+        std::optional<ProcessCpuTime> m_serverCpuAfter;
+        std::optional<ProcessCpuTime> m_selfCpuBefore;
+        std::optional<ProcessCpuTime> m_selfCpuAfter;
+        double m_serverCpuPeak = 0.0;
+        std::chrono::steady_clock::time_point m_measureStartedAt{};
+        std::chrono::steady_clock::time_point m_measureEndedAt{};
+        Traffic m_trafficBefore;
+        Traffic m_trafficAfter;
+
+        // Main thread only.
+        std::chrono::steady_clock::time_point m_lastProgressAt{};
+        uint64_t m_lastProgressSent = 0;
+        uint64_t m_lastProgressReceived = 0;
+    };
+}
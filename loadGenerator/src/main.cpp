@@ -0,0 +1,29 @@
+#include <iostream>
+#include <string>
+
+#include "loadConfig.h"
+#include "loadGenerator.h"
+
+int main(int argc, char** argv)
+{
+    std::string error;
+    auto config = loadGenerator::parseArguments(argc, argv, error);
+    if (!config) {
+        if (!error.empty()) {
+            std::cerr << error << "\n\n";
+            loadGenerator::printUsage(std::cerr);
+            return 1;
+        }
+        loadGenerator::printUsage(std::cout);
+        return 0;
+    }
+
+    try {
+        loadGenerator::LoadGenerator generator(*config);
+        return generator.run();
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+}
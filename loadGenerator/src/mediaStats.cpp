@@ -0,0 +1,74 @@
+#include "mediaStats.h"
+
+#include <algorithm>
+
+namespace loadGenerator
+{
+    void LatencyHistogram::record(uint64_t micros) {
+        ++m_buckets[Registry::bucketIndex(micros)];
+        ++m_count;
+        m_sum += micros;
+        m_max = std::max(m_max, micros);
+    }
+
+    void LatencyHistogram::merge(const LatencyHistogram& other) {
+        for (std::size_t i = 0; i < m_buckets.size(); ++i) {
+            m_buckets[i] += other.m_buckets[i];
+        }
+        m_count += other.m_count;
+        m_sum += other.m_sum;
+        m_max = std::max(m_max, other.m_max);
+    }
+
+    double LatencyHistogram::mean() const {
+        return m_count == 0 ? 0.0 : static_cast<double>(m_sum) / static_cast<double>(m_count);
+    }
+
+    uint64_t LatencyHistogram::quantile(double q) const {
+        if (m_count == 0) {
+            return 0;
+        }
+        const auto rank = static_cast<uint64_t>(q * static_cast<double>(m_count - 1)) + 1;
+        uint64_t seen = 0;
+        for (std::size_t i = 0; i < m_buckets.size(); ++i) {
+            seen += m_buckets[i];
+            if (seen >= rank) {
+                return std::min(Registry::bucketUpperBound(i), m_max);
+            }
+        }
+        return m_max;
+    }
+
+    void StreamTracker::onFrame(uint32_t frameSeq) {
+        if (!m_started) {
+            m_started = true;
+            m_first = frameSeq;
+            m_highest = frameSeq;
+            m_seen.set(frameSeq % m_window);
+            m_received = 1;
+            return;
+        }
+        if (frameSeq < m_first || frameSeq + m_window <= m_highest) {
+            // From before measuring started, or too late to tell from a duplicate.
+            return;
+        }
+        if (frameSeq > m_highest) {
+            const uint32_t gap = frameSeq - m_highest;
+            if (gap >= m_window) {
+                m_seen.reset();
+            }
+            else {
+                for (uint32_t seq = m_highest + 1; seq != frameSeq; ++seq) {
+                    m_seen.reset(seq % m_window);
+                }
+            }
+            m_seen.reset(frameSeq % m_window);
+            m_highest = frameSeq;
+        }
+        if (m_seen.test(frameSeq % m_window)) {
+            return;
+        }
+        m_seen.set(frameSeq % m_window);
+        ++m_received;
+    }
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+
+#include "utilities/metricsRegistry.h"
+
+namespace loadGenerator
+{
+    // Same log-linear buckets the server's /metrics summaries use, so both sides quote
+    // percentiles with the same ~12% resolution. Owned by one receive path, merged at the end.
+    class LatencyHistogram {
+    public:
+        void record(uint64_t micros);
+        void merge(const LatencyHistogram& other);
+
+        uint64_t count() const { return m_count; }
+        uint64_t max() const { return m_max; }
+        double mean() const;
+        // Upper bound of the bucket holding the given quantile, 0 when empty.
+        uint64_t quantile(double q) const;
+
+    private:
+        using Registry = server::utilities::MetricsRegistry;
+
+        std::array<uint64_t, Registry::m_bucketCount> m_buckets{};
+        uint64_t m_count = 0;
+        uint64_t m_sum = 0;
+        uint64_t m_max = 0;
+    };
+
+    // Frames of one sender stream as seen by one receiver. Loss is counted between the first
+    // frame seen and the highest one; duplicates from keyframe replays are ignored.
+    class StreamTracker {
+    public:
+        void onFrame(uint32_t frameSeq);
+
+        uint64_t received() const { return m_received; }
+        uint64_t expected() const { return m_started ? static_cast<uint64_t>(m_highest - m_first) + 1 : 0; }
+
+    private:
+        static constexpr std::size_t m_window = 1024;
+
+        bool m_started = false;
+        uint32_t m_first = 0;
+        uint32_t m_highest = 0;
+        uint64_t m_received = 0;
+        std::bitset<m_window> m_seen;
+    };
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#ifdef __linux__
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <unistd.h>
+#endif
+
+namespace loadGenerator
+{
+    // CPU time a process has used so far, user and system together.
+    struct ProcessCpuTime {
+        std::chrono::steady_clock::time_point readAt{};
+        double cpuSeconds = 0.0;
+    };
+
+    // Share of one core used between two reads, in percent (400 means four busy cores).
+    inline double getProcessCpuPercent(const ProcessCpuTime& before, const ProcessCpuTime& after) {
+        const double wallSeconds = std::chrono::duration<double>(after.readAt - before.readAt).count();
+        if (wallSeconds <= 0.0 || after.cpuSeconds < before.cpuSeconds)
+            return 0.0;
+        return 100.0 * (after.cpuSeconds - before.cpuSeconds) / wallSeconds;
+    }
+
+#ifdef __linux__
+    // pid 0 reads this process.
+    inline std::optional<ProcessCpuTime> readProcessCpuTime(int pid) {
+        std::ifstream stat(pid == 0 ? std::string("/proc/self/stat") : "/proc/" + std::to_string(pid) + "/stat");
+        std::string line;
+        if (!std::getline(stat, line))
+            return std::nullopt;
+
+        // The command name may contain spaces and parentheses, so fields are counted after the last ')'.
+        const auto nameEnd = line.rfind(')');
+        if (nameEnd == std::string::npos)
+            return std::nullopt;
+        std::istringstream iss(line.substr(nameEnd + 1));
+        std::string field;
+        uint64_t userTicks = 0, systemTicks = 0;
+        // state is field 3; utime and stime are fields 14 and 15.
+        for (int index = 3; index <= 15 && iss >> field; ++index) {
+            if (index == 14)
+                userTicks = std::stoull(field);
+            else if (index == 15)
+                systemTicks = std::stoull(field);
+        }
+        if (!iss)
+            return std::nullopt;
+
+        const long ticksPerSecond = sysconf(_SC_CLK_TCK);
+        ProcessCpuTime time;
+        time.readAt = std::chrono::steady_clock::now();
+        time.cpuSeconds = static_cast<double>(userTicks + systemTicks) / static_cast<double>(ticksPerSecond > 0 ? ticksPerSecond : 100);
+        return time;
+    }
+
+    // The kernel truncates process names to 15 characters, so "calliforniaServer" shows up as
+    // "calliforniaServ". Returns 0 when there is no such process or more than one.
+    inline int findProcessByName(const std::string& name) {
+        const std::string shortName = name.substr(0, 15);
+        int found = 0;
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator("/proc", ec)) {
+            const std::string pidText = entry.path().filename().string();
+            if (pidText.empty() || pidText.find_first_not_of("0123456789") != std::string::npos)
+                continue;
+            std::ifstream comm(entry.path() / "comm");
+            std::string processName;
+            if (!std::getline(comm, processName) || processName != shortName)
+                continue;
+            if (found != 0)
+                return 0;
+            found = std::stoi(pidText);
+        }
+        return found;
+    }
+#else
+    inline std::optional<ProcessCpuTime> readProcessCpuTime(int) { return std::nullopt; }
+    inline int findProcessByName(const std::string&) { return 0; }
+#endif
+}
@@ -0,0 +1,498 @@
+#include "simulatedClient.h"
+
+#include <algorithm>
+#include <cstring>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#endif
+
+#include "constants/jsonType.h"
+#include "constants/mediaFrame.h"
+#include "utilities/crypto.h"
+
+using namespace server::constant;
+namespace crypto = server::utilities::crypto;
+
+namespace loadGenerator
+{
+    namespace
+    {
+        unsigned char* writeUint16(unsigned char* out, uint16_t value) {
+            out[0] = static_cast<unsigned char>(value >> 8);
+            out[1] = static_cast<unsigned char>(value);
+            return out + 2;
+        }
+
+        unsigned char* writeUint32(unsigned char* out, uint32_t value) {
+            for (int shift = 24; shift >= 0; shift -= 8) {
+                *out++ = static_cast<unsigned char>(value >> shift);
+            }
+            return out;
+        }
+
+        unsigned char* writeUint64(unsigned char* out, uint64_t value) {
+            for (int shift = 56; shift >= 0; shift -= 8) {
+                *out++ = static_cast<unsigned char>(value >> shift);
+            }
+            return out;
+        }
+
+        uint16_t readUint16(const unsigned char* data) {
+            return static_cast<uint16_t>((static_cast<uint16_t>(data[0]) << 8) | data[1]);
+        }
+
+        uint32_t readUint32(const unsigned char* data) {
+            return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16)
+                | (static_cast<uint32_t>(data[2]) << 8) | static_cast<uint32_t>(data[3]);
+        }
+
+        uint64_t readUint64(const unsigned char* data) {
+            return (static_cast<uint64_t>(readUint32(data)) << 32) | readUint32(data + 4);
+        }
+
+        int64_t steadyNanoseconds(std::chrono::steady_clock::time_point time) {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+        }
+
+        uint64_t streamKey(uint32_t senderIndex, MediaKind kind, uint8_t layer) {
+            return (static_cast<uint64_t>(senderIndex) << 16) | (static_cast<uint64_t>(kind) << 8) | layer;
+        }
+
+        std::size_t bytesPerFrame(uint32_t kbps, uint32_t fps) {
+            return static_cast<std::size_t>(kbps) * 1000 / 8 / std::max<uint32_t>(fps, 1);
+        }
+
+        bool isMediaType(uint32_t type) {
+            return type == static_cast<uint32_t>(PacketType::VOICE)
+                || type == static_cast<uint32_t>(PacketType::CAMERA)
+                || type == static_cast<uint32_t>(PacketType::SCREEN);
+        }
+    }
+
+    SimulatedClient::SimulatedClient(asio::io_context& controlContext, asio::io_context& mediaContext, const LoadConfig& config,
+        uint32_t index, const std::string& nickname, const std::string& publicKey, const std::atomic<bool>& measuring,
+        ControlHandler onControl, DisconnectHandler onDisconnected)
+        : m_config(config)
+        , m_index(index)
+        , m_nicknameHash(crypto::calculateHash(nickname))
+        , m_publicKey(publicKey)
+        , m_measuring(measuring)
+        , m_onControl(std::move(onControl))
+        , m_onDisconnected(std::move(onDisconnected))
+        , m_controlSocket(controlContext)
+        , m_mediaSocket(mediaContext)
+    {
+        if (auto binary = crypto::hashToBinary(m_nicknameHash)) {
+            m_nicknameHashBinary = *binary;
+        }
+    }
+
+    void SimulatedClient::connect(const asio::ip::tcp::endpoint& controlEndpoint, const asio::ip::udp::endpoint& mediaEndpoint) {
+        m_mediaEndpoint = mediaEndpoint;
+
+        std::error_code ec;
+        m_mediaSocket.open(mediaEndpoint.protocol(), ec);
+        if (!ec) m_mediaSocket.bind(asio::ip::udp::endpoint(mediaEndpoint.protocol(), 0), ec);
+        if (!ec) m_mediaSocket.non_blocking(true, ec);
+        if (ec) {
+            fail("media socket: " + ec.message());
+            return;
+        }
+        std::error_code ignored;
+        m_mediaSocket.set_option(asio::socket_base::receive_buffer_size(1 << 18), ignored);
+        receiveMedia();
+
+        m_controlSocket.async_connect(controlEndpoint, [this](std::error_code ec) {
+            if (ec) {
+                fail("connect: " + ec.message());
+                return;
+            }
+            std::error_code ignored;
+            m_controlSocket.set_option(asio::ip::tcp::no_delay(true), ignored);
+            readHandshake();
+        });
+    }
+
+    void SimulatedClient::readHandshake() {
+        asio::async_read(m_controlSocket, asio::buffer(&m_handshakeIn, sizeof(uint64_t)), [this](std::error_code ec, std::size_t) {
+            if (ec) {
+                fail("handshake read: " + ec.message());
+                return;
+            }
+            m_handshakeOut = crypto::scramble(m_handshakeIn);
+            asio::async_write(m_controlSocket, asio::buffer(&m_handshakeOut, sizeof(uint64_t)), [this](std::error_code ec, std::size_t) {
+                if (ec) {
+                    fail("handshake write: " + ec.message());
+                    return;
+                }
+                // The server echoes the answer once it has accepted it.
+                asio::async_read(m_controlSocket, asio::buffer(&m_handshakeIn, sizeof(uint64_t)), [this](std::error_code ec, std::size_t) {
+                    if (ec || m_handshakeIn != m_handshakeOut) {
+                        fail(ec ? "handshake confirmation: " + ec.message() : "handshake rejected");
+                        return;
+                    }
+                    sendAuthorization();
+                    readHeader();
+                });
+            });
+        });
+    }
+
+    void SimulatedClient::sendAuthorization() {
+        std::error_code ec;
+        const auto mediaLocal = m_mediaSocket.local_endpoint(ec);
+
+        nlohmann::json json;
+        json[UID] = crypto::generateUID();
+        json[SENDER_NICKNAME_HASH] = m_nicknameHash;
+        json[PUBLIC_KEY] = m_publicKey;
+        json[UDP_PORT] = ec ? 0 : mediaLocal.port();
+        sendControl(PacketType::AUTHORIZATION, json);
+    }
+
+    void SimulatedClient::readHeader() {
+        asio::async_read(m_controlSocket, asio::buffer(m_header.data(), sizeof(m_header)), [this](std::error_code ec, std::size_t) {
+            if (ec) {
+                fail("control read: " + ec.message());
+                return;
+            }
+            if (m_header[1] > (16u << 20)) {
+                fail("control packet of " + std::to_string(m_header[1]) + " bytes");
+                return;
+            }
+            m_body.resize(m_header[1]);
+            if (m_body.empty()) {
+                m_onControl(*this, static_cast<PacketType>(m_header[0]), nlohmann::json());
+                readHeader();
+                return;
+            }
+            readBody();
+        });
+    }
+
+    void SimulatedClient::readBody() {
+        asio::async_read(m_controlSocket, asio::buffer(m_body.data(), m_body.size()), [this](std::error_code ec, std::size_t) {
+            if (ec) {
+                fail("control read: " + ec.message());
+                return;
+            }
+            nlohmann::json json = nlohmann::json::parse(m_body, nullptr, false);
+            if (!json.is_discarded()) {
+                m_onControl(*this, static_cast<PacketType>(m_header[0]), json);
+            }
+            if (!m_closed) {
+                readHeader();
+            }
+        });
+    }
+
+    void SimulatedClient::sendControl(PacketType type, const nlohmann::json& body) {
+        if (m_closed) {
+            return;
+        }
+        const std::string text = body.dump();
+        const std::array<uint32_t, 2> header = { static_cast<uint32_t>(type), static_cast<uint32_t>(text.size()) };
+
+        std::string message(sizeof(header) + text.size(), '\0');
+        std::memcpy(message.data(), header.data(), sizeof(header));
+        std::memcpy(message.data() + sizeof(header), text.data(), text.size());
+
+        m_outQueue.push_back(std::move(message));
+        if (m_outQueue.size() == 1) {
+            writeNext();
+        }
+    }
+
+    void SimulatedClient::writeNext() {
+        asio::async_write(m_controlSocket, asio::buffer(m_outQueue.front()), [this](std::error_code ec, std::size_t) {
+            if (ec) {
+                fail("control write: " + ec.message());
+                return;
+            }
+            m_outQueue.pop_front();
+            if (!m_outQueue.empty()) {
+                writeNext();
+            }
+        });
+    }
+
+    void SimulatedClient::fail(const std::string& reason) {
+        if (m_closed) {
+            return;
+        }
+        m_closed = true;
+        m_mediaEnabled.store(false, std::memory_order_release);
+        std::error_code ignored;
+        m_controlSocket.close(ignored);
+        m_outQueue.clear();
+        m_onDisconnected(*this, reason);
+    }
+
+    void SimulatedClient::startMedia(const std::string& meetingId, const MediaPlan& plan) {
+        if (m_closed || m_mediaEnabled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        m_plan = plan;
+
+        // Everything up to the media kind is the same in every frame, so it is written once.
+        m_frameBuffer.assign(1 + 2 + meetingId.size() + 2 + m_nicknameHash.size(), 0);
+        unsigned char* out = m_frameBuffer.data();
+        *out++ = kMeetingFrameVersion1;
+        out = writeUint16(out, static_cast<uint16_t>(meetingId.size()));
+        out = std::copy(meetingId.begin(), meetingId.end(), out);
+        out = writeUint16(out, static_cast<uint16_t>(m_nicknameHash.size()));
+        std::copy(m_nicknameHash.begin(), m_nicknameHash.end(), out);
+        m_framePrefixSize = m_frameBuffer.size();
+
+        const auto now = std::chrono::steady_clock::now();
+        const auto keyframeInterval = std::chrono::milliseconds(m_config.keyframeIntervalMs);
+        auto addTrack = [&](PacketType type, MediaKind kind, uint8_t layer, std::size_t frameBytes, uint32_t fps) {
+            Track track;
+            track.type = type;
+            track.kind = kind;
+            track.layer = layer;
+            track.frameBytes = frameBytes;
+            // Keyframes are three times a regular frame, roughly what the real encoders produce.
+            track.keyframeBytes = kind == MediaKind::Voice ? frameBytes : frameBytes * 3;
+            track.interval = std::chrono::nanoseconds(std::chrono::seconds(1)) / std::max<uint32_t>(fps, 1);
+            track.keyframeInterval = keyframeInterval;
+            // Spread the clients over the frame interval so the server sees a steady stream, not bursts.
+            track.nextFrameAt = now + track.interval * ((m_index * 7919u) % 1000u) / 1000;
+            track.nextKeyframeAt = track.nextFrameAt;
+            m_tracks.push_back(track);
+        };
+
+        if (plan.voice) {
+            addTrack(PacketType::VOICE, MediaKind::Voice, 0, bytesPerFrame(m_config.voiceKbps, 50), 50);
+        }
+        if (plan.camera) {
+            // The top layer is 2, the one the server forwards until a receiver subscribes to another.
+            const uint32_t layers = std::clamp<uint32_t>(m_config.cameraLayers, 1, 3);
+            for (uint32_t i = 0; i < layers; ++i) {
+                const uint32_t kbps = std::max<uint32_t>(1, m_config.cameraKbps >> (2 * (layers - 1 - i)));
+                addTrack(PacketType::CAMERA, MediaKind::Camera, static_cast<uint8_t>(3 - layers + i),
+                    bytesPerFrame(kbps, m_config.cameraFps), m_config.cameraFps);
+            }
+        }
+        if (plan.screen) {
+            addTrack(PacketType::SCREEN, MediaKind::Screen, 0, bytesPerFrame(m_config.screenKbps, m_config.screenFps), m_config.screenFps);
+        }
+
+        m_mediaEnabled.store(true, std::memory_order_release);
+    }
+
+    void SimulatedClient::stopMedia() {
+        m_mediaEnabled.store(false, std::memory_order_release);
+    }
+
+    void SimulatedClient::sendDueMedia(std::chrono::steady_clock::time_point now) {
+        if (!m_mediaEnabled.load(std::memory_order_acquire)) {
+            return;
+        }
+        for (auto& track : m_tracks) {
+            if (now < track.nextFrameAt) {
+                continue;
+            }
+            // Frames the tick missed are skipped rather than sent in a burst, and counted so a
+            // saturated generator shows up in the report instead of passing as server loss.
+            const auto behind = now - track.nextFrameAt;
+            if (behind >= track.interval) {
+                const auto missed = behind / track.interval;
+                m_lateFrames.fetch_add(static_cast<uint64_t>(missed), std::memory_order_relaxed);
+                track.nextFrameAt += track.interval * missed;
+            }
+
+            const bool keyframe = track.kind != MediaKind::Voice && now >= track.nextKeyframeAt;
+            if (keyframe) {
+                track.nextKeyframeAt = now + track.keyframeInterval;
+            }
+            sendFrame(track, keyframe, now);
+            track.nextFrameAt += track.interval;
+        }
+    }
+
+    void SimulatedClient::sendFrame(Track& track, bool keyframe, std::chrono::steady_clock::time_point now) {
+        const std::size_t metaSize = 1 + 1 + 4 + 4;
+        const std::size_t frameSize = std::max(keyframe ? track.keyframeBytes : track.frameBytes, m_framePrefixSize + metaSize + m_stampSize);
+        m_frameBuffer.resize(frameSize);
+
+        unsigned char* out = m_frameBuffer.data() + m_framePrefixSize;
+        *out++ = static_cast<unsigned char>(track.kind);
+        if (track.kind == MediaKind::Voice) {
+            const uint8_t level = m_plan.audioLevel & kMeetingFrameAudioLevelMask;
+            *out++ = static_cast<unsigned char>(level | (level < kMeetingFrameSilentAudioLevel ? kMeetingFrameVoiceActivityFlag : 0));
+        }
+        else {
+            *out++ = static_cast<unsigned char>((track.layer & kMeetingFrameLayerMask) | (keyframe ? kMeetingFrameKeyframeFlag : 0));
+        }
+        out = writeUint32(out, ++track.frameSeq);
+        out = writeUint32(out, static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count()));
+
+        // The stamp opens the payload, so it always rides in chunk 0.
+        out = writeUint32(out, m_stampMagic);
+        out = writeUint32(out, m_index);
+        writeUint64(out, static_cast<uint64_t>(steadyNanoseconds(std::chrono::steady_clock::now())));
+
+        sendChunks(static_cast<uint32_t>(track.type), frameSize);
+        if (m_measuring.load(std::memory_order_relaxed)) {
+            m_framesSent[static_cast<std::size_t>(track.kind)].fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void SimulatedClient::sendChunks(uint32_t type, std::size_t frameSize) {
+        const std::size_t totalChunks = (frameSize + m_maxChunkPayload - 1) / m_maxChunkPayload;
+        const uint64_t packetId = ++m_nextPacketId;
+
+        for (std::size_t chunkIndex = 0; chunkIndex < totalChunks; ++chunkIndex) {
+            const std::size_t offset = chunkIndex * m_maxChunkPayload;
+            const std::size_t payloadSize = std::min(m_maxChunkPayload, frameSize - offset);
+
+            unsigned char* out = std::copy(m_nicknameHashBinary.begin(), m_nicknameHashBinary.end(), m_datagram.data());
+            out = writeUint64(out, packetId);
+            out = writeUint16(out, static_cast<uint16_t>(chunkIndex));
+            out = writeUint16(out, static_cast<uint16_t>(totalChunks));
+            out = writeUint16(out, static_cast<uint16_t>(payloadSize));
+            out = writeUint32(out, type);
+            std::memcpy(out, m_frameBuffer.data() + offset, payloadSize);
+
+            // The receive chain may be inside the socket object on another thread, so sends bypass
+            // it and go to the descriptor, which the kernel makes safe to share.
+            const std::size_t size = m_chunkHeaderSize + payloadSize;
+#ifdef _WIN32
+            const auto sent = ::sendto(m_mediaSocket.native_handle(), reinterpret_cast<const char*>(m_datagram.data()),
+                static_cast<int>(size), 0, m_mediaEndpoint.data(), static_cast<int>(m_mediaEndpoint.size()));
+#else
+            const auto sent = ::sendto(m_mediaSocket.native_handle(), m_datagram.data(), size, 0,
+                m_mediaEndpoint.data(), static_cast<socklen_t>(m_mediaEndpoint.size()));
+#endif
+            if (sent < 0) {
+                m_sendErrors.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            m_sentDatagrams.fetch_add(1, std::memory_order_relaxed);
+            m_sentBytes.fetch_add(size, std::memory_order_relaxed);
+        }
+    }
+
+    void SimulatedClient::receiveMedia() {
+        m_mediaSocket.async_receive_from(asio::buffer(m_receiveBuffer), m_receivedFrom, [this](std::error_code ec, std::size_t size) {
+            if (ec == asio::error::operation_aborted || !m_mediaSocket.is_open()) {
+                return;
+            }
+            if (!ec) {
+                onMediaDatagram(size);
+            }
+            receiveMedia();
+        });
+    }
+
+    void SimulatedClient::onMediaDatagram(std::size_t size) {
+        m_receivedDatagrams.fetch_add(1, std::memory_order_relaxed);
+        m_receivedBytes.fetch_add(size, std::memory_order_relaxed);
+        if (size < m_forwardHeaderSize || !m_measuring.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        const unsigned char* data = m_receiveBuffer.data();
+        const uint64_t packetId = readUint64(data);
+        const uint16_t chunkIndex = readUint16(data + 8);
+        const uint16_t totalChunks = readUint16(data + 10);
+        const uint16_t payloadLength = readUint16(data + 12);
+        const uint32_t type = readUint32(data + 14);
+        if (!isMediaType(type) || totalChunks == 0 || chunkIndex >= totalChunks || payloadLength > size - m_forwardHeaderSize) {
+            return;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        auto [it, inserted] = m_pendingFrames.try_emplace(packetId);
+        PendingFrame& frame = it->second;
+        if (inserted) {
+            frame.firstChunkAt = now;
+            frame.totalChunks = totalChunks;
+        }
+        if (chunkIndex < 64) {
+            const uint64_t bit = uint64_t{ 1 } << chunkIndex;
+            if (frame.chunkMask & bit) {
+                return;
+            }
+            frame.chunkMask |= bit;
+        }
+        ++frame.chunksSeen;
+        if (chunkIndex == 0) {
+            readStamp(frame, data + m_forwardHeaderSize, payloadLength);
+        }
+
+        if (frame.chunksSeen >= frame.totalChunks) {
+            if (frame.stamped) {
+                completeFrame(frame, now);
+            }
+            m_pendingFrames.erase(it);
+        }
+
+        if (now - m_lastStaleCheck >= std::chrono::seconds(1)) {
+            m_lastStaleCheck = now;
+            dropStaleFrames(now);
+        }
+    }
+
+    void SimulatedClient::readStamp(PendingFrame& frame, const unsigned char* payload, std::size_t size) {
+        if (size < 3 || payload[0] != kMeetingFrameVersion1) {
+            return;
+        }
+        std::size_t offset = 1;
+        const uint16_t meetingIdLength = readUint16(payload + offset);
+        offset += 2 + meetingIdLength;
+        if (size < offset + 2) {
+            return;
+        }
+        const uint16_t senderLength = readUint16(payload + offset);
+        offset += 2 + senderLength;
+        if (size < offset + 1 + 1 + 4 + 4 + m_stampSize) {
+            return;
+        }
+
+        const auto kind = static_cast<MediaKind>(payload[offset]);
+        const uint8_t layerByte = payload[offset + 1];
+        const uint32_t frameSeq = readUint32(payload + offset + 2);
+        offset += 1 + 1 + 4 + 4;
+        if (static_cast<std::size_t>(kind) >= kMediaKindCount || readUint32(payload + offset) != m_stampMagic) {
+            return;
+        }
+        const uint32_t senderIndex = readUint32(payload + offset + 4);
+
+        frame.kind = kind;
+        frame.frameSeq = frameSeq;
+        frame.sentAtNs = static_cast<int64_t>(readUint64(payload + offset + 8));
+        frame.streamKey = streamKey(senderIndex, kind, kind == MediaKind::Voice ? 0 : static_cast<uint8_t>(layerByte & kMeetingFrameLayerMask));
+        frame.stamped = true;
+    }
+
+    void SimulatedClient::completeFrame(const PendingFrame& frame, std::chrono::steady_clock::time_point now) {
+        const int64_t latencyNs = steadyNanoseconds(now) - frame.sentAtNs;
+        m_receiveStats.latency[static_cast<std::size_t>(frame.kind)].record(static_cast<uint64_t>(std::max<int64_t>(latencyNs, 0) / 1000));
+        m_streams[frame.streamKey].onFrame(frame.frameSeq);
+    }
+
+    void SimulatedClient::dropStaleFrames(std::chrono::steady_clock::time_point now) {
+        for (auto it = m_pendingFrames.begin(); it != m_pendingFrames.end();) {
+            if (now - it->second.firstChunkAt > m_pendingFrameTimeout) {
+                ++m_receiveStats.incompleteFrames;
+                it = m_pendingFrames.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+
+    ReceiveStats SimulatedClient::collectReceiveStats() const {
+        ReceiveStats stats = m_receiveStats;
+        for (const auto& [key, tracker] : m_streams) {
+            const std::size_t kind = static_cast<std::size_t>((key >> 8) & 0xFF);
+            stats.framesReceived[kind] += tracker.received();
+            stats.framesExpected[kind] += tracker.expected();
+        }
+        return stats;
+    }
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "asio.hpp"
+#include <nlohmann/json.hpp>
+
+#include "constants/packetType.h"
+#include "loadConfig.h"
+#include "mediaStats.h"
+
+namespace loadGenerator
+{
+    // Meeting media kinds as they appear in the frame header.
+    enum class MediaKind : uint8_t {
+        Voice = 0,
+        Screen = 1,
+        Camera = 2
+    };
+    static constexpr std::size_t kMediaKindCount = 3;
+
+    struct MediaPlan {
+        bool voice = true;
+        bool camera = false;
+        bool screen = false;
+        // -dBov as the real client reports it; a fixed level per participant keeps the server's
+        // speaker selection stable, so voice gaps in the report are real loss.
+        uint8_t audioLevel = 30;
+    };
+
+    // What one client received while measuring. Only read once the media threads have stopped.
+    struct ReceiveStats {
+        std::array<LatencyHistogram, kMediaKindCount> latency;
+        std::array<uint64_t, kMediaKindCount> framesReceived{};
+        std::array<uint64_t, kMediaKindCount> framesExpected{};
+        uint64_t incompleteFrames = 0;
+    };
+
+    // One fake participant: a control connection on the control context that speaks the real
+    // handshake and JSON protocol, and a media socket on the media context that sends stamped
+    // v1 meeting frames and times the ones forwarded back to it.
+    class SimulatedClient {
+    public:
+        using ControlHandler = std::function<void(SimulatedClient& client, server::constant::PacketType type, const nlohmann::json& json)>;
+        using DisconnectHandler = std::function<void(SimulatedClient& client, const std::string& reason)>;
+
+        SimulatedClient(asio::io_context& controlContext, asio::io_context& mediaContext, const LoadConfig& config,
+            uint32_t index, const std::string& nickname, const std::string& publicKey, const std::atomic<bool>& measuring,
+            ControlHandler onControl, DisconnectHandler onDisconnected);
+
+        SimulatedClient(const SimulatedClient&) = delete;
+        SimulatedClient& operator=(const SimulatedClient&) = delete;
+
+        // Control context only.
+        void connect(const asio::ip::tcp::endpoint& controlEndpoint, const asio::ip::udp::endpoint& mediaEndpoint);
+        void sendControl(server::constant::PacketType type, const nlohmann::json& body);
+        void startMedia(const std::string& meetingId, const MediaPlan& plan);
+        void stopMedia();
+
+        // Media tick of the shard this client belongs to; never runs concurrently for one client.
+        void sendDueMedia(std::chrono::steady_clock::time_point now);
+
+        ReceiveStats collectReceiveStats() const;
+
+        uint32_t getIndex() const { return m_index; }
+        const std::string& getNicknameHash() const { return m_nicknameHash; }
+        const MediaPlan& getPlan() const { return m_plan; }
+
+        uint64_t getSentDatagrams() const { return m_sentDatagrams.load(std::memory_order_relaxed); }
+        uint64_t getSentBytes() const { return m_sentBytes.load(std::memory_order_relaxed); }
+        uint64_t getReceivedDatagrams() const { return m_receivedDatagrams.load(std::memory_order_relaxed); }
+        uint64_t getReceivedBytes() const { return m_receivedBytes.load(std::memory_order_relaxed); }
+        uint64_t getSendErrors() const { return m_sendErrors.load(std::memory_order_relaxed); }
+        uint64_t getLateFrames() const { return m_lateFrames.load(std::memory_order_relaxed); }
+        const std::array<std::atomic<uint64_t>, kMediaKindCount>& getFramesSent() const { return m_framesSent; }
+
+        // Orchestrator bookkeeping, control context only.
+        std::size_t meeting = 0;
+        std::size_t slot = 0;
+        bool authorized = false;
+        bool joinRequested = false;
+        bool joined = false;
+        int joinAttempts = 0;
+        std::chrono::steady_clock::time_point retryJoinAt{};
+        std::chrono::steady_clock::time_point announceSharingAt{};
+
+    private:
+        struct Track {
+            server::constant::PacketType type;
+            MediaKind kind;
+            uint8_t layer = 0;
+            std::size_t frameBytes = 0;
+            std::size_t keyframeBytes = 0;
+            std::chrono::nanoseconds interval{};
+            std::chrono::nanoseconds keyframeInterval{};
+            std::chrono::steady_clock::time_point nextFrameAt{};
+            std::chrono::steady_clock::time_point nextKeyframeAt{};
+            uint32_t frameSeq = 0;
+        };
+
+        struct PendingFrame {
+            std::chrono::steady_clock::time_point firstChunkAt{};
+            uint64_t chunkMask = 0;
+            uint16_t chunksSeen = 0;
+            uint16_t totalChunks = 0;
+            bool stamped = false;
+            MediaKind kind = MediaKind::Voice;
+            uint64_t streamKey = 0;
+            uint32_t frameSeq = 0;
+            int64_t sentAtNs = 0;
+        };
+
+        void readHandshake();
+        void sendAuthorization();
+        void readHeader();
+        void readBody();
+        void writeNext();
+        void fail(const std::string& reason);
+
+        void receiveMedia();
+        void onMediaDatagram(std::size_t size);
+        void readStamp(PendingFrame& frame, const unsigned char* payload, std::size_t size);
+        void completeFrame(const PendingFrame& frame, std::chrono::steady_clock::time_point now);
+        void dropStaleFrames(std::chrono::steady_clock::time_point now);
+
+        void sendFrame(Track& track, bool keyframe, std::chrono::steady_clock::time_point now);
+        void sendChunks(uint32_t type, std::size_t frameSize);
+
+        static constexpr std::size_t m_chunkHeaderSize = 50;
+        static constexpr std::size_t m_forwardHeaderSize = 18;
+        static constexpr std::size_t m_maxChunkPayload = 1300;
+        static constexpr std::size_t m_stampSize = 16;
+        static constexpr uint32_t m_stampMagic = 0x4C47454E;
+        static constexpr std::chrono::seconds m_pendingFrameTimeout{ 2 };
+
+        const LoadConfig& m_config;
+        const uint32_t m_index;
+        const std::string m_nicknameHash;
+        const std::string m_publicKey;
+        std::array<unsigned char, 32> m_nicknameHashBinary{};
+        const std::atomic<bool>& m_measuring;
+        ControlHandler m_onControl;
+        DisconnectHandler m_onDisconnected;
+
+        // Control context.
+        asio::ip::tcp::socket m_controlSocket;
+        uint64_t m_handshakeIn = 0;
+        uint64_t m_handshakeOut = 0;
+        std::array<uint32_t, 2> m_header{};
+        std::string m_body;
+        std::deque<std::string> m_outQueue;
+        bool m_closed = false;
+
+        // Tracks and the frame prefix are written once before m_mediaEnabled is set.
+        MediaPlan m_plan;
+        std::vector<Track> m_tracks;
+        std::vector<unsigned char> m_frameBuffer;
+        std::size_t m_framePrefixSize = 0;
+        std::array<unsigned char, m_chunkHeaderSize + m_maxChunkPayload> m_datagram{};
+        std::atomic<bool> m_mediaEnabled{ false };
+        uint64_t m_nextPacketId = 0;
+
+        // Media socket: the receive chain owns it, sends go straight to the descriptor.
+        asio::ip::udp::socket m_mediaSocket;
+        asio::ip::udp::endpoint m_mediaEndpoint;
+        asio::ip::udp::endpoint m_receivedFrom;
+        std::array<unsigned char, 2048> m_receiveBuffer{};
+
+        // Receive chain only.
+        std::unordered_map<uint64_t, PendingFrame> m_pendingFrames;
+        std::unordered_map<uint64_t, StreamTracker> m_streams;
+        std::chrono::steady_clock::time_point m_lastStaleCheck{};
+        ReceiveStats m_receiveStats;
+
+        std::atomic<uint64_t> m_sentDatagrams{ 0 };
+        std::atomic<uint64_t> m_sentBytes{ 0 };
+        std::atomic<uint64_t> m_receivedDatagrams{ 0 };
+        std::atomic<uint64_t> m_receivedBytes{ 0 };
+        std::atomic<uint64_t> m_sendErrors{ 0 };
+        std::atomic<uint64_t> m_lateFrames{ 0 };
+        std::array<std::atomic<uint64_t>, kMediaKindCount> m_framesSent{};
+    };
+}
@@ -23,7 +23,26 @@ namespace server::constant
     static constexpr const char* CPU_USAGE = "cpu_usage";
     static constexpr const char* MEMORY_USED = "memory_used";
     static constexpr const char* MEMORY_AVAILABLE = "memory_available";
+    static constexpr const char* PROCESS_RSS = "process_rss";
+    static constexpr const char* THREAD_COUNT = "thread_count";
+    static constexpr const char* UDP_RECEIVE_QUEUE = "udp_receive_queue";
+    static constexpr const char* UDP_SEND_QUEUE = "udp_send_queue";
+    static constexpr const char* UDP_SOCKET_DROPS = "udp_socket_drops";
+    static constexpr const char* SAMPLED_AT = "sampled_at";
+    static constexpr const char* HISTORY = "history";
     static constexpr const char* ACTIVE_USERS = "active_users";
+    static constexpr const char* PACING_QUEUE_DEPTH = "pacing_queue_depth";
+    static constexpr const char* EGRESS_VIDEO_DROPS = "egress_video_drops";
+    static constexpr const char* JOIN_KEYFRAME_QUEUED_AVG_MS = "join_keyframe_queued_avg_ms";
+    static constexpr const char* JOIN_KEYFRAME_QUEUED_MAX_MS = "join_keyframe_queued_max_ms";
+    static constexpr const char* JOIN_KEYFRAME_QUEUED_SAMPLES = "join_keyframe_queued_samples";
+    static constexpr const char* BUFFER_POOL_ACQUISITIONS = "buffer_pool_acquisitions";
+    static constexpr const char* BUFFER_POOL_HEAP_ALLOCATIONS = "buffer_pool_heap_allocations";
+    static constexpr const char* MEDIA_WORKERS = "media_workers";
+    static constexpr const char* QUEUE_DEPTH = "queue_depth";
+    static constexpr const char* UTILISATION = "utilisation";
+    static constexpr const char* PROCESSED = "processed";
+    static constexpr const char* DROPPED = "dropped";
     static constexpr const char* RECORDED_AT = "recorded_at";
     static constexpr const char* MEETING_ID = "meeting_id";
     static constexpr const char* MEETING_ID_HASH = "meeting_id_hash";
@@ -33,6 +52,14 @@ namespace server::constant
     static constexpr const char* ENCRYPTED_PARTICIPANTS = "encrypted_participants";
     static constexpr const char* REASON = "reason";
     static constexpr const char* MAX_LAYER = "max_layer";
+    static constexpr const char* LAST_N = "last_n";
+    static constexpr const char* PINNED_NICKNAME_HASHES = "pinned_nickname_hashes";
+    static constexpr const char* WIRE_VERSION = "wire_version";
+    static constexpr const char* SESSION_ID = "session_id";
+    static constexpr const char* MEETING_SESSIONS = "meeting_sessions";
+    static constexpr const char* COMPACT_MEDIA_FRAMES = "compact_media_frames";
+    static constexpr const char* MEDIA_KIND = "media_kind";
+    static constexpr const char* LAYER_ID = "layer_id";
     static constexpr const char* LOSS_PCT = "loss_pct";
     static constexpr const char* JITTER_MS = "jitter_ms";
     static constexpr const char* RTT_MS = "rtt_ms";
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace server::constant
+{
+    // Meeting frame layer byte: the low bits carry the simulcast layer id, the top bit marks a frame
+    // the decoder can start from (IDR). Receivers are only moved to another layer on such a frame.
+    static constexpr uint8_t kMeetingFrameKeyframeFlag = 0x80;
+    static constexpr uint8_t kMeetingFrameLayerMask = 0x7F;
+
+    // Voice frames have no layers; the same byte carries the audio level instead: the low bits are
+    // the level in -dBov (0 loudest, 127 silence) and the top bit is the sender's voice activity.
+    static constexpr uint8_t kMeetingFrameVoiceActivityFlag = 0x80;
+    static constexpr uint8_t kMeetingFrameAudioLevelMask = 0x7F;
+    static constexpr uint8_t kMeetingFrameSilentAudioLevel = 127;
+
+    // Wire format v2, negotiated at authorization (WIRE_VERSION) and identified by the media
+    // session id the server hands out there. The client chunk header replaces the 32-byte nickname
+    // hash with that id: marker, version, sessionId u32, packetId u32, chunkIndex u16,
+    // totalChunks u16, payloadLength u16, type u16.
+    static constexpr uint8_t kWireVersion2 = 2;
+    static constexpr uint8_t kCompactChunkHeaderMarker = 0xC2;
+    static constexpr std::size_t kCompactChunkHeaderSize = 18;
+
+    // v1 meeting frames spell out the meeting id and the hex sender hash; v2 frames are a fixed
+    // header: version, mediaKind, layer byte, reserved, senderSessionId u32, frameSeq u32, timestampMs u32.
+    // Clients send v2 frames only after MEDIA_FRAME_FORMAT allowed them for their call or meeting.
+    static constexpr uint8_t kMeetingFrameVersion1 = 1;
+    static constexpr uint8_t kMeetingFrameVersion2 = 2;
+    static constexpr std::size_t kCompactMeetingFrameHeaderSize = 16;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 
 namespace server::constant
@@ -9,6 +10,34 @@ namespace server::constant
     static constexpr int kReconnectConservativeCallLayer = 1;
     static constexpr int kReconnectConservativeMeetingLayer = 0;
 
+    // Egress pacing: receivers are paced at a multiple of their reported receive bitrate, so the
+    // stream can still grow while keyframe bursts no longer hit the receiver's link at line rate.
+    static constexpr double kPacingHeadroom = 2.0;
+    static constexpr int kMinPacingBitrateKbps = 500;
+
+    // Keyframe requests are coalesced per sender stream: every receiver that lost the same frame
+    // asks at once, but one IDR repairs all of them.
+    static constexpr int kKeyframeRequestMinIntervalMs = 300;
+
+    // Meeting voice goes to each receiver only from the kMaxForwardedSpeakers loudest senders.
+    // Levels are smoothed per sender; a louder voice takes over a slot only after staying
+    // kSpeakerSwitchMarginDb above its holder for kSpeakerSwitchHoldMs, and a new holder keeps
+    // its slot for at least kSpeakerMinActiveMs, so the forwarded set does not flap between words.
+    static constexpr std::size_t kMaxForwardedSpeakers = 3;
+    static constexpr double kSpeakerLevelAlpha = 0.2;
+    static constexpr double kSpeakerSwitchMarginDb = 6.0;
+    static constexpr int kSpeakerSwitchHoldMs = 300;
+    static constexpr int kSpeakerMinActiveMs = 1500;
+    static constexpr int kSpeakerStaleMs = 1000;
+    static constexpr int kDominantSpeakerHoldMs = 800;
+
+    // Last-N video: a meeting receiver gets camera video only from the lastN sharers that most
+    // recently held the dominant speaker, plus the ones it pinned. The owner may change lastN;
+    // 0 leaves only the pinned cameras.
+    static constexpr std::size_t kDefaultMeetingLastN = 9;
+    static constexpr std::size_t kMaxMeetingLastN = 25;
+    static constexpr std::size_t kMaxMeetingVideoPins = 9;
+
     struct AbrProfile {
         double ewmaAlpha = 0.25;
         double lossDownToMid = 0.0;
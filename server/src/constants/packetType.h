@@ -56,7 +56,25 @@ namespace server::constant
     GET_METRICS_RESULT,
     CONNECTION_DOWN_WITH_USER,
     CONNECTION_RESTORED_WITH_USER,
-    USER_LOGOUT
+    USER_LOGOUT,
+
+    // media transport (UDP), only receive
+    MEDIA_NACK,
+
+    // redirect
+    MEDIA_KEYFRAME_REQUEST,
+
+    // only send
+    MEETING_DOMINANT_SPEAKER,
+
+    // only receive
+    MEETING_VIDEO_CONFIG,
+
+    // only send
+    MEETING_SESSION_MAP,
+
+    // only send
+    MEDIA_FRAME_FORMAT
 };
 
 inline std::string packetTypeToString(PacketType type) {
@@ -112,6 +130,22 @@ inline std::string packetTypeToString(PacketType type) {
         case PacketType::CONNECTION_RESTORED_WITH_USER: return "CONNECTION_RESTORED_WITH_USER";
         case PacketType::USER_LOGOUT: return "USER_LOGOUT";
 
+        // media transport (UDP), only receive
+        case PacketType::MEDIA_NACK: return "MEDIA_NACK";
+
+        // redirect
+        case PacketType::MEDIA_KEYFRAME_REQUEST: return "MEDIA_KEYFRAME_REQUEST";
+
+        // only send
+        case PacketType::MEETING_DOMINANT_SPEAKER: return "MEETING_DOMINANT_SPEAKER";
+
+        // only receive
+        case PacketType::MEETING_VIDEO_CONFIG: return "MEETING_VIDEO_CONFIG";
+
+        // only send
+        case PacketType::MEETING_SESSION_MAP: return "MEETING_SESSION_MAP";
+        case PacketType::MEDIA_FRAME_FORMAT: return "MEDIA_FRAME_FORMAT";
+
         default: return "UNKNOWN";
     }
 }
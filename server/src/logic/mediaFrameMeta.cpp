@@ -0,0 +1,56 @@
+#include "logic/mediaFrameMeta.h"
+
+#include <cstddef>
+
+using namespace server::constant;
+
+namespace server::logic
+{
+    std::optional<MediaFrameMeta> parseMediaFrameMeta(const unsigned char* data, int size)
+    {
+        if (!data || size < 1 + 2) {
+            return std::nullopt;
+        }
+        MediaFrameMeta meta;
+        meta.version = data[0];
+        size_t mediaOffset = 0;
+        if (meta.version == kMeetingFrameVersion2) {
+            if (size < static_cast<int>(kCompactMeetingFrameHeaderSize)) {
+                return std::nullopt;
+            }
+            meta.senderSessionId = (static_cast<uint32_t>(data[4]) << 24)
+                | (static_cast<uint32_t>(data[5]) << 16)
+                | (static_cast<uint32_t>(data[6]) << 8)
+                | static_cast<uint32_t>(data[7]);
+            mediaOffset = 1;
+        }
+        else if (meta.version == kMeetingFrameVersion1) {
+            const size_t meetingLenOffset = 1;
+            const uint16_t meetingIdLen = (static_cast<uint16_t>(data[meetingLenOffset]) << 8)
+                | static_cast<uint16_t>(data[meetingLenOffset + 1]);
+            const size_t meetingIdOffset = meetingLenOffset + 2;
+            if (size < static_cast<int>(meetingIdOffset + meetingIdLen + 2)) {
+                return std::nullopt;
+            }
+            const size_t senderLenOffset = meetingIdOffset + meetingIdLen;
+            const uint16_t senderHashLen = (static_cast<uint16_t>(data[senderLenOffset]) << 8)
+                | static_cast<uint16_t>(data[senderLenOffset + 1]);
+            const size_t senderOffset = senderLenOffset + 2;
+            if (size < static_cast<int>(senderOffset + senderHashLen + 2)) {
+                return std::nullopt;
+            }
+            mediaOffset = senderOffset + senderHashLen;
+        }
+        else {
+            return std::nullopt;
+        }
+        meta.mediaKind = data[mediaOffset];
+        meta.layerId = data[mediaOffset + 1] & kMeetingFrameLayerMask;
+        meta.keyframe = (data[mediaOffset + 1] & kMeetingFrameKeyframeFlag) != 0;
+        if (meta.mediaKind == 0) {
+            meta.audioLevel = data[mediaOffset + 1] & kMeetingFrameAudioLevelMask;
+            meta.voiceActivity = (data[mediaOffset + 1] & kMeetingFrameVoiceActivityFlag) != 0;
+        }
+        return meta;
+    }
+}
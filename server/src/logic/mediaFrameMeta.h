@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+
+#include "constants/mediaFrame.h"
+
+namespace server::logic
+{
+    // Routing fields of a meeting frame, as far as the server needs them to pick receivers.
+    struct MediaFrameMeta {
+        uint8_t version = 0;
+        uint32_t senderSessionId = 0;
+        uint8_t mediaKind = 0;
+        uint8_t layerId = 0;
+        bool keyframe = false;
+        uint8_t audioLevel = constant::kMeetingFrameSilentAudioLevel;
+        bool voiceActivity = false;
+    };
+
+    // Reads only the routing fields, in place: the v1 meeting id and sender hash are skipped
+    // since the sender is already known from the chunk header.
+    std::optional<MediaFrameMeta> parseMediaFrameMeta(const unsigned char* data, int size);
+}
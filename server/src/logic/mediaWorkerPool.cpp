@@ -0,0 +1,144 @@
+#include "mediaWorkerPool.h"
+
+#include <algorithm>
+#include <exception>
+
+#include "utilities/logger.h"
+
+namespace server::logic
+{
+    MediaWorkerPool::MediaWorkerPool(std::size_t workerCount, std::function<void(MediaJob&)> handler)
+        : m_handler(std::move(handler))
+        , m_running(false)
+        , m_sampledAt(std::chrono::steady_clock::now())
+    {
+        m_droppedJobs = utilities::queueDropCounter("media_worker");
+        if (workerCount == 0) {
+            workerCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        m_workers.reserve(workerCount);
+        for (std::size_t i = 0; i < workerCount; ++i) {
+            m_workers.push_back(std::make_unique<Worker>());
+        }
+    }
+
+    MediaWorkerPool::~MediaWorkerPool()
+    {
+        stop();
+    }
+
+    void MediaWorkerPool::start()
+    {
+        if (m_running.exchange(true)) {
+            return;
+        }
+        for (auto& worker : m_workers) {
+            worker->thread = std::thread([this, &worker = *worker]() { run(worker); });
+        }
+        LOG_INFO("Media routing on {} worker thread(s)", m_workers.size());
+    }
+
+    void MediaWorkerPool::stop()
+    {
+        if (!m_running.exchange(false)) {
+            return;
+        }
+        for (auto& worker : m_workers) {
+            if (worker->thread.joinable()) {
+                worker->thread.join();
+            }
+            worker->queue.clear();
+        }
+    }
+
+    void MediaWorkerPool::dispatch(std::size_t affinityKey, MediaJob&& job)
+    {
+        // Keys are often pointers, so mix the bits before picking a worker.
+        const uint64_t mixed = (static_cast<uint64_t>(affinityKey) * 0x9E3779B97F4A7C15ULL) >> 32;
+        if (const std::size_t dropped = m_workers[mixed % m_workers.size()]->queue.push_drop_oldest(std::move(job))) {
+            m_droppedJobs.add(dropped);
+        }
+    }
+
+    std::size_t MediaWorkerPool::runPending()
+    {
+        std::size_t processed = 0;
+        for (auto& worker : m_workers) {
+            std::size_t workerProcessed = 0;
+            while (auto job = worker->queue.try_pop()) {
+                m_handler(*job);
+                ++workerProcessed;
+            }
+            worker->processed.fetch_add(workerProcessed, std::memory_order_relaxed);
+            processed += workerProcessed;
+        }
+        return processed;
+    }
+
+    std::size_t MediaWorkerPool::getWorkerCount() const
+    {
+        return m_workers.size();
+    }
+
+    std::vector<std::size_t> MediaWorkerPool::getQueueDepths() const
+    {
+        std::vector<std::size_t> depths;
+        depths.reserve(m_workers.size());
+        for (const auto& worker : m_workers) {
+            depths.push_back(worker->queue.size());
+        }
+        return depths;
+    }
+
+    std::vector<MediaWorkerPool::WorkerStats> MediaWorkerPool::sampleStats()
+    {
+        std::lock_guard<std::mutex> lock(m_sampleMutex);
+        const auto now = std::chrono::steady_clock::now();
+        const auto elapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now - m_sampledAt).count();
+        m_sampledAt = now;
+
+        std::vector<WorkerStats> stats;
+        stats.reserve(m_workers.size());
+        for (auto& worker : m_workers) {
+            const uint64_t busyNs = worker->busyNs.load(std::memory_order_relaxed);
+            WorkerStats workerStats;
+            workerStats.queueDepth = worker->queue.size();
+            workerStats.processed = worker->processed.load(std::memory_order_relaxed);
+            workerStats.dropped = worker->queue.dropped();
+            if (elapsedNs > 0) {
+                workerStats.utilisation = std::min(1.0, static_cast<double>(busyNs - worker->sampledBusyNs) / static_cast<double>(elapsedNs));
+            }
+            worker->sampledBusyNs = busyNs;
+            stats.push_back(workerStats);
+        }
+        return stats;
+    }
+
+    void MediaWorkerPool::run(Worker& worker)
+    {
+        const auto timeout = std::chrono::milliseconds(100);
+        std::vector<MediaJob> jobs;
+        jobs.reserve(m_maxBatchJobs);
+
+        while (m_running.load()) {
+            jobs.clear();
+            worker.queue.pop_batch_for(jobs, m_maxBatchJobs, timeout);
+            if (jobs.empty()) {
+                continue;
+            }
+
+            const auto startedAt = std::chrono::steady_clock::now();
+            for (auto& job : jobs) {
+                try {
+                    m_handler(job);
+                }
+                catch (const std::exception& e) {
+                    LOG_ERROR("Media routing error: {}", e.what());
+                }
+            }
+            const auto busy = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startedAt);
+            worker.busyNs.fetch_add(static_cast<uint64_t>(busy.count()), std::memory_order_relaxed);
+            worker.processed.fetch_add(jobs.size(), std::memory_order_relaxed);
+        }
+    }
+}
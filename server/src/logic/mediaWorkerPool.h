@@ -0,0 +1,87 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include "network/udp/packet.h"
+#include "utilities/bufferPool.h"
+#include "utilities/metricsRegistry.h"
+#include "utilities/ringBuffer.h"
+
+#include <asio.hpp>
+
+namespace server::logic
+{
+    // One media packet to route: a reassembled packet to forward, or chunk 0 of a cut-through
+    // packet whose receivers go back to the UDP receiver with ticket.
+    struct MediaJob {
+        utilities::PooledBuffer data;
+        uint32_t type = 0;
+        asio::ip::udp::endpoint endpoint;
+        std::array<unsigned char, 32> senderNicknameHash{};
+        std::optional<network::ForwardTicket> ticket;
+    };
+
+    // Fixed set of threads that run media routing. A job's affinity key (its meeting or call)
+    // always maps to the same worker, so one meeting's routing state is only touched by one
+    // thread, in arrival order, while independent meetings are routed in parallel.
+    class MediaWorkerPool {
+    public:
+        struct WorkerStats {
+            std::size_t queueDepth = 0;
+            // Share of wall time spent routing since the previous sampleStats call, 0..1.
+            double utilisation = 0.0;
+            uint64_t processed = 0;
+            uint64_t dropped = 0;
+        };
+
+        // workerCount 0 means one worker per hardware thread.
+        MediaWorkerPool(std::size_t workerCount, std::function<void(MediaJob&)> handler);
+        ~MediaWorkerPool();
+
+        void start();
+        void stop();
+
+        // Never blocks: a full worker queue drops its oldest job.
+        void dispatch(std::size_t affinityKey, MediaJob&& job);
+        // Handles the queued jobs on the calling thread and returns how many there were.
+        // Only for a pool that was not started.
+        std::size_t runPending();
+
+        std::size_t getWorkerCount() const;
+        std::vector<WorkerStats> sampleStats();
+        // Jobs waiting per worker; unlike sampleStats it leaves the utilisation window alone.
+        std::vector<std::size_t> getQueueDepths() const;
+
+    private:
+        static constexpr std::size_t m_maxQueueSize = 1024;
+        static constexpr std::size_t m_maxBatchJobs = 64;
+
+        struct Worker {
+            utilities::MpscRingBuffer<MediaJob> queue{ m_maxQueueSize };
+            std::atomic<uint64_t> processed{ 0 };
+            std::atomic<uint64_t> busyNs{ 0 };
+            // Busy time at the previous sample; guarded by m_sampleMutex.
+            uint64_t sampledBusyNs = 0;
+            std::thread thread;
+        };
+
+        void run(Worker& worker);
+
+        std::function<void(MediaJob&)> m_handler;
+        utilities::Counter m_droppedJobs;
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        std::atomic<bool> m_running;
+        std::mutex m_sampleMutex;
+        std::chrono::steady_clock::time_point m_sampledAt;
+    };
+}
@@ -1,5 +1,6 @@
 #include "packetFactory.h"
 #include "constants/jsonType.h"
+#include "constants/mediaFrame.h"
 #include <nlohmann/json.hpp>
 
 #include <chrono>
@@ -19,9 +20,8 @@ namespace
         return std::vector<unsigned char>(value.begin(), value.end());
     }
 
-    std::string utcTimestampIso8601() {
+    std::string utcTimestampIso8601(std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) {
         using namespace std::chrono;
-        const auto now = system_clock::now();
         const auto time = system_clock::to_time_t(now);
         const auto ms = duration_cast<milliseconds>(now.time_since_epoch()) % 1000;
         std::ostringstream oss;
@@ -41,7 +41,7 @@ std::vector<unsigned char> PacketFactory::getConfirmationPacket(const std::strin
     return toBytes(jsonObject.dump());
 }
 
-std::vector<unsigned char> PacketFactory::getAuthorizationResultPacket(bool authorized, const std::string& uid, const std::string& receiverNicknameHash, std::optional<std::string> receiverToken, std::optional<std::string> encryptedNickname, std::optional<std::string> packetKey) {
+std::vector<unsigned char> PacketFactory::getAuthorizationResultPacket(bool authorized, const std::string& uid, const std::string& receiverNicknameHash, std::optional<std::string> receiverToken, std::optional<std::string> encryptedNickname, std::optional<std::string> packetKey, std::optional<uint32_t> mediaSessionId) {
     nlohmann::json jsonObject;
 
     jsonObject[UID] = uid;
@@ -54,6 +54,10 @@ std::vector<unsigned char> PacketFactory::getAuthorizationResultPacket(bool auth
             jsonObject[ENCRYPTED_NICKNAME] = encryptedNickname.value();
         if (packetKey.has_value())
             jsonObject[PACKET_KEY] = packetKey.value();
+        if (mediaSessionId.has_value()) {
+            jsonObject[WIRE_VERSION] = kWireVersion2;
+            jsonObject[SESSION_ID] = mediaSessionId.value();
+        }
     }
 
     return toBytes(jsonObject.dump());
@@ -67,7 +71,8 @@ std::vector<unsigned char> PacketFactory::getReconnectionResultPacket(
     std::optional<bool> activeCall,
     const std::string& callPartnerNicknameHash,
     std::optional<bool> isInMeeting,
-    std::optional<std::string> meetingRosterJson)
+    std::optional<std::string> meetingRosterJson,
+    std::optional<uint32_t> mediaSessionId)
 {
     nlohmann::json jsonObject;
 
@@ -94,6 +99,11 @@ std::vector<unsigned char> PacketFactory::getReconnectionResultPacket(
         }
     }
 
+    if (reconnectedSuccessfully && mediaSessionId.has_value()) {
+        jsonObject[WIRE_VERSION] = kWireVersion2;
+        jsonObject[SESSION_ID] = mediaSessionId.value();
+    }
+
     return toBytes(jsonObject.dump());
 }
 
@@ -220,13 +230,74 @@ std::vector<unsigned char> PacketFactory::getMeetingJoinRejectedPacket(const std
     return toBytes(jsonObject.dump());
 }
 
-std::vector<unsigned char> PacketFactory::getMetricsResultPacket(double cpuUsagePercent, uint64_t memoryUsedBytes, uint64_t memoryAvailableBytes, size_t activeUsers) {
+std::vector<unsigned char> PacketFactory::getMeetingSessionMapPacket(const std::vector<std::pair<std::string, uint32_t>>& sessions)
+{
+    nlohmann::json jsonObject;
+    jsonObject[UID] = crypto::generateUID();
+    nlohmann::json entries = nlohmann::json::array();
+    for (const auto& [nicknameHash, sessionId] : sessions) {
+        entries.push_back({ { NICKNAME_HASH, nicknameHash }, { SESSION_ID, sessionId } });
+    }
+    jsonObject[MEETING_SESSIONS] = std::move(entries);
+    return toBytes(jsonObject.dump());
+}
+
+std::vector<unsigned char> PacketFactory::getMediaFrameFormatPacket(bool compactFrames)
+{
+    nlohmann::json jsonObject;
+    jsonObject[UID] = crypto::generateUID();
+    jsonObject[COMPACT_MEDIA_FRAMES] = compactFrames;
+    return toBytes(jsonObject.dump());
+}
+
+std::vector<unsigned char> PacketFactory::getMetricsResultPacket(const utilities::SystemSnapshot& system,
+    const std::vector<utilities::SystemSnapshot>& history, size_t activeUsers,
+    size_t pacingQueueDepth, uint64_t egressVideoDrops,
+    uint64_t joinKeyframeQueuedAvgMs, uint64_t joinKeyframeQueuedMaxMs, uint64_t joinKeyframeQueuedSamples,
+    uint64_t bufferPoolAcquisitions, uint64_t bufferPoolHeapAllocations,
+    const std::vector<logic::MediaWorkerPool::WorkerStats>& mediaWorkers) {
     nlohmann::json jsonObject;
 
-    jsonObject[CPU_USAGE] = cpuUsagePercent;
-    jsonObject[MEMORY_USED] = memoryUsedBytes;
-    jsonObject[MEMORY_AVAILABLE] = memoryAvailableBytes;
+    jsonObject[CPU_USAGE] = system.cpuUsagePercent;
+    jsonObject[MEMORY_USED] = system.memoryUsedBytes;
+    jsonObject[MEMORY_AVAILABLE] = system.memoryAvailableBytes;
+    jsonObject[PROCESS_RSS] = system.process.residentBytes;
+    jsonObject[THREAD_COUNT] = system.process.threadCount;
+    jsonObject[UDP_RECEIVE_QUEUE] = system.udpSockets.receiveQueueBytes;
+    jsonObject[UDP_SEND_QUEUE] = system.udpSockets.sendQueueBytes;
+    jsonObject[UDP_SOCKET_DROPS] = system.udpSockets.drops;
+    jsonObject[SAMPLED_AT] = utcTimestampIso8601(system.sampledAt);
     jsonObject[ACTIVE_USERS] = activeUsers;
+    jsonObject[PACING_QUEUE_DEPTH] = pacingQueueDepth;
+    jsonObject[EGRESS_VIDEO_DROPS] = egressVideoDrops;
+    jsonObject[JOIN_KEYFRAME_QUEUED_AVG_MS] = joinKeyframeQueuedAvgMs;
+    jsonObject[JOIN_KEYFRAME_QUEUED_MAX_MS] = joinKeyframeQueuedMaxMs;
+    jsonObject[JOIN_KEYFRAME_QUEUED_SAMPLES] = joinKeyframeQueuedSamples;
+    jsonObject[BUFFER_POOL_ACQUISITIONS] = bufferPoolAcquisitions;
+    jsonObject[BUFFER_POOL_HEAP_ALLOCATIONS] = bufferPoolHeapAllocations;
+
+    nlohmann::json workers = nlohmann::json::array();
+    for (const auto& worker : mediaWorkers) {
+        workers.push_back({
+            { QUEUE_DEPTH, worker.queueDepth },
+            { UTILISATION, worker.utilisation },
+            { PROCESSED, worker.processed },
+            { DROPPED, worker.dropped } });
+    }
+    jsonObject[MEDIA_WORKERS] = std::move(workers);
+
+    nlohmann::json samples = nlohmann::json::array();
+    for (const auto& sample : history) {
+        samples.push_back({
+            { SAMPLED_AT, utcTimestampIso8601(sample.sampledAt) },
+            { CPU_USAGE, sample.cpuUsagePercent },
+            { MEMORY_USED, sample.memoryUsedBytes },
+            { PROCESS_RSS, sample.process.residentBytes },
+            { THREAD_COUNT, sample.process.threadCount },
+            { UDP_RECEIVE_QUEUE, sample.udpSockets.receiveQueueBytes },
+            { UDP_SOCKET_DROPS, sample.udpSockets.drops } });
+    }
+    jsonObject[HISTORY] = std::move(samples);
     jsonObject[RECORDED_AT] = utcTimestampIso8601();
 
     return toBytes(jsonObject.dump());
@@ -248,6 +319,14 @@ std::vector<unsigned char> PacketFactory::getMediaSharingEndPacket(const std::st
     return toBytes(jsonObject.dump());
 }
 
+std::vector<unsigned char> PacketFactory::getDominantSpeakerPacket(const std::string& speakerNicknameHash)
+{
+    nlohmann::json jsonObject;
+    jsonObject[UID] = crypto::generateUID();
+    jsonObject[SENDER_NICKNAME_HASH] = speakerNicknameHash;
+    return toBytes(jsonObject.dump());
+}
+
 std::vector<unsigned char> PacketFactory::getMuteBeginPacket(const std::string& senderNicknameHash)
 {
     nlohmann::json jsonObject;
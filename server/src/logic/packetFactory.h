@@ -5,8 +5,11 @@
 #include <optional>
 #include <cstddef>
 #include <cstdint>
+#include <utility>
 
 #include "utilities/crypto.h"
+#include "logic/mediaWorkerPool.h"
+#include "utilities/metricsSampler.h"
 
 namespace server
 {
@@ -15,7 +18,7 @@ namespace server
         PacketFactory() = default;
     
         static std::vector<unsigned char> getConfirmationPacket(const std::string& uid, const std::string& receiverNicknameHash);
-        static std::vector<unsigned char> getAuthorizationResultPacket(bool authorized, const std::string& uid, const std::string& receiverNicknameHash, std::optional<std::string> receiverToken = std::nullopt, std::optional<std::string> encryptedNickname = std::nullopt, std::optional<std::string> packetKey = std::nullopt);
+        static std::vector<unsigned char> getAuthorizationResultPacket(bool authorized, const std::string& uid, const std::string& receiverNicknameHash, std::optional<std::string> receiverToken = std::nullopt, std::optional<std::string> encryptedNickname = std::nullopt, std::optional<std::string> packetKey = std::nullopt, std::optional<uint32_t> mediaSessionId = std::nullopt);
         static std::vector<unsigned char> getReconnectionResultPacket(
             bool reconnectedSuccessfully,
             const std::string& uid,
@@ -24,7 +27,8 @@ namespace server
             std::optional<bool> activeCall = std::nullopt,
             const std::string& callPartnerNicknameHash = "",
             std::optional<bool> isInMeeting = std::nullopt,
-            std::optional<std::string> meetingRosterJson = std::nullopt);
+            std::optional<std::string> meetingRosterJson = std::nullopt,
+            std::optional<uint32_t> mediaSessionId = std::nullopt);
         static std::vector<unsigned char> getUserInfoResultPacket(bool userInfoFound, const std::string& uid, const std::string& userNicknameHash, std::optional<CryptoPP::RSA::PublicKey> userPublicKey = std::nullopt, std::optional<std::string> encryptedNickname = std::nullopt, std::optional<std::string> packetKey = std::nullopt);
         static std::pair<std::string, std::vector<unsigned char>> getConnectionDownWithUserPacket(const std::string& userNicknameHash);
         static std::pair<std::string, std::vector<unsigned char>> getConnectionRestoredWithUserPacket(const std::string& userNicknameHash);
@@ -40,11 +44,21 @@ namespace server
         static std::vector<unsigned char> getMeetingParticipantJoinedPacket(const std::string& encryptedNickname, const std::string& serializedPublicKey);
         static std::vector<unsigned char> getMeetingParticipantLeftPacket(const std::string& nicknameHash);
         static std::vector<unsigned char> getMeetingJoinRejectedPacket(const std::string& reason);
-        static std::vector<unsigned char> getMetricsResultPacket(double cpuUsagePercent, uint64_t memoryUsedBytes, uint64_t memoryAvailableBytes, size_t activeUsers);
+        // Media session id of each listed participant, so receivers can attribute v2 meeting frames.
+        static std::vector<unsigned char> getMeetingSessionMapPacket(const std::vector<std::pair<std::string, uint32_t>>& sessions);
+        // Whether the receiver may send v2 meeting frames in its current call or meeting.
+        static std::vector<unsigned char> getMediaFrameFormatPacket(bool compactFrames);
+        static std::vector<unsigned char> getMetricsResultPacket(const utilities::SystemSnapshot& system,
+            const std::vector<utilities::SystemSnapshot>& history, size_t activeUsers,
+            size_t pacingQueueDepth, uint64_t egressVideoDrops,
+            uint64_t joinKeyframeQueuedAvgMs, uint64_t joinKeyframeQueuedMaxMs, uint64_t joinKeyframeQueuedSamples,
+            uint64_t bufferPoolAcquisitions, uint64_t bufferPoolHeapAllocations,
+            const std::vector<logic::MediaWorkerPool::WorkerStats>& mediaWorkers);
 
         // Helper packets for media sharing state (used for late joiners / reconnect).
         static std::vector<unsigned char> getMediaSharingBeginPacket(const std::string& senderNicknameHash);
         static std::vector<unsigned char> getMediaSharingEndPacket(const std::string& senderNicknameHash);
+        static std::vector<unsigned char> getDominantSpeakerPacket(const std::string& speakerNicknameHash);
         static std::vector<unsigned char> getMuteBeginPacket(const std::string& senderNicknameHash);
         static std::vector<unsigned char> getMuteEndPacket(const std::string& senderNicknameHash);
     };
@@ -0,0 +1,71 @@
+#include "logic/stateLocks.h"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace server::logic
+{
+    StateLocks::Guard::Guard(StateLocks& locks, const Meeting* meeting)
+        : m_locks(&locks)
+        , m_allLock(locks.m_allMutex)
+    {
+        if (meeting) {
+            m_meetingLock = std::unique_lock<std::mutex>(locks.m_meetingStripes[stripeOf(meeting)]);
+        }
+    }
+
+    void StateLocks::Guard::lockUsers(const std::vector<const User*>& users)
+    {
+        if (!m_userLocks.empty()) {
+            return;
+        }
+
+        std::vector<std::size_t> stripes;
+        stripes.reserve(users.size());
+        for (const User* user : users) {
+            if (user) {
+                stripes.push_back(stripeOf(user));
+            }
+        }
+        std::sort(stripes.begin(), stripes.end());
+        stripes.erase(std::unique(stripes.begin(), stripes.end()), stripes.end());
+
+        m_userLocks.reserve(stripes.size());
+        for (std::size_t stripe : stripes) {
+            m_userLocks.emplace_back(m_locks->m_userStripes[stripe]);
+        }
+    }
+
+    void StateLocks::Guard::unlock()
+    {
+        // Reverse of the acquisition order.
+        while (!m_userLocks.empty()) {
+            m_userLocks.pop_back();
+        }
+        if (m_meetingLock.owns_lock()) {
+            m_meetingLock.unlock();
+        }
+        if (m_allLock.owns_lock()) {
+            m_allLock.unlock();
+        }
+    }
+
+    StateLocks::Guard StateLocks::lock(const Meeting* meeting, std::initializer_list<const User*> users)
+    {
+        Guard guard(*this, meeting);
+        guard.lockUsers(std::vector<const User*>(users));
+        return guard;
+    }
+
+    std::unique_lock<std::shared_mutex> StateLocks::lockAll()
+    {
+        return std::unique_lock<std::shared_mutex>(m_allMutex);
+    }
+
+    std::size_t StateLocks::stripeOf(const void* object)
+    {
+        // Fibonacci hashing: heap addresses differ mostly in their middle bits.
+        const uint64_t address = static_cast<uint64_t>(reinterpret_cast<std::uintptr_t>(object));
+        return static_cast<std::size_t>((address * 0x9E3779B97F4A7C15ULL) >> 58);
+    }
+}
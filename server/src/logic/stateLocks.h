@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+namespace server
+{
+    class User;
+    class Meeting;
+}
+
+namespace server::logic
+{
+    // Locks for call and meeting state transitions. A transition locks the meeting it changes and
+    // the users whose call, pending-call or meeting state it reads or writes, so transitions on
+    // unrelated calls and meetings run in parallel. Meetings and users map onto fixed stripes; two
+    // unrelated ones sharing a stripe only cost parallelism.
+    //
+    // Lock order: the all-state lock (shared for lock(), exclusive for lockAll()), then at most one
+    // meeting stripe, then user stripes in ascending stripe order, all taken in one go. Ascending
+    // stripe order rather than caller before callee: two users calling each other at the same time
+    // would take caller-then-callee in opposite orders. Repository, manager and model mutexes and the
+    // server's table mutexes come after all of these.
+    class StateLocks {
+    public:
+        class Guard {
+        public:
+            // Takes the shared side of the all-state lock, then the meeting's stripe (none when null).
+            Guard(StateLocks& locks, const Meeting* meeting);
+
+            // Adds the stripes of users, skipping null entries. Only while the guard holds no user
+            // stripe yet, so a transition that reads a meeting's members under the meeting's stripe
+            // can lock them afterwards.
+            void lockUsers(const std::vector<const User*>& users);
+            // Releases everything early, for the part of a handler that only sends.
+            void unlock();
+
+        private:
+            StateLocks* m_locks;
+            std::shared_lock<std::shared_mutex> m_allLock;
+            std::unique_lock<std::mutex> m_meetingLock;
+            std::vector<std::unique_lock<std::mutex>> m_userLocks;
+        };
+
+        StateLocks() = default;
+        StateLocks(const StateLocks&) = delete;
+        StateLocks& operator=(const StateLocks&) = delete;
+
+        // Locks the meeting's stripe (none when null), then the users' stripes.
+        Guard lock(const Meeting* meeting, std::initializer_list<const User*> users);
+        // Excludes every other transition, for the few that cut across a user's calls and meeting
+        // at once (logout, a dropped connection).
+        std::unique_lock<std::shared_mutex> lockAll();
+
+    private:
+        static constexpr std::size_t kStripeCount = 64;
+        static std::size_t stripeOf(const void* object);
+
+        std::shared_mutex m_allMutex;
+        std::array<std::mutex, kStripeCount> m_meetingStripes;
+        std::array<std::mutex, kStripeCount> m_userStripes;
+    };
+}
@@ -11,6 +11,30 @@ namespace server::logic
 		return nullptr;
 	}
 
+	UserPtr UserRepository::findUserByBinaryHash(const std::array<unsigned char, 32>& nicknameHash) const {
+		auto index = m_binaryHashIndex[shardOf(nicknameHash)].load(std::memory_order_acquire);
+		if (!index) {
+			return nullptr;
+		}
+		auto it = index->find(nicknameHash);
+		if (it != index->end()) {
+			return it->second;
+		}
+		return nullptr;
+	}
+
+	UserPtr UserRepository::findUserByMediaSessionId(uint32_t sessionId) const {
+		auto index = m_mediaSessionIndex[shardOf(sessionId)].load(std::memory_order_acquire);
+		if (!index) {
+			return nullptr;
+		}
+		auto it = index->find(sessionId);
+		if (it != index->end()) {
+			return it->second;
+		}
+		return nullptr;
+	}
+
 	UserPtr UserRepository::findUserByTcpConnection(std::shared_ptr<network::tcp::Connection> conn) {
 		if (!conn) return nullptr;
 		std::lock_guard<std::mutex> lock(m_mutex);
@@ -24,12 +48,34 @@ namespace server::logic
 	void UserRepository::addUser(UserPtr user) {
 		if (!user) return;
 		std::lock_guard<std::mutex> lock(m_mutex);
-		m_nicknameHashToUser[user->getNicknameHash()] = user;
+		auto& slot = m_nicknameHashToUser[user->getNicknameHash()];
+		if (slot) {
+			unindexUserLocked(slot);
+		}
+		slot = user;
+		indexUserLocked(user);
+	}
+
+	bool UserRepository::tryAddUser(UserPtr user) {
+		if (!user) return false;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (!m_nicknameHashToUser.emplace(user->getNicknameHash(), user).second) {
+			return false;
+		}
+		indexUserLocked(user);
+		return true;
 	}
 
 	void UserRepository::removeUser(const std::string& nicknameHash) {
 		std::lock_guard<std::mutex> lock(m_mutex);
-		m_nicknameHashToUser.erase(nicknameHash);
+		auto it = m_nicknameHashToUser.find(nicknameHash);
+		if (it == m_nicknameHashToUser.end()) {
+			return;
+		}
+		if (it->second) {
+			unindexUserLocked(it->second);
+		}
+		m_nicknameHashToUser.erase(it);
 	}
 
 	bool UserRepository::containsUser(const std::string& nicknameHash) const {
@@ -55,4 +101,42 @@ namespace server::logic
 		}
 		return count;
 	}
+
+	uint32_t UserRepository::allocateMediaSessionId() {
+		uint32_t sessionId = m_nextMediaSessionId.fetch_add(1, std::memory_order_relaxed);
+		if (sessionId == 0) {
+			sessionId = m_nextMediaSessionId.fetch_add(1, std::memory_order_relaxed);
+		}
+		return sessionId;
+	}
+
+	std::size_t UserRepository::shardOf(const std::array<unsigned char, 32>& nicknameHash) {
+		// The in-shard hash uses the leading bytes; the last one picks the shard independently.
+		return nicknameHash[31] % m_indexShardCount;
+	}
+
+	std::size_t UserRepository::shardOf(uint32_t sessionId) {
+		// Session ids are handed out sequentially, so consecutive logins land in different shards.
+		return sessionId % m_indexShardCount;
+	}
+
+	void UserRepository::indexUserLocked(const UserPtr& user) {
+		if (user->hasNicknameHashBinary()) {
+			const auto& binaryHash = user->getNicknameHashBinary();
+			updateShard(m_binaryHashIndex[shardOf(binaryHash)], binaryHash, user);
+		}
+		if (const uint32_t sessionId = user->getMediaSessionId(); sessionId != 0) {
+			updateShard(m_mediaSessionIndex[shardOf(sessionId)], sessionId, user);
+		}
+	}
+
+	void UserRepository::unindexUserLocked(const UserPtr& user) {
+		if (user->hasNicknameHashBinary()) {
+			const auto& binaryHash = user->getNicknameHashBinary();
+			updateShard(m_binaryHashIndex[shardOf(binaryHash)], binaryHash, UserPtr());
+		}
+		if (const uint32_t sessionId = user->getMediaSessionId(); sessionId != 0) {
+			updateShard(m_mediaSessionIndex[shardOf(sessionId)], sessionId, UserPtr());
+		}
+	}
 }
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <cstring>
 #include <unordered_map>
 #include <mutex>
 #include <memory>
@@ -16,16 +19,68 @@ namespace server::logic
 		~UserRepository() = default;
 
 		UserPtr findUserByNickname(const std::string& nicknameHash);
+		// Takes no repository mutex: reads an immutable snapshot of one index shard that addUser/removeUser
+		// republish. std::atomic<std::shared_ptr> is not lock-free on common standard libraries, so the load
+		// may briefly spin while a writer swaps that shard's pointer. It never waits for m_mutex or for a shard copy.
+		UserPtr findUserByBinaryHash(const std::array<unsigned char, 32>& nicknameHash) const;
+		// Same guarantee as findUserByBinaryHash; only users that negotiated wire format v2 are indexed.
+		UserPtr findUserByMediaSessionId(uint32_t sessionId) const;
 		UserPtr findUserByTcpConnection(std::shared_ptr<network::tcp::Connection> conn);
 
 		void addUser(UserPtr user);
+		// Adds the user unless the nickname is already taken, as one step.
+		bool tryAddUser(UserPtr user);
 		void removeUser(const std::string& nicknameHash);
 		bool containsUser(const std::string& nicknameHash) const;
 		void updateUserUdpEndpoint(const std::string& nicknameHash, const asio::ip::udp::endpoint& newEndpoint);
 		size_t getActiveUsersCount() const;
+		// Never returns 0, which marks a user without a media session.
+		uint32_t allocateMediaSessionId();
+
+	private:
+		struct BinaryHashHasher {
+			std::size_t operator()(const std::array<unsigned char, 32>& hash) const {
+				// Already a SHA-256 digest, so any slice of it is uniformly distributed.
+				std::size_t value = 0;
+				std::memcpy(&value, hash.data(), sizeof(value));
+				return value;
+			}
+		};
+		using BinaryHashIndex = std::unordered_map<std::array<unsigned char, 32>, UserPtr, BinaryHashHasher>;
+		using MediaSessionIndex = std::unordered_map<uint32_t, UserPtr>;
+
+		// The lookup indexes are split into shards that are republished one at a time, so a login
+		// or logout copies about 1/m_indexShardCount of the users instead of rebuilding everything.
+		// An unpublished (null) shard is empty.
+		static constexpr std::size_t m_indexShardCount = 256;
+		template<typename Index>
+		using IndexShards = std::array<std::atomic<std::shared_ptr<const Index>>, m_indexShardCount>;
+
+		static std::size_t shardOf(const std::array<unsigned char, 32>& nicknameHash);
+		static std::size_t shardOf(uint32_t sessionId);
+
+		// Copy-on-write of one shard: user set inserts or replaces key, a null user erases it.
+		template<typename Index, typename Key>
+		static void updateShard(std::atomic<std::shared_ptr<const Index>>& shard, const Key& key, const UserPtr& user) {
+			auto current = shard.load(std::memory_order_acquire);
+			auto next = current ? std::make_shared<Index>(*current) : std::make_shared<Index>();
+			if (user) {
+				(*next)[key] = user;
+			}
+			else {
+				next->erase(key);
+			}
+			shard.store(std::move(next), std::memory_order_release);
+		}
+
+		void indexUserLocked(const UserPtr& user);
+		void unindexUserLocked(const UserPtr& user);
 
 	private:
 		mutable std::mutex m_mutex;
 		std::unordered_map<std::string, UserPtr> m_nicknameHashToUser;
+		IndexShards<BinaryHashIndex> m_binaryHashIndex;
+		IndexShards<MediaSessionIndex> m_mediaSessionIndex;
+		std::atomic<uint32_t> m_nextMediaSessionId{ 1 };
 	};
 }
@@ -2,6 +2,7 @@
 #include <filesystem>
 
 #include "server.h"
+#include "serverConfig.h"
 #include "utilities/logger.h"
 
 int main()
@@ -10,7 +11,7 @@ int main()
     
     
     try {
-        server::Server server("8081", "8081");
+        server::Server server(server::ServerConfig::fromEnvironment());
         server.run();
     }
     catch (const std::exception& e) {
@@ -2,13 +2,75 @@
 
 #include "pendingMeetingJoinRequest.h"
 #include "user.h"
+#include "constants/mediaPolicy.h"
+
+#include <algorithm>
 
 namespace server
 {
+    namespace
+    {
+        constexpr uint8_t kDefaultCameraLayer = 2;
+    }
+
+    std::optional<std::size_t> Meeting::ForwardingSnapshot::findSlot(const std::string& nicknameHash) const
+    {
+        for (std::size_t slot = 0; slot < receivers.size(); ++slot) {
+            if (receivers[slot].nicknameHash == nicknameHash) {
+                return slot;
+            }
+        }
+        return std::nullopt;
+    }
+
+    std::optional<std::size_t> Meeting::ForwardingSnapshot::findSlot(const User* user) const
+    {
+        auto it = slotByUser.find(user);
+        if (it == slotByUser.end()) {
+            return std::nullopt;
+        }
+        return it->second;
+    }
+
+    uint8_t Meeting::ForwardingSnapshot::getCameraLayer(std::optional<std::size_t> senderSlot, std::size_t receiverSlot) const
+    {
+        if (!senderSlot.has_value()) {
+            return kDefaultCameraLayer;
+        }
+        return cameraLayers[*senderSlot * receivers.size() + receiverSlot];
+    }
+
+    Meeting::CameraForwardState* Meeting::ForwardingSnapshot::getCameraForwardState(std::optional<std::size_t> senderSlot, std::size_t receiverSlot) const
+    {
+        if (!senderSlot.has_value()) {
+            return nullptr;
+        }
+        return cameraForwardStates[*senderSlot * receivers.size() + receiverSlot].get();
+    }
+
+    Meeting::ScreenForwardState* Meeting::ForwardingSnapshot::getScreenForwardState(std::optional<std::size_t> senderSlot, std::size_t receiverSlot) const
+    {
+        if (!senderSlot.has_value()) {
+            return nullptr;
+        }
+        return screenForwardStates[*senderSlot * receivers.size() + receiverSlot].get();
+    }
+
+    bool Meeting::ForwardingSnapshot::isCameraForwarded(std::optional<std::size_t> senderSlot, std::size_t receiverSlot) const
+    {
+        if (!senderSlot.has_value()) {
+            return true;
+        }
+        return cameraForwarded[*senderSlot * receivers.size() + receiverSlot] != 0;
+    }
+
     Meeting::Meeting(const std::string& meetingId, const std::string& meetingIdHash, const UserPtr& owner)
         : m_meetingId(meetingId)
         , m_meetingIdHash(meetingIdHash)
         , m_owner(owner)
+        , m_lastN(constant::kDefaultMeetingLastN)
+        , m_forwardingSnapshot(std::make_shared<const ForwardingSnapshot>())
+        , m_speakerSelector(constant::kMaxForwardedSpeakers)
     {
     }
 
@@ -42,6 +104,10 @@ namespace server
 
         std::lock_guard<std::mutex> lock(m_mutex);
         m_participants[user->getNicknameHash()] = ParticipantInfo{ user, encryptedNickname };
+        if (std::find(m_videoSpeakerOrder.begin(), m_videoSpeakerOrder.end(), user->getNicknameHash()) == m_videoSpeakerOrder.end()) {
+            m_videoSpeakerOrder.push_back(user->getNicknameHash());
+        }
+        publishForwardingSnapshotLocked();
     }
 
     std::optional<std::string> Meeting::removeParticipant(const std::string& nicknameHash)
@@ -54,6 +120,21 @@ namespace server
 
         std::string encryptedNickname = it->second.encryptedNickname;
         m_participants.erase(it);
+        m_cameraForwardStates.erase(nicknameHash);
+        for (auto& [_, perSender] : m_cameraForwardStates) {
+            perSender.erase(nicknameHash);
+        }
+        m_screenForwardStates.erase(nicknameHash);
+        for (auto& [_, perSender] : m_screenForwardStates) {
+            perSender.erase(nicknameHash);
+        }
+        m_speakerSelector.removeParticipant(nicknameHash);
+        m_videoSpeakerOrder.erase(std::remove(m_videoSpeakerOrder.begin(), m_videoSpeakerOrder.end(), nicknameHash), m_videoSpeakerOrder.end());
+        m_videoPins.erase(nicknameHash);
+        for (auto& [_, pins] : m_videoPins) {
+            pins.erase(nicknameHash);
+        }
+        publishForwardingSnapshotLocked();
         return encryptedNickname;
     }
 
@@ -130,6 +211,13 @@ namespace server
     {
         std::lock_guard<std::mutex> lock(m_mutex);
         m_screenSharers.erase(nicknameHash);
+        // The next share starts a new encoder; receivers have to wait for its first keyframe again.
+        for (auto& [_, perSender] : m_screenForwardStates) {
+            auto it = perSender.find(nicknameHash);
+            if (it != perSender.end()) {
+                it->second->forwarding.store(false, std::memory_order_relaxed);
+            }
+        }
     }
 
     std::vector<std::string> Meeting::getScreenSharers() const
@@ -141,13 +229,24 @@ namespace server
     void Meeting::addCameraSharer(const std::string& nicknameHash)
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        m_cameraSharers.insert(nicknameHash);
+        if (m_cameraSharers.insert(nicknameHash).second) {
+            publishForwardingSnapshotLocked();
+        }
     }
 
     void Meeting::removeCameraSharer(const std::string& nicknameHash)
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        m_cameraSharers.erase(nicknameHash);
+        if (m_cameraSharers.erase(nicknameHash) != 0) {
+            publishForwardingSnapshotLocked();
+        }
+        // A restarted camera comes with fresh encoders; receivers have to wait for its first keyframe again.
+        for (auto& [_, perSender] : m_cameraForwardStates) {
+            auto it = perSender.find(nicknameHash);
+            if (it != perSender.end()) {
+                it->second->forwardedLayer.store(CameraForwardState::kNoLayer, std::memory_order_relaxed);
+            }
+        }
     }
 
     std::vector<std::string> Meeting::getCameraSharers() const
@@ -180,12 +279,18 @@ namespace server
         m_screenSharers.clear();
         m_cameraSharers.clear();
         m_mutedParticipants.clear();
+        publishForwardingSnapshotLocked();
     }
 
     void Meeting::setCameraSubscriptionLayer(const std::string& receiverHash, const std::string& senderHash, uint8_t maxLayer)
     {
         std::lock_guard<std::mutex> lock(m_mutex);
-        m_cameraSubscriptions[receiverHash][senderHash] = maxLayer;
+        auto& layer = m_cameraSubscriptions[receiverHash][senderHash];
+        if (layer == maxLayer) {
+            return;
+        }
+        layer = maxLayer;
+        publishForwardingSnapshotLocked();
     }
 
     uint8_t Meeting::getCameraSubscriptionLayer(const std::string& receiverHash, const std::string& senderHash) const
@@ -193,11 +298,11 @@ namespace server
         std::lock_guard<std::mutex> lock(m_mutex);
         auto receiverIt = m_cameraSubscriptions.find(receiverHash);
         if (receiverIt == m_cameraSubscriptions.end()) {
-            return 2;
+            return kDefaultCameraLayer;
         }
         auto senderIt = receiverIt->second.find(senderHash);
         if (senderIt == receiverIt->second.end()) {
-            return 2;
+            return kDefaultCameraLayer;
         }
         return senderIt->second;
     }
@@ -216,6 +321,198 @@ namespace server
             found = true;
             required = std::max(required, it->second);
         }
-        return found ? required : 2;
+        return found ? required : kDefaultCameraLayer;
+    }
+
+    SpeakerSelector& Meeting::getSpeakerSelector()
+    {
+        return m_speakerSelector;
+    }
+
+    void Meeting::setLastN(std::size_t lastN)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        lastN = std::min(lastN, constant::kMaxMeetingLastN);
+        if (m_lastN == lastN) {
+            return;
+        }
+        m_lastN = lastN;
+        publishForwardingSnapshotLocked();
+    }
+
+    std::size_t Meeting::getLastN() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_lastN;
+    }
+
+    void Meeting::setVideoPins(const std::string& receiverHash, const std::vector<std::string>& pinnedHashes)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_participants.contains(receiverHash)) {
+            return;
+        }
+        std::unordered_set<std::string> pins;
+        for (const auto& pinnedHash : pinnedHashes) {
+            if (pins.size() == constant::kMaxMeetingVideoPins) {
+                break;
+            }
+            if (pinnedHash != receiverHash && m_participants.contains(pinnedHash)) {
+                pins.insert(pinnedHash);
+            }
+        }
+        if (pins.empty()) {
+            m_videoPins.erase(receiverHash);
+        }
+        else {
+            m_videoPins[receiverHash] = std::move(pins);
+        }
+        publishForwardingSnapshotLocked();
+    }
+
+    void Meeting::promoteVideoSpeaker(const std::string& nicknameHash)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = std::find(m_videoSpeakerOrder.begin(), m_videoSpeakerOrder.end(), nicknameHash);
+        if (it == m_videoSpeakerOrder.end() || it == m_videoSpeakerOrder.begin()) {
+            return;
+        }
+        std::rotate(m_videoSpeakerOrder.begin(), it, it + 1);
+        publishForwardingSnapshotLocked();
+    }
+
+    bool Meeting::isCameraForwarded(const std::string& receiverHash, const std::string& senderHash) const
+    {
+        const auto snapshot = getForwardingSnapshot();
+        const auto receiverSlot = snapshot->findSlot(receiverHash);
+        if (!receiverSlot) {
+            return false;
+        }
+        return snapshot->isCameraForwarded(snapshot->findSlot(senderHash), *receiverSlot);
+    }
+
+    std::optional<bool> Meeting::updateCompactMediaFrames()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        bool compactFrames = true;
+        for (const auto& [_, participant] : m_participants) {
+            if (!participant.user || participant.user->getMediaSessionId() == 0) {
+                compactFrames = false;
+                break;
+            }
+        }
+        if (compactFrames == m_compactMediaFrames) {
+            return std::nullopt;
+        }
+        m_compactMediaFrames = compactFrames;
+        return compactFrames;
+    }
+
+    bool Meeting::usesCompactMediaFrames() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_compactMediaFrames;
+    }
+
+    Meeting::ForwardingSnapshotPtr Meeting::getForwardingSnapshot() const
+    {
+        return m_forwardingSnapshot.load(std::memory_order_acquire);
+    }
+
+    void Meeting::refreshForwardingSnapshot()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        publishForwardingSnapshotLocked();
+    }
+
+    void Meeting::publishForwardingSnapshotLocked()
+    {
+        auto snapshot = std::make_shared<ForwardingSnapshot>();
+        snapshot->receivers.reserve(m_participants.size());
+        for (const auto& [nicknameHash, participant] : m_participants) {
+            if (!participant.user) {
+                continue;
+            }
+            snapshot->receivers.push_back(ForwardingSnapshot::Receiver{ participant.user, nicknameHash, participant.user->getEndpoint() });
+        }
+
+        const std::size_t count = snapshot->receivers.size();
+        snapshot->slotByUser.reserve(count);
+        for (std::size_t slot = 0; slot < count; ++slot) {
+            snapshot->slotByUser.emplace(snapshot->receivers[slot].user.get(), slot);
+        }
+        snapshot->cameraLayers.assign(count * count, kDefaultCameraLayer);
+        snapshot->cameraForwardStates.assign(count * count, nullptr);
+        snapshot->screenForwardStates.assign(count * count, nullptr);
+        for (std::size_t receiverSlot = 0; receiverSlot < count; ++receiverSlot) {
+            auto& perSender = m_cameraForwardStates[snapshot->receivers[receiverSlot].nicknameHash];
+            auto& perScreenSender = m_screenForwardStates[snapshot->receivers[receiverSlot].nicknameHash];
+            for (std::size_t senderSlot = 0; senderSlot < count; ++senderSlot) {
+                if (senderSlot == receiverSlot) {
+                    continue;
+                }
+                auto& state = perSender[snapshot->receivers[senderSlot].nicknameHash];
+                if (!state) {
+                    state = std::make_shared<CameraForwardState>();
+                }
+                snapshot->cameraForwardStates[senderSlot * count + receiverSlot] = state;
+                auto& screenState = perScreenSender[snapshot->receivers[senderSlot].nicknameHash];
+                if (!screenState) {
+                    screenState = std::make_shared<ScreenForwardState>();
+                }
+                snapshot->screenForwardStates[senderSlot * count + receiverSlot] = screenState;
+            }
+        }
+        for (std::size_t receiverSlot = 0; receiverSlot < count; ++receiverSlot) {
+            auto receiverIt = m_cameraSubscriptions.find(snapshot->receivers[receiverSlot].nicknameHash);
+            if (receiverIt == m_cameraSubscriptions.end()) {
+                continue;
+            }
+            for (std::size_t senderSlot = 0; senderSlot < count; ++senderSlot) {
+                auto senderIt = receiverIt->second.find(snapshot->receivers[senderSlot].nicknameHash);
+                if (senderIt != receiverIt->second.end()) {
+                    snapshot->cameraLayers[senderSlot * count + receiverSlot] = senderIt->second;
+                }
+            }
+        }
+
+        std::unordered_map<std::string, std::size_t> slotByHash;
+        slotByHash.reserve(count);
+        for (std::size_t slot = 0; slot < count; ++slot) {
+            slotByHash.emplace(snapshot->receivers[slot].nicknameHash, slot);
+        }
+        std::vector<std::size_t> rankedCameraSlots;
+        for (const auto& nicknameHash : m_videoSpeakerOrder) {
+            auto slotIt = slotByHash.find(nicknameHash);
+            if (slotIt != slotByHash.end() && m_cameraSharers.contains(nicknameHash)) {
+                rankedCameraSlots.push_back(slotIt->second);
+            }
+        }
+        snapshot->cameraForwarded.assign(count * count, 0);
+        for (std::size_t receiverSlot = 0; receiverSlot < count; ++receiverSlot) {
+            std::size_t taken = 0;
+            for (std::size_t senderSlot : rankedCameraSlots) {
+                if (taken == m_lastN) {
+                    break;
+                }
+                if (senderSlot == receiverSlot) {
+                    continue;
+                }
+                snapshot->cameraForwarded[senderSlot * count + receiverSlot] = 1;
+                ++taken;
+            }
+            auto pinsIt = m_videoPins.find(snapshot->receivers[receiverSlot].nicknameHash);
+            if (pinsIt == m_videoPins.end()) {
+                continue;
+            }
+            for (const auto& pinnedHash : pinsIt->second) {
+                auto slotIt = slotByHash.find(pinnedHash);
+                if (slotIt != slotByHash.end()) {
+                    snapshot->cameraForwarded[slotIt->second * count + receiverSlot] = 1;
+                }
+            }
+        }
+
+        m_forwardingSnapshot.store(std::move(snapshot), std::memory_order_release);
     }
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <memory>
 #include <mutex>
 #include <optional>
@@ -8,6 +10,10 @@
 #include <unordered_set>
 #include <vector>
 
+#include "asio.hpp"
+#include "models/speakerSelector.h"
+#include "utilities/bufferPool.h"
+
 namespace server
 {
     class User;
@@ -23,6 +29,58 @@ namespace server
             std::string encryptedNickname;
         };
 
+        // Camera layer actually forwarded for one sender/receiver pair. It trails the subscribed layer
+        // until that layer delivers a keyframe, so a receiver's decoder never starts on a P-frame.
+        // Owned by the meeting and shared by consecutive snapshots, so a republish keeps a pending switch.
+        struct CameraForwardState {
+            static constexpr uint8_t kNoLayer = 0xFF;
+
+            std::atomic<uint8_t> forwardedLayer{ kNoLayer };
+            std::atomic<int64_t> keyframeRequestedAtMs{ 0 };
+        };
+        typedef std::shared_ptr<CameraForwardState> CameraForwardStatePtr;
+
+        // Whether screen frames already flow for one sender/receiver pair. Forwarding starts on a
+        // live keyframe, so a joiner that got a cached one never decodes P-frames built on a newer one.
+        struct ScreenForwardState {
+            std::atomic<bool> forwarding{ false };
+            std::atomic<int64_t> keyframeRequestedAtMs{ 0 };
+        };
+        typedef std::shared_ptr<ScreenForwardState> ScreenForwardStatePtr;
+
+        // Immutable view of the participants for the media fan-out loop. Rebuilt on join/leave,
+        // subscription and endpoint changes and swapped in atomically, so per-packet routing
+        // walks plain arrays without touching the meeting or user locks.
+        struct ForwardingSnapshot {
+            struct Receiver {
+                UserPtr user;
+                std::string nicknameHash;
+                asio::ip::udp::endpoint endpoint;
+            };
+            // Receiver slots picked for one packet; pooled, since the fan-out loop builds one per packet.
+            using SlotList = std::vector<std::size_t, utilities::PoolAllocator<std::size_t>>;
+
+            std::vector<Receiver> receivers;
+            // Slot of each receiver by user, so the media path finds the sender without comparing hashes.
+            std::unordered_map<const User*, std::size_t> slotByUser;
+            // Selected camera layer per sender/receiver slot pair: [senderSlot * receivers.size() + receiverSlot].
+            std::vector<uint8_t> cameraLayers;
+            // Same indexing as cameraLayers; empty entries on the diagonal.
+            std::vector<CameraForwardStatePtr> cameraForwardStates;
+            // Same indexing as cameraLayers; empty entries on the diagonal.
+            std::vector<ScreenForwardStatePtr> screenForwardStates;
+            // Same indexing as cameraLayers; nonzero where the sender is in the receiver's Last-N or pinned.
+            std::vector<uint8_t> cameraForwarded;
+
+            std::optional<std::size_t> findSlot(const std::string& nicknameHash) const;
+            std::optional<std::size_t> findSlot(const User* user) const;
+            uint8_t getCameraLayer(std::optional<std::size_t> senderSlot, std::size_t receiverSlot) const;
+            CameraForwardState* getCameraForwardState(std::optional<std::size_t> senderSlot, std::size_t receiverSlot) const;
+            ScreenForwardState* getScreenForwardState(std::optional<std::size_t> senderSlot, std::size_t receiverSlot) const;
+            bool isCameraForwarded(std::optional<std::size_t> senderSlot, std::size_t receiverSlot) const;
+        };
+        typedef std::shared_ptr<const ForwardingSnapshot> ForwardingSnapshotPtr;
+
         Meeting(const std::string& meetingId, const std::string& meetingIdHash, const UserPtr& owner);
 
         const std::string& getMeetingId() const;
@@ -58,6 +116,29 @@ namespace server
         uint8_t getCameraSubscriptionLayer(const std::string& receiverHash, const std::string& senderHash) const;
         uint8_t getRequiredSenderLayer(const std::string& senderHash) const;
 
+        // Thread-safe on its own; used from the media path without the meeting lock.
+        SpeakerSelector& getSpeakerSelector();
+
+        // Last-N video. Sharers are ranked by when they last became the dominant speaker;
+        // participants that never did keep their join order behind them.
+        void setLastN(std::size_t lastN);
+        std::size_t getLastN() const;
+        void setVideoPins(const std::string& receiverHash, const std::vector<std::string>& pinnedHashes);
+        void promoteVideoSpeaker(const std::string& nicknameHash);
+        bool isCameraForwarded(const std::string& receiverHash, const std::string& senderHash) const;
+
+        // Whether senders may use v2 meeting frames: only while every participant negotiated wire
+        // format v2. Re-evaluates after a join or leave and returns the new value when it changed.
+        std::optional<bool> updateCompactMediaFrames();
+        bool usesCompactMediaFrames() const;
+
+        ForwardingSnapshotPtr getForwardingSnapshot() const;
+        // Call after a participant's UDP endpoint changed.
+        void refreshForwardingSnapshot();
+
+    private:
+        void publishForwardingSnapshotLocked();
+
     private:
         mutable std::mutex m_mutex;
         std::string m_meetingId;
@@ -69,5 +150,13 @@ namespace server
         std::unordered_set<std::string> m_cameraSharers;
         std::unordered_set<std::string> m_mutedParticipants;
         std::unordered_map<std::string, std::unordered_map<std::string, uint8_t>> m_cameraSubscriptions;
+        std::unordered_map<std::string, std::unordered_map<std::string, CameraForwardStatePtr>> m_cameraForwardStates;
+        std::unordered_map<std::string, std::unordered_map<std::string, ScreenForwardStatePtr>> m_screenForwardStates;
+        std::size_t m_lastN;
+        std::vector<std::string> m_videoSpeakerOrder;
+        std::unordered_map<std::string, std::unordered_set<std::string>> m_videoPins;
+        bool m_compactMediaFrames = false;
+        std::atomic<ForwardingSnapshotPtr> m_forwardingSnapshot;
+        SpeakerSelector m_speakerSelector;
     };
 }
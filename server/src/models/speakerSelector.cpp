@@ -0,0 +1,186 @@
+#include "speakerSelector.h"
+
+#include "constants/mediaPolicy.h"
+
+#include <algorithm>
+
+namespace server
+{
+    namespace
+    {
+        bool isStale(std::chrono::steady_clock::time_point lastFrameAt, std::chrono::steady_clock::time_point now)
+        {
+            return now - lastFrameAt > std::chrono::milliseconds(constant::kSpeakerStaleMs);
+        }
+    }
+
+    SpeakerSelector::SpeakerSelector(std::size_t maxSpeakers)
+        : m_maxSpeakers(maxSpeakers == 0 ? 1 : maxSpeakers),
+        m_publishedActiveSpeakers(std::make_shared<const std::vector<std::string>>())
+    {
+    }
+
+    SpeakerSelector::Decision SpeakerSelector::onVoiceFrame(const std::string& senderHash, uint8_t audioLevel, bool voiceActivity,
+        std::chrono::steady_clock::time_point now)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto [it, inserted] = m_speakers.try_emplace(senderHash);
+        Speaker& speaker = it->second;
+        if (inserted || isStale(speaker.lastFrameAt, now)) {
+            speaker.level = audioLevel;
+        }
+        else {
+            speaker.level += constant::kSpeakerLevelAlpha * (static_cast<double>(audioLevel) - speaker.level);
+        }
+        speaker.voiceActivity = voiceActivity;
+        speaker.lastFrameAt = now;
+
+        dropStaleLocked(now);
+        if (!speaker.active) {
+            promoteLocked(senderHash, speaker, now);
+        }
+
+        Decision decision;
+        decision.dominantSpeaker = updateDominantLocked(senderHash, speaker, now);
+        if (speaker.active) {
+            decision.route = Route::All;
+        }
+        else if (isLoudestInactiveLocked(senderHash, now)) {
+            decision.route = Route::ActiveReceiversOnly;
+            decision.activeSpeakers = m_publishedActiveSpeakers;
+        }
+        return decision;
+    }
+
+    void SpeakerSelector::removeParticipant(const std::string& nicknameHash)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_speakers.erase(nicknameHash);
+        auto removedBegin = std::remove(m_activeSpeakers.begin(), m_activeSpeakers.end(), nicknameHash);
+        if (removedBegin != m_activeSpeakers.end()) {
+            m_activeSpeakers.erase(removedBegin, m_activeSpeakers.end());
+            publishActiveSpeakersLocked();
+        }
+        if (m_dominantSpeaker == nicknameHash) {
+            m_dominantSpeaker.clear();
+        }
+        if (m_dominantChallenger == nicknameHash) {
+            m_dominantChallenger.clear();
+        }
+    }
+
+    void SpeakerSelector::publishActiveSpeakersLocked()
+    {
+        m_publishedActiveSpeakers = std::make_shared<const std::vector<std::string>>(m_activeSpeakers);
+    }
+
+    void SpeakerSelector::dropStaleLocked(std::chrono::steady_clock::time_point now)
+    {
+        // Muted or disconnected senders stop sending voice; free their slots.
+        auto staleBegin = std::remove_if(m_activeSpeakers.begin(), m_activeSpeakers.end(), [this, now](const std::string& hash) {
+            auto it = m_speakers.find(hash);
+            if (it == m_speakers.end()) {
+                return true;
+            }
+            if (!isStale(it->second.lastFrameAt, now)) {
+                return false;
+            }
+            it->second.active = false;
+            return true;
+        });
+        if (staleBegin != m_activeSpeakers.end()) {
+            m_activeSpeakers.erase(staleBegin, m_activeSpeakers.end());
+            publishActiveSpeakersLocked();
+        }
+    }
+
+    void SpeakerSelector::promoteLocked(const std::string& senderHash, Speaker& speaker, std::chrono::steady_clock::time_point now)
+    {
+        if (m_activeSpeakers.size() < m_maxSpeakers) {
+            speaker.active = true;
+            speaker.activeSince = now;
+            speaker.louderSince = {};
+            m_activeSpeakers.push_back(senderHash);
+            publishActiveSpeakersLocked();
+            return;
+        }
+
+        auto weakestIt = std::max_element(m_activeSpeakers.begin(), m_activeSpeakers.end(),
+            [this](const std::string& lhs, const std::string& rhs) { return m_speakers[lhs].level < m_speakers[rhs].level; });
+        Speaker& weakest = m_speakers[*weakestIt];
+        if (!speaker.voiceActivity || speaker.level + constant::kSpeakerSwitchMarginDb >= weakest.level) {
+            speaker.louderSince = {};
+            return;
+        }
+        if (speaker.louderSince.time_since_epoch().count() == 0) {
+            speaker.louderSince = now;
+            return;
+        }
+        if (now - speaker.louderSince < std::chrono::milliseconds(constant::kSpeakerSwitchHoldMs)
+            || now - weakest.activeSince < std::chrono::milliseconds(constant::kSpeakerMinActiveMs)) {
+            return;
+        }
+
+        weakest.active = false;
+        speaker.active = true;
+        speaker.activeSince = now;
+        speaker.louderSince = {};
+        *weakestIt = senderHash;
+        publishActiveSpeakersLocked();
+    }
+
+    bool SpeakerSelector::isLoudestInactiveLocked(const std::string& senderHash, std::chrono::steady_clock::time_point now) const
+    {
+        auto senderIt = m_speakers.find(senderHash);
+        if (senderIt == m_speakers.end()) {
+            return false;
+        }
+        for (const auto& [hash, speaker] : m_speakers) {
+            if (hash == senderHash || speaker.active || isStale(speaker.lastFrameAt, now)) {
+                continue;
+            }
+            if (speaker.level < senderIt->second.level || (speaker.level == senderIt->second.level && hash < senderHash)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    std::optional<std::string> SpeakerSelector::updateDominantLocked(const std::string& senderHash, const Speaker& speaker,
+        std::chrono::steady_clock::time_point now)
+    {
+        if (m_dominantSpeaker == senderHash) {
+            return std::nullopt;
+        }
+        if (!speaker.active || !speaker.voiceActivity) {
+            if (m_dominantChallenger == senderHash) {
+                m_dominantChallenger.clear();
+            }
+            return std::nullopt;
+        }
+
+        // The dominant speaker keeps the floor through pauses until someone is clearly louder for a while.
+        auto holderIt = m_speakers.find(m_dominantSpeaker);
+        const bool holderPresent = holderIt != m_speakers.end() && holderIt->second.active;
+        if (holderPresent) {
+            if (speaker.level + constant::kSpeakerSwitchMarginDb >= holderIt->second.level) {
+                if (m_dominantChallenger == senderHash) {
+                    m_dominantChallenger.clear();
+                }
+                return std::nullopt;
+            }
+            if (m_dominantChallenger != senderHash) {
+                m_dominantChallenger = senderHash;
+                m_dominantChallengeSince = now;
+                return std::nullopt;
+            }
+            if (now - m_dominantChallengeSince < std::chrono::milliseconds(constant::kDominantSpeakerHoldMs)) {
+                return std::nullopt;
+            }
+        }
+
+        m_dominantSpeaker = senderHash;
+        m_dominantChallenger.clear();
+        return m_dominantSpeaker;
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace server
+{
+    // Chooses which voices of a meeting are forwarded, from the audio level each voice frame carries
+    // in its header. At most maxSpeakers senders are active; every receiver gets the active voices
+    // other than its own, and an active receiver additionally gets the loudest inactive one so it
+    // also hears maxSpeakers others. The loudest active voice is tracked as the dominant speaker.
+    class SpeakerSelector {
+    public:
+        enum class Route {
+            None,
+            All,
+            ActiveReceiversOnly
+        };
+
+        struct Decision {
+            Route route = Route::None;
+            // Filled for ActiveReceiversOnly: the receivers that get this frame. Shared with the
+            // selector until the active set changes, so a decision never copies it.
+            std::shared_ptr<const std::vector<std::string>> activeSpeakers;
+            // Set when this frame made its sender the dominant speaker.
+            std::optional<std::string> dominantSpeaker;
+        };
+
+        explicit SpeakerSelector(std::size_t maxSpeakers);
+
+        // audioLevel is in -dBov (0 loudest, 127 silence).
+        Decision onVoiceFrame(const std::string& senderHash, uint8_t audioLevel, bool voiceActivity,
+            std::chrono::steady_clock::time_point now);
+        void removeParticipant(const std::string& nicknameHash);
+
+    private:
+        struct Speaker {
+            double level = 127.0;
+            bool voiceActivity = false;
+            bool active = false;
+            std::chrono::steady_clock::time_point lastFrameAt{};
+            std::chrono::steady_clock::time_point activeSince{};
+            std::chrono::steady_clock::time_point louderSince{};
+        };
+
+        void publishActiveSpeakersLocked();
+        void dropStaleLocked(std::chrono::steady_clock::time_point now);
+        void promoteLocked(const std::string& senderHash, Speaker& speaker, std::chrono::steady_clock::time_point now);
+        bool isLoudestInactiveLocked(const std::string& senderHash, std::chrono::steady_clock::time_point now) const;
+        std::optional<std::string> updateDominantLocked(const std::string& senderHash, const Speaker& speaker,
+            std::chrono::steady_clock::time_point now);
+
+    private:
+        mutable std::mutex m_mutex;
+        const std::size_t m_maxSpeakers;
+        std::unordered_map<std::string, Speaker> m_speakers;
+        std::vector<std::string> m_activeSpeakers;
+        // Copy of m_activeSpeakers handed out with decisions, replaced whenever it changes.
+        std::shared_ptr<const std::vector<std::string>> m_publishedActiveSpeakers;
+        std::string m_dominantSpeaker;
+        std::string m_dominantChallenger;
+        std::chrono::steady_clock::time_point m_dominantChallengeSince{};
+    };
+}
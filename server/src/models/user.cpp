@@ -3,15 +3,33 @@
 #include "pendingCall.h"
 #include "meeting.h"
 #include "pendingMeetingJoinRequest.h"
+#include "network/udp/endpointKey.h"
 
 #include <chrono>
 #include <vector>
 
 namespace server
 {
+namespace
+{
+	// Exact for IPv4 (address and port packed), hashed for IPv6.
+	uint64_t endpointFingerprint(const asio::ip::udp::endpoint& endpoint)
+	{
+		if (endpoint.address().is_v4()) {
+			return (1ULL << 63) | (static_cast<uint64_t>(endpoint.address().to_v4().to_uint()) << 16) | endpoint.port();
+		}
+		return network::udp::EndpointKeyHash{}(network::udp::EndpointKey::from(endpoint)) & ~(1ULL << 63);
+	}
+}
+
 User::User(const std::string& nicknameHash, const std::string& token, const CryptoPP::RSA::PublicKey& publicKey, asio::ip::udp::endpoint endpoint, std::function<void()> onReconnectionTimeout)
 	: m_nicknameHash(nicknameHash), m_token(token), m_publicKey(publicKey), m_endpoint(endpoint), m_onReconnectionTimeout(std::move(onReconnectionTimeout))
 {
+	if (auto binary = utilities::crypto::hashToBinary(nicknameHash)) {
+		m_nicknameHashBinary = *binary;
+		m_hasNicknameHashBinary = true;
+	}
+	m_endpointFingerprint.store(endpointFingerprint(endpoint), std::memory_order_relaxed);
 }
 
 bool User::isConnectionDown()
@@ -22,8 +40,27 @@ bool User::isConnectionDown()
 
 void User::setEndpoint(asio::ip::udp::endpoint endpoint)
 {
-	std::lock_guard<std::mutex> lock(m_mutex);
-	m_endpoint = endpoint;
+	MeetingPtr meeting;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_endpoint = endpoint;
+		m_endpointFingerprint.store(endpointFingerprint(endpoint), std::memory_order_relaxed);
+		meeting = m_meeting.lock();
+	}
+	// The meeting fan-out reads endpoints from its snapshot; refresh it outside our lock.
+	if (meeting) {
+		meeting->refreshForwardingSnapshot();
+	}
+}
+
+bool User::updateEndpointIfChanged(const asio::ip::udp::endpoint& endpoint)
+{
+	const uint64_t fingerprint = endpointFingerprint(endpoint);
+	if (m_endpointFingerprint.load(std::memory_order_relaxed) == fingerprint) {
+		return false;
+	}
+	setEndpoint(endpoint);
+	return true;
 }
 
 void User::setTcpConnection(std::shared_ptr<network::TcpConnection> conn)
@@ -70,6 +107,26 @@ const std::string& User::getNicknameHash() const
 	return m_nicknameHash;
 }
 
+const std::array<unsigned char, 32>& User::getNicknameHashBinary() const
+{
+	return m_nicknameHashBinary;
+}
+
+bool User::hasNicknameHashBinary() const
+{
+	return m_hasNicknameHashBinary;
+}
+
+uint32_t User::getMediaSessionId() const
+{
+	return m_mediaSessionId;
+}
+
+void User::setMediaSessionId(uint32_t sessionId)
+{
+	m_mediaSessionId = sessionId;
+}
+
 const std::string& User::getToken() const
 {
 	return m_token;
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <memory>
 #include <string>
 #include <functional>
@@ -44,6 +46,10 @@ public:
 	
 	const CryptoPP::RSA::PublicKey& getPublicKey() const;
 	const std::string& getNicknameHash() const;
+	const std::array<unsigned char, 32>& getNicknameHashBinary() const;
+	bool hasNicknameHashBinary() const;
+	// Nonzero once the client negotiated wire format v2; set before the user is published.
+	uint32_t getMediaSessionId() const;
 	const std::string& getToken() const;
 	asio::ip::udp::endpoint getEndpoint() const;
 	CallPtr getCall() const;
@@ -55,7 +61,10 @@ public:
     PendingMeetingJoinRequestPtr getPendingMeetingJoinRequest() const;
 
 	void setConnectionDown(bool value);
+	void setMediaSessionId(uint32_t sessionId);
 	void setEndpoint(asio::ip::udp::endpoint endpoint);
+	// Called per media packet: compares lock-free and only takes the mutex when the endpoint moved.
+	bool updateEndpointIfChanged(const asio::ip::udp::endpoint& endpoint);
 	void setTcpConnection(std::shared_ptr<network::TcpConnection> conn);
 	std::shared_ptr<network::TcpConnection> getTcpConnection() const;
 	void clearTcpConnection();
@@ -75,6 +84,9 @@ private:
 	mutable std::mutex m_mutex;
 	bool m_connectionDown = false;
 	std::string m_nicknameHash;
+	std::array<unsigned char, 32> m_nicknameHashBinary{};
+	bool m_hasNicknameHashBinary = false;
+	uint32_t m_mediaSessionId = 0;
 	std::string m_token;
 	std::weak_ptr<Call> m_call;
 	std::weak_ptr<PendingCall> m_outgoingPendingCall;
@@ -83,6 +95,7 @@ private:
     std::weak_ptr<PendingMeetingJoinRequest> m_pendingMeetingJoinRequest;
 	CryptoPP::RSA::PublicKey m_publicKey;
 	asio::ip::udp::endpoint m_endpoint;
+	std::atomic<uint64_t> m_endpointFingerprint{ 0 };
 	std::weak_ptr<network::TcpConnection> m_tcpConnection;
 
 	std::function<void()> m_onReconnectionTimeout;
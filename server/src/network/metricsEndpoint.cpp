@@ -0,0 +1,163 @@
+#include "network/metricsEndpoint.h"
+#include "utilities/logger.h"
+#include "utilities/errorCodeForLog.h"
+
+#include <chrono>
+#include <exception>
+#include <utility>
+
+using namespace std::chrono_literals;
+
+namespace server::network
+{
+    class MetricsEndpoint::Session : public std::enable_shared_from_this<Session> {
+    public:
+        Session(asio::ip::tcp::socket socket, const std::function<std::string()>& render)
+            : m_socket(std::move(socket))
+            , m_timer(m_socket.get_executor())
+            , m_render(render)
+        {
+        }
+
+        void start() {
+            // A scraper that never finishes its request is cut off.
+            m_timer.expires_after(5s);
+            m_timer.async_wait([self = shared_from_this()](const std::error_code& ec) {
+                if (!ec) {
+                    std::error_code ignored;
+                    self->m_socket.close(ignored);
+                }
+            });
+
+            asio::async_read_until(m_socket, asio::dynamic_buffer(m_request, m_maxRequestSize), "\r\n\r\n",
+                [self = shared_from_this()](const std::error_code& ec, std::size_t) {
+                    if (ec) {
+                        self->m_timer.cancel();
+                        return;
+                    }
+                    self->respond();
+                });
+        }
+
+    private:
+        void respond() {
+            std::string status = "200 OK";
+            std::string body;
+            const bool isGet = m_request.rfind("GET ", 0) == 0;
+            const std::size_t pathEnd = m_request.find(' ', 4);
+            const std::string path = isGet && pathEnd != std::string::npos ? m_request.substr(4, pathEnd - 4) : std::string();
+            if (!isGet) {
+                status = "405 Method Not Allowed";
+            }
+            else if (path != "/metrics" && path != "/") {
+                status = "404 Not Found";
+            }
+            else {
+                try {
+                    body = m_render();
+                }
+                catch (const std::exception& e) {
+                    LOG_ERROR("[Metrics] Failed to render metrics: {}", e.what());
+                    status = "500 Internal Server Error";
+                }
+            }
+
+            m_response = "HTTP/1.1 " + status + "\r\n"
+                "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                "Connection: close\r\n\r\n" + body;
+
+            asio::async_write(m_socket, asio::buffer(m_response),
+                [self = shared_from_this()](const std::error_code&, std::size_t) {
+                    std::error_code ignored;
+                    self->m_socket.shutdown(asio::ip::tcp::socket::shutdown_both, ignored);
+                    self->m_socket.close(ignored);
+                    self->m_timer.cancel();
+                });
+        }
+
+        static constexpr std::size_t m_maxRequestSize = 8192;
+
+        asio::ip::tcp::socket m_socket;
+        asio::steady_timer m_timer;
+        const std::function<std::string()>& m_render;
+        std::string m_request;
+        std::string m_response;
+    };
+
+    MetricsEndpoint::MetricsEndpoint(std::string address, std::string port, std::function<std::string()> render)
+        : m_address(std::move(address))
+        , m_port(std::move(port))
+        , m_render(std::move(render))
+        , m_acceptor(m_ctx)
+    {
+    }
+
+    MetricsEndpoint::~MetricsEndpoint() {
+        stop();
+    }
+
+    bool MetricsEndpoint::start() {
+        if (m_running.exchange(true))
+            return true;
+
+        std::error_code ec;
+        asio::ip::tcp::resolver resolver(m_ctx);
+        auto endpoints = resolver.resolve(m_address, m_port, asio::ip::tcp::resolver::passive, ec);
+        if (ec || endpoints.empty()) {
+            LOG_ERROR("[Metrics] Failed to resolve {}:{} - {}", m_address, m_port, server::utilities::errorCodeForLog(ec));
+            m_running = false;
+            return false;
+        }
+
+        const asio::ip::tcp::endpoint endpoint = *endpoints.begin();
+        m_acceptor.open(endpoint.protocol(), ec);
+        if (!ec) m_acceptor.set_option(asio::socket_base::reuse_address(true), ec);
+        if (!ec) m_acceptor.bind(endpoint, ec);
+        if (!ec) m_acceptor.listen(asio::socket_base::max_listen_connections, ec);
+        if (ec) {
+            LOG_ERROR("[Metrics] Failed to listen on {}:{} - {}", m_address, m_port, server::utilities::errorCodeForLog(ec));
+            std::error_code ignored;
+            m_acceptor.close(ignored);
+            m_running = false;
+            return false;
+        }
+
+        waitForScrapers();
+        m_ctxThread = std::thread([this]() {
+            try {
+                m_ctx.run();
+            }
+            catch (const std::exception& e) {
+                LOG_ERROR("[Metrics] io_context exception: {}", e.what());
+            }
+        });
+        LOG_INFO("[Metrics] Serving metrics on http://{}:{}/metrics", m_address, m_port);
+        return true;
+    }
+
+    void MetricsEndpoint::stop() {
+        if (!m_running.exchange(false))
+            return;
+        m_ctx.stop();
+        if (m_ctxThread.joinable())
+            m_ctxThread.join();
+        std::error_code ignored;
+        m_acceptor.close(ignored);
+    }
+
+    void MetricsEndpoint::waitForScrapers() {
+        m_acceptor.async_accept([this](std::error_code ec, asio::ip::tcp::socket socket) {
+            if (ec) {
+                if (ec != asio::error::operation_aborted)
+                    LOG_WARN("[Metrics] Accept error: {}", server::utilities::errorCodeForLog(ec));
+                if (m_running.load() && m_acceptor.is_open())
+                    waitForScrapers();
+                return;
+            }
+            std::make_shared<Session>(std::move(socket), m_render)->start();
+            if (m_running.load())
+                waitForScrapers();
+        });
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "asio.hpp"
+
+namespace server::network
+{
+    // Plain HTTP responder for metrics scrapers: GET /metrics answers with render() as
+    // Prometheus text, one request per connection, on its own io_context thread so a slow
+    // scraper never touches the control or media threads.
+    class MetricsEndpoint {
+    public:
+        MetricsEndpoint(std::string address, std::string port, std::function<std::string()> render);
+        ~MetricsEndpoint();
+
+        // False when the address cannot be bound; the server keeps running without the endpoint.
+        bool start();
+        void stop();
+
+    private:
+        class Session;
+
+        void waitForScrapers();
+
+        std::string m_address;
+        std::string m_port;
+        std::function<std::string()> m_render;
+        std::atomic<bool> m_running{ false };
+
+        asio::io_context m_ctx;
+        asio::ip::tcp::acceptor m_acceptor;
+        std::thread m_ctxThread;
+    };
+}
@@ -6,13 +6,35 @@ namespace server::network
 {
 	NetworkController::NetworkController(
 		uint16_t tcpPort,
+		std::size_t tcpHandlerCount,
 		const std::string& udpPort,
+		std::size_t udpWorkerCount,
 		tcp::Server::OnPacket onTcpPacket,
 		tcp::Server::OnDisconnect onTcpDisconnect,
 		std::function<void(const unsigned char*, int, uint32_t, const asio::ip::udp::endpoint&, const std::array<unsigned char, 32>&)> onUdpReceive)
-		: m_tcpServer(tcpPort, std::move(onTcpPacket), std::move(onTcpDisconnect))
+		: m_tcpServer(tcpPort, tcpHandlerCount, std::move(onTcpPacket), std::move(onTcpDisconnect))
 	{
-		m_udpServer.init(udpPort, std::move(onUdpReceive));
+		m_udpServer.init(udpPort, udpWorkerCount, std::move(onUdpReceive));
+	}
+
+	void NetworkController::setUdpForwardDispatcher(udp::PacketReceiver::ForwardDispatcher dispatchTargets) {
+		m_udpServer.setForwardDispatcher(std::move(dispatchTargets));
+	}
+
+	void NetworkController::completeUdpForward(const ForwardTicket& ticket, ForwardTargets&& targets) {
+		m_udpServer.completeForward(ticket, std::move(targets));
+	}
+
+	void NetworkController::enableUdpRetransmission(std::chrono::milliseconds window) {
+		m_udpServer.enableRetransmission(window);
+	}
+
+	void NetworkController::setUdpSessionResolver(udp::PacketReceiver::SessionResolver resolveSession) {
+		m_udpServer.setSessionResolver(std::move(resolveSession));
+	}
+
+	void NetworkController::enableUdpSegmentationOffload() {
+		m_udpServer.enableSegmentationOffload();
 	}
 
 	NetworkController::~NetworkController() {
@@ -40,4 +62,44 @@ namespace server::network
 	bool NetworkController::sendUdp(const unsigned char* data, int size, uint32_t type, const asio::ip::udp::endpoint& endpoint) {
 		return m_udpServer.send(data, size, type, endpoint);
 	}
+
+	bool NetworkController::sendUdp(const unsigned char* data, int size, uint32_t type, const ForwardTargets& targets) {
+		return m_udpServer.send(data, size, type, targets);
+	}
+
+	bool NetworkController::replayUdpKeyframe(const KeyframeKey& key, const asio::ip::udp::endpoint& endpoint) {
+		return m_udpServer.replayKeyframe(key, endpoint);
+	}
+
+	void NetworkController::dropUdpKeyframe(const KeyframeKey& key) {
+		m_udpServer.dropKeyframe(key);
+	}
+
+	void NetworkController::dropUdpKeyframes(const std::array<unsigned char, 32>& owner) {
+		m_udpServer.dropKeyframes(owner);
+	}
+
+	void NetworkController::setUdpPacingRate(const asio::ip::udp::endpoint& endpoint, uint32_t kbps) {
+		m_udpServer.setPacingRate(endpoint, kbps);
+	}
+
+	std::size_t NetworkController::getUdpPacingQueueDepth() const {
+		return m_udpServer.getPacingQueueDepth();
+	}
+
+	std::size_t NetworkController::getTcpQueuedPackets() const {
+		return m_tcpServer.getQueuedPackets();
+	}
+
+	uint64_t NetworkController::getUdpDroppedVideoEntries() const {
+		return m_udpServer.getDroppedVideoEntries();
+	}
+
+	void NetworkController::holdUdpSending() {
+		m_udpServer.holdSending();
+	}
+
+	std::size_t NetworkController::discardQueuedUdpSends() {
+		return m_udpServer.discardQueuedSends();
+	}
 }
@@ -1,5 +1,7 @@
 #pragma once
 #include <array>
+#include <chrono>
+#include <cstddef>
 #include <functional>
 #include <string>
 #include <vector>
@@ -15,19 +17,40 @@ namespace server
         class NetworkController {
         public:
             NetworkController(uint16_t tcpPort,
+                std::size_t tcpHandlerCount,
                 const std::string& udpPort,
+                std::size_t udpWorkerCount,
                 tcp::Server::OnPacket onTcpPacket,
                 tcp::Server::OnDisconnect onTcpDisconnect,
                 std::function<void(const unsigned char*, int, uint32_t, const asio::ip::udp::endpoint&, const std::array<unsigned char, 32>&)> onUdpReceive);
 
             ~NetworkController();
 
+            void setUdpForwardDispatcher(udp::PacketReceiver::ForwardDispatcher dispatchTargets);
+            void completeUdpForward(const ForwardTicket& ticket, ForwardTargets&& targets);
+            void enableUdpRetransmission(std::chrono::milliseconds window);
+            void setUdpSessionResolver(udp::PacketReceiver::SessionResolver resolveSession);
+            void enableUdpSegmentationOffload();
+
             void start();
             void stop();
 
             bool sendUdp(const std::vector<unsigned char>& data, uint32_t type, const asio::ip::udp::endpoint& endpoint);
             bool sendUdp(std::vector<unsigned char>&& data, uint32_t type, const asio::ip::udp::endpoint& endpoint);
             bool sendUdp(const unsigned char* data, int size, uint32_t type, const asio::ip::udp::endpoint& endpoint);
+            bool sendUdp(const unsigned char* data, int size, uint32_t type, const ForwardTargets& targets);
+
+            bool replayUdpKeyframe(const KeyframeKey& key, const asio::ip::udp::endpoint& endpoint);
+            void dropUdpKeyframe(const KeyframeKey& key);
+            void dropUdpKeyframes(const std::array<unsigned char, 32>& owner);
+
+            void setUdpPacingRate(const asio::ip::udp::endpoint& endpoint, uint32_t kbps);
+            std::size_t getUdpPacingQueueDepth() const;
+            std::size_t getTcpQueuedPackets() const;
+            uint64_t getUdpDroppedVideoEntries() const;
+
+            void holdUdpSending();
+            std::size_t discardQueuedUdpSends();
 
         private:
             tcp::Server m_tcpServer;
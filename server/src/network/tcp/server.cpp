@@ -3,6 +3,7 @@
 #include "utilities/errorCodeForLog.h"
 
 #include <chrono>
+#include <cstdint>
 
 using namespace std::chrono_literals;
 
@@ -10,6 +11,7 @@ namespace server::network::tcp
 {
     Server::Server(
         uint16_t port,
+        std::size_t handlerCount,
         OnPacket onPacket,
         OnDisconnect onDisconnect)
         : m_port(port)
@@ -17,6 +19,11 @@ namespace server::network::tcp
         , m_onPacket(std::move(onPacket))
         , m_onDisconnect(std::move(onDisconnect))
     {
+        m_droppedPackets = utilities::queueDropCounter("tcp_control");
+        const std::size_t queueCount = handlerCount != 0 ? handlerCount : 1;
+        for (std::size_t i = 0; i < queueCount; ++i) {
+            m_queues.push_back(std::make_unique<utilities::SafeQueue<OwnedPacket>>());
+        }
     }
 
     Server::~Server() {
@@ -43,7 +50,11 @@ namespace server::network::tcp
                 waitForClients();
             }
         });
-        processQueue();
+        LOG_INFO("[TCP] Handling control packets on {} thread(s)", m_queues.size());
+        for (std::size_t i = 1; i < m_queues.size(); ++i) {
+            m_handlerThreads.emplace_back([this, i]() { processQueue(*m_queues[i]); });
+        }
+        processQueue(*m_queues[0]);
     }
 
     void Server::stop() {
@@ -60,6 +71,11 @@ namespace server::network::tcp
         m_ctx.stop();
         if (m_ctxThread.joinable())
             m_ctxThread.join();
+        for (auto& thread : m_handlerThreads) {
+            if (thread.joinable())
+                thread.join();
+        }
+        m_handlerThreads.clear();
         LOG_INFO("[TCP] Control server stopped");
     }
 
@@ -67,6 +83,14 @@ namespace server::network::tcp
         return m_running.load();
     }
 
+    std::size_t Server::getQueuedPackets() const {
+        std::size_t queued = 0;
+        for (const auto& queue : m_queues) {
+            queued += queue->size();
+        }
+        return queued;
+    }
+
     void Server::waitForClients() {
         m_acceptor.async_accept([this](std::error_code ec, asio::ip::tcp::socket socket) {
             if (ec) {
@@ -89,7 +113,11 @@ namespace server::network::tcp
         ConnectionPtr conn = std::make_shared<Connection>(
             m_ctx,
             std::move(socket),
-            [this](OwnedPacket&& p) { m_queue.push_with_limit(std::move(p), m_maxQueueSize); },
+            [this](OwnedPacket&& p) {
+                if (const std::size_t dropped = queueFor(p.connection).push_with_limit(std::move(p), m_maxQueueSize)) {
+                    m_droppedPackets.add(dropped);
+                }
+            },
             [this](ConnectionPtr c) { handleDisconnect(c); });
         {
             std::lock_guard<std::mutex> lock(m_connMutex);
@@ -99,9 +127,15 @@ namespace server::network::tcp
         conn->start();
     }
 
-    void Server::processQueue() {
+    utilities::SafeQueue<OwnedPacket>& Server::queueFor(const ConnectionPtr& conn) {
+        // Connections are heap pointers with zero low bits, so mix before taking the modulo.
+        const uint64_t key = static_cast<uint64_t>(reinterpret_cast<std::uintptr_t>(conn.get()));
+        return *m_queues[((key * 0x9E3779B97F4A7C15ULL) >> 32) % m_queues.size()];
+    }
+
+    void Server::processQueue(utilities::SafeQueue<OwnedPacket>& queue) {
         while (m_running.load()) { 
-            auto item = m_queue.pop_for(100ms);
+            auto item = queue.pop_for(100ms);
             if (!item || !m_onPacket)
                 continue;
             try {
@@ -1,14 +1,18 @@
 #pragma once
 
 #include <atomic>
+#include <cstddef>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <thread>
 #include <unordered_set>
+#include <vector>
 
 #include "network/tcp/packet.h"
 #include "network/tcp/connection.h"
+#include "utilities/metricsRegistry.h"
 #include "utilities/safeQueue.h"
 #include "asio.hpp"
 
@@ -19,24 +23,31 @@ namespace server::network::tcp
         using OnPacket = std::function<void(OwnedPacket&&)>;
         using OnDisconnect = std::function<void(ConnectionPtr)>;
 
-        Server(uint16_t port, OnPacket onPacket, OnDisconnect onDisconnect);
+        // Control packets are handled on handlerCount threads; each connection is pinned to one
+        // of them, so a client's packets are still handled in the order they were sent.
+        Server(uint16_t port, std::size_t handlerCount, OnPacket onPacket, OnDisconnect onDisconnect);
         ~Server();
 
         void start();
         void stop();
         bool isRunning() const;
+        // Packets waiting for a handler thread, over all queues.
+        std::size_t getQueuedPackets() const;
 
     private:
         void waitForClients();
         void createConnection(asio::ip::tcp::socket socket);
-        void processQueue();
+        utilities::SafeQueue<OwnedPacket>& queueFor(const ConnectionPtr& conn);
+        void processQueue(utilities::SafeQueue<OwnedPacket>& queue);
         void handleDisconnect(ConnectionPtr conn);
 
     private:
         std::atomic<bool> m_running{ false };
         uint16_t m_port;
-        utilities::SafeQueue<OwnedPacket> m_queue;
+        std::vector<std::unique_ptr<utilities::SafeQueue<OwnedPacket>>> m_queues;
+        std::vector<std::thread> m_handlerThreads;
         static constexpr size_t m_maxQueueSize = 1024;
+        utilities::Counter m_droppedPackets;
         std::mutex m_connMutex;
         std::unordered_set<ConnectionPtr> m_connections;
 
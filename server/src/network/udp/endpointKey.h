@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "asio.hpp"
+
+namespace server::network::udp
+{
+    // Fixed-size binary form of a UDP endpoint, cheap to build, compare and hash per datagram.
+    struct EndpointKey {
+        std::array<unsigned char, 16> address{};
+        uint16_t port = 0;
+        uint8_t family = 0;
+
+        static EndpointKey from(const asio::ip::udp::endpoint& endpoint) {
+            EndpointKey key;
+            const auto address = endpoint.address();
+            if (address.is_v4()) {
+                const auto bytes = address.to_v4().to_bytes();
+                std::memcpy(key.address.data(), bytes.data(), bytes.size());
+                key.family = 4;
+            }
+            else {
+                const auto bytes = address.to_v6().to_bytes();
+                std::memcpy(key.address.data(), bytes.data(), bytes.size());
+                key.family = 6;
+            }
+            key.port = endpoint.port();
+            return key;
+        }
+
+        bool operator==(const EndpointKey& other) const {
+            return port == other.port && family == other.family && address == other.address;
+        }
+
+        bool operator!=(const EndpointKey& other) const {
+            return !(*this == other);
+        }
+    };
+
+    struct EndpointKeyHash {
+        std::size_t operator()(const EndpointKey& key) const {
+            // FNV-1a over the address bytes, then port and family.
+            uint64_t hash = 1469598103934665603ULL;
+            for (unsigned char byte : key.address) {
+                hash ^= byte;
+                hash *= 1099511628211ULL;
+            }
+            hash ^= static_cast<uint64_t>(key.port) | (static_cast<uint64_t>(key.family) << 16);
+            hash *= 1099511628211ULL;
+            return static_cast<std::size_t>(hash ^ (hash >> 32));
+        }
+    };
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "network/udp/endpointKey.h"
+
+namespace server::network::udp
+{
+    // Open-addressing table (linear probing, backward-shift deletion) from endpoint to a fixed
+    // inline array of entries. Buckets are allocated up front and only reallocate when the number
+    // of distinct endpoints outgrows the table, so per-datagram lookups never touch the heap.
+    template<typename Entry, std::size_t EntriesPerEndpoint>
+    class EndpointTable {
+    public:
+        struct Bucket {
+            EndpointKey key{};
+            bool used = false;
+            std::array<Entry, EntriesPerEndpoint> entries{};
+        };
+
+        explicit EndpointTable(std::size_t initialCapacity = 64) {
+            std::size_t capacity = 8;
+            while (capacity < initialCapacity) {
+                capacity <<= 1;
+            }
+            m_buckets.resize(capacity);
+        }
+
+        Bucket* find(const EndpointKey& key) {
+            const std::size_t mask = m_buckets.size() - 1;
+            for (std::size_t index = indexFor(key); ; index = (index + 1) & mask) {
+                Bucket& bucket = m_buckets[index];
+                if (!bucket.used) {
+                    return nullptr;
+                }
+                if (bucket.key == key) {
+                    return &bucket;
+                }
+            }
+        }
+
+        Bucket& findOrInsert(const EndpointKey& key) {
+            if ((m_size + 1) * 4 > m_buckets.size() * 3) {
+                grow();
+            }
+            const std::size_t mask = m_buckets.size() - 1;
+            for (std::size_t index = indexFor(key); ; index = (index + 1) & mask) {
+                Bucket& bucket = m_buckets[index];
+                if (!bucket.used) {
+                    bucket.used = true;
+                    bucket.key = key;
+                    ++m_size;
+                    return bucket;
+                }
+                if (bucket.key == key) {
+                    return bucket;
+                }
+            }
+        }
+
+        void erase(const EndpointKey& key) {
+            const std::size_t mask = m_buckets.size() - 1;
+            std::size_t hole = indexFor(key);
+            while (true) {
+                if (!m_buckets[hole].used) {
+                    return;
+                }
+                if (m_buckets[hole].key == key) {
+                    break;
+                }
+                hole = (hole + 1) & mask;
+            }
+
+            // Shift following entries of the same probe run back so lookups never need tombstones.
+            for (std::size_t next = (hole + 1) & mask; m_buckets[next].used; next = (next + 1) & mask) {
+                const std::size_t ideal = indexFor(m_buckets[next].key);
+                const bool between = hole <= next
+                    ? (ideal > hole && ideal <= next)
+                    : (ideal > hole || ideal <= next);
+                if (!between) {
+                    std::swap(m_buckets[hole], m_buckets[next]);
+                    hole = next;
+                }
+            }
+
+            m_buckets[hole].used = false;
+            m_buckets[hole].key = EndpointKey{};
+            --m_size;
+        }
+
+        void clear() {
+            for (auto& bucket : m_buckets) {
+                bucket.used = false;
+                bucket.key = EndpointKey{};
+                bucket.entries = {};
+            }
+            m_size = 0;
+        }
+
+        std::size_t size() const {
+            return m_size;
+        }
+
+    private:
+        std::size_t indexFor(const EndpointKey& key) const {
+            return EndpointKeyHash{}(key) & (m_buckets.size() - 1);
+        }
+
+        void grow() {
+            std::vector<Bucket> old(m_buckets.size() * 2);
+            old.swap(m_buckets);
+            m_size = 0;
+            for (auto& bucket : old) {
+                if (bucket.used) {
+                    Bucket& target = findOrInsert(bucket.key);
+                    target.entries = std::move(bucket.entries);
+                }
+            }
+        }
+
+    private:
+        std::vector<Bucket> m_buckets;
+        std::size_t m_size = 0;
+    };
+}
@@ -0,0 +1,103 @@
+#include "keyframeCache.h"
+
+namespace server::network::udp
+{
+    namespace
+    {
+        constexpr std::size_t kForwardHeaderSize = 18;
+
+        uint16_t readUint16(const unsigned char* data) {
+            return static_cast<uint16_t>((static_cast<uint16_t>(data[0]) << 8) | static_cast<uint16_t>(data[1]));
+        }
+
+        uint64_t readUint64(const unsigned char* data) {
+            uint64_t value = 0;
+            for (int i = 0; i < 8; ++i) {
+                value = (value << 8) | data[i];
+            }
+            return value;
+        }
+    }
+
+    void KeyframeCache::store(const KeyframeKey& key, const DatagramSetPtr& datagrams) {
+        if (!datagrams || datagrams->empty()) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Entry& entry = m_entries[key.owner][key.stream];
+        for (std::size_t i = 0; i < datagrams->size(); ++i) {
+            const auto& datagram = (*datagrams)[i];
+            if (datagram.size() < kForwardHeaderSize) {
+                continue;
+            }
+            const uint64_t packetId = readUint64(datagram.data());
+            const uint16_t chunkIndex = readUint16(datagram.data() + 8);
+            const uint16_t totalChunks = readUint16(datagram.data() + 10);
+            if (chunkIndex >= totalChunks) {
+                continue;
+            }
+            if (!entry.complete.chunks.empty() && entry.complete.packetId == packetId) {
+                continue;
+            }
+
+            Keyframe& pending = entry.pending;
+            if (pending.chunks.empty() || pending.packetId != packetId || pending.chunks.size() != totalChunks) {
+                pending.packetId = packetId;
+                pending.chunks.assign(totalChunks, ChunkRef{});
+                pending.receivedChunks = 0;
+            }
+
+            ChunkRef& chunk = pending.chunks[chunkIndex];
+            if (!chunk.datagrams) {
+                chunk = ChunkRef{ datagrams, static_cast<uint16_t>(i) };
+                ++pending.receivedChunks;
+            }
+            if (pending.receivedChunks == pending.chunks.size()) {
+                // Swapped rather than moved, so both chunk lists keep their storage for the next keyframe.
+                std::swap(entry.complete, pending);
+                pending.packetId = 0;
+                pending.chunks.clear();
+                pending.receivedChunks = 0;
+            }
+        }
+    }
+
+    DatagramSet KeyframeCache::collect(const KeyframeKey& key) const {
+        DatagramSet result;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto ownerIt = m_entries.find(key.owner);
+        if (ownerIt == m_entries.end()) {
+            return result;
+        }
+        auto streamIt = ownerIt->second.find(key.stream);
+        if (streamIt == ownerIt->second.end()) {
+            return result;
+        }
+
+        const Keyframe& keyframe = streamIt->second.complete;
+        result.reserve(keyframe.chunks.size());
+        for (const auto& chunk : keyframe.chunks) {
+            result.push_back((*chunk.datagrams)[chunk.index]);
+        }
+        return result;
+    }
+
+    void KeyframeCache::erase(const KeyframeKey& key) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto ownerIt = m_entries.find(key.owner);
+        if (ownerIt == m_entries.end()) {
+            return;
+        }
+        ownerIt->second.erase(key.stream);
+        if (ownerIt->second.empty()) {
+            m_entries.erase(ownerIt);
+        }
+    }
+
+    void KeyframeCache::erase(const std::array<unsigned char, 32>& owner) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_entries.erase(owner);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "network/udp/packet.h"
+#include "utilities/bufferPool.h"
+
+namespace server::network::udp
+{
+    // Newest keyframe packet per sender stream, kept as the datagrams it was forwarded with.
+    // The payload stays end-to-end encrypted; the server only replays it so that a new subscriber
+    // can decode a picture right away instead of waiting for the sender's next IDR.
+    class KeyframeCache {
+    public:
+        // Adds the chunks in datagrams (any subset of one packet) under key. Chunks of a newer packet
+        // start the next keyframe; the previous one stays replayable until that one is complete.
+        void store(const KeyframeKey& key, const DatagramSetPtr& datagrams);
+
+        // Copies of the newest complete keyframe for key, empty when there is none.
+        DatagramSet collect(const KeyframeKey& key) const;
+
+        void erase(const KeyframeKey& key);
+        void erase(const std::array<unsigned char, 32>& owner);
+
+    private:
+        struct ChunkRef {
+            DatagramSetPtr datagrams;
+            uint16_t index = 0;
+        };
+
+        struct Keyframe {
+            uint64_t packetId = 0;
+            std::vector<ChunkRef, utilities::PoolAllocator<ChunkRef>> chunks;
+            std::size_t receivedChunks = 0;
+        };
+
+        struct Entry {
+            Keyframe complete;
+            Keyframe pending;
+        };
+
+        struct OwnerHasher {
+            std::size_t operator()(const std::array<unsigned char, 32>& owner) const {
+                // Already a SHA-256 digest, so any slice of it is uniformly distributed.
+                std::size_t value = 0;
+                std::memcpy(&value, owner.data(), sizeof(value));
+                return value;
+            }
+        };
+
+        // Stored into for every forwarded keyframe chunk, so the nodes come from the buffer pool too.
+        using StreamEntries = std::unordered_map<uint16_t, Entry, std::hash<uint16_t>, std::equal_to<uint16_t>,
+            utilities::PoolAllocator<std::pair<const uint16_t, Entry>>>;
+        using OwnerEntries = std::unordered_map<std::array<unsigned char, 32>, StreamEntries, OwnerHasher,
+            std::equal_to<std::array<unsigned char, 32>>,
+            utilities::PoolAllocator<std::pair<const std::array<unsigned char, 32>, StreamEntries>>>;
+
+    private:
+        mutable std::mutex m_mutex;
+        OwnerEntries m_entries;
+    };
+}
@@ -0,0 +1,74 @@
+#include "network/udp/mediaMetrics.h"
+#include "constants/packetType.h"
+
+#include <string>
+#include <vector>
+
+namespace server::network::udp
+{
+    namespace
+    {
+        enum TypeLabel : std::size_t {
+            Ping,
+            Voice,
+            Camera,
+            Screen,
+            Nack,
+            KeyframeRequest,
+            Other
+        };
+
+        const std::vector<std::string> kTypeLabels = { "ping", "voice", "camera", "screen", "nack", "keyframe_request", "other" };
+
+        MediaMetrics registerMediaMetrics() {
+            auto& registry = utilities::MetricsRegistry::shared();
+            MediaMetrics metrics;
+            metrics.datagramsReceived = registry.counterFamily("callifornia_udp_datagrams_received_total",
+                "UDP datagrams received on the media port, by packet type.", "type", kTypeLabels);
+            metrics.bytesReceived = registry.counterFamily("callifornia_udp_bytes_received_total",
+                "UDP bytes received on the media port, headers included, by packet type.", "type", kTypeLabels);
+            metrics.datagramsSent = registry.counterFamily("callifornia_udp_datagrams_sent_total",
+                "UDP datagrams handed to the kernel on the media port, by packet type.", "type", kTypeLabels);
+            metrics.bytesSent = registry.counterFamily("callifornia_udp_bytes_sent_total",
+                "UDP bytes handed to the kernel on the media port, headers included, by packet type.", "type", kTypeLabels);
+
+            const std::string reassemblyHelp = "Media packets whose chunks all arrived, by path.";
+            metrics.packetsReassembled = registry.counter("callifornia_udp_packets_completed_total", reassemblyHelp, "path=\"reassembly\"");
+            metrics.forwardRoutesCompleted = registry.counter("callifornia_udp_packets_completed_total", reassemblyHelp, "path=\"cut_through\"");
+            const std::string evictionHelp = "Partly received media packets evicted to make room for a newer one, by path.";
+            metrics.reassemblyEvicted = registry.counter("callifornia_udp_packets_evicted_total", evictionHelp, "path=\"reassembly\"");
+            metrics.forwardRoutesEvicted = registry.counter("callifornia_udp_packets_evicted_total", evictionHelp, "path=\"cut_through\"");
+
+            metrics.assemblyQueueDropped = utilities::queueDropCounter("udp_assembly");
+            metrics.receivedQueueDropped = utilities::queueDropCounter("udp_received");
+            metrics.voiceQueueDropped = utilities::queueDropCounter("udp_egress_voice");
+            metrics.controlQueueDropped = utilities::queueDropCounter("udp_egress_control");
+            metrics.cameraQueueDropped = utilities::queueDropCounter("udp_egress_camera");
+            metrics.screenQueueDropped = utilities::queueDropCounter("udp_egress_screen");
+            metrics.pacerDropped = utilities::queueDropCounter("udp_pacer");
+
+            metrics.forwardLatencyUs = registry.histogram("callifornia_udp_forward_latency_microseconds",
+                "Time from receiving a cut-through media chunk to putting it in a send batch.");
+            return metrics;
+        }
+    }
+
+    const MediaMetrics& MediaMetrics::get() {
+        static const MediaMetrics metrics = registerMediaMetrics();
+        return metrics;
+    }
+
+    std::size_t MediaMetrics::typeIndex(uint32_t type) {
+        if (type == 0 || type == 1) {
+            return Ping;
+        }
+        switch (static_cast<constant::PacketType>(type)) {
+        case constant::PacketType::VOICE: return Voice;
+        case constant::PacketType::CAMERA: return Camera;
+        case constant::PacketType::SCREEN: return Screen;
+        case constant::PacketType::MEDIA_NACK: return Nack;
+        case constant::PacketType::MEDIA_KEYFRAME_REQUEST: return KeyframeRequest;
+        default: return Other;
+        }
+    }
+}
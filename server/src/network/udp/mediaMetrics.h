@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "utilities/metricsRegistry.h"
+
+namespace server::network::udp
+{
+    // Handles for the UDP media path in the shared metrics registry, registered on first use.
+    struct MediaMetrics {
+        utilities::CounterFamily datagramsReceived;
+        utilities::CounterFamily bytesReceived;
+        utilities::CounterFamily datagramsSent;
+        utilities::CounterFamily bytesSent;
+
+        utilities::Counter packetsReassembled;
+        utilities::Counter reassemblyEvicted;
+        utilities::Counter forwardRoutesCompleted;
+        utilities::Counter forwardRoutesEvicted;
+
+        utilities::Counter assemblyQueueDropped;
+        utilities::Counter receivedQueueDropped;
+        utilities::Counter voiceQueueDropped;
+        utilities::Counter controlQueueDropped;
+        utilities::Counter cameraQueueDropped;
+        utilities::Counter screenQueueDropped;
+        utilities::Counter pacerDropped;
+
+        // Cut-through chunks only: from the chunk's receive to its send batch, in microseconds.
+        utilities::Histogram forwardLatencyUs;
+
+        static const MediaMetrics& get();
+
+        // Label index of a wire packet type for the per-type families; both ping types share one.
+        static std::size_t typeIndex(uint32_t type);
+    };
+}
@@ -1,8 +1,15 @@
 #pragma once
 
+#include <array>
+#include <chrono>
 #include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
 #include <vector>
 #include "asio.hpp"
+#include "utilities/bufferPool.h"
 
 namespace server
 {
@@ -14,6 +21,48 @@ namespace server
             std::vector<unsigned char> data;
             asio::ip::udp::endpoint endpoint;
         };
+
+        // Wire-ready datagrams (header + payload). Immutable once built, so one set
+        // can be queued to any number of endpoints. The datagrams, the list and the
+        // shared_ptr block all come from the buffer pool.
+        using DatagramSet = utilities::PooledBufferList;
+        using DatagramSetPtr = std::shared_ptr<const DatagramSet>;
+
+        inline DatagramSetPtr makeDatagramSet(DatagramSet&& datagrams) {
+            return std::allocate_shared<const DatagramSet>(utilities::PoolAllocator<DatagramSet>{}, std::move(datagrams));
+        }
+
+        // Newest keyframe of one sender stream: owner is the sender's binary nickname hash, stream
+        // a per-owner stream slot.
+        struct KeyframeKey {
+            std::array<unsigned char, 32> owner{};
+            uint16_t stream = 0;
+        };
+
+        using EndpointList = std::vector<asio::ip::udp::endpoint, utilities::PoolAllocator<asio::ip::udp::endpoint>>;
+
+        // Where one forwarded media packet goes. keyframeKey is set when the packet is a keyframe
+        // kept for replay to later subscribers; it is kept even while nobody receives the stream.
+        // Built per packet, so the endpoint list comes from the buffer pool.
+        struct ForwardTargets {
+            EndpointList endpoints;
+            std::optional<KeyframeKey> keyframeKey;
+        };
+
+        // A cut-through packet whose receivers are chosen off the receive thread. Handed back
+        // with the targets; a ticket whose packet has since been evicted is ignored.
+        struct ForwardTicket {
+            std::size_t worker = 0;
+            asio::ip::udp::endpoint endpoint;
+            uint64_t packetId = 0;
+            uint64_t forwardedId = 0;
+        };
+
+        struct OutgoingDatagrams {
+            DatagramSetPtr datagrams;
+            asio::ip::udp::endpoint endpoint;
+            // When the relayed chunk came in; left empty for packets the server builds itself.
+            std::chrono::steady_clock::time_point receivedAt{};
+        };
     }
 }
-
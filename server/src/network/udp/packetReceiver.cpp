@@ -1,5 +1,8 @@
 #include "packetReceiver.h"
 #include "constants/constant.h"
+#include "constants/packetType.h"
+#include "constants/mediaFrame.h"
+#include "network/udp/mediaMetrics.h"
 
 #include <chrono>
 #include <cstring>
@@ -11,8 +14,55 @@
 #include "utilities/logger.h"
 #include "utilities/errorCodeForLog.h"
 
+#if defined(__linux__)
+#include <cerrno>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#endif
+
 namespace server::network::udp
 {
+    namespace
+    {
+        template<typename Entry, std::size_t N>
+        Entry* findEntry(std::array<Entry, N>& entries, uint64_t packetId)
+        {
+            for (auto& entry : entries) {
+                if (entry.active && entry.packetId == packetId) {
+                    return &entry;
+                }
+            }
+            return nullptr;
+        }
+
+        // A free slot, or the least recently updated one when all are in use.
+        template<typename Entry, std::size_t N>
+        Entry& claimEntry(std::array<Entry, N>& entries)
+        {
+            Entry* oldest = &entries[0];
+            for (auto& entry : entries) {
+                if (!entry.active) {
+                    return entry;
+                }
+                if (entry.lastUpdated < oldest->lastUpdated) {
+                    oldest = &entry;
+                }
+            }
+            return *oldest;
+        }
+
+        template<typename Entry, std::size_t N>
+        bool hasActiveEntries(const std::array<Entry, N>& entries)
+        {
+            for (const auto& entry : entries) {
+                if (entry.active) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
         PacketReceiver::PacketReceiver()
         : m_running(false) {
     }
@@ -32,10 +82,14 @@ namespace server::network::udp
         m_onPingReceived = std::move(onPingReceived);
         m_running = false;
         m_remoteEndpoint = asio::ip::udp::endpoint();
+#if defined(__linux__)
+        m_receiveOffload = false;
+#endif
 
         {
             std::lock_guard<std::mutex> lock(m_stateMutex);
             m_pendingPackets.clear();
+            m_forwardRoutes.clear();
         }
 
         if (!m_socket.has_value() || !m_socket->get().is_open()) {
@@ -46,6 +100,41 @@ namespace server::network::udp
         return true;
     }
 
+    void PacketReceiver::enableCutThrough(ForwardDispatcher dispatchTargets, std::function<uint64_t()> nextPacketId, ForwardSender forward)
+    {
+        m_dispatchForwardTargets = std::move(dispatchTargets);
+        m_nextForwardId = std::move(nextPacketId);
+        m_forward = std::move(forward);
+    }
+
+    void PacketReceiver::setNackHandler(std::function<void(const unsigned char*, std::size_t, const asio::ip::udp::endpoint&)> onNack)
+    {
+        m_onNackReceived = std::move(onNack);
+    }
+
+    void PacketReceiver::setSessionResolver(SessionResolver resolveSession)
+    {
+        m_resolveSession = std::move(resolveSession);
+    }
+
+    bool PacketReceiver::enableReceiveOffload()
+    {
+#if defined(__linux__) && defined(UDP_GRO)
+        if (!m_socket.has_value() || m_running.load()) {
+            return false;
+        }
+        int enable = 1;
+        if (::setsockopt(m_socket->get().native_handle(), SOL_UDP, UDP_GRO, &enable, sizeof(enable)) != 0) {
+            return false;
+        }
+        m_coalescedBuffers.resize(m_maxCoalescedDatagrams * m_coalescedBufferSize);
+        m_receiveOffload = true;
+        return true;
+#else
+        return false;
+#endif
+    }
+
     void PacketReceiver::start()
     {
         if (!m_socket.has_value() || !m_socket->get().is_open()) {
@@ -85,6 +174,7 @@ namespace server::network::udp
         {
             std::lock_guard<std::mutex> lock(m_stateMutex);
             m_pendingPackets.clear();
+            m_forwardRoutes.clear();
         }
 
         m_assemblyQueue.clear();
@@ -100,11 +190,6 @@ namespace server::network::udp
         return m_running.load();
     }
 
-    std::string PacketReceiver::makeEndpointKey(const asio::ip::udp::endpoint& endpoint)
-    {
-        return endpoint.address().to_string() + ":" + std::to_string(endpoint.port());
-    }
-
     void PacketReceiver::doReceive()
     {
         if (!m_socket.has_value()) {
@@ -117,6 +202,43 @@ namespace server::network::udp
             return;
         }
 
+#if defined(__linux__)
+        socket.async_wait(asio::socket_base::wait_read,
+            [this](const std::error_code& ec)
+            {
+                if (!m_running.load()) {
+                    return;
+                }
+
+                if (ec) {
+                    if (ec != asio::error::operation_aborted) {
+                        try {
+                            notifyError(ec);
+                        }
+                        catch (const std::exception& e) {
+                            LOG_ERROR("notifyError exception: {}", e.what());
+                        }
+                        catch (...) {
+                            LOG_ERROR("notifyError unknown exception");
+                        }
+                    }
+
+                    if (m_running.load()) {
+                        doReceive();
+                    }
+
+                    return;
+                }
+
+                if (m_receiveOffload) {
+                    receiveCoalescedBatch();
+                }
+                else {
+                    receiveBatch();
+                }
+                doReceive();
+            });
+#else
         socket.async_receive_from(asio::buffer(m_buffer), m_remoteEndpoint,
             [this](const std::error_code& ec, std::size_t bytesTransferred)
             {
@@ -145,7 +267,7 @@ namespace server::network::udp
                 }
 
                 try {
-                    processDatagram(bytesTransferred);
+                    processDatagram(m_buffer.data(), bytesTransferred, m_remoteEndpoint);
                 }
                 catch (const std::exception& e) {
                     LOG_ERROR("processDatagram error (receive chain continues): {}", e.what());
@@ -156,28 +278,184 @@ namespace server::network::udp
 
                 doReceive();
             });
+#endif
     }
 
-    void PacketReceiver::processDatagram(std::size_t bytesTransferred)
+#if defined(__linux__)
+    void PacketReceiver::receiveBatch()
     {
-        if (bytesTransferred < m_headerSize) {
-            LOG_WARN("Received datagram too small: {} bytes", bytesTransferred);
+        if (!m_socket.has_value()) {
             return;
         }
 
-        const unsigned char* data = m_buffer.data();
-        const std::string endpointKey = makeEndpointKey(m_remoteEndpoint);
+        const int fd = m_socket->get().native_handle();
+
+        std::array<mmsghdr, m_maxBatchDatagrams> messages{};
+        std::array<iovec, m_maxBatchDatagrams> iovecs{};
+
+        for (std::size_t round = 0; round < m_maxBatchRounds && m_running.load(); ++round) {
+            for (std::size_t i = 0; i < m_maxBatchDatagrams; ++i) {
+                iovecs[i].iov_base = m_batchBuffers[i].data();
+                iovecs[i].iov_len = m_batchBuffers[i].size();
+                messages[i].msg_hdr = msghdr{};
+                messages[i].msg_hdr.msg_name = m_batchEndpoints[i].data();
+                messages[i].msg_hdr.msg_namelen = static_cast<socklen_t>(m_batchEndpoints[i].capacity());
+                messages[i].msg_hdr.msg_iov = &iovecs[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+                messages[i].msg_len = 0;
+            }
+
+            const int received = ::recvmmsg(fd, messages.data(), static_cast<unsigned int>(m_maxBatchDatagrams), MSG_DONTWAIT, nullptr);
+            if (received < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    notifyError(std::error_code(errno, asio::error::get_system_category()));
+                }
+                return;
+            }
+
+            for (int i = 0; i < received; ++i) {
+                auto& endpoint = m_batchEndpoints[i];
+                endpoint.resize(messages[i].msg_hdr.msg_namelen);
+                try {
+                    processDatagram(m_batchBuffers[i].data(), messages[i].msg_len, endpoint);
+                }
+                catch (const std::exception& e) {
+                    LOG_ERROR("processDatagram error (receive chain continues): {}", e.what());
+                }
+                catch (...) {
+                    LOG_ERROR("processDatagram unknown error (receive chain continues)");
+                }
+            }
+
+            if (static_cast<std::size_t>(received) < m_maxBatchDatagrams) {
+                return;
+            }
+        }
+    }
+#endif
+
+#if defined(__linux__)
+    void PacketReceiver::receiveCoalescedBatch()
+    {
+#if defined(UDP_GRO)
+        if (!m_socket.has_value()) {
+            return;
+        }
+
+        const int fd = m_socket->get().native_handle();
+
+        std::array<mmsghdr, m_maxCoalescedDatagrams> messages{};
+        std::array<iovec, m_maxCoalescedDatagrams> iovecs{};
+        std::array<std::array<char, CMSG_SPACE(sizeof(int))>, m_maxCoalescedDatagrams> controls{};
+
+        for (std::size_t round = 0; round < m_maxBatchRounds && m_running.load(); ++round) {
+            for (std::size_t i = 0; i < m_maxCoalescedDatagrams; ++i) {
+                iovecs[i].iov_base = m_coalescedBuffers.data() + i * m_coalescedBufferSize;
+                iovecs[i].iov_len = m_coalescedBufferSize;
+                messages[i].msg_hdr = msghdr{};
+                messages[i].msg_hdr.msg_name = m_batchEndpoints[i].data();
+                messages[i].msg_hdr.msg_namelen = static_cast<socklen_t>(m_batchEndpoints[i].capacity());
+                messages[i].msg_hdr.msg_iov = &iovecs[i];
+                messages[i].msg_hdr.msg_iovlen = 1;
+                messages[i].msg_hdr.msg_control = controls[i].data();
+                messages[i].msg_hdr.msg_controllen = controls[i].size();
+                messages[i].msg_len = 0;
+            }
+
+            const int received = ::recvmmsg(fd, messages.data(), static_cast<unsigned int>(m_maxCoalescedDatagrams), MSG_DONTWAIT, nullptr);
+            if (received < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    notifyError(std::error_code(errno, asio::error::get_system_category()));
+                }
+                return;
+            }
+
+            for (int i = 0; i < received; ++i) {
+                auto& endpoint = m_batchEndpoints[i];
+                endpoint.resize(messages[i].msg_hdr.msg_namelen);
+                const unsigned char* buffer = m_coalescedBuffers.data() + static_cast<std::size_t>(i) * m_coalescedBufferSize;
+                const std::size_t length = messages[i].msg_len;
+
+                // Without the cmsg the kernel did not coalesce anything: it is a single datagram.
+                std::size_t segmentSize = length;
+                for (cmsghdr* cmsg = CMSG_FIRSTHDR(&messages[i].msg_hdr); cmsg; cmsg = CMSG_NXTHDR(&messages[i].msg_hdr, cmsg)) {
+                    if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                        int size = 0;
+                        std::memcpy(&size, CMSG_DATA(cmsg), sizeof(size));
+                        if (size > 0) {
+                            segmentSize = static_cast<std::size_t>(size);
+                        }
+                    }
+                }
+
+                for (std::size_t offset = 0; offset < length; offset += segmentSize) {
+                    try {
+                        processDatagram(buffer + offset, std::min(segmentSize, length - offset), endpoint);
+                    }
+                    catch (const std::exception& e) {
+                        LOG_ERROR("processDatagram error (receive chain continues): {}", e.what());
+                    }
+                    catch (...) {
+                        LOG_ERROR("processDatagram unknown error (receive chain continues)");
+                    }
+                }
+            }
 
+            if (static_cast<std::size_t>(received) < m_maxCoalescedDatagrams) {
+                return;
+            }
+        }
+#else
+        receiveBatch();
+#endif
+    }
+#endif
+
+    void PacketReceiver::processDatagram(const unsigned char* data, std::size_t bytesTransferred, const asio::ip::udp::endpoint& endpoint)
+    {
         std::array<unsigned char, 32> senderNicknameHash;
-        std::memcpy(senderNicknameHash.data(), data, 32);
+        std::size_t headerSize = m_headerSize;
+        uint64_t packetId = 0;
+        uint16_t chunkIndex = 0;
+        uint16_t totalChunks = 0;
+        uint16_t payloadLength = 0;
+        uint32_t packetType = 0;
+
+        // A v1 header starts with a SHA-256 digest, so the marker alone is not proof of v2:
+        // only a session id that resolves to a known user is.
+        if (m_resolveSession
+            && bytesTransferred >= constant::kCompactChunkHeaderSize
+            && data[0] == constant::kCompactChunkHeaderMarker
+            && data[1] == constant::kWireVersion2
+            && m_resolveSession(readUint32(data + 2), senderNicknameHash)) {
+            headerSize = constant::kCompactChunkHeaderSize;
+            packetId = readUint32(data + 6);
+            chunkIndex = readUint16(data + 10);
+            totalChunks = readUint16(data + 12);
+            payloadLength = readUint16(data + 14);
+            packetType = readUint16(data + 16);
+        }
+        else {
+            if (bytesTransferred < m_headerSize) {
+                LOG_WARN("Received datagram too small: {} bytes", bytesTransferred);
+                return;
+            }
+            std::memcpy(senderNicknameHash.data(), data, 32);
+            packetId = readUint64(data + 32);
+            chunkIndex = readUint16(data + 40);
+            totalChunks = readUint16(data + 42);
+            payloadLength = readUint16(data + 44);
+            packetType = readUint32(data + 46);
+        }
+
+        const auto& metrics = MediaMetrics::get();
+        const std::size_t typeIndex = MediaMetrics::typeIndex(packetType);
+        metrics.datagramsReceived.add(typeIndex);
+        metrics.bytesReceived.add(typeIndex, bytesTransferred);
 
-        const uint64_t packetId = readUint64(data + 32);
-        const uint16_t chunkIndex = readUint16(data + 40);
-        const uint16_t totalChunks = readUint16(data + 42);
-        const uint16_t payloadLength = readUint16(data + 44);
-        const uint32_t packetType = readUint32(data + 46);
+        const EndpointKey endpointKey = EndpointKey::from(endpoint);
 
-        const std::size_t actualPayload = bytesTransferred - m_headerSize;
+        const std::size_t actualPayload = bytesTransferred - headerSize;
         if (payloadLength > actualPayload) {
             LOG_WARN("Payload length mismatch: declared {}, available {}", payloadLength, actualPayload);
             return;
@@ -185,7 +463,15 @@ namespace server::network::udp
 
         if (packetType == 0 || packetType == 1) {
             if (m_onPingReceived) {
-                m_onPingReceived(packetType, m_remoteEndpoint);
+                m_onPingReceived(packetType, endpoint);
+            }
+            return;
+        }
+
+        if (packetType == static_cast<uint32_t>(constant::PacketType::MEDIA_NACK)) {
+            // Transport feedback for this hop, answered from the retransmission cache.
+            if (m_onNackReceived && totalChunks == 1) {
+                m_onNackReceived(data + headerSize, payloadLength, endpoint);
             }
             return;
         }
@@ -194,20 +480,28 @@ namespace server::network::udp
             AssemblyJob job;
             job.chunks.clear();
             job.type = packetType;
-            job.endpoint = m_remoteEndpoint;
+            job.endpoint = endpoint;
             job.senderNicknameHash = senderNicknameHash;
-            m_assemblyQueue.push_with_limit(std::move(job), m_maxAssemblyQueueSize);
+            if (const std::size_t dropped = m_assemblyQueue.push_drop_oldest(std::move(job))) {
+                metrics.assemblyQueueDropped.add(dropped);
+            }
             return;
         }
 
-        const unsigned char* payload = data + m_headerSize;
+        if (m_dispatchForwardTargets && m_forward && m_nextForwardId) {
+            forwardChunk(data + headerSize, endpointKey, endpoint, senderNicknameHash,
+                packetId, chunkIndex, totalChunks, payloadLength, packetType);
+            return;
+        }
+
+        const unsigned char* payload = data + headerSize;
         const std::size_t payloadSize = payloadLength;
 
         if (payload == nullptr || payloadSize == 0) {
             return;
         }
 
-        std::vector<std::vector<unsigned char>> chunksToAssemble;
+        utilities::PooledBufferList chunksToAssemble;
         bool packetComplete = false;
         uint32_t completedType = 0;
 
@@ -220,41 +514,43 @@ namespace server::network::udp
             }
 
             const auto now = std::chrono::steady_clock::now();
-            auto& pendingPackets = m_pendingPackets[endpointKey];
+            auto& bucket = m_pendingPackets.findOrInsert(endpointKey);
 
-            auto packetIt = pendingPackets.find(packetId);
-            if (packetIt == pendingPackets.end()) {
-                if (pendingPackets.size() >= m_maxPendingPackets) {
-                    evictOldestPacket(pendingPackets);
+            PendingPacket* pendingPacketPtr = findEntry(bucket.entries, packetId);
+            if (!pendingPacketPtr) {
+                pendingPacketPtr = &claimEntry(bucket.entries);
+                if (pendingPacketPtr->active) {
+                    metrics.reassemblyEvicted.add();
                 }
-                packetIt = pendingPackets.emplace(packetId, PendingPacket{}).first;
-                initPendingPacket(packetIt->second, packetId, totalChunks, packetType, senderNicknameHash, now);
+                initPendingPacket(*pendingPacketPtr, packetId, totalChunks, packetType, senderNicknameHash, now);
             }
-            else if (packetIt->second.totalChunks != totalChunks) {
+            else if (pendingPacketPtr->totalChunks != totalChunks) {
                 LOG_WARN("Total chunks mismatch for packet {}: expected {}, got {}",
                     packetId,
-                    packetIt->second.totalChunks,
+                    pendingPacketPtr->totalChunks,
                     totalChunks);
-                initPendingPacket(packetIt->second, packetId, totalChunks, packetType, senderNicknameHash, now);
+                initPendingPacket(*pendingPacketPtr, packetId, totalChunks, packetType, senderNicknameHash, now);
             }
-            else if (packetIt->second.type != packetType) {
+            else if (pendingPacketPtr->type != packetType) {
                 LOG_WARN("Packet type mismatch for packet {}: expected {}, got {}",
                     packetId,
-                    static_cast<uint32_t>(packetIt->second.type),
+                    static_cast<uint32_t>(pendingPacketPtr->type),
                     static_cast<uint32_t>(packetType));
-                initPendingPacket(packetIt->second, packetId, totalChunks, packetType, senderNicknameHash, now);
+                initPendingPacket(*pendingPacketPtr, packetId, totalChunks, packetType, senderNicknameHash, now);
             }
 
-            auto& pendingPacket = packetIt->second;
+            auto& pendingPacket = *pendingPacketPtr;
             pendingPacket.lastUpdated = now;
 
-            if (chunkIndex >= pendingPacket.chunks.size()) {
-                LOG_WARN("Chunk index {} out of range for packet {} ({})", chunkIndex, packetId, pendingPacket.chunks.size());
+            if (chunkIndex >= pendingPacket.totalChunks) {
+                LOG_WARN("Chunk index {} out of range for packet {} ({})", chunkIndex, packetId, pendingPacket.totalChunks);
                 return;
             }
 
-            if (pendingPacket.chunks[chunkIndex].empty()) {
-                pendingPacket.chunks[chunkIndex] = std::vector<unsigned char>(payload, payload + payloadSize);
+            auto& chunk = pendingPacket.chunks[chunkIndex];
+            if (!chunk) {
+                chunk = utilities::BufferPool::shared().acquire(payloadSize);
+                std::memcpy(chunk.data(), payload, payloadSize);
                 pendingPacket.receivedChunks++;
             }
 
@@ -263,8 +559,9 @@ namespace server::network::udp
                 completedType = pendingPacket.type;
                 chunksToAssemble = std::move(pendingPacket.chunks);
                 senderNicknameHash = pendingPacket.senderNicknameHash;
-                pendingPackets.erase(packetIt);
-                if (pendingPackets.empty()) {
+                pendingPacket.chunks.clear();
+                pendingPacket.active = false;
+                if (!hasActiveEntries(bucket.entries)) {
                     m_pendingPackets.erase(endpointKey);
                 }
             }
@@ -273,44 +570,188 @@ namespace server::network::udp
         if (!packetComplete) {
             return;
         }
+        metrics.packetsReassembled.add();
 
         AssemblyJob job;
         job.chunks = std::move(chunksToAssemble);
         job.type = completedType;
-        job.endpoint = m_remoteEndpoint;
+        job.endpoint = endpoint;
         job.senderNicknameHash = senderNicknameHash;
-        m_assemblyQueue.push_with_limit(std::move(job), m_maxAssemblyQueueSize);
+        if (const std::size_t dropped = m_assemblyQueue.push_drop_oldest(std::move(job))) {
+            metrics.assemblyQueueDropped.add(dropped);
+        }
     }
 
-    void PacketReceiver::initPendingPacket(PendingPacket& packet, uint64_t packetId, uint16_t totalChunks, uint32_t packetType,
-        const std::array<unsigned char, 32>& senderNicknameHash, std::chrono::steady_clock::time_point now)
+    void PacketReceiver::forwardChunk(const unsigned char* payload, const EndpointKey& endpointKey, const asio::ip::udp::endpoint& endpoint,
+        const std::array<unsigned char, 32>& senderNicknameHash, uint64_t packetId, uint16_t chunkIndex, uint16_t totalChunks,
+        uint16_t payloadLength, uint32_t packetType)
     {
-        packet = PendingPacket{};
-        packet.packetId = packetId;
-        packet.totalChunks = totalChunks;
-        packet.chunks.resize(totalChunks);
-        packet.receivedChunks = 0;
-        packet.type = packetType;
-        packet.senderNicknameHash = senderNicknameHash;
-        packet.lastUpdated = now;
+        if (totalChunks == 0 || chunkIndex >= totalChunks) {
+            LOG_WARN("Chunk index {} out of range for forwarded packet {} ({})", chunkIndex, packetId, totalChunks);
+            return;
+        }
+
+        const auto& metrics = MediaMetrics::get();
+        const auto now = std::chrono::steady_clock::now();
+        uint64_t forwardedId = 0;
+        bool needsDispatch = false;
+
+        {
+            std::lock_guard<std::mutex> lock(m_stateMutex);
+            auto& bucket = m_forwardRoutes.findOrInsert(endpointKey);
+
+            ForwardRoute* route = findEntry(bucket.entries, packetId);
+            if (!route || route->totalChunks != totalChunks || route->type != packetType) {
+                if (!route) {
+                    route = &claimEntry(bucket.entries);
+                    if (route->active) {
+                        metrics.forwardRoutesEvicted.add();
+                    }
+                }
+                route->active = true;
+                route->packetId = packetId;
+                route->forwardedId = m_nextForwardId();
+                route->totalChunks = totalChunks;
+                route->type = packetType;
+                route->receivedChunks = 0;
+                route->seenChunks.assign(totalChunks, false);
+                route->resolved = false;
+                route->targets.reset();
+                route->heldChunks.clear();
+            }
+
+            route->lastUpdated = now;
+            if (route->seenChunks[chunkIndex]) {
+                return;
+            }
+            route->seenChunks[chunkIndex] = true;
+            route->receivedChunks++;
+            forwardedId = route->forwardedId;
+            needsDispatch = !route->resolved && chunkIndex == 0;
+        }
+
+        auto datagram = buildForwardDatagram(payload, payloadLength, forwardedId, chunkIndex, totalChunks, packetType);
+
+        std::shared_ptr<const ForwardTargets> targets;
+
+        {
+            std::lock_guard<std::mutex> lock(m_stateMutex);
+            auto* bucket = m_forwardRoutes.find(endpointKey);
+            if (!bucket) {
+                return;
+            }
+            ForwardRoute* route = findEntry(bucket->entries, packetId);
+            if (!route || route->forwardedId != forwardedId) {
+                return;
+            }
+
+            // Receivers are chosen from the frame meta at the start of chunk 0; until they are
+            // known every chunk, chunk 0 included, waits here for completeForward.
+            if (!route->resolved) {
+                route->heldChunks.push_back(HeldChunk{ std::move(datagram), now });
+            }
+            else {
+                targets = route->targets;
+                if (route->receivedChunks == route->totalChunks) {
+                    metrics.forwardRoutesCompleted.add();
+                    route->active = false;
+                    route->targets.reset();
+                    if (!hasActiveEntries(bucket->entries)) {
+                        m_forwardRoutes.erase(endpointKey);
+                    }
+                }
+            }
+        }
+
+        // Dispatched only once chunk 0 is held, so an early answer cannot miss it.
+        if (needsDispatch) {
+            m_dispatchForwardTargets(payload, payloadLength, packetType, endpoint, senderNicknameHash,
+                ForwardTicket{ 0, endpoint, packetId, forwardedId });
+        }
+
+        if (!targets || (targets->endpoints.empty() && !targets->keyframeKey)) {
+            return;
+        }
+        m_forward(datagram, *targets, now);
     }
 
-    void PacketReceiver::evictOldestPacket(PendingPacketMap& packets)
+    void PacketReceiver::completeForward(const ForwardTicket& ticket, ForwardTargets&& targets)
     {
-        if (packets.empty()) {
+        auto resolvedTargets = std::allocate_shared<const ForwardTargets>(utilities::PoolAllocator<ForwardTargets>{}, std::move(targets));
+        const EndpointKey endpointKey = EndpointKey::from(ticket.endpoint);
+        HeldChunks heldChunks;
+
+        {
+            std::lock_guard<std::mutex> lock(m_stateMutex);
+            auto* bucket = m_forwardRoutes.find(endpointKey);
+            if (!bucket) {
+                return;
+            }
+            ForwardRoute* route = findEntry(bucket->entries, ticket.packetId);
+            if (!route || route->forwardedId != ticket.forwardedId || route->resolved) {
+                return;
+            }
+
+            route->resolved = true;
+            route->targets = resolvedTargets;
+            heldChunks.swap(route->heldChunks);
+            if (route->receivedChunks == route->totalChunks) {
+                MediaMetrics::get().forwardRoutesCompleted.add();
+                route->active = false;
+                route->targets.reset();
+                if (!hasActiveEntries(bucket->entries)) {
+                    m_forwardRoutes.erase(endpointKey);
+                }
+            }
+        }
+
+        if (resolvedTargets->endpoints.empty() && !resolvedTargets->keyframeKey) {
             return;
         }
+        for (const auto& held : heldChunks) {
+            m_forward(held.datagram, *resolvedTargets, held.receivedAt);
+        }
+    }
 
-        auto oldestIt = packets.begin();
-        for (auto it = packets.begin(); it != packets.end(); ++it) {
-            if (it->second.lastUpdated < oldestIt->second.lastUpdated) {
-                oldestIt = it;
-            }
+    DatagramSetPtr PacketReceiver::buildForwardDatagram(const unsigned char* payload, uint16_t payloadLength, uint64_t forwardedId,
+        uint16_t chunkIndex, uint16_t totalChunks, uint32_t packetType)
+    {
+        auto datagram = utilities::BufferPool::shared().acquire(m_forwardHeaderSize + payloadLength);
+        unsigned char* out = datagram.data();
+        for (int i = 0; i < 8; ++i) {
+            out[i] = static_cast<unsigned char>((forwardedId >> (56 - 8 * i)) & 0xFF);
         }
+        out[8] = static_cast<unsigned char>((chunkIndex >> 8) & 0xFF);
+        out[9] = static_cast<unsigned char>(chunkIndex & 0xFF);
+        out[10] = static_cast<unsigned char>((totalChunks >> 8) & 0xFF);
+        out[11] = static_cast<unsigned char>(totalChunks & 0xFF);
+        out[12] = static_cast<unsigned char>((payloadLength >> 8) & 0xFF);
+        out[13] = static_cast<unsigned char>(payloadLength & 0xFF);
+        for (int i = 0; i < 4; ++i) {
+            out[14 + i] = static_cast<unsigned char>((packetType >> (24 - 8 * i)) & 0xFF);
+        }
+        std::memcpy(out + m_forwardHeaderSize, payload, payloadLength);
+
+        DatagramSet datagrams;
+        datagrams.push_back(std::move(datagram));
+        return makeDatagramSet(std::move(datagrams));
+    }
 
-        if (oldestIt != packets.end()) {
-            packets.erase(oldestIt);
+    void PacketReceiver::initPendingPacket(PendingPacket& packet, uint64_t packetId, uint16_t totalChunks, uint32_t packetType,
+        const std::array<unsigned char, 32>& senderNicknameHash, std::chrono::steady_clock::time_point now)
+    {
+        // Reuse the slot's chunk list; chunks left over from an abandoned packet go back to the pool.
+        packet.active = true;
+        packet.packetId = packetId;
+        packet.totalChunks = totalChunks;
+        packet.chunks.resize(totalChunks);
+        for (auto& chunk : packet.chunks) {
+            chunk.reset();
         }
+        packet.receivedChunks = 0;
+        packet.type = packetType;
+        packet.senderNicknameHash = senderNicknameHash;
+        packet.lastUpdated = now;
     }
 
     uint16_t PacketReceiver::readUint16(const unsigned char* data)
@@ -340,31 +781,64 @@ namespace server::network::udp
     {
         const auto timeout = std::chrono::milliseconds(100);
 
-        constexpr int maxAssemblyBatch = 64;
+        constexpr std::size_t maxAssemblyBatch = 64;
+        std::vector<AssemblyJob> jobs;
+        jobs.reserve(maxAssemblyBatch);
+
         while (m_running.load()) {
-            for (int i = 0; i < maxAssemblyBatch; ++i) {
-                auto jobOpt = m_assemblyQueue.try_pop();
-                if (!jobOpt.has_value()) break;
-                try {
-                    ReceivedPacket packet;
-                    packet.type = jobOpt->type;
-                    packet.endpoint = jobOpt->endpoint;
-                    packet.senderNicknameHash = jobOpt->senderNicknameHash;
-                    for (const auto& chunk : jobOpt->chunks) {
-                        packet.data.insert(packet.data.end(), chunk.begin(), chunk.end());
-                    }
-                    m_receivedPacketsQueue.push_with_limit(std::move(packet), m_maxReceivedPacketsQueueSize);
-                }
-                catch (const std::exception& e) {
-                    LOG_ERROR("Assembly failed: {}", e.what());
-                }
+            jobs.clear();
+            // Sleep on the assembly queue itself so a completed packet wakes this thread immediately.
+            m_assemblyQueue.pop_batch_for(jobs, maxAssemblyBatch, timeout);
+
+            for (auto& job : jobs) {
+                assemblePacket(job);
             }
+            deliverReceivedPackets();
+        }
+    }
 
-            auto packetOpt = m_receivedPacketsQueue.pop_for(timeout);
-            if (!packetOpt.has_value()) {
-                continue;
+    std::size_t PacketReceiver::processPending()
+    {
+        std::size_t processed = 0;
+        while (auto job = m_assemblyQueue.try_pop()) {
+            assemblePacket(*job);
+            ++processed;
+        }
+        deliverReceivedPackets();
+        return processed;
+    }
+
+    void PacketReceiver::assemblePacket(AssemblyJob& job)
+    {
+        try {
+            ReceivedPacket packet;
+            packet.type = job.type;
+            packet.endpoint = job.endpoint;
+            packet.senderNicknameHash = job.senderNicknameHash;
+            std::size_t size = 0;
+            for (const auto& chunk : job.chunks) {
+                size += chunk.size();
             }
+            if (size != 0) {
+                packet.data = utilities::BufferPool::shared().acquire(size);
+                unsigned char* out = packet.data.data();
+                for (const auto& chunk : job.chunks) {
+                    std::memcpy(out, chunk.data(), chunk.size());
+                    out += chunk.size();
+                }
+            }
+            if (const std::size_t dropped = m_receivedPacketsQueue.push_drop_oldest(std::move(packet))) {
+                MediaMetrics::get().receivedQueueDropped.add(dropped);
+            }
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR("Assembly failed: {}", e.what());
+        }
+    }
 
+    void PacketReceiver::deliverReceivedPackets()
+    {
+        while (auto packetOpt = m_receivedPacketsQueue.try_pop()) {
             if (!m_onPacketReceived) {
                 continue;
             }
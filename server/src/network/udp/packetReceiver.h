@@ -7,43 +7,78 @@
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <mutex>
-#include <string>
 #include <thread>
-#include <unordered_map>
 #include <vector>
 
-#include "utilities/safeQueue.h"
+#include "network/udp/endpointKey.h"
+#include "network/udp/endpointTable.h"
+#include "network/udp/packet.h"
+#include "utilities/bufferPool.h"
+#include "utilities/ringBuffer.h"
 
 namespace server::network::udp
 {
     class PacketReceiver {
     private:
+        struct HeldChunk {
+            DatagramSetPtr datagram;
+            std::chrono::steady_clock::time_point receivedAt{};
+        };
+
+        using HeldChunks = std::vector<HeldChunk, utilities::PoolAllocator<HeldChunk>>;
+
         struct PendingPacket {
+            bool active = false;
             uint64_t packetId = 0;
             uint16_t totalChunks = 0;
             std::size_t receivedChunks = 0;
-            std::vector<std::vector<unsigned char>> chunks;
+            utilities::PooledBufferList chunks;
             uint32_t type = 0;
             std::array<unsigned char, 32> senderNicknameHash{};
             std::chrono::steady_clock::time_point lastUpdated{};
         };
 
         struct ReceivedPacket {
-            std::vector<unsigned char> data;
+            utilities::PooledBuffer data;
             uint32_t type;
             asio::ip::udp::endpoint endpoint;
             std::array<unsigned char, 32> senderNicknameHash{};
         };
 
+        struct ForwardRoute {
+            bool active = false;
+            uint64_t packetId = 0;
+            uint64_t forwardedId = 0;
+            uint16_t totalChunks = 0;
+            uint32_t type = 0;
+            std::size_t receivedChunks = 0;
+            std::vector<bool, utilities::PoolAllocator<bool>> seenChunks;
+            bool resolved = false;
+            std::shared_ptr<const ForwardTargets> targets;
+            HeldChunks heldChunks;
+            std::chrono::steady_clock::time_point lastUpdated{};
+        };
+
         struct AssemblyJob {
-            std::vector<std::vector<unsigned char>> chunks;
+            utilities::PooledBufferList chunks;
             uint32_t type = 0;
             asio::ip::udp::endpoint endpoint;
             std::array<unsigned char, 32> senderNicknameHash{};
         };
 
     public:
+        // Gets chunk 0 of every cut-through packet (payload, size, type, source, sender hash) and must
+        // answer through completeForward with the ticket, from any thread. Called on the receive thread.
+        using ForwardDispatcher = std::function<void(const unsigned char*, std::size_t, uint32_t,
+            const asio::ip::udp::endpoint&, const std::array<unsigned char, 32>&, const ForwardTicket&)>;
+        // Relays one rewritten chunk; the time point is when the chunk was received.
+        using ForwardSender = std::function<void(const DatagramSetPtr&, const ForwardTargets&, std::chrono::steady_clock::time_point)>;
+        // Maps the media session id of a v2 chunk header to the sender's binary nickname hash.
+        // Called per datagram, so it must not block.
+        using SessionResolver = std::function<bool(uint32_t, std::array<unsigned char, 32>&)>;
+
         PacketReceiver();
         ~PacketReceiver();
 
@@ -52,43 +87,97 @@ namespace server::network::udp
             std::function<void()> onErrorCallback,
             std::function<void(uint32_t, const asio::ip::udp::endpoint&)> onPingReceived);
 
+        // Cut-through forwarding: chunk 0 of each packet goes to dispatchTargets, which picks the
+        // receivers from its payload; from then on every chunk is relayed with a rewritten header
+        // as soon as it arrives, instead of being reassembled and handed to onPacketReceived.
+        // Chunks that arrive before the receivers are known are held back.
+        void enableCutThrough(ForwardDispatcher dispatchTargets, std::function<uint64_t()> nextPacketId, ForwardSender forward);
+
+        // Receivers for a packet handed to the dispatcher; relays the chunks held for it so far.
+        void completeForward(const ForwardTicket& ticket, ForwardTargets&& targets);
+
+        // MEDIA_NACK datagrams are handed to onNack (payload, size, source) and never forwarded or reassembled.
+        void setNackHandler(std::function<void(const unsigned char*, std::size_t, const asio::ip::udp::endpoint&)> onNack);
+
+        // Linux: asks the kernel to coalesce bursts of datagrams from one sender (UDP_GRO) and
+        // splits them again here. Returns false when unsupported; receiving is unchanged then.
+        // Call before start().
+        bool enableReceiveOffload();
+
+        // Enables wire format v2 chunk headers; without a resolver every datagram is parsed as v1.
+        void setSessionResolver(SessionResolver resolveSession);
+
         void start();
         void stop();
         bool isRunning() const;
 
+        // One datagram as the socket handlers pass it on; lets a caller without a socket feed the receiver.
+        void processDatagram(const unsigned char* data, std::size_t bytesTransferred, const asio::ip::udp::endpoint& endpoint);
+        // Does the processing thread's work for the packets completed so far on the calling thread and
+        // returns how many there were. Only for a receiver that was not started.
+        std::size_t processPending();
+
     private:
-        using PendingPacketMap = std::unordered_map<uint64_t, PendingPacket>;
-        using EndpointPendingMap = std::unordered_map<std::string, PendingPacketMap>;
+        static constexpr std::size_t m_maxPendingPackets = 8;
+        using PendingPacketTable = EndpointTable<PendingPacket, m_maxPendingPackets>;
+        using ForwardRouteTable = EndpointTable<ForwardRoute, m_maxPendingPackets>;
 
         void doReceive();
-        void processDatagram(std::size_t bytesTransferred);
+#if defined(__linux__)
+        void receiveBatch();
+        void receiveCoalescedBatch();
+#endif
         void processReceivedPackets();
+        void assemblePacket(AssemblyJob& job);
+        void deliverReceivedPackets();
         void initPendingPacket(PendingPacket& packet, uint64_t packetId, uint16_t totalChunks, uint32_t packetType,
             const std::array<unsigned char, 32>& senderNicknameHash, std::chrono::steady_clock::time_point now);
-        void evictOldestPacket(PendingPacketMap& packets);
+        void forwardChunk(const unsigned char* data, const EndpointKey& endpointKey, const asio::ip::udp::endpoint& endpoint,
+            const std::array<unsigned char, 32>& senderNicknameHash, uint64_t packetId, uint16_t chunkIndex, uint16_t totalChunks,
+            uint16_t payloadLength, uint32_t packetType);
+        DatagramSetPtr buildForwardDatagram(const unsigned char* payload, uint16_t payloadLength, uint64_t forwardedId,
+            uint16_t chunkIndex, uint16_t totalChunks, uint32_t packetType);
         uint16_t readUint16(const unsigned char* data);
         uint32_t readUint32(const unsigned char* data);
         uint64_t readUint64(const unsigned char* data);
         void notifyError(const std::error_code& ec);
-        std::string makeEndpointKey(const asio::ip::udp::endpoint& endpoint);
 
     private:
         std::optional<std::reference_wrapper<asio::ip::udp::socket>> m_socket;
         asio::ip::udp::endpoint m_remoteEndpoint;
         std::array<unsigned char, 1500> m_buffer{};
+#if defined(__linux__)
+        // recvmmsg drains up to m_maxBatchDatagrams datagrams per readiness wakeup.
+        static constexpr std::size_t m_maxBatchDatagrams = 32;
+        static constexpr std::size_t m_maxBatchRounds = 4;
+        std::array<std::array<unsigned char, 1500>, m_maxBatchDatagrams> m_batchBuffers{};
+        std::array<asio::ip::udp::endpoint, m_maxBatchDatagrams> m_batchEndpoints{};
+        // With UDP_GRO one receive can hold up to 64 KB of segments, so fewer, larger buffers
+        // are allocated only once the offload is on.
+        static constexpr std::size_t m_maxCoalescedDatagrams = 8;
+        static constexpr std::size_t m_coalescedBufferSize = 65536;
+        std::vector<unsigned char> m_coalescedBuffers;
+        bool m_receiveOffload = false;
+#endif
         std::atomic<bool> m_running;
         std::mutex m_stateMutex;
-        EndpointPendingMap m_pendingPackets;
-        server::utilities::SafeQueue<ReceivedPacket> m_receivedPacketsQueue;
-        server::utilities::SafeQueue<AssemblyJob> m_assemblyQueue;
+        PendingPacketTable m_pendingPackets;
+        ForwardRouteTable m_forwardRoutes;
+        ForwardDispatcher m_dispatchForwardTargets;
+        std::function<uint64_t()> m_nextForwardId;
+        ForwardSender m_forward;
+        SessionResolver m_resolveSession;
+        server::utilities::SpscRingBuffer<ReceivedPacket> m_receivedPacketsQueue{ m_maxReceivedPacketsQueueSize };
+        server::utilities::SpscRingBuffer<AssemblyJob> m_assemblyQueue{ m_maxAssemblyQueueSize };
         std::thread m_processingThread;
         const std::size_t m_headerSize = 50;  // 32 (senderNicknameHash) + 18 (packetId, chunkIndex, etc.)
-        const std::size_t m_maxPendingPackets = 8;
+        const std::size_t m_forwardHeaderSize = 18;
         static constexpr std::size_t m_maxAssemblyQueueSize = 64;
         static constexpr std::size_t m_maxReceivedPacketsQueueSize = 64;
         std::function<void(const unsigned char*, int, uint32_t, const asio::ip::udp::endpoint&, const std::array<unsigned char, 32>&)> m_onPacketReceived;
         std::function<void()> m_onErrorCallback;
         std::function<void(uint32_t, const asio::ip::udp::endpoint&)> m_onPingReceived;
+        std::function<void(const unsigned char*, std::size_t, const asio::ip::udp::endpoint&)> m_onNackReceived;
     };
 }
 
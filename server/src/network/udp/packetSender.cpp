@@ -1,14 +1,29 @@
 #include "packetSender.h"
+#include "constants/packetType.h"
+#include "network/udp/mediaMetrics.h"
 
 #include <algorithm>
+#include <cstring>
 
 #include "utilities/logger.h"
 #include "utilities/errorCodeForLog.h"
 
+#if defined(__linux__)
+#include <array>
+#include <cerrno>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#endif
+
 namespace server::network::udp
 {
     PacketSender::PacketSender()
-        : m_isSending(false), m_currentDatagramIndex(0)
+        : m_droppedVideoEntries(0U)
+        , m_isSending(false)
+        , m_videoTurn(0)
+        , m_pacingQueueDepth(0)
+        , m_pacingTimerArmed(false)
+        , m_currentDatagramIndex(0)
     {
     }
 
@@ -20,26 +35,174 @@ namespace server::network::udp
         m_socket = std::ref(socket);
         m_onErrorCallback = std::move(onErrorCallback);
         m_isSending = false;
+        m_currentSets.clear();
         m_currentDatagrams.clear();
+        m_currentEndpoints.clear();
         m_currentDatagramIndex = 0;
-
-        m_packetQueue.clear();
+        m_videoTurn = 0;
+        m_pacingTimer.emplace(socket.get_executor());
+        m_pacingTimerArmed = false;
+#if defined(__linux__)
+        m_segmentationOffload = false;
+#endif
+
+        clearQueues();
     }
 
     void PacketSender::send(const Packet& packet) {
-        m_packetQueue.push_with_limit(packet, m_maxPacketQueueSize);
+        send(makeDatagramSet(splitPacket(packet)), packet.endpoint);
+    }
+
+    void PacketSender::send(DatagramSetPtr datagrams, const asio::ip::udp::endpoint& endpoint, std::chrono::steady_clock::time_point receivedAt) {
+        if (!datagrams || datagrams->empty()) {
+            return;
+        }
+        enqueue(OutgoingDatagrams{ std::move(datagrams), endpoint, receivedAt });
         startSendingIfIdle();
     }
 
     void PacketSender::stop() {
         m_isSending = false;
+        if (m_pacingTimer.has_value()) {
+            m_pacingTimer->cancel();
+        }
+        m_currentSets.clear();
         m_currentDatagrams.clear();
+        m_currentEndpoints.clear();
         m_currentDatagramIndex = 0;
 
-        m_packetQueue.clear();
+        clearQueues();
+    }
+
+    bool PacketSender::enableSegmentationOffload() {
+#if defined(__linux__) && defined(UDP_SEGMENT)
+        if (!m_socket.has_value()) {
+            return false;
+        }
+        // A zero socket-wide segment size leaves plain sends alone; the size is given per send.
+        int segmentSize = 0;
+        if (::setsockopt(m_socket->get().native_handle(), SOL_UDP, UDP_SEGMENT, &segmentSize, sizeof(segmentSize)) != 0) {
+            return false;
+        }
+        m_segmentationOffload = true;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void PacketSender::setPacingRate(const asio::ip::udp::endpoint& endpoint, uint32_t kbps) {
+        m_pacingRateUpdates.push_drop_oldest(PacingRateUpdate{ endpoint, kbps });
+    }
+
+    std::size_t PacketSender::getPacingQueueDepth() const {
+        return m_pacingQueueDepth.load(std::memory_order_relaxed);
+    }
+
+    uint64_t PacketSender::getDroppedVideoEntries() const {
+        return m_droppedVideoEntries.load(std::memory_order_relaxed);
+    }
+
+    uint32_t PacketSender::packetTypeOf(const DatagramSet& datagrams) {
+        // Every datagram of a set carries the same type in the last header field.
+        const auto& header = datagrams.front();
+        if (header.size() < m_headerSize) {
+            return 0;
+        }
+        return (static_cast<uint32_t>(header[14]) << 24)
+            | (static_cast<uint32_t>(header[15]) << 16)
+            | (static_cast<uint32_t>(header[16]) << 8)
+            | static_cast<uint32_t>(header[17]);
+    }
+
+    PacketSender::EgressClass PacketSender::classify(const DatagramSet& datagrams) {
+        switch (static_cast<constant::PacketType>(packetTypeOf(datagrams))) {
+        case constant::PacketType::VOICE: return EgressClass::Voice;
+        case constant::PacketType::CAMERA: return EgressClass::Camera;
+        case constant::PacketType::SCREEN: return EgressClass::Screen;
+        default: return EgressClass::Control;
+        }
+    }
+
+    void PacketSender::enqueue(OutgoingDatagrams&& outgoing) {
+        const auto& metrics = MediaMetrics::get();
+        switch (classify(*outgoing.datagrams)) {
+        case EgressClass::Voice:
+            if (const std::size_t dropped = m_voiceQueue.push_drop_oldest(std::move(outgoing))) {
+                metrics.voiceQueueDropped.add(dropped);
+            }
+            break;
+        case EgressClass::Control:
+            if (const std::size_t dropped = m_controlQueue.push_drop_oldest(std::move(outgoing))) {
+                metrics.controlQueueDropped.add(dropped);
+            }
+            break;
+        case EgressClass::Camera:
+            if (!m_cameraQueue.try_push(std::move(outgoing))) {
+                m_droppedVideoEntries.fetch_add(1U, std::memory_order_relaxed);
+                metrics.cameraQueueDropped.add();
+            }
+            break;
+        case EgressClass::Screen:
+            if (!m_screenQueue.try_push(std::move(outgoing))) {
+                m_droppedVideoEntries.fetch_add(1U, std::memory_order_relaxed);
+                metrics.screenQueueDropped.add();
+            }
+            break;
+        }
+    }
+
+    std::optional<OutgoingDatagrams> PacketSender::popScheduled(EgressClass& egressClass) {
+        if (auto outgoing = m_voiceQueue.try_pop()) {
+            egressClass = EgressClass::Voice;
+            return outgoing;
+        }
+        if (auto outgoing = m_controlQueue.try_pop()) {
+            egressClass = EgressClass::Control;
+            return outgoing;
+        }
+
+        // Weighted round robin between the video classes; an empty class yields its turn.
+        const bool cameraTurn = m_videoTurn < m_cameraWeight;
+        m_videoTurn = (m_videoTurn + 1) % (m_cameraWeight + m_screenWeight);
+        auto& preferred = cameraTurn ? m_cameraQueue : m_screenQueue;
+        auto& other = cameraTurn ? m_screenQueue : m_cameraQueue;
+        if (auto outgoing = preferred.try_pop()) {
+            egressClass = cameraTurn ? EgressClass::Camera : EgressClass::Screen;
+            return outgoing;
+        }
+        egressClass = cameraTurn ? EgressClass::Screen : EgressClass::Camera;
+        return other.try_pop();
+    }
+
+    bool PacketSender::hasQueuedDatagrams() const {
+        return !m_voiceQueue.empty() || !m_controlQueue.empty() || !m_cameraQueue.empty() || !m_screenQueue.empty();
+    }
+
+    void PacketSender::clearQueues() {
+        m_voiceQueue.clear();
+        m_controlQueue.clear();
+        m_cameraQueue.clear();
+        m_screenQueue.clear();
+        m_pacingRateUpdates.clear();
+        m_pacedReceivers.clear();
+        m_pacingQueueDepth.store(0, std::memory_order_relaxed);
+    }
+
+    void PacketSender::holdSending() {
+        m_sendingHeld = true;
+    }
+
+    std::size_t PacketSender::discardQueued() {
+        const std::size_t queued = m_voiceQueue.size() + m_controlQueue.size() + m_cameraQueue.size() + m_screenQueue.size();
+        clearQueues();
+        return queued;
     }
 
     void PacketSender::startSendingIfIdle() {
+        if (m_sendingHeld.load(std::memory_order_relaxed)) {
+            return;
+        }
         if (m_isSending.exchange(true)) {
             return;
         }
@@ -52,25 +215,28 @@ namespace server::network::udp
         processNextPacketFromQueue();
     }
 
-    void PacketSender::writeUint16(std::vector<unsigned char>& buffer, uint16_t value)
+    unsigned char* PacketSender::writeUint16(unsigned char* out, uint16_t value)
     {
-        buffer.push_back(static_cast<unsigned char>((value >> 8) & 0xFF));
-        buffer.push_back(static_cast<unsigned char>(value & 0xFF));
+        *out++ = static_cast<unsigned char>((value >> 8) & 0xFF);
+        *out++ = static_cast<unsigned char>(value & 0xFF);
+        return out;
     }
 
-    void PacketSender::writeUint32(std::vector<unsigned char>& buffer, uint32_t value)
+    unsigned char* PacketSender::writeUint32(unsigned char* out, uint32_t value)
     {
-        buffer.push_back(static_cast<unsigned char>((value >> 24) & 0xFF));
-        buffer.push_back(static_cast<unsigned char>((value >> 16) & 0xFF));
-        buffer.push_back(static_cast<unsigned char>((value >> 8) & 0xFF));
-        buffer.push_back(static_cast<unsigned char>(value & 0xFF));
+        *out++ = static_cast<unsigned char>((value >> 24) & 0xFF);
+        *out++ = static_cast<unsigned char>((value >> 16) & 0xFF);
+        *out++ = static_cast<unsigned char>((value >> 8) & 0xFF);
+        *out++ = static_cast<unsigned char>(value & 0xFF);
+        return out;
     }
 
-    void PacketSender::writeUint64(std::vector<unsigned char>& buffer, uint64_t value)
+    unsigned char* PacketSender::writeUint64(unsigned char* out, uint64_t value)
     {
         for (int shift = 56; shift >= 0; shift -= 8) {
-            buffer.push_back(static_cast<unsigned char>((value >> shift) & 0xFF));
+            *out++ = static_cast<unsigned char>((value >> shift) & 0xFF);
         }
+        return out;
     }
 
     void PacketSender::processNextPacketFromQueue() {
@@ -79,25 +245,350 @@ namespace server::network::udp
             return;
         }
 
-        auto packetOpt = m_packetQueue.try_pop();
-        if (!packetOpt.has_value()) {
-            m_isSending = false;
+        while (true) {
+            collectBatch();
+
+            if (m_currentDatagrams.empty()) {
+                if (m_pacingQueueDepth.load(std::memory_order_relaxed) != 0) {
+                    armPacingTimer(std::chrono::steady_clock::now());
+                }
+                m_isSending = false;
+                // A producer may have pushed between the last pop and clearing m_isSending.
+                if (!hasQueuedDatagrams() || m_isSending.exchange(true)) {
+                    return;
+                }
+                continue;
+            }
+
+#if defined(__linux__)
+            // Socket buffer full: flushDatagramBatch resumes from the write-ready handler.
+            if (!flushDatagramBatch()) {
+                return;
+            }
+#else
+            sendNextDatagram();
             return;
+#endif
         }
+    }
 
-        Packet packet = std::move(*packetOpt);
-        m_currentEndpoint = packet.endpoint;
-        m_currentDatagrams = splitPacket(packet);
-        m_currentDatagramIndex = 0; 
+    void PacketSender::collectBatch() {
+        m_currentSets.clear();
+        m_currentDatagrams.clear();
+        m_currentEndpoints.clear();
+        m_currentDatagramIndex = 0;
 
-        if (!m_currentDatagrams.empty()) {
-            sendNextDatagram();
+        const auto now = std::chrono::steady_clock::now();
+        applyPacingRateUpdates(now);
+        releasePacedDatagrams(now);
+
+        for (std::size_t i = 0; i < m_maxBatchPackets; ++i) {
+            EgressClass egressClass = EgressClass::Control;
+            auto outgoingOpt = popScheduled(egressClass);
+            if (!outgoingOpt.has_value()) {
+                break;
+            }
+            schedule(std::move(*outgoingOpt), egressClass, now);
         }
-        else {
-            processNextPacketFromQueue();
+    }
+
+    void PacketSender::schedule(OutgoingDatagrams&& outgoing, EgressClass egressClass, std::chrono::steady_clock::time_point now) {
+        if (m_pacedReceivers.empty()) {
+            takeQueuedDatagrams(std::move(outgoing));
+            return;
+        }
+        auto it = m_pacedReceivers.find(EndpointKey::from(outgoing.endpoint));
+        if (it == m_pacedReceivers.end()) {
+            takeQueuedDatagrams(std::move(outgoing));
+            return;
         }
+
+        PacedReceiver& receiver = it->second;
+        refill(receiver, now);
+
+        // Voice and control are never held back, but they still spend the receiver's budget.
+        if (egressClass == EgressClass::Voice || egressClass == EgressClass::Control) {
+            const double burstBytes = std::max(m_minPacingBurstBytes, receiver.bytesPerMs * m_pacingBurstMs);
+            for (const auto& datagram : *outgoing.datagrams) {
+                receiver.tokens -= static_cast<double>(datagram.size());
+            }
+            receiver.tokens = std::max(receiver.tokens, -burstBytes);
+            takeQueuedDatagrams(std::move(outgoing));
+            return;
+        }
+
+        const std::size_t count = outgoing.datagrams->size();
+        if (receiver.backlogDatagrams + count > m_maxPacedDatagramsPerReceiver) {
+            m_droppedVideoEntries.fetch_add(1U, std::memory_order_relaxed);
+            MediaMetrics::get().pacerDropped.add();
+            return;
+        }
+        receiver.backlogDatagrams += count;
+        m_pacingQueueDepth.fetch_add(count, std::memory_order_relaxed);
+        receiver.backlog.push_back(std::move(outgoing));
+        releaseBacklog(receiver);
+    }
+
+    void PacketSender::applyPacingRateUpdates(std::chrono::steady_clock::time_point now) {
+        while (auto update = m_pacingRateUpdates.try_pop()) {
+            const EndpointKey key = EndpointKey::from(update->endpoint);
+            if (update->kbps == 0) {
+                auto it = m_pacedReceivers.find(key);
+                if (it != m_pacedReceivers.end() && it->second.backlog.empty()) {
+                    m_pacedReceivers.erase(it);
+                }
+                else if (it != m_pacedReceivers.end()) {
+                    // Let the backlog drain at line rate, then forget the receiver.
+                    it->second.bytesPerMs = 0.0;
+                    it->second.rateUpdatedAt = now;
+                }
+                continue;
+            }
+
+            auto [it, inserted] = m_pacedReceivers.try_emplace(key);
+            PacedReceiver& receiver = it->second;
+            if (inserted) {
+                receiver.endpoint = update->endpoint;
+                receiver.lastRefill = now;
+            }
+            else {
+                refill(receiver, now);
+            }
+            receiver.bytesPerMs = static_cast<double>(update->kbps) / 8.0;
+            receiver.rateUpdatedAt = now;
+            if (inserted) {
+                receiver.tokens = std::max(m_minPacingBurstBytes, receiver.bytesPerMs * m_pacingBurstMs);
+            }
+        }
+    }
+
+    void PacketSender::releasePacedDatagrams(std::chrono::steady_clock::time_point now) {
+        for (auto it = m_pacedReceivers.begin(); it != m_pacedReceivers.end();) {
+            PacedReceiver& receiver = it->second;
+            if (!receiver.backlog.empty()) {
+                refill(receiver, now);
+                releaseBacklog(receiver);
+            }
+            if (receiver.backlog.empty() && now - receiver.rateUpdatedAt > m_pacingRateTimeout) {
+                it = m_pacedReceivers.erase(it);
+                continue;
+            }
+            ++it;
+        }
+    }
+
+    void PacketSender::releaseBacklog(PacedReceiver& receiver) {
+        while (!receiver.backlog.empty() && (receiver.tokens > 0.0 || receiver.bytesPerMs <= 0.0)) {
+            OutgoingDatagrams& front = receiver.backlog.front();
+            const auto& datagrams = *front.datagrams;
+            const std::size_t firstReleased = receiver.nextDatagram;
+            // Keep the set alive for the batch even if it is only partly released.
+            m_currentSets.push_back(front.datagrams);
+            while (receiver.nextDatagram < datagrams.size() && (receiver.tokens > 0.0 || receiver.bytesPerMs <= 0.0)) {
+                const auto& datagram = datagrams[receiver.nextDatagram++];
+                m_currentDatagrams.push_back(&datagram);
+                m_currentEndpoints.push_back(front.endpoint);
+                receiver.tokens -= static_cast<double>(datagram.size());
+                --receiver.backlogDatagrams;
+                m_pacingQueueDepth.fetch_sub(1, std::memory_order_relaxed);
+            }
+            // refill() ran just before, so lastRefill is the current time.
+            recordSent(front, firstReleased, receiver.nextDatagram - firstReleased, receiver.lastRefill);
+            if (receiver.nextDatagram < datagrams.size()) {
+                break;
+            }
+            receiver.nextDatagram = 0;
+            receiver.backlog.pop_front();
+        }
+    }
+
+    void PacketSender::refill(PacedReceiver& receiver, std::chrono::steady_clock::time_point now) {
+        const double elapsedMs = std::chrono::duration<double, std::milli>(now - receiver.lastRefill).count();
+        receiver.lastRefill = now;
+        if (elapsedMs <= 0.0 || receiver.bytesPerMs <= 0.0) {
+            return;
+        }
+        const double burstBytes = std::max(m_minPacingBurstBytes, receiver.bytesPerMs * m_pacingBurstMs);
+        receiver.tokens = std::min(burstBytes, receiver.tokens + elapsedMs * receiver.bytesPerMs);
+    }
+
+    void PacketSender::armPacingTimer(std::chrono::steady_clock::time_point now) {
+        if (!m_pacingTimer.has_value() || m_pacingTimerArmed.exchange(true)) {
+            return;
+        }
+
+        // Wake up when the first backlogged receiver has a positive budget again.
+        double waitMs = m_pacingBurstMs;
+        for (const auto& [key, receiver] : m_pacedReceivers) {
+            (void)key;
+            if (receiver.backlog.empty() || receiver.bytesPerMs <= 0.0) {
+                continue;
+            }
+            waitMs = std::min(waitMs, (1.0 - receiver.tokens) / receiver.bytesPerMs);
+        }
+        const auto wait = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double, std::milli>(std::max(waitMs, 0.5)));
+
+        m_pacingTimer->expires_at(now + wait);
+        m_pacingTimer->async_wait([this](const std::error_code& ec) {
+            m_pacingTimerArmed = false;
+            if (ec) {
+                return;
+            }
+            startSendingIfIdle();
+        });
+    }
+
+    void PacketSender::takeQueuedDatagrams(OutgoingDatagrams&& outgoing) {
+        for (const auto& datagram : *outgoing.datagrams) {
+            m_currentDatagrams.push_back(&datagram);
+            m_currentEndpoints.push_back(outgoing.endpoint);
+        }
+        recordSent(outgoing, 0, outgoing.datagrams->size(), std::chrono::steady_clock::now());
+        m_currentSets.push_back(std::move(outgoing.datagrams));
     }
 
+    // Counted when a datagram joins a send batch; the batch is flushed right after collectBatch.
+    void PacketSender::recordSent(const OutgoingDatagrams& outgoing, std::size_t first, std::size_t count,
+        std::chrono::steady_clock::time_point now)
+    {
+        if (count == 0) {
+            return;
+        }
+        const auto& metrics = MediaMetrics::get();
+        const auto& datagrams = *outgoing.datagrams;
+        const std::size_t typeIndex = MediaMetrics::typeIndex(packetTypeOf(datagrams));
+        std::size_t bytes = 0;
+        for (std::size_t i = first; i < first + count; ++i) {
+            bytes += datagrams[i].size();
+        }
+        metrics.datagramsSent.add(typeIndex, count);
+        metrics.bytesSent.add(typeIndex, bytes);
+
+        // A set released in several pacing rounds is timed by its first datagram only.
+        if (first == 0 && outgoing.receivedAt.time_since_epoch().count() != 0) {
+            const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(now - outgoing.receivedAt);
+            metrics.forwardLatencyUs.record(static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0)));
+        }
+    }
+
+#if defined(__linux__)
+    // Number of datagrams from first that can go out as one segmented send: same endpoint, every
+    // segment the size of the first, except a shorter last one (the tail chunk of a packet).
+    std::size_t PacketSender::segmentRunLength(std::size_t first, std::size_t limit) const {
+        const std::size_t segmentSize = m_currentDatagrams[first]->size();
+        const std::size_t maxSegments = std::min(m_maxSegmentsPerSend, m_maxSegmentedBytes / std::max<std::size_t>(segmentSize, 1));
+        std::size_t count = 1;
+        while (first + count < limit && count < maxSegments) {
+            const std::size_t next = first + count;
+            if (!(m_currentEndpoints[next] == m_currentEndpoints[first])) {
+                break;
+            }
+            const std::size_t size = m_currentDatagrams[next]->size();
+            if (size > segmentSize || size == 0) {
+                break;
+            }
+            ++count;
+            if (size < segmentSize) {
+                break;
+            }
+        }
+        return count;
+    }
+
+    bool PacketSender::flushDatagramBatch() {
+        auto& socket = m_socket->get();
+        const int fd = socket.native_handle();
+
+        std::array<mmsghdr, m_maxBatchDatagrams> messages{};
+        std::array<iovec, m_maxBatchDatagrams> iovecs{};
+#if defined(UDP_SEGMENT)
+        std::array<std::array<char, CMSG_SPACE(sizeof(uint16_t))>, m_maxBatchDatagrams> controls{};
+#endif
+        // Datagrams carried by each message; more than one only for segmented sends.
+        std::array<std::size_t, m_maxBatchDatagrams> messageDatagrams{};
+
+        while (m_currentDatagramIndex < m_currentDatagrams.size()) {
+            const std::size_t limit = m_currentDatagramIndex + std::min(m_maxBatchDatagrams, m_currentDatagrams.size() - m_currentDatagramIndex);
+            const bool segmentation = m_segmentationOffload.load(std::memory_order_relaxed);
+            std::size_t count = 0;
+            for (std::size_t index = m_currentDatagramIndex; index < limit; ++count) {
+                const std::size_t run = segmentation ? segmentRunLength(index, limit) : 1;
+                for (std::size_t i = 0; i < run; ++i) {
+                    const auto& datagram = *m_currentDatagrams[index + i];
+                    iovecs[index - m_currentDatagramIndex + i].iov_base = const_cast<unsigned char*>(datagram.data());
+                    iovecs[index - m_currentDatagramIndex + i].iov_len = datagram.size();
+                }
+                auto& endpoint = m_currentEndpoints[index];
+                messages[count].msg_hdr = msghdr{};
+                messages[count].msg_hdr.msg_name = endpoint.data();
+                messages[count].msg_hdr.msg_namelen = static_cast<socklen_t>(endpoint.size());
+                messages[count].msg_hdr.msg_iov = &iovecs[index - m_currentDatagramIndex];
+                messages[count].msg_hdr.msg_iovlen = run;
+#if defined(UDP_SEGMENT)
+                if (run > 1) {
+                    auto& control = controls[count];
+                    messages[count].msg_hdr.msg_control = control.data();
+                    messages[count].msg_hdr.msg_controllen = control.size();
+                    cmsghdr* cmsg = CMSG_FIRSTHDR(&messages[count].msg_hdr);
+                    cmsg->cmsg_level = SOL_UDP;
+                    cmsg->cmsg_type = UDP_SEGMENT;
+                    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                    const uint16_t segmentSize = static_cast<uint16_t>(m_currentDatagrams[index]->size());
+                    std::memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof(segmentSize));
+                }
+#endif
+                messageDatagrams[count] = run;
+                index += run;
+            }
+
+            const int sent = ::sendmmsg(fd, messages.data(), static_cast<unsigned int>(count), MSG_DONTWAIT);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                    socket.async_wait(asio::socket_base::wait_write, [this](const std::error_code& ec) {
+                        if (ec) {
+                            if (ec != asio::error::operation_aborted) {
+                                LOG_ERROR("Failed to wait for UDP socket: {}", server::utilities::errorCodeForLog(ec));
+                            }
+                            m_isSending = false;
+                            return;
+                        }
+                        if (m_socket.has_value() && flushDatagramBatch()) {
+                            processNextPacketFromQueue();
+                        }
+                    });
+                    return false;
+                }
+
+                if (messageDatagrams[0] > 1 && (errno == EIO || errno == EINVAL || errno == EOPNOTSUPP)) {
+                    // No checksum offload on the egress device or an older kernel: resend unsegmented.
+                    LOG_WARN("UDP segmentation offload rejected, falling back to one datagram per send: {}",
+                        server::utilities::errorCodeForLog(std::error_code(errno, asio::error::get_system_category())));
+                    m_segmentationOffload = false;
+                    continue;
+                }
+
+                // sendmmsg reports an error only for the first message of the batch; drop it and go on.
+                LOG_ERROR("Failed to send datagram chunk: {}", server::utilities::errorCodeForLog(std::error_code(errno, asio::error::get_system_category())));
+                if (m_onErrorCallback) {
+                    m_onErrorCallback();
+                }
+                m_currentDatagramIndex += messageDatagrams[0];
+                continue;
+            }
+
+            for (int i = 0; i < sent; ++i) {
+                m_currentDatagramIndex += messageDatagrams[static_cast<std::size_t>(i)];
+            }
+        }
+
+        return true;
+    }
+#endif
+
     void PacketSender::sendNextDatagram() {
         if (!m_socket.has_value()) {
             m_isSending = false;
@@ -110,11 +601,11 @@ namespace server::network::udp
         }
 
         auto& socket = m_socket->get();
-        auto& datagram = m_currentDatagrams[m_currentDatagramIndex];
+        const auto& datagram = *m_currentDatagrams[m_currentDatagramIndex];
 
         socket.async_send_to(
-            asio::buffer(datagram),
-            m_currentEndpoint,
+            asio::buffer(datagram.data(), datagram.size()),
+            m_currentEndpoints[m_currentDatagramIndex],
             [this](std::error_code ec, std::size_t bytesTransferred) {
                 if (ec) {
                     LOG_ERROR("Failed to send datagram chunk: {}", server::utilities::errorCodeForLog(ec));
@@ -141,35 +632,35 @@ namespace server::network::udp
         );
     }
 
-    std::vector<std::vector<unsigned char>> PacketSender::splitPacket(const Packet& packetData) {
-        const bool hasPayload = !packetData.data.empty();
+    DatagramSet PacketSender::splitPacket(const Packet& packetData) {
+        return splitPayload(packetData.id, packetData.type, packetData.data.data(), packetData.data.size());
+    }
+
+    DatagramSet PacketSender::splitPayload(uint64_t id, uint32_t type, const unsigned char* data, std::size_t size) {
+        const bool hasPayload = data != nullptr && size > 0;
         const std::size_t totalChunks = hasPayload
-            ? static_cast<std::size_t>((packetData.data.size() + m_maxPayloadSize - 1) / m_maxPayloadSize)
+            ? static_cast<std::size_t>((size + m_maxPayloadSize - 1) / m_maxPayloadSize)
             : 1U;
 
-        std::vector<std::vector<unsigned char>> packets;
+        DatagramSet packets;
         packets.reserve(totalChunks);
 
         for (std::size_t chunkIndex = 0; chunkIndex < totalChunks; ++chunkIndex) {
             const std::size_t offset = chunkIndex * m_maxPayloadSize;
             const std::size_t payloadSize = hasPayload
-                ? std::min(m_maxPayloadSize, packetData.data.size() - offset)
+                ? std::min(m_maxPayloadSize, size - offset)
                 : 0U;
 
-            std::vector<unsigned char> datagram;
-            datagram.reserve(m_headerSize + payloadSize);
-
-            writeUint64(datagram, packetData.id);
-            writeUint16(datagram, static_cast<uint16_t>(chunkIndex));
-            writeUint16(datagram, static_cast<uint16_t>(totalChunks));
-            writeUint16(datagram, static_cast<uint16_t>(payloadSize));
-            writeUint32(datagram, static_cast<uint32_t>(packetData.type));
+            auto datagram = utilities::BufferPool::shared().acquire(m_headerSize + payloadSize);
+            unsigned char* out = datagram.data();
+            out = writeUint64(out, id);
+            out = writeUint16(out, static_cast<uint16_t>(chunkIndex));
+            out = writeUint16(out, static_cast<uint16_t>(totalChunks));
+            out = writeUint16(out, static_cast<uint16_t>(payloadSize));
+            out = writeUint32(out, type);
 
             if (payloadSize > 0) {
-                datagram.insert(datagram.end(),
-                    packetData.data.begin() + static_cast<std::ptrdiff_t>(offset),
-                    packetData.data.begin() + static_cast<std::ptrdiff_t>(offset + payloadSize)
-                );
+                std::memcpy(out, data + offset, payloadSize);
             }
 
             packets.push_back(std::move(datagram));
@@ -178,4 +669,3 @@ namespace server::network::udp
         return packets;
     }
 }
-
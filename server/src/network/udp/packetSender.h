@@ -1,13 +1,17 @@
 #pragma once
 
 #include <atomic>
+#include <chrono>
 #include <cstdint>
+#include <deque>
 #include <functional>
 #include <optional>
+#include <unordered_map>
 #include <vector>
 
+#include "network/udp/endpointKey.h"
 #include "network/udp/packet.h"
-#include "utilities/safeQueue.h"
+#include "utilities/ringBuffer.h"
 
 #include <asio.hpp>
 
@@ -21,31 +25,144 @@ namespace server::network::udp
 
         void init(asio::ip::udp::socket& socket, std::function<void()> onErrorCallback);
         void send(const Packet& packet);
+        // receivedAt is set for relayed chunks, whose forwarding latency is recorded when they go out.
+        void send(DatagramSetPtr datagrams, const asio::ip::udp::endpoint& endpoint,
+            std::chrono::steady_clock::time_point receivedAt = {});
         void stop();
 
+        // Linux: sends runs of equal-sized datagrams to one endpoint as a single UDP_SEGMENT
+        // super-datagram. Returns false when the kernel lacks UDP GSO; sending is unchanged then.
+        bool enableSegmentationOffload();
+
+        // Paces video to this receiver with a token bucket at kbps; 0 sends unpaced again.
+        // Safe to call from any thread, applied before the next batch.
+        void setPacingRate(const asio::ip::udp::endpoint& endpoint, uint32_t kbps);
+        // Datagrams currently held back by the pacer.
+        std::size_t getPacingQueueDepth() const;
+        // Video entries dropped because their egress or pacing queue was full.
+        uint64_t getDroppedVideoEntries() const;
+
+        // From now on send() only queues: nothing is handed to the socket, as if a send never completed.
+        // For measuring the path up to the send queues; discardQueued() then empties them.
+        void holdSending();
+        // Drops everything queued and returns how many entries (one datagram set for one endpoint
+        // each) that was. Only while sending is held.
+        std::size_t discardQueued();
+
+        // Chunks a payload into wire-ready datagrams; the result does not depend on the receiver.
+        static DatagramSet splitPayload(uint64_t id, uint32_t type, const unsigned char* data, std::size_t size);
+
     private:
+        // Egress classes. Voice is always served first, then control traffic; camera and
+        // screen share split the remaining capacity by weight so neither starves the other.
+        enum class EgressClass {
+            Voice,
+            Control,
+            Camera,
+            Screen
+        };
+
+        struct PacingRateUpdate {
+            asio::ip::udp::endpoint endpoint;
+            uint32_t kbps = 0;
+        };
+
+        struct PacedReceiver {
+            asio::ip::udp::endpoint endpoint;
+            double bytesPerMs = 0.0;
+            double tokens = 0.0;
+            std::chrono::steady_clock::time_point lastRefill{};
+            std::chrono::steady_clock::time_point rateUpdatedAt{};
+            std::deque<OutgoingDatagrams> backlog;
+            std::size_t backlogDatagrams = 0;
+            std::size_t nextDatagram = 0;
+        };
+
+        static uint32_t packetTypeOf(const DatagramSet& datagrams);
+        static EgressClass classify(const DatagramSet& datagrams);
+        void enqueue(OutgoingDatagrams&& outgoing);
+        std::optional<OutgoingDatagrams> popScheduled(EgressClass& egressClass);
+        bool hasQueuedDatagrams() const;
+        void clearQueues();
+        void collectBatch();
+        void schedule(OutgoingDatagrams&& outgoing, EgressClass egressClass, std::chrono::steady_clock::time_point now);
+        void applyPacingRateUpdates(std::chrono::steady_clock::time_point now);
+        void releasePacedDatagrams(std::chrono::steady_clock::time_point now);
+        void releaseBacklog(PacedReceiver& receiver);
+        void armPacingTimer(std::chrono::steady_clock::time_point now);
+        static void refill(PacedReceiver& receiver, std::chrono::steady_clock::time_point now);
         void startSendingIfIdle();
         void sendNextDatagram();
         void processNextPacketFromQueue();
-        std::vector<std::vector<unsigned char>> splitPacket(const Packet& packetData);
-        void writeUint16(std::vector<unsigned char>& buffer, uint16_t value);
-        void writeUint32(std::vector<unsigned char>& buffer, uint32_t value);
-        void writeUint64(std::vector<unsigned char>& buffer, uint64_t value);
+#if defined(__linux__)
+        bool flushDatagramBatch();
+        std::size_t segmentRunLength(std::size_t first, std::size_t limit) const;
+#endif
+        DatagramSet splitPacket(const Packet& packetData);
+        void takeQueuedDatagrams(OutgoingDatagrams&& outgoing);
+        static void recordSent(const OutgoingDatagrams& outgoing, std::size_t first, std::size_t count,
+            std::chrono::steady_clock::time_point now);
+        static unsigned char* writeUint16(unsigned char* out, uint16_t value);
+        static unsigned char* writeUint32(unsigned char* out, uint32_t value);
+        static unsigned char* writeUint64(unsigned char* out, uint64_t value);
 
     private:
-        server::utilities::SafeQueue<Packet> m_packetQueue;
+        // Fed by every worker's processing thread; drained by whichever thread owns m_isSending.
+        // Full voice/control queues evict their oldest entry; full video queues drop the new one,
+        // so a screen-share burst can neither delay nor evict voice.
+        server::utilities::MpscRingBuffer<OutgoingDatagrams> m_voiceQueue{ m_maxVoiceQueueSize };
+        server::utilities::MpscRingBuffer<OutgoingDatagrams> m_controlQueue{ m_maxControlQueueSize };
+        server::utilities::MpscRingBuffer<OutgoingDatagrams> m_cameraQueue{ m_maxVideoQueueSize };
+        server::utilities::MpscRingBuffer<OutgoingDatagrams> m_screenQueue{ m_maxVideoQueueSize };
+        std::atomic<uint64_t> m_droppedVideoEntries;
         std::atomic<bool> m_isSending;
+        std::atomic<bool> m_sendingHeld{ false };
+        // Position in the camera/screen weighted round robin; only touched by the sending thread.
+        std::size_t m_videoTurn;
+
+        // Pacer state is owned by the sending thread; other threads only post rate updates.
+        server::utilities::MpscRingBuffer<PacingRateUpdate> m_pacingRateUpdates{ m_maxPacingRateUpdates };
+        std::unordered_map<EndpointKey, PacedReceiver, EndpointKeyHash> m_pacedReceivers;
+        std::atomic<std::size_t> m_pacingQueueDepth;
+        std::optional<asio::steady_timer> m_pacingTimer;
+        std::atomic<bool> m_pacingTimerArmed;
 
         std::optional<std::reference_wrapper<asio::ip::udp::socket>> m_socket;
         std::function<void()> m_onErrorCallback;
 
-        std::vector<std::vector<unsigned char>> m_currentDatagrams;
+        std::vector<DatagramSetPtr> m_currentSets;
+        std::vector<const utilities::PooledBuffer*> m_currentDatagrams;
+        std::vector<asio::ip::udp::endpoint> m_currentEndpoints;
         std::size_t m_currentDatagramIndex;
-        asio::ip::udp::endpoint m_currentEndpoint;
 
-        const std::size_t m_maxPayloadSize = 1300;
-        const std::size_t m_headerSize = 18;
-        static constexpr std::size_t m_maxPacketQueueSize = 256;  // ~2-5 sec buffer at 50-100 pkt/s
+        static constexpr std::size_t m_maxPayloadSize = 1300;
+        static constexpr std::size_t m_headerSize = 18;
+        // Entries are whole packets or single forwarded chunks, so these are sized in chunks:
+        // ~1-2 sec of a 720p stream fanned out to a handful of receivers per video class.
+        static constexpr std::size_t m_maxVoiceQueueSize = 512;
+        static constexpr std::size_t m_maxControlQueueSize = 256;
+        static constexpr std::size_t m_maxVideoQueueSize = 1024;
+        static constexpr std::size_t m_cameraWeight = 2;
+        static constexpr std::size_t m_screenWeight = 1;
+        // Queued entries (e.g. one frame fanned out to a meeting) are sent as one batch,
+        // flushed with sendmmsg on Linux.
+        static constexpr std::size_t m_maxBatchPackets = 64;
+#if defined(__linux__)
+        static constexpr std::size_t m_maxBatchDatagrams = 64;
+        // Kernel limits for one UDP_SEGMENT send: UDP_MAX_SEGMENTS and the 64 KB IP datagram.
+        static constexpr std::size_t m_maxSegmentsPerSend = 64;
+        static constexpr std::size_t m_maxSegmentedBytes = 65000;
+        // Cleared for good when the kernel or NIC rejects a segmented send.
+        std::atomic<bool> m_segmentationOffload{ false };
+#endif
+        static constexpr std::size_t m_maxPacingRateUpdates = 256;
+        // Held-back datagrams per receiver (~0.5 MB); beyond that new video is dropped.
+        static constexpr std::size_t m_maxPacedDatagramsPerReceiver = 384;
+        // Bucket depth: a few ms of the rate, but never less than a handful of full datagrams.
+        static constexpr double m_pacingBurstMs = 5.0;
+        static constexpr double m_minPacingBurstBytes = 4.0 * (m_headerSize + m_maxPayloadSize);
+        // Receivers without a rate update for this long are forgotten (sent unpaced again).
+        static constexpr std::chrono::seconds m_pacingRateTimeout{ 10 };
     };
 }
 
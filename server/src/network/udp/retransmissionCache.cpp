@@ -0,0 +1,140 @@
+#include "retransmissionCache.h"
+#include "constants/packetType.h"
+
+#include <algorithm>
+
+namespace server::network::udp
+{
+    namespace
+    {
+        constexpr std::size_t kForwardHeaderSize = 18;
+
+        uint16_t readUint16(const unsigned char* data) {
+            return static_cast<uint16_t>((static_cast<uint16_t>(data[0]) << 8) | static_cast<uint16_t>(data[1]));
+        }
+
+        uint32_t readUint32(const unsigned char* data) {
+            uint32_t value = 0;
+            for (int i = 0; i < 4; ++i) {
+                value = (value << 8) | data[i];
+            }
+            return value;
+        }
+
+        uint64_t readUint64(const unsigned char* data) {
+            uint64_t value = 0;
+            for (int i = 0; i < 8; ++i) {
+                value = (value << 8) | data[i];
+            }
+            return value;
+        }
+
+        bool isRetransmittable(uint32_t type) {
+            // Voice is not worth a round trip; a late audio frame is dropped by the jitter buffer anyway.
+            return type == static_cast<uint32_t>(constant::PacketType::CAMERA)
+                || type == static_cast<uint32_t>(constant::PacketType::SCREEN);
+        }
+    }
+
+    RetransmissionCache::RetransmissionCache(std::chrono::milliseconds window)
+        : m_window(window)
+    {
+    }
+
+    RetransmissionCache::Shard& RetransmissionCache::shardFor(uint64_t packetId) {
+        return m_shards[packetId % m_shardCount];
+    }
+
+    void RetransmissionCache::store(const DatagramSetPtr& datagrams, const EndpointList& endpoints) {
+        if (!datagrams || datagrams->empty() || endpoints.empty()) {
+            return;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < datagrams->size(); ++i) {
+            const auto& datagram = (*datagrams)[i];
+            if (datagram.size() < kForwardHeaderSize || !isRetransmittable(readUint32(datagram.data() + 14))) {
+                continue;
+            }
+            const uint64_t packetId = readUint64(datagram.data());
+            const uint16_t chunkIndex = readUint16(datagram.data() + 8);
+            const uint16_t totalChunks = readUint16(datagram.data() + 10);
+            if (chunkIndex >= totalChunks) {
+                continue;
+            }
+
+            Shard& shard = shardFor(packetId);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto [it, inserted] = shard.entries.try_emplace(packetId);
+            Entry& entry = it->second;
+            if (inserted || entry.chunks.size() != totalChunks) {
+                entry.storedAt = now;
+                entry.chunks.assign(totalChunks, ChunkRef{});
+                entry.receivers.clear();
+                entry.receivers.reserve(endpoints.size());
+                for (const auto& endpoint : endpoints) {
+                    entry.receivers.push_back(EndpointKey::from(endpoint));
+                }
+                shard.order.emplace_back(now, packetId);
+                expireLocked(shard, now);
+            }
+            entry.chunks[chunkIndex] = ChunkRef{ datagrams, static_cast<uint16_t>(i) };
+        }
+    }
+
+    DatagramSet RetransmissionCache::collect(const unsigned char* nack, std::size_t size, const asio::ip::udp::endpoint& requester) {
+        DatagramSet result;
+        if (!nack) {
+            return result;
+        }
+
+        const EndpointKey requesterKey = EndpointKey::from(requester);
+        const auto now = std::chrono::steady_clock::now();
+        std::size_t offset = 0;
+        std::size_t requested = 0;
+
+        while (offset + 10 <= size && requested < m_maxChunksPerNack) {
+            const uint64_t packetId = readUint64(nack + offset);
+            const uint16_t count = readUint16(nack + offset + 8);
+            offset += 10;
+            if (offset + static_cast<std::size_t>(count) * 2 > size) {
+                break;
+            }
+
+            Shard& shard = shardFor(packetId);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.entries.find(packetId);
+            const bool allowed = it != shard.entries.end()
+                && now - it->second.storedAt <= m_window
+                && std::find(it->second.receivers.begin(), it->second.receivers.end(), requesterKey) != it->second.receivers.end();
+
+            for (uint16_t i = 0; i < count && requested < m_maxChunksPerNack; ++i, offset += 2) {
+                ++requested;
+                if (!allowed) {
+                    continue;
+                }
+                const uint16_t chunkIndex = readUint16(nack + offset);
+                if (chunkIndex >= it->second.chunks.size()) {
+                    continue;
+                }
+                const ChunkRef& chunk = it->second.chunks[chunkIndex];
+                if (chunk.datagrams) {
+                    result.push_back((*chunk.datagrams)[chunk.index]);
+                }
+            }
+        }
+        return result;
+    }
+
+    void RetransmissionCache::expireLocked(Shard& shard, std::chrono::steady_clock::time_point now) {
+        while (!shard.order.empty()
+            && (now - shard.order.front().first > m_window || shard.order.size() > m_maxEntriesPerShard)) {
+            const auto [storedAt, packetId] = shard.order.front();
+            shard.order.pop_front();
+            auto it = shard.entries.find(packetId);
+            if (it != shard.entries.end() && it->second.storedAt == storedAt) {
+                shard.entries.erase(it);
+            }
+        }
+    }
+}
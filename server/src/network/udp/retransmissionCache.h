@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "network/udp/endpointKey.h"
+#include "network/udp/packet.h"
+#include "utilities/bufferPool.h"
+
+#include "asio.hpp"
+
+namespace server::network::udp
+{
+    // Recently forwarded video datagrams, kept for a short time window so a receiver can NACK
+    // single lost chunks instead of waiting for the next keyframe. Entries are keyed by the
+    // server-side packet id and chunk index and share the datagram sets queued for sending.
+    class RetransmissionCache {
+    public:
+        explicit RetransmissionCache(std::chrono::milliseconds window);
+
+        void store(const DatagramSetPtr& datagrams, const EndpointList& endpoints);
+
+        // Parses a MEDIA_NACK payload (repeated: u64 packetId, u16 count, count x u16 chunkIndex)
+        // and returns copies of the cached datagrams it asks for. Only endpoints a packet was
+        // originally sent to get its chunks back.
+        DatagramSet collect(const unsigned char* nack, std::size_t size, const asio::ip::udp::endpoint& requester);
+
+    private:
+        static constexpr std::size_t m_shardCount = 16;
+        static constexpr std::size_t m_maxEntriesPerShard = 4096;
+        static constexpr std::size_t m_maxChunksPerNack = 256;
+
+        struct ChunkRef {
+            DatagramSetPtr datagrams;
+            uint16_t index = 0;
+        };
+
+        // An entry is added per forwarded video packet, so all of its storage comes from the buffer pool.
+        struct Entry {
+            std::chrono::steady_clock::time_point storedAt{};
+            std::vector<ChunkRef, utilities::PoolAllocator<ChunkRef>> chunks;
+            std::vector<EndpointKey, utilities::PoolAllocator<EndpointKey>> receivers;
+        };
+
+        using StoredAt = std::pair<std::chrono::steady_clock::time_point, uint64_t>;
+
+        struct Shard {
+            std::mutex mutex;
+            std::unordered_map<uint64_t, Entry, std::hash<uint64_t>, std::equal_to<uint64_t>,
+                utilities::PoolAllocator<std::pair<const uint64_t, Entry>>> entries;
+            std::deque<StoredAt, utilities::PoolAllocator<StoredAt>> order;
+        };
+
+        Shard& shardFor(uint64_t packetId);
+        void expireLocked(Shard& shard, std::chrono::steady_clock::time_point now);
+
+    private:
+        const std::chrono::steady_clock::duration m_window;
+        std::array<Shard, m_shardCount> m_shards;
+    };
+}
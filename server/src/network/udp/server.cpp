@@ -11,30 +11,68 @@ using namespace std::chrono_literals;
 
 namespace server::network::udp
 {
+#if defined(SO_REUSEPORT)
+    using reuse_port = asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>;
+#endif
+
+    Server::Worker::Worker(std::size_t workerIndex)
+        : index(workerIndex)
+        , socket(context)
+    {
+        workGuard.emplace(asio::make_work_guard(context));
+    }
+
     Server::Server()
-        : m_socket(m_context)
-        , m_running(false)
+        : m_running(false)
         , m_nextPacketId(0U)
     {
-        m_workGuard.emplace(asio::make_work_guard(m_context));
     }
 
     Server::~Server() {
         stop();
     }
 
-    bool Server::init(const std::string& port,
+    bool Server::init(const std::string& port, std::size_t workerCount,
         std::function<void(const unsigned char*, int, uint32_t, const asio::ip::udp::endpoint&, const std::array<unsigned char, 32>&)> onReceive)
     {
         m_port = port;
         m_onReceive = std::move(onReceive);
-        return reinit();
+
+        if (workerCount == 0) {
+            workerCount = 1;
+        }
+#if !defined(SO_REUSEPORT)
+        if (workerCount > 1) {
+            LOG_WARN("[UDP] SO_REUSEPORT is not available on this platform, using a single media socket instead of {}", workerCount);
+            workerCount = 1;
+        }
+#endif
+
+        m_workers.clear();
+        m_workers.reserve(workerCount);
+        for (std::size_t i = 0; i < workerCount; ++i) {
+            m_workers.push_back(std::make_unique<Worker>(i));
+        }
+
+        if (!resolveServerEndpoint()) {
+            return false;
+        }
+
+        for (auto& worker : m_workers) {
+            if (!reinit(*worker)) {
+                return false;
+            }
+        }
+
+        LOG_INFO("[UDP] Media server initialized on port {} with {} socket worker(s)", m_port, m_workers.size());
+        return true;
     }
 
-    bool Server::reinit() {
+    bool Server::resolveServerEndpoint() {
         try {
             std::error_code ec;
-            asio::ip::udp::resolver resolver(m_context);
+            asio::io_context resolverContext;
+            asio::ip::udp::resolver resolver(resolverContext);
             auto endpoints = resolver.resolve(asio::ip::udp::v4(), "0.0.0.0", m_port, ec);
             if (ec) {
                 LOG_ERROR("Failed to resolve 0.0.0.0:{} - {}", m_port, server::utilities::errorCodeForLog(ec));
@@ -45,41 +83,64 @@ namespace server::network::udp
                 return false;
             }
             m_serverEndpoint = *endpoints.begin();
+            return true;
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR("Server resolve error: {}", e.what());
+            return false;
+        }
+    }
 
-            if (m_socket.is_open()) {
-                m_socket.close(ec);
+    bool Server::reinit(Worker& worker) {
+        try {
+            std::error_code ec;
+            auto& socket = worker.socket;
+
+            if (socket.is_open()) {
+                socket.close(ec);
                 ec.clear();
             }
-            m_socket.open(asio::ip::udp::v4(), ec);
+            socket.open(asio::ip::udp::v4(), ec);
             if (ec) {
                 LOG_ERROR("Failed to open UDP socket: {}", server::utilities::errorCodeForLog(ec));
                 return false;
             }
-            m_socket.set_option(asio::socket_base::reuse_address(true), ec);
+            socket.set_option(asio::socket_base::reuse_address(true), ec);
             if (ec) {
                 LOG_ERROR("Failed to set reuse_address on UDP socket: {}", server::utilities::errorCodeForLog(ec));
                 return false;
             }
-            m_socket.bind(m_serverEndpoint, ec);
+#if defined(SO_REUSEPORT)
+            if (m_workers.size() > 1) {
+                socket.set_option(reuse_port(true), ec);
+                if (ec) {
+                    LOG_ERROR("Failed to set reuse_port on UDP socket: {}", server::utilities::errorCodeForLog(ec));
+                    return false;
+                }
+            }
+#endif
+            socket.bind(m_serverEndpoint, ec);
             if (ec) {
                 LOG_ERROR("Failed to bind UDP socket: {}", server::utilities::errorCodeForLog(ec));
                 return false;
             }
 
-            m_workGuard.emplace(asio::make_work_guard(m_context));
+            worker.workGuard.emplace(asio::make_work_guard(worker.context));
 
-            std::function<void()> errorHandler = []() {
-                LOG_ERROR("[UDP] Packet send/receive error");
+            std::function<void()> errorHandler = [index = worker.index]() {
+                LOG_ERROR("[UDP] Packet send/receive error on worker {}", index);
             };
             auto pingNoOp = [](uint32_t, const asio::ip::udp::endpoint&) {};
 
-            if (!m_packetReceiver.init(m_socket, m_onReceive, errorHandler, pingNoOp)) {
+            if (!worker.packetReceiver.init(socket, m_onReceive, errorHandler, pingNoOp)) {
                 LOG_ERROR("Failed to initialize packet receiver");
                 return false;
             }
-            m_packetSender.init(m_socket, errorHandler);
-
-            LOG_INFO("[UDP] Media server initialized on port {}", m_port);
+            enableCutThrough(worker);
+            enableRetransmission(worker);
+            enableSessionResolver(worker);
+            worker.packetSender.init(socket, errorHandler);
+            enableSegmentationOffload(worker);
             return true;
         }
         catch (const std::exception& e) {
@@ -88,91 +149,280 @@ namespace server::network::udp
         }
     }
 
+    void Server::setForwardDispatcher(PacketReceiver::ForwardDispatcher dispatchTargets) {
+        m_forwardDispatcher = std::move(dispatchTargets);
+        for (auto& worker : m_workers) {
+            enableCutThrough(*worker);
+        }
+        LOG_INFO("[UDP] Cut-through media forwarding enabled");
+    }
+
+    void Server::enableCutThrough(Worker& worker) {
+        if (!m_forwardDispatcher) {
+            return;
+        }
+        // The ticket remembers the socket worker, so the answer reaches the receiver that holds the chunks.
+        worker.packetReceiver.enableCutThrough(
+            [this, index = worker.index](const unsigned char* data, std::size_t size, uint32_t type, const asio::ip::udp::endpoint& endpoint,
+                const std::array<unsigned char, 32>& senderNicknameHash, const ForwardTicket& ticket) {
+                ForwardTicket workerTicket = ticket;
+                workerTicket.worker = index;
+                m_forwardDispatcher(data, size, type, endpoint, senderNicknameHash, workerTicket);
+            },
+            [this]() { return generateId(); },
+            [this](const DatagramSetPtr& datagrams, const ForwardTargets& targets, std::chrono::steady_clock::time_point receivedAt) {
+                forward(datagrams, targets, receivedAt);
+            });
+    }
+
+    void Server::completeForward(const ForwardTicket& ticket, ForwardTargets&& targets) {
+        if (ticket.worker >= m_workers.size()) {
+            return;
+        }
+        m_workers[ticket.worker]->packetReceiver.completeForward(ticket, std::move(targets));
+    }
+
+    void Server::setSessionResolver(PacketReceiver::SessionResolver resolveSession) {
+        m_sessionResolver = std::move(resolveSession);
+        for (auto& worker : m_workers) {
+            enableSessionResolver(*worker);
+        }
+    }
+
+    void Server::enableSessionResolver(Worker& worker) {
+        if (!m_sessionResolver) {
+            return;
+        }
+        worker.packetReceiver.setSessionResolver(m_sessionResolver);
+    }
+
+    void Server::enableSegmentationOffload() {
+        m_segmentationOffload = true;
+        for (auto& worker : m_workers) {
+            enableSegmentationOffload(*worker);
+        }
+    }
+
+    void Server::enableSegmentationOffload(Worker& worker) {
+        if (!m_segmentationOffload) {
+            return;
+        }
+        const bool gso = worker.packetSender.enableSegmentationOffload();
+        const bool gro = worker.packetReceiver.enableReceiveOffload();
+        LOG_INFO("[UDP] Worker {}: segmentation offload {}, receive offload {}",
+            worker.index, gso ? "on" : "unavailable", gro ? "on" : "unavailable");
+    }
+
+    void Server::enableRetransmission(std::chrono::milliseconds window) {
+        if (window.count() <= 0) {
+            return;
+        }
+        m_retransmissionCache = std::make_unique<RetransmissionCache>(window);
+        for (auto& worker : m_workers) {
+            enableRetransmission(*worker);
+        }
+        LOG_INFO("[UDP] Video retransmission on NACK enabled ({} ms window)", window.count());
+    }
+
+    void Server::enableRetransmission(Worker& worker) {
+        if (!m_retransmissionCache) {
+            return;
+        }
+        worker.packetReceiver.setNackHandler(
+            [this](const unsigned char* nack, std::size_t size, const asio::ip::udp::endpoint& requester) { retransmit(nack, size, requester); });
+    }
+
+    void Server::retransmit(const unsigned char* nack, std::size_t size, const asio::ip::udp::endpoint& requester) {
+        DatagramSet datagrams = m_retransmissionCache->collect(nack, size, requester);
+        if (datagrams.empty()) {
+            return;
+        }
+        selectWorker(requester).packetSender.send(makeDatagramSet(std::move(datagrams)), requester);
+    }
+
+    void Server::forward(const DatagramSetPtr& datagrams, const ForwardTargets& targets, std::chrono::steady_clock::time_point receivedAt) {
+        if (targets.keyframeKey) {
+            m_keyframeCache.store(*targets.keyframeKey, datagrams);
+        }
+        if (m_retransmissionCache) {
+            m_retransmissionCache->store(datagrams, targets.endpoints);
+        }
+        for (const auto& endpoint : targets.endpoints) {
+            selectWorker(endpoint).packetSender.send(datagrams, endpoint, receivedAt);
+        }
+    }
+
+    bool Server::replayKeyframe(const KeyframeKey& key, const asio::ip::udp::endpoint& endpoint) {
+        if (m_workers.empty()) return false;
+        DatagramSet datagrams = m_keyframeCache.collect(key);
+        if (datagrams.empty()) {
+            return false;
+        }
+        selectWorker(endpoint).packetSender.send(makeDatagramSet(std::move(datagrams)), endpoint);
+        return true;
+    }
+
+    void Server::dropKeyframe(const KeyframeKey& key) {
+        m_keyframeCache.erase(key);
+    }
+
+    void Server::dropKeyframes(const std::array<unsigned char, 32>& owner) {
+        m_keyframeCache.erase(owner);
+    }
+
     void Server::start() {
         if (m_running.exchange(true))
             return;
         LOG_INFO("[UDP] Media server starting on port {}", m_port);
-        m_ctxThread = std::thread([this]() {
-            while (m_running.load()) {
-                run();
-                if (!m_running.load()) break;
-
-                LOG_WARN("[UDP] io_context stopped unexpectedly, reinitializing in 1s...");
-                std::this_thread::sleep_for(1s);
-
-                stop_internal();
-                if (!reinit()) {
-                    LOG_ERROR("[UDP] Reinitialization failed, retrying in 3s...");
-                    std::this_thread::sleep_for(3s);
+        for (auto& workerPtr : m_workers) {
+            Worker& worker = *workerPtr;
+            worker.ctxThread = std::thread([this, &worker]() {
+                while (m_running.load()) {
+                    run(worker);
+                    if (!m_running.load()) break;
+
+                    LOG_WARN("[UDP] io_context of worker {} stopped unexpectedly, reinitializing in 1s...", worker.index);
+                    std::this_thread::sleep_for(1s);
+
+                    stop_internal(worker);
+                    if (!reinit(worker)) {
+                        LOG_ERROR("[UDP] Reinitialization of worker {} failed, retrying in 3s...", worker.index);
+                        std::this_thread::sleep_for(3s);
+                    }
                 }
-            }
-        });
+            });
+        }
     }
 
-    void Server::run() {
-        m_packetReceiver.start();
+    void Server::run(Worker& worker) {
+        worker.packetReceiver.start();
         try {
-            m_context.run();
+            worker.context.run();
         }
         catch (const std::exception& e) {
-            LOG_ERROR("[UDP] io_context exception: {}", e.what());
+            LOG_ERROR("[UDP] io_context exception on worker {}: {}", worker.index, e.what());
         }
         catch (...) {
-            LOG_ERROR("[UDP] io_context unknown exception");
+            LOG_ERROR("[UDP] io_context unknown exception on worker {}", worker.index);
         }
     }
 
     void Server::stop() {
         if (!m_running.exchange(false))
             return;
-        stop_internal();
-        if (m_ctxThread.joinable())
-            m_ctxThread.join();
+        for (auto& worker : m_workers) {
+            stop_internal(*worker);
+        }
+        for (auto& worker : m_workers) {
+            if (worker->ctxThread.joinable())
+                worker->ctxThread.join();
+        }
         LOG_INFO("[UDP] Media server stopped");
     }
 
-    void Server::stop_internal() {
-        m_packetSender.stop();
-        m_packetReceiver.stop();
+    void Server::stop_internal(Worker& worker) {
+        worker.packetSender.stop();
+        worker.packetReceiver.stop();
         std::error_code ec;
-        if (m_socket.is_open()) {
-            m_socket.cancel(ec);
-            m_socket.close(ec);
+        if (worker.socket.is_open()) {
+            worker.socket.cancel(ec);
+            worker.socket.close(ec);
         }
-        m_workGuard.reset();
-        m_context.stop();
-        m_context.restart();
+        worker.workGuard.reset();
+        worker.context.stop();
+        worker.context.restart();
     }
 
     bool Server::isRunning() const {
         return m_running.load();
     }
 
+    std::size_t Server::getWorkerCount() const {
+        return m_workers.size();
+    }
+
+    Server::Worker& Server::selectWorker(const asio::ip::udp::endpoint& endpoint) {
+        if (m_workers.size() == 1) {
+            return *m_workers.front();
+        }
+        // Keep every receiver on one worker so its datagrams stay in order on one send queue.
+        const std::size_t addressHash = endpoint.address().is_v4()
+            ? std::hash<uint32_t>{}(endpoint.address().to_v4().to_uint())
+            : std::hash<std::string>{}(endpoint.address().to_string());
+        const std::size_t hash = addressHash ^ (std::hash<uint16_t>{}(endpoint.port()) << 1);
+        return *m_workers[hash % m_workers.size()];
+    }
+
     bool Server::send(const std::vector<unsigned char>& data, uint32_t type, const asio::ip::udp::endpoint& endpoint) {
-        if (type == 0 || type == 1) return false;
+        if (type == 0 || type == 1 || m_workers.empty()) return false;
         Packet p;
         p.id = generateId();
         p.type = type;
         p.data = data;
         p.endpoint = endpoint;
-        m_packetSender.send(p);
+        selectWorker(endpoint).packetSender.send(p);
         return true;
     }
 
     bool Server::send(std::vector<unsigned char>&& data, uint32_t type, const asio::ip::udp::endpoint& endpoint) {
-        if (type == 0 || type == 1) return false;
+        if (type == 0 || type == 1 || m_workers.empty()) return false;
         Packet p;
         p.id = generateId();
         p.type = type;
         p.data = std::move(data);
         p.endpoint = endpoint;
-        m_packetSender.send(p);
+        selectWorker(endpoint).packetSender.send(p);
         return true;
     }
 
     bool Server::send(const unsigned char* data, int size, uint32_t type, const asio::ip::udp::endpoint& endpoint) {
-        if (type == 0 || type == 1 || !data || size <= 0) return false;
-        return send(std::vector<unsigned char>(data, data + size), type, endpoint);
+        if (type == 0 || type == 1 || !data || size <= 0 || m_workers.empty()) return false;
+        auto datagrams = makeDatagramSet(PacketSender::splitPayload(generateId(), type, data, static_cast<std::size_t>(size)));
+        selectWorker(endpoint).packetSender.send(std::move(datagrams), endpoint);
+        return true;
+    }
+
+    bool Server::send(const unsigned char* data, int size, uint32_t type, const ForwardTargets& targets) {
+        if (type == 0 || type == 1 || !data || size <= 0 || m_workers.empty()) return false;
+        if (targets.endpoints.empty() && !targets.keyframeKey) return true;
+        auto datagrams = makeDatagramSet(PacketSender::splitPayload(generateId(), type, data, static_cast<std::size_t>(size)));
+        forward(datagrams, targets);
+        return true;
+    }
+
+    void Server::setPacingRate(const asio::ip::udp::endpoint& endpoint, uint32_t kbps) {
+        if (m_workers.empty()) return;
+        selectWorker(endpoint).packetSender.setPacingRate(endpoint, kbps);
+    }
+
+    std::size_t Server::getPacingQueueDepth() const {
+        std::size_t depth = 0;
+        for (const auto& worker : m_workers) {
+            depth += worker->packetSender.getPacingQueueDepth();
+        }
+        return depth;
+    }
+
+    uint64_t Server::getDroppedVideoEntries() const {
+        uint64_t dropped = 0;
+        for (const auto& worker : m_workers) {
+            dropped += worker->packetSender.getDroppedVideoEntries();
+        }
+        return dropped;
+    }
+
+    void Server::holdSending() {
+        for (auto& worker : m_workers) {
+            worker->packetSender.holdSending();
+        }
+    }
+
+    std::size_t Server::discardQueuedSends() {
+        std::size_t discarded = 0;
+        for (auto& worker : m_workers) {
+            discarded += worker->packetSender.discardQueued();
+        }
+        return discarded;
     }
 
     uint64_t Server::generateId() {
@@ -1,6 +1,8 @@
 #pragma once
 #include <array>
 #include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -10,6 +12,8 @@
 
 #include "network/udp/packetSender.h"
 #include "network/udp/packetReceiver.h"
+#include "network/udp/retransmissionCache.h"
+#include "network/udp/keyframeCache.h"
 
 #include "asio.hpp"
 
@@ -20,36 +24,94 @@ namespace server::network::udp
         Server();
         ~Server();
 
-        bool init(const std::string& port,
+        // workerCount > 1 binds that many sockets to the same port with SO_REUSEPORT,
+        // each served by its own io_context thread, receiver and sender.
+        // The kernel hashes every client 4-tuple to one socket, so all chunks of a
+        // client's packets are reassembled by the same worker.
+        bool init(const std::string& port, std::size_t workerCount,
             std::function<void(const unsigned char*, int, uint32_t, const asio::ip::udp::endpoint&, const std::array<unsigned char, 32>&)> onReceive);
 
+        // Relay media chunk by chunk instead of reassembling packets for onReceive; dispatchTargets
+        // gets chunk 0 of every packet and answers through completeForward. Call before start().
+        void setForwardDispatcher(PacketReceiver::ForwardDispatcher dispatchTargets);
+        void completeForward(const ForwardTicket& ticket, ForwardTargets&& targets);
+
+        // Accept wire format v2 chunk headers whose session id resolveSession maps to a sender hash.
+        // Call before start().
+        void setSessionResolver(PacketReceiver::SessionResolver resolveSession);
+
+        // Linux: UDP GSO for chunk trains on send and UDP GRO on receive, per socket where the
+        // kernel supports them. Call before start().
+        void enableSegmentationOffload();
+
+        // Keep forwarded video for window so receivers can NACK lost chunks. Call before start().
+        void enableRetransmission(std::chrono::milliseconds window);
+
         void start();
         void stop();
         bool isRunning() const;
+        std::size_t getWorkerCount() const;
         bool send(const std::vector<unsigned char>& data, uint32_t type, const asio::ip::udp::endpoint& endpoint);
         bool send(std::vector<unsigned char>&& data, uint32_t type, const asio::ip::udp::endpoint& endpoint);
         bool send(const unsigned char* data, int size, uint32_t type, const asio::ip::udp::endpoint& endpoint);
+        // Fan-out: the payload is chunked once and the same immutable datagrams are queued to every endpoint.
+        bool send(const unsigned char* data, int size, uint32_t type, const ForwardTargets& targets);
+
+        // Sends the newest cached keyframe for key to endpoint; false when none is cached.
+        bool replayKeyframe(const KeyframeKey& key, const asio::ip::udp::endpoint& endpoint);
+        void dropKeyframe(const KeyframeKey& key);
+        void dropKeyframes(const std::array<unsigned char, 32>& owner);
+
+        // Paces video to endpoint at kbps on the worker that serves it; 0 disables pacing.
+        void setPacingRate(const asio::ip::udp::endpoint& endpoint, uint32_t kbps);
+        std::size_t getPacingQueueDepth() const;
+        uint64_t getDroppedVideoEntries() const;
+
+        // Every worker's sender only queues from now on (PacketSender::holdSending).
+        void holdSending();
+        // Drops what the held senders queued; returns the number of entries dropped.
+        std::size_t discardQueuedSends();
 
     private:
-        void run();
-        void stop_internal();
-        bool reinit();
+        struct Worker {
+            explicit Worker(std::size_t workerIndex);
+
+            std::size_t index;
+            asio::io_context context;
+            asio::ip::udp::socket socket;
+            std::optional<asio::executor_work_guard<asio::io_context::executor_type>> workGuard;
+            udp::PacketReceiver packetReceiver;
+            udp::PacketSender packetSender;
+            std::thread ctxThread;
+        };
+
+        void run(Worker& worker);
+        void stop_internal(Worker& worker);
+        bool reinit(Worker& worker);
+        bool resolveServerEndpoint();
+        Worker& selectWorker(const asio::ip::udp::endpoint& endpoint);
+        void enableCutThrough(Worker& worker);
+        void enableRetransmission(Worker& worker);
+        void enableSessionResolver(Worker& worker);
+        void enableSegmentationOffload(Worker& worker);
+        void retransmit(const unsigned char* nack, std::size_t size, const asio::ip::udp::endpoint& requester);
+        void forward(const DatagramSetPtr& datagrams, const ForwardTargets& targets,
+            std::chrono::steady_clock::time_point receivedAt = {});
         uint64_t generateId();
 
     private:
-        asio::io_context m_context;
-        asio::ip::udp::socket m_socket;
+        std::vector<std::unique_ptr<Worker>> m_workers;
         asio::ip::udp::endpoint m_serverEndpoint;
-        std::optional<asio::executor_work_guard<asio::io_context::executor_type>> m_workGuard;
-
-        udp::PacketReceiver m_packetReceiver;
-        udp::PacketSender m_packetSender;
 
         std::atomic<bool> m_running;
         std::atomic<uint64_t> m_nextPacketId;
 
         std::string m_port;
         std::function<void(const unsigned char*, int, uint32_t, const asio::ip::udp::endpoint&, const std::array<unsigned char, 32>&)> m_onReceive;
-        std::thread m_ctxThread;
+        PacketReceiver::ForwardDispatcher m_forwardDispatcher;
+        PacketReceiver::SessionResolver m_sessionResolver;
+        std::unique_ptr<RetransmissionCache> m_retransmissionCache;
+        bool m_segmentationOffload = false;
+        KeyframeCache m_keyframeCache;
     };
 }
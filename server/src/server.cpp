@@ -1,10 +1,13 @@
 #include "server.h"
 #include "logic/packetFactory.h"
+#include "logic/mediaFrameMeta.h"
 #include "constants/jsonType.h"
 #include "utilities/crypto.h"
 #include "utilities/logger.h"
-#include "utilities/metrics.h"
+#include "utilities/bufferPool.h"
+#include "utilities/metricsRegistry.h"
 #include "constants/mediaPolicy.h"
+#include "constants/mediaFrame.h"
 #include "models/pendingCall.h"
 #include "models/meeting.h"
 #include "models/pendingMeetingJoinRequest.h"
@@ -20,6 +23,8 @@
 using namespace server;
 using namespace server::constant;
 using namespace server::utilities;
+using server::logic::MediaFrameMeta;
+using server::logic::parseMediaFrameMeta;
 
 namespace
 {
@@ -27,44 +32,64 @@ namespace
         return std::vector<unsigned char>(s.begin(), s.end());
     }
 
-    struct MediaFrameMeta {
-        uint8_t version = 0;
-        std::string meetingId;
-        std::string senderHash;
-        uint8_t mediaKind = 0;
-        uint8_t layerId = 0;
-    };
+    // Receivers per forwarded meeting packet. Labelled by media kind rather than by meeting,
+    // so the number of series stays fixed however many meetings run.
+    const Histogram& meetingFanOutHistogram(PacketType type) {
+        static const std::array<Histogram, 3> histograms = [] {
+            auto& registry = MetricsRegistry::shared();
+            const std::string name = "callifornia_meeting_fanout_receivers";
+            const std::string help = "Receivers each forwarded meeting media packet went to, by media kind.";
+            return std::array<Histogram, 3>{
+                registry.histogram(name, help, "kind=\"voice\""),
+                registry.histogram(name, help, "kind=\"camera\""),
+                registry.histogram(name, help, "kind=\"screen\"")
+            };
+        }();
+        return type == PacketType::VOICE ? histograms[0] : type == PacketType::CAMERA ? histograms[1] : histograms[2];
+    }
 
-    std::optional<MediaFrameMeta> parseMediaFrameMeta(const unsigned char* data, int size)
+    // Decides whether a camera frame of the given layer goes to one receiver. The forwarded layer
+    // only moves to the subscribed one on a keyframe of that layer; until then the old layer keeps
+    // flowing, so the receiver's decoder is never fed P-frames it has no reference for.
+    bool selectCameraLayer(Meeting::CameraForwardState& state, const MediaFrameMeta& meta, uint8_t targetLayer, bool& keyframeNeeded)
     {
-        if (!data || size < 1 + 2) {
-            return std::nullopt;
+        const uint8_t forwardedLayer = state.forwardedLayer.load(std::memory_order_acquire);
+        if (meta.layerId != targetLayer) {
+            return meta.layerId == forwardedLayer;
         }
-        MediaFrameMeta meta;
-        meta.version = data[0];
-        if (meta.version != 1) {
-            return std::nullopt;
+        if (forwardedLayer == targetLayer) {
+            return true;
         }
-        const size_t meetingLenOffset = 1;
-        const uint16_t meetingIdLen = (static_cast<uint16_t>(data[meetingLenOffset]) << 8)
-            | static_cast<uint16_t>(data[meetingLenOffset + 1]);
-        const size_t meetingIdOffset = meetingLenOffset + 2;
-        if (size < static_cast<int>(meetingIdOffset + meetingIdLen + 2)) {
-            return std::nullopt;
+        if (meta.keyframe) {
+            state.forwardedLayer.store(targetLayer, std::memory_order_release);
+            return true;
         }
-        meta.meetingId.assign(reinterpret_cast<const char*>(data + meetingIdOffset), meetingIdLen);
-        const size_t senderLenOffset = meetingIdOffset + meetingIdLen;
-        const uint16_t senderHashLen = (static_cast<uint16_t>(data[senderLenOffset]) << 8)
-            | static_cast<uint16_t>(data[senderLenOffset + 1]);
-        const size_t senderOffset = senderLenOffset + 2;
-        if (size < static_cast<int>(senderOffset + senderHashLen + 2)) {
-            return std::nullopt;
+        keyframeNeeded = true;
+        return false;
+    }
+
+    // Screen counterpart of selectCameraLayer: nothing goes to a receiver until a keyframe does.
+    bool selectScreenFrame(Meeting::ScreenForwardState& state, const MediaFrameMeta& meta)
+    {
+        if (state.forwarding.load(std::memory_order_acquire)) {
+            return true;
+        }
+        if (meta.keyframe) {
+            state.forwarding.store(true, std::memory_order_release);
+            return true;
+        }
+        return false;
+    }
+
+    template<typename ForwardState>
+    bool claimKeyframeRequest(ForwardState& state, std::chrono::steady_clock::time_point now)
+    {
+        const int64_t nowMs = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+        int64_t requestedAtMs = state.keyframeRequestedAtMs.load(std::memory_order_relaxed);
+        if (requestedAtMs != 0 && nowMs - requestedAtMs < kKeyframeRequestMinIntervalMs) {
+            return false;
         }
-        meta.senderHash.assign(reinterpret_cast<const char*>(data + senderOffset), senderHashLen);
-        const size_t mediaOffset = senderOffset + senderHashLen;
-        meta.mediaKind = data[mediaOffset];
-        meta.layerId = data[mediaOffset + 1];
-        return meta;
+        return state.keyframeRequestedAtMs.compare_exchange_strong(requestedAtMs, nowMs, std::memory_order_relaxed);
     }
 
     bool shouldKeepLayer1(double lossEwma, double rttEwma, const server::constant::AbrProfile& profile)
@@ -88,19 +113,94 @@ namespace
         return profile.maxLayerCap;
     }
 
+    // Video stream slots per sender: one for the screen stream, one per camera simulcast layer.
+    // They index keyframe request rate limits and the server keyframe cache.
+    std::optional<std::size_t> keyframeStreamSlot(uint8_t mediaKind, uint8_t layerId)
+    {
+        if (mediaKind == 1) {
+            return 0;
+        }
+        if (mediaKind == 2 && layerId <= 2) {
+            return 1 + static_cast<std::size_t>(layerId);
+        }
+        return std::nullopt;
+    }
+
+    std::optional<network::KeyframeKey> keyframeCacheKey(const std::array<unsigned char, 32>& senderHash, uint8_t mediaKind, uint8_t layerId)
+    {
+        const auto slot = keyframeStreamSlot(mediaKind, layerId);
+        if (!slot) {
+            return std::nullopt;
+        }
+        return network::KeyframeKey{ senderHash, static_cast<uint16_t>(*slot) };
+    }
+
+    std::optional<network::KeyframeKey> keyframeCacheKey(const std::string& senderHash, uint8_t mediaKind, uint8_t layerId)
+    {
+        const auto owner = server::utilities::crypto::hashToBinary(senderHash);
+        if (!owner) {
+            return std::nullopt;
+        }
+        return keyframeCacheKey(*owner, mediaKind, layerId);
+    }
+
 }
 
 namespace server
 {
-    Server::Server(const std::string& tcpPort, const std::string& udpPort)
+    Server::Server(const ServerConfig& config)
+        : Server(config, std::make_shared<logic::UserRepository>(), std::make_shared<logic::MeetingManager>())
+    {
+    }
+
+    Server::Server(const ServerConfig& config, std::shared_ptr<logic::UserRepository> userRepository,
+        std::shared_ptr<logic::MeetingManager> meetingManager)
         : m_networkController(
-            static_cast<uint16_t>(std::stoul(tcpPort)),
-            udpPort,
+            static_cast<uint16_t>(std::stoul(config.tcpPort)),
+            config.controlWorkerCount,
+            config.udpPort,
+            config.udpWorkerCount,
             [this](network::tcp::OwnedPacket&& packet) {handleReceiveTcp(std::move(packet)); },
             [this](network::tcp::ConnectionPtr connection) {handleConnectionWithUserDown(connection); },
             [this](const unsigned char* data, int size, uint32_t type, const asio::ip::udp::endpoint& ep, const std::array<unsigned char, 32>& senderHash) {handleReceiveUdp(data, size, type, ep, senderHash);})
+        , m_userRepositoryOwner(std::move(userRepository))
+        , m_meetingManagerOwner(std::move(meetingManager))
+        , m_userRepository(*m_userRepositoryOwner)
+        , m_meetingManager(*m_meetingManagerOwner)
+        , m_metricsSampler(std::chrono::milliseconds(config.metricsSampleIntervalMs), std::chrono::milliseconds(config.metricsHistoryWindowMs),
+            static_cast<uint16_t>(std::stoul(config.udpPort)))
+        , m_mediaWorkers(config.mediaWorkerCount, [this](logic::MediaJob& job) { processMediaJob(job); })
     {
         registerHandlers();
+
+        if (!config.metricsPort.empty() && config.metricsPort != "0") {
+            m_metricsEndpoint = std::make_unique<network::MetricsEndpoint>(config.metricsAddress, config.metricsPort,
+                [this]() { return renderMetrics(); });
+        }
+
+        if (config.udpCutThrough) {
+            m_networkController.setUdpForwardDispatcher(
+                [this](const unsigned char* data, std::size_t size, uint32_t type, const asio::ip::udp::endpoint& ep, const std::array<unsigned char, 32>& senderHash,
+                    const network::ForwardTicket& ticket) {
+                    dispatchMediaJob(data, size, type, ep, senderHash, ticket);
+                });
+        }
+        m_networkController.enableUdpRetransmission(std::chrono::milliseconds(config.udpRetransmitWindowMs));
+        if (config.udpSegmentationOffload) {
+            m_networkController.enableUdpSegmentationOffload();
+        }
+        if (config.udpHoldSending) {
+            m_networkController.holdUdpSending();
+        }
+        m_networkController.setUdpSessionResolver(
+            [this](uint32_t sessionId, std::array<unsigned char, 32>& senderHash) {
+                UserPtr user = m_userRepository.findUserByMediaSessionId(sessionId);
+                if (!user || !user->hasNicknameHashBinary()) {
+                    return false;
+                }
+                senderHash = user->getNicknameHashBinary();
+                return true;
+            });
     }
 
     void Server::registerHandlers() {
@@ -130,78 +230,249 @@ namespace server
         m_packetHandlers.emplace(PacketType::MEETING_END, [this](const nlohmann::json& json, network::tcp::ConnectionPtr conn) { handleMeetingEnd(json, conn); });
         m_packetHandlers.emplace(PacketType::MEDIA_RECEIVER_STATS, [this](const nlohmann::json& json, network::tcp::ConnectionPtr conn) { handleMediaReceiverStats(json, conn); });
         m_packetHandlers.emplace(PacketType::MEDIA_RTT_PING, [this](const nlohmann::json& json, network::tcp::ConnectionPtr conn) { handleMediaRttPing(json, conn); });
+        m_packetHandlers.emplace(PacketType::MEDIA_KEYFRAME_REQUEST, [this](const nlohmann::json& json, network::tcp::ConnectionPtr conn) { handleMediaKeyframeRequest(json, conn); });
+        m_packetHandlers.emplace(PacketType::MEETING_VIDEO_CONFIG, [this](const nlohmann::json& json, network::tcp::ConnectionPtr conn) { handleMeetingVideoConfig(json, conn); });
     }
 
     void Server::run() {
+        m_metricsSampler.start();
+        if (m_metricsEndpoint) {
+            m_metricsEndpoint->start();
+        }
+        m_mediaWorkers.start();
         m_networkController.start();
     }
 
     void Server::stop() {
+        if (m_metricsEndpoint) {
+            m_metricsEndpoint->stop();
+        }
         m_networkController.stop();
+        m_mediaWorkers.stop();
+        m_metricsSampler.stop();
     }
 
     void Server::handleReceiveUdp(const unsigned char* data, int size, uint32_t rawType, const asio::ip::udp::endpoint& endpointFrom,
         const std::array<unsigned char, 32>& senderNicknameHash) {
+        dispatchMediaJob(data, size > 0 ? static_cast<std::size_t>(size) : 0U, rawType, endpointFrom, senderNicknameHash, std::nullopt);
+    }
+
+    std::size_t Server::runPendingMediaJobs() {
+        return m_mediaWorkers.runPending();
+    }
+
+    std::size_t Server::discardQueuedUdpSends() {
+        return m_networkController.discardQueuedUdpSends();
+    }
+
+    // Runs on the UDP receive threads: only copies the packet and hands it to the worker that owns
+    // the sender's meeting or call, so receiver selection never runs on the socket threads.
+    void Server::dispatchMediaJob(const unsigned char* data, std::size_t size, uint32_t rawType, const asio::ip::udp::endpoint& endpointFrom,
+        const std::array<unsigned char, 32>& senderNicknameHash, std::optional<network::ForwardTicket> ticket) {
+        logic::MediaJob job;
+        job.data = utilities::BufferPool::shared().acquire(size);
+        if (size > 0) {
+            std::memcpy(job.data.data(), data, size);
+        }
+        job.type = rawType;
+        job.endpoint = endpointFrom;
+        job.senderNicknameHash = senderNicknameHash;
+        job.ticket = std::move(ticket);
+        m_mediaWorkers.dispatch(mediaAffinityKey(senderNicknameHash), std::move(job));
+    }
+
+    void Server::processMediaJob(logic::MediaJob& job) {
+        auto targets = selectUdpReceivers(job.data.data(), job.data.size(), job.type, job.endpoint, job.senderNicknameHash);
+        if (job.ticket) {
+            m_networkController.completeUdpForward(*job.ticket, std::move(targets));
+            return;
+        }
+        m_networkController.sendUdp(job.data.data(), static_cast<int>(job.data.size()), job.type, targets);
+    }
+
+    // Both partners of a call share the call object and all members of a meeting share the meeting,
+    // so their packets land on the same worker. Unknown senders are dropped by selectUdpReceivers anyway.
+    std::size_t Server::mediaAffinityKey(const std::array<unsigned char, 32>& senderNicknameHash) const {
+        UserPtr sender = m_userRepository.findUserByBinaryHash(senderNicknameHash);
+        if (!sender) {
+            return 0;
+        }
+        if (auto meeting = sender->getMeeting()) {
+            return reinterpret_cast<std::uintptr_t>(meeting.get());
+        }
+        if (auto call = sender->getCall()) {
+            return reinterpret_cast<std::uintptr_t>(call.get());
+        }
+        return reinterpret_cast<std::uintptr_t>(sender.get());
+    }
+
+    // Used per reassembled packet and, in cut-through mode, once per packet with only chunk 0
+    // in data, so everything here must be decidable from the frame meta at the start of the payload.
+    network::ForwardTargets Server::selectUdpReceivers(const unsigned char* data, std::size_t size, uint32_t rawType,
+        const asio::ip::udp::endpoint& endpointFrom, const std::array<unsigned char, 32>& senderNicknameHash) {
+        network::ForwardTargets targets;
+        auto& receivers = targets.endpoints;
+
         PacketType type = static_cast<PacketType>(rawType);
         if (type != PacketType::VOICE && type != PacketType::SCREEN && type != PacketType::CAMERA)
-            return;
+            return targets;
 
-        std::string senderHashHex = utilities::crypto::binaryToHex(senderNicknameHash.data(), senderNicknameHash.size());
-        UserPtr sender = m_userRepository.findUserByNickname(senderHashHex);
+        UserPtr sender = m_userRepository.findUserByBinaryHash(senderNicknameHash);
         if (!sender) {
-            LOG_DEBUG("[UDP] Media from unknown sender hash {}:{}", senderHashHex.substr(0, 10), endpointFrom.address().to_string());
-            return;
+            LOG_DEBUG("[UDP] Media from unknown sender hash {}:{}",
+                utilities::crypto::binaryToHex(senderNicknameHash.data(), senderNicknameHash.size()).substr(0, 10),
+                endpointFrom.address().to_string());
+            return targets;
         }
 
-        m_userRepository.updateUserUdpEndpoint(senderHashHex, endpointFrom);
+        sender->updateEndpointIfChanged(endpointFrom);
         const auto now = std::chrono::steady_clock::now();
 
         if (sender->isInCall()) {
             UserPtr partner = sender->getCallPartner();
-            if (!partner || !m_userRepository.containsUser(partner->getNicknameHash())) {
-                return;
+            if (!partner || !m_userRepository.findUserByBinaryHash(partner->getNicknameHashBinary())) {
+                return targets;
+            }
+            // A partner that did not negotiate wire format v2 cannot parse its frames. Senders are only
+            // told to use v2 when both sides did, so this only drops frames sent before that.
+            if (size > 0 && data[0] == kMeetingFrameVersion2 && partner->getMediaSessionId() == 0) {
+                return targets;
             }
             // In 1:1 calls we avoid receiver-side layer filtering to prevent startup blackouts.
             // Sender-side ABR (MEDIA_ADAPT_COMMAND) remains enabled and is sufficient for call stability.
-            m_networkController.sendUdp(data, size, rawType, partner->getEndpoint());
-            return;
+            receivers.push_back(partner->getEndpoint());
+            return targets;
         }
 
         if (!sender->isInMeeting()) {
-            return;
+            return targets;
         }
 
         auto meeting = sender->getMeeting();
         if (!meeting) {
-            return;
+            return targets;
         }
 
-        const std::string senderHash = sender->getNicknameHash();
-        const auto mediaMeta = parseMediaFrameMeta(data, size);
-        for (const auto& participant : meeting->getParticipants()) {
-            if (!participant.user) {
+        const auto snapshot = meeting->getForwardingSnapshot();
+        const auto senderSlot = snapshot->findSlot(sender.get());
+        const auto mediaMeta = parseMediaFrameMeta(data, static_cast<int>(size));
+        const bool compactFrame = mediaMeta && mediaMeta->version == kMeetingFrameVersion2;
+        if (compactFrame && mediaMeta->senderSessionId != sender->getMediaSessionId()) {
+            // Receivers attribute v2 frames by this id, so it has to be the sender's own.
+            return targets;
+        }
+        const bool layered = type == PacketType::CAMERA && mediaMeta && mediaMeta->mediaKind == 2;
+        const bool keyframe = type != PacketType::VOICE && mediaMeta && mediaMeta->keyframe;
+
+        // Voice only goes out from the loudest speakers; the rest of the meeting's voice is dropped here.
+        std::optional<SpeakerSelector::Decision> speakerDecision;
+        if (type == PacketType::VOICE && mediaMeta && mediaMeta->mediaKind == 0) {
+            speakerDecision = meeting->getSpeakerSelector().onVoiceFrame(
+                sender->getNicknameHash(), mediaMeta->audioLevel, mediaMeta->voiceActivity, now);
+            if (speakerDecision->dominantSpeaker) {
+                meeting->promoteVideoSpeaker(*speakerDecision->dominantSpeaker);
+                broadcastToMeeting(meeting, std::string(), static_cast<uint32_t>(PacketType::MEETING_DOMINANT_SPEAKER),
+                    PacketFactory::getDominantSpeakerPacket(*speakerDecision->dominantSpeaker));
+            }
+            if (speakerDecision->route == SpeakerSelector::Route::None) {
+                return targets;
+            }
+        }
+
+        bool keyframeNeeded = false;
+        Meeting::ForwardingSnapshot::SlotList keyframeReceivers;
+        receivers.reserve(snapshot->receivers.size());
+        for (std::size_t slot = 0; slot < snapshot->receivers.size(); ++slot) {
+            if (senderSlot == slot) {
+                continue;
+            }
+            const auto& receiver = snapshot->receivers[slot];
+            // A v1 receiver cannot parse v2 frames; only ones sent before the sender learned that it
+            // joined (updateMeetingFrameFormat) get here.
+            if (compactFrame && receiver.user->getMediaSessionId() == 0) {
+                continue;
+            }
+            if (speakerDecision && speakerDecision->route == SpeakerSelector::Route::ActiveReceiversOnly
+                && std::find(speakerDecision->activeSpeakers->begin(), speakerDecision->activeSpeakers->end(), receiver.nicknameHash)
+                    == speakerDecision->activeSpeakers->end()) {
                 continue;
             }
-            if (participant.user->getNicknameHash() == senderHash) {
+            if (type == PacketType::CAMERA && !snapshot->isCameraForwarded(senderSlot, slot)) {
+                // Outside this receiver's Last-N: once the sender is back in, forwarding has to
+                // restart on a keyframe, which selectCameraLayer requests.
+                auto* forwardState = snapshot->getCameraForwardState(senderSlot, slot);
+                if (forwardState && forwardState->forwardedLayer.load(std::memory_order_relaxed) != Meeting::CameraForwardState::kNoLayer) {
+                    forwardState->forwardedLayer.store(Meeting::CameraForwardState::kNoLayer, std::memory_order_relaxed);
+                }
                 continue;
             }
-            if (type == PacketType::CAMERA && mediaMeta && mediaMeta->version == 1 && mediaMeta->mediaKind == 2) {
-                uint8_t maxLayer = meeting->getCameraSubscriptionLayer(participant.user->getNicknameHash(), senderHash);
-                auto it = m_receiverAbrStates.find(participant.user->getNicknameHash());
-                if (it != m_receiverAbrStates.end()
-                    && it->second.lastStatsAt.time_since_epoch().count() != 0
-                    && std::chrono::duration_cast<std::chrono::milliseconds>(now - it->second.lastStatsAt).count() > constant::kStatsTimeoutMs) {
+            if (type == PacketType::SCREEN && mediaMeta && mediaMeta->mediaKind == 1) {
+                auto* screenState = snapshot->getScreenForwardState(senderSlot, slot);
+                if (screenState && !selectScreenFrame(*screenState, *mediaMeta)) {
+                    if (claimKeyframeRequest(*screenState, now)) {
+                        keyframeNeeded = true;
+                    }
+                    continue;
+                }
+            }
+            if (layered) {
+                uint8_t maxLayer = snapshot->getCameraLayer(senderSlot, slot);
+                std::chrono::steady_clock::time_point lastStatsAt{};
+                {
+                    std::shared_lock<std::shared_mutex> abrLock(m_abrMutex);
+                    auto it = m_receiverAbrStates.find(receiver.nicknameHash);
+                    if (it != m_receiverAbrStates.end()) {
+                        lastStatsAt = it->second.lastStatsAt;
+                    }
+                }
+                if (lastStatsAt.time_since_epoch().count() != 0
+                    && std::chrono::duration_cast<std::chrono::milliseconds>(now - lastStatsAt).count() > constant::kStatsTimeoutMs) {
                     maxLayer = 0;
                 }
                 // Forward exactly one selected simulcast layer per receiver/sender pair.
                 // Sending multiple layers to a receiver that decodes into a single stream key
                 // causes frequent resolution switches and visible artifacts.
-                if (mediaMeta->layerId != maxLayer) {
-                    continue;
+                auto* forwardState = snapshot->getCameraForwardState(senderSlot, slot);
+                if (!forwardState) {
+                    if (mediaMeta->layerId != maxLayer) {
+                        continue;
+                    }
+                }
+                else {
+                    bool switchPending = false;
+                    const bool forward = selectCameraLayer(*forwardState, *mediaMeta, maxLayer, switchPending);
+                    if (switchPending && claimKeyframeRequest(*forwardState, now)) {
+                        keyframeNeeded = true;
+                    }
+                    if (!forward) {
+                        continue;
+                    }
                 }
             }
-            m_networkController.sendUdp(data, size, rawType, participant.user->getEndpoint());
+            receivers.push_back(receiver.endpoint);
+            if (keyframe) {
+                keyframeReceivers.push_back(slot);
+            }
+        }
+
+        meetingFanOutHistogram(type).record(receivers.size());
+
+        if (keyframe) {
+            targets.keyframeKey = keyframeCacheKey(senderNicknameHash, mediaMeta->mediaKind, mediaMeta->layerId);
+            recordKeyframesQueued(*snapshot, keyframeReceivers, now);
+        }
+
+        if (keyframeNeeded) {
+            // Ask over UDP straight from the media path: the sender's endpoint is the one this frame
+            // came from, and a lost request is simply repeated on a later frame of the same layer.
+            nlohmann::json request{
+                { RESULT, true },
+                { MEDIA_KIND, mediaMeta->mediaKind },
+                { LAYER_ID, mediaMeta->layerId }
+            };
+            m_networkController.sendUdp(toBytes(request.dump()), static_cast<uint32_t>(PacketType::MEDIA_KEYFRAME_REQUEST), endpointFrom);
         }
+        return targets;
     }
 
     void Server::handleReceiveTcp(network::tcp::OwnedPacket&& owned) {
@@ -233,19 +504,42 @@ namespace server
     }
 
     void Server::handleConnectionWithUserDown(network::tcp::ConnectionPtr conn) {
-        std::lock_guard<std::mutex> lock(m_mutex);
-        auto it = m_connToUser.find(conn);
-        if (it == m_connToUser.end()) {
-            LOG_DEBUG("[TCP] Disconnect: no user associated with connection (e.g. pre-auth or already reconnected)");
-            return;
+        UserPtr user;
+        {
+            std::lock_guard<std::mutex> connLock(m_connToUserMutex);
+            auto it = m_connToUser.find(conn);
+            if (it == m_connToUser.end()) {
+                LOG_DEBUG("[TCP] Disconnect: no user associated with connection (e.g. pre-auth or already reconnected)");
+                return;
+            }
+            user = it->second;
+        }
+
+        const std::string nicknameHash = user->getNicknameHash();
+        auto [_, connectionDownPacket] = PacketFactory::getConnectionDownWithUserPacket(nicknameHash);
+        nlohmann::json cancelJson;
+        cancelJson[UID] = crypto::generateUID();
+        cancelJson[SENDER_NICKNAME_HASH] = nicknameHash;
+        const std::vector<unsigned char> joinCancelBody = toBytes(cancelJson.dump());
+        const DeparturePackets departure = makeDeparturePackets(nicknameHash);
+        const auto joinRejectedPacket = PacketFactory::getMeetingJoinRejectedPacket("owner_unavailable");
+
+        // Touches the user's call, pending calls and meeting at once.
+        auto stateLock = m_stateLocks.lockAll();
+        {
+            std::lock_guard<std::mutex> connLock(m_connToUserMutex);
+            auto it = m_connToUser.find(conn);
+            // A reconnect may have moved the user to another connection since the lookup above.
+            if (it == m_connToUser.end() || it->second != user) {
+                return;
+            }
+            m_connToUser.erase(it);
         }
-        UserPtr user = std::move(it->second);
-        m_connToUser.erase(it);
-        std::string prefix = user->getNicknameHash().length() >= 5 ? user->getNicknameHash().substr(0, 5) : user->getNicknameHash();
+        std::string prefix = nicknameHash.length() >= 5 ? nicknameHash.substr(0, 5) : nicknameHash;
         LOG_INFO("[TCP] Connection down with user {}", prefix);
         user->setConnectionDown(true);
         user->clearTcpConnection();
-        processConnectionDown(user);
+        processConnectionDownLocked(user, connectionDownPacket, joinCancelBody, departure, joinRejectedPacket);
     }
 
     void Server::sendTcp(network::tcp::ConnectionPtr conn, uint32_t type, const std::vector<unsigned char>& body) {
@@ -275,6 +569,7 @@ namespace server
 
     void Server::resetAbrStateForUser(const std::string& receiverHash, bool inMeeting, bool inCall)
     {
+        std::lock_guard<std::shared_mutex> abrLock(m_abrMutex);
         auto& state = m_receiverAbrStates[receiverHash];
         state = ReceiverAbrState{};
         if (!inMeeting && !inCall) {
@@ -291,8 +586,26 @@ namespace server
         state.fastProbeUntil = now + std::chrono::milliseconds(constant::kFastProbeHoldMs);
     }
 
+    void Server::dropMediaStateForUser(const std::string& nicknameHash)
+    {
+        {
+            std::lock_guard<std::shared_mutex> abrLock(m_abrMutex);
+            m_receiverAbrStates.erase(nicknameHash);
+        }
+        {
+            std::lock_guard<std::mutex> keyframeLock(m_keyframeRequestMutex);
+            m_keyframeRequestTimes.erase(nicknameHash);
+        }
+        if (auto owner = utilities::crypto::hashToBinary(nicknameHash)) {
+            m_networkController.dropUdpKeyframes(*owner);
+        }
+        std::lock_guard<std::mutex> keyframeWaitLock(m_keyframeWaitMutex);
+        m_keyframeWaits.erase(nicknameHash);
+    }
+
+    // Takes no state lock: a new user is in no call or meeting yet, and the repository claims the
+    // nickname atomically, so concurrent logins only meet on the repository's own lock.
     void Server::handleAuthorization(const nlohmann::json& json, network::tcp::ConnectionPtr conn) {
-        std::lock_guard<std::mutex> lock(m_mutex);
         try {
             std::string uid = json[UID].get<std::string>();
             std::string nicknameHash = json[SENDER_NICKNAME_HASH].get<std::string>();
@@ -311,26 +624,38 @@ namespace server
 
             bool authorized = false;
             std::string token;
+            uint32_t mediaSessionId = 0;
 
+            std::string prefix = nicknameHash.length() >= 5 ? nicknameHash.substr(0, 5) : nicknameHash;
             if (m_userRepository.containsUser(nicknameHash)) {
-                std::string prefix = nicknameHash.length() >= 5 ? nicknameHash.substr(0, 5) : nicknameHash;
                 LOG_WARN("Authorization failed - nickname already taken: {}", prefix);
             }
             else {
                 token = crypto::generateUID();
                 UserPtr user = std::make_shared<User>(nicknameHash, token, publicKey, udpEndpoint,
                     [this, nicknameHash]() {
-                        std::lock_guard<std::mutex> lock(m_mutex);
                         auto u = m_userRepository.findUserByNickname(nicknameHash);
                         if (u) processUserLogout(u);
                     });
                 user->setTcpConnection(conn);
-                m_userRepository.addUser(user);
-                m_connToUser[conn] = user;
-                resetAbrStateForUser(nicknameHash, false, false);
-                authorized = true;
-                std::string prefix = nicknameHash.length() >= 5 ? nicknameHash.substr(0, 5) : nicknameHash;
-                LOG_INFO("User authorized: {}", prefix);
+                if (json.contains(WIRE_VERSION) && json[WIRE_VERSION].is_number_unsigned()
+                    && json[WIRE_VERSION].get<uint32_t>() >= kWireVersion2) {
+                    user->setMediaSessionId(m_userRepository.allocateMediaSessionId());
+                }
+                if (!m_userRepository.tryAddUser(user)) {
+                    // Lost a race with another login for the same nickname.
+                    LOG_WARN("Authorization failed - nickname already taken: {}", prefix);
+                }
+                else {
+                    mediaSessionId = user->getMediaSessionId();
+                    {
+                        std::lock_guard<std::mutex> connLock(m_connToUserMutex);
+                        m_connToUser[conn] = user;
+                    }
+                    resetAbrStateForUser(nicknameHash, false, false);
+                    authorized = true;
+                    LOG_INFO("User authorized: {}", prefix);
+                }
             }
 
             std::optional<std::string> encryptedNickname;
@@ -342,7 +667,8 @@ namespace server
 
             std::vector<unsigned char> packet;
             if (authorized)
-                packet = PacketFactory::getAuthorizationResultPacket(true, uid, nicknameHash, token, encryptedNickname, packetKey);
+                packet = PacketFactory::getAuthorizationResultPacket(true, uid, nicknameHash, token, encryptedNickname, packetKey,
+                    mediaSessionId != 0 ? std::optional<uint32_t>(mediaSessionId) : std::nullopt);
             else
                 packet = PacketFactory::getAuthorizationResultPacket(false, uid, nicknameHash);
             sendTcp(conn, static_cast<uint32_t>(PacketType::AUTHORIZATION_RESULT), packet);
@@ -372,9 +698,13 @@ namespace server
             std::optional<bool> isInMeetingOpt;
             std::optional<std::string> meetingRosterJson;
             MeetingPtr meeting;
+            user = m_userRepository.findUserByNickname(senderNicknameHash);
             {
-                std::lock_guard<std::mutex> lock(m_mutex);
-                user = m_userRepository.findUserByNickname(senderNicknameHash);
+                auto stateLock = m_stateLocks.lock(nullptr, { user.get() });
+                // A logout may have removed the user since the lookup above.
+                if (user && m_userRepository.findUserByNickname(senderNicknameHash) != user) {
+                    user.reset();
+                }
                 if (!user) {
                     LOG_INFO("[TCP] Reconnect: user {} not found (logged out or never authorized)", prefix);
                 }
@@ -385,11 +715,14 @@ namespace server
                     }
                     else {
                         oldConn = user->getTcpConnection();
-                        if (oldConn)
-                            m_connToUser.erase(oldConn);
                         user->setConnectionDown(false);
                         user->setTcpConnection(conn);
-                        m_connToUser[conn] = user;
+                        {
+                            std::lock_guard<std::mutex> connLock(m_connToUserMutex);
+                            if (oldConn)
+                                m_connToUser.erase(oldConn);
+                            m_connToUser[conn] = user;
+                        }
                         if (udpPort != 0) {
                             auto tcpEp = conn->remoteEndpoint();
                             if (!tcpEp.address().is_unspecified()) {
@@ -407,28 +740,31 @@ namespace server
                         isInMeetingOpt = userInMeeting;
                         if (userInMeeting) {
                             meeting = user->getMeeting();
-                            if (meeting) {
-                                nlohmann::json roster = nlohmann::json::array();
-                                const auto owner = meeting->getOwner();
-                                const std::string ownerHash = owner ? owner->getNicknameHash() : "";
-
-                                for (const auto& participant : meeting->getParticipants()) {
-                                    if (!participant.user) {
-                                        continue;
-                                    }
-                                    nlohmann::json item;
-                                    item[ENCRYPTED_NICKNAME] = participant.encryptedNickname;
-                                    item[PUBLIC_KEY] = crypto::serializePublicKey(participant.user->getPublicKey());
-                                    item[IS_OWNER] = (!ownerHash.empty() && participant.user->getNicknameHash() == ownerHash);
-                                    roster.push_back(std::move(item));
-                                }
-                                meetingRosterJson = roster.dump();
-                            }
                         }
                     }
                 }
             }
 
+            // Serializing every participant's public key is the expensive part, so it runs unlocked
+            // on the meeting's own participant snapshot.
+            if (meeting) {
+                nlohmann::json roster = nlohmann::json::array();
+                const auto owner = meeting->getOwner();
+                const std::string ownerHash = owner ? owner->getNicknameHash() : "";
+
+                for (const auto& participant : meeting->getParticipants()) {
+                    if (!participant.user) {
+                        continue;
+                    }
+                    nlohmann::json item;
+                    item[ENCRYPTED_NICKNAME] = participant.encryptedNickname;
+                    item[PUBLIC_KEY] = crypto::serializePublicKey(participant.user->getPublicKey());
+                    item[IS_OWNER] = (!ownerHash.empty() && participant.user->getNicknameHash() == ownerHash);
+                    roster.push_back(std::move(item));
+                }
+                meetingRosterJson = roster.dump();
+            }
+
             if (!user) {
                 auto packet = PacketFactory::getReconnectionResultPacket(false, uid, senderNicknameHash, token);
                 sendTcp(conn, static_cast<uint32_t>(PacketType::RECONNECT_RESULT), packet);
@@ -439,7 +775,8 @@ namespace server
                 allowed, uid, senderNicknameHash, token,
                 allowed && userInCall, callPartnerHash,
                 isInMeetingOpt,
-                meetingRosterJson);
+                meetingRosterJson,
+                user->getMediaSessionId() != 0 ? std::optional<uint32_t>(user->getMediaSessionId()) : std::nullopt);
             sendTcp(conn, static_cast<uint32_t>(PacketType::RECONNECT_RESULT), packet);
             if (allowed && oldConn && oldConn != conn) {
                 oldConn->close();
@@ -453,6 +790,9 @@ namespace server
 
             if (allowed && userInCall) {
                 auto partner = user->getCallPartner();
+                if (partner) {
+                    sendMediaFrameFormatToUser(user, user->getMediaSessionId() != 0 && partner->getMediaSessionId() != 0);
+                }
                 if (partner && m_userRepository.containsUser(partner->getNicknameHash())) {
                     auto partnerInRepo = m_userRepository.findUserByNickname(partner->getNicknameHash());
                     if (!partnerInRepo->isConnectionDown()) {
@@ -488,6 +828,9 @@ namespace server
                     sendTcp(conn, static_cast<uint32_t>(PacketType::MUTE_BEGIN), beginPacket);
                 }
                 sendMeetingConnectionDownStateToUser(meeting, userHash);
+                sendMeetingSessionMapToUser(meeting, user);
+                sendMediaFrameFormatToUser(user, meeting->usesCompactMediaFrames());
+                requestKeyframesForSubscriber(meeting, userHash);
 
                 auto [_, restoredPacket] = PacketFactory::getConnectionRestoredWithUserPacket(user->getNicknameHash());
                 broadcastToMeeting(meeting, user->getNicknameHash(), static_cast<uint32_t>(PacketType::CONNECTION_RESTORED_WITH_USER), restoredPacket);
@@ -499,7 +842,6 @@ namespace server
     }
 
     void Server::handleLogout(const nlohmann::json& json, network::tcp::ConnectionPtr conn) {
-        std::lock_guard<std::mutex> lock(m_mutex);
         try {
             std::string senderNicknameHash = json[SENDER_NICKNAME_HASH].get<std::string>();
             auto user = m_userRepository.findUserByNickname(senderNicknameHash);
@@ -512,7 +854,6 @@ namespace server
     }
 
     void Server::handleGetFriendInfo(const nlohmann::json& json, network::tcp::ConnectionPtr conn) {
-        std::lock_guard<std::mutex> lock(m_mutex);
         try {
             std::string uid = json[UID].get<std::string>();
             std::string nicknameHash = json[NICKNAME_HASH].get<std::string>();
@@ -540,12 +881,27 @@ namespace server
 
     void Server::handleGetMetrics(const nlohmann::json&, network::tcp::ConnectionPtr conn) {
         try {
-            double cpuUsage = getCpuUsagePercent();
-            auto [memoryUsed, memoryAvailable] = getMemoryUsedAndAvailable();
             size_t activeUsers = m_userRepository.getActiveUsersCount();
 
+            uint64_t joinKeyframeQueuedSamples = 0;
+            uint64_t joinKeyframeQueuedAvgMs = 0;
+            uint64_t joinKeyframeQueuedMaxMs = 0;
+            {
+                std::lock_guard<std::mutex> lock(m_keyframeWaitMutex);
+                joinKeyframeQueuedSamples = m_joinKeyframeQueuedCount;
+                joinKeyframeQueuedAvgMs = m_joinKeyframeQueuedCount != 0 ? m_joinKeyframeQueuedTotalMs / m_joinKeyframeQueuedCount : 0;
+                joinKeyframeQueuedMaxMs = m_joinKeyframeQueuedMaxMs;
+            }
+
+            // Heap allocations that keep pace with acquisitions mean a media path bypasses the pool.
+            const auto& bufferPool = utilities::BufferPool::shared();
+
             auto packet = PacketFactory::getMetricsResultPacket(
-                cpuUsage, static_cast<uint64_t>(memoryUsed), static_cast<uint64_t>(memoryAvailable), activeUsers);
+                m_metricsSampler.getLatest(), m_metricsSampler.getHistory(), activeUsers,
+                m_networkController.getUdpPacingQueueDepth(), m_networkController.getUdpDroppedVideoEntries(),
+                joinKeyframeQueuedAvgMs, joinKeyframeQueuedMaxMs, joinKeyframeQueuedSamples,
+                bufferPool.getAcquisitions(), bufferPool.getHeapAllocations(),
+                m_mediaWorkers.sampleStats());
             
             sendTcp(conn, static_cast<uint32_t>(PacketType::GET_METRICS_RESULT), packet);
         }
@@ -554,20 +910,50 @@ namespace server
         }  
     }
 
+    // Registry counters plus point-in-time gauges; runs on the metrics endpoint thread.
+    std::string Server::renderMetrics() {
+        std::string text;
+        MetricsRegistry::shared().renderText(text);
+
+        const auto system = m_metricsSampler.getLatest();
+        MetricsRegistry::appendGauge(text, "callifornia_udp_socket_drops",
+            "Datagrams the kernel dropped on the media sockets since they were opened, as of the last sample.",
+            static_cast<double>(system.udpSockets.drops));
+        MetricsRegistry::appendGauge(text, "callifornia_udp_socket_receive_queue_bytes",
+            "Bytes waiting in the kernel receive queues of the media sockets, as of the last sample.",
+            static_cast<double>(system.udpSockets.receiveQueueBytes));
+        MetricsRegistry::appendGauge(text, "callifornia_active_users", "Users currently logged in.",
+            static_cast<double>(m_userRepository.getActiveUsersCount()));
+        MetricsRegistry::appendGauge(text, "callifornia_tcp_control_queue_packets",
+            "Control packets waiting for a handler thread.", static_cast<double>(m_networkController.getTcpQueuedPackets()));
+        MetricsRegistry::appendGauge(text, "callifornia_udp_pacing_queue_datagrams",
+            "Video datagrams held back by the per-receiver pacers.", static_cast<double>(m_networkController.getUdpPacingQueueDepth()));
+
+        std::vector<std::pair<std::string, double>> workerDepths;
+        const auto depths = m_mediaWorkers.getQueueDepths();
+        for (std::size_t i = 0; i < depths.size(); ++i) {
+            workerDepths.emplace_back("worker=\"" + std::to_string(i) + "\"", static_cast<double>(depths[i]));
+        }
+        MetricsRegistry::appendGauge(text, "callifornia_media_worker_queue_jobs", "Media jobs waiting per routing worker.", workerDepths);
+        return text;
+    }
+
     void Server::handleStartOutgoingCall(const nlohmann::json& json, network::tcp::ConnectionPtr conn) {
-        std::lock_guard<std::mutex> lock(m_mutex);
         try {
             std::string uid = json[UID].get<std::string>();
             std::string receiverNicknameHash = json[RECEIVER_NICKNAME_HASH].get<std::string>();
             std::string senderNicknameHash = json[SENDER_NICKNAME_HASH].get<std::string>();
+            std::string sp = senderNicknameHash.length() >= 5 ? senderNicknameHash.substr(0, 5) : senderNicknameHash;
+            std::string rp = receiverNicknameHash.length() >= 5 ? receiverNicknameHash.substr(0, 5) : receiverNicknameHash;
 
             auto receiver = m_userRepository.findUserByNickname(receiverNicknameHash);
             auto sender = m_userRepository.findUserByNickname(senderNicknameHash);
             if (!receiver || !sender) return;
             if (sender->getTcpConnection() != conn) return;
+            const std::vector<unsigned char> body = toBytes(json.dump());
+
+            auto stateLock = m_stateLocks.lock(nullptr, { sender.get(), receiver.get() });
             if (!canStartCallLocked(sender, receiver)) {
-                std::string sp = senderNicknameHash.length() >= 5 ? senderNicknameHash.substr(0, 5) : senderNicknameHash;
-                std::string rp = receiverNicknameHash.length() >= 5 ? receiverNicknameHash.substr(0, 5) : receiverNicknameHash;
                 LOG_INFO(
                     "Call start rejected: {} -> {} (senderInCall={}, senderInMeeting={}, senderPendingCall={}, senderPendingJoin={}, receiverInCall={}, receiverPendingCall={}, receiverPendingJoin={})",
                     sp,
@@ -583,8 +969,6 @@ namespace server
             }
 
             if (receiver->isInMeeting()) {
-                std::string sp = senderNicknameHash.length() >= 5 ? senderNicknameHash.substr(0, 5) : senderNicknameHash;
-                std::string rp = receiverNicknameHash.length() >= 5 ? receiverNicknameHash.substr(0, 5) : receiverNicknameHash;
                 LOG_INFO("Call allowed to meeting participant: {} -> {}", sp, rp);
             }
 
@@ -598,10 +982,7 @@ namespace server
             m_callManager.addPendingCall(pending);
             sender->setOutgoingPendingCall(pending);
             receiver->addIncomingPendingCall(pending);
-            std::vector<unsigned char> body = toBytes(json.dump());
             if (sendTcpToUserIfConnected(receiverNicknameHash, static_cast<uint32_t>(PacketType::CALLING_BEGIN), body)) {
-                std::string sp = senderNicknameHash.length() >= 5 ? senderNicknameHash.substr(0, 5) : senderNicknameHash;
-                std::string rp = receiverNicknameHash.length() >= 5 ? receiverNicknameHash.substr(0, 5) : receiverNicknameHash;
                 LOG_INFO("Call initiated from {} to {}", sp, rp);
             }
         }
@@ -611,18 +992,20 @@ namespace server
     }
 
     void Server::handleStopOutgoingCall(const nlohmann::json& json, network::tcp::ConnectionPtr conn) {
-        std::lock_guard<std::mutex> lock(m_mutex);
         try {
             std::string senderNicknameHash = json[SENDER_NICKNAME_HASH].get<std::string>();
 
             auto sender = m_userRepository.findUserByNickname(senderNicknameHash);
             if (!sender || sender->getTcpConnection() != conn) return;
-            if (!sender->hasOutgoingPendingCall()) return;
-
             auto out = sender->getOutgoingPendingCall();
+            if (!out) return;
             auto receiver = out->getReceiver();
+            const std::vector<unsigned char> body = toBytes(json.dump());
+
+            auto stateLock = m_stateLocks.lock(nullptr, { sender.get(), receiver.get() });
+            // Answered, declined or timed out since the lookup above.
+            if (sender->getOutgoingPendingCall() != out) return;
 
-            std::vector<unsigned char> body = toBytes(json.dump());
             if (receiver && !receiver->isConnectionDown())
                 sendTcpToUserIfConnected(receiver->getNicknameHash(), static_cast<uint32_t>(PacketType::CALLING_END), body);
 
@@ -639,51 +1022,58 @@ namespace server
     }
 
     void Server::handleAcceptCall(const nlohmann::json& json, network::tcp::ConnectionPtr conn) {
-        std::lock_guard<std::mutex> lock(m_mutex);
         try {
             std::string senderNicknameHash = json[SENDER_NICKNAME_HASH].get<std::string>();
             std::string receiverNicknameHash = json[RECEIVER_NICKNAME_HASH].get<std::string>();
+            std::string sp = senderNicknameHash.length() >= 5 ? senderNicknameHash.substr(0, 5) : senderNicknameHash;
+            std::string rp = receiverNicknameHash.length() >= 5 ? receiverNicknameHash.substr(0, 5) : receiverNicknameHash;
 
             auto sender = m_userRepository.findUserByNickname(senderNicknameHash);
             auto receiver = m_userRepository.findUserByNickname(receiverNicknameHash);
             if (!sender || !receiver || sender->getTcpConnection() != conn) return;
-            if (!canAcceptCallLocked(sender, receiver)) return;
+            const std::vector<unsigned char> body = toBytes(json.dump());
+            const std::vector<unsigned char> callEndBody = PacketFactory::getCallEndPacket(receiverNicknameHash);
 
-            auto incoming = sender->getIncomingPendingCalls();
-            PendingCallPtr found;
-            for (auto& pc : incoming) {
-                auto initiator = pc->getInitiator();
-                if (initiator && initiator->getNicknameHash() == receiverNicknameHash) {
-                    found = pc;
-                    break;
+            {
+                auto stateLock = m_stateLocks.lock(nullptr, { sender.get(), receiver.get() });
+                if (!canAcceptCallLocked(sender, receiver)) return;
+
+                auto incoming = sender->getIncomingPendingCalls();
+                PendingCallPtr found;
+                for (auto& pc : incoming) {
+                    auto initiator = pc->getInitiator();
+                    if (initiator && initiator->getNicknameHash() == receiverNicknameHash) {
+                        found = pc;
+                        break;
+                    }
                 }
-            }
-            if (!found) return;
+                if (!found) return;
+
+                bool delivered = sendTcpToUserIfConnected(receiverNicknameHash, static_cast<uint32_t>(PacketType::CALL_ACCEPT), body);
 
-            std::vector<unsigned char> body = toBytes(json.dump());
-            bool delivered = sendTcpToUserIfConnected(receiverNicknameHash, static_cast<uint32_t>(PacketType::CALL_ACCEPT), body);
+                if (!delivered) {
+                    resetOutgoingPendingCall(receiver);
+                    removeIncomingPendingCall(sender, found);
+                    sendTcpToUserIfConnected(senderNicknameHash, static_cast<uint32_t>(PacketType::CALL_END), callEndBody);
+                    LOG_INFO("Call accept not delivered (caller {} unreachable), callee {} notified", rp, sp);
+                    return;
+                }
 
-            if (!delivered) {
                 resetOutgoingPendingCall(receiver);
                 removeIncomingPendingCall(sender, found);
-                std::vector<unsigned char> callEndBody = PacketFactory::getCallEndPacket(receiverNicknameHash);
-                sendTcpToUserIfConnected(senderNicknameHash, static_cast<uint32_t>(PacketType::CALL_END), callEndBody);
-                std::string rp = receiverNicknameHash.length() >= 5 ? receiverNicknameHash.substr(0, 5) : receiverNicknameHash;
-                std::string sp = senderNicknameHash.length() >= 5 ? senderNicknameHash.substr(0, 5) : senderNicknameHash;
-                LOG_INFO("Call accept not delivered (caller {} unreachable), callee {} notified", rp, sp);
-                return;
+                auto call = m_callManager.createCall(receiver, sender);
+                receiver->setCall(call);
+                sender->setCall(call);
+                resetAbrStateForUser(receiverNicknameHash, false, true);
+                resetAbrStateForUser(senderNicknameHash, false, true);
             }
 
-            resetOutgoingPendingCall(receiver);
-            removeIncomingPendingCall(sender, found);
-            auto call = m_callManager.createCall(receiver, sender);
-            receiver->setCall(call);
-            sender->setCall(call);
-            resetAbrStateForUser(receiverNicknameHash, false, true);
-            resetAbrStateForUser(senderNicknameHash, false, true);
+            // Clients start every call on v1 meeting frames; v2 only when both sides can parse it.
+            if (sender->getMediaSessionId() != 0 && receiver->getMediaSessionId() != 0) {
+                sendMediaFrameFormatToUser(receiver, true);
+                sendMediaFrameFormatToUser(sender, true);
+            }
 
-            std::string sp = senderNicknameHash.length() >= 5 ? senderNicknameHash.substr(0, 5) : senderNicknameHash;
-            std::string rp = receiverNicknameHash.length() >= 5 ? receiverNicknameHash.substr(0, 5) : receiverNicknameHash;
             LOG_INFO("Call accepted: {} -> {}", rp, sp);
         }
         catch (const std::exception& e) {
@@ -692,7 +1082,6 @@ namespace server
     }
 
     void Server::handleDeclineCall(const nlohmann::json& json, network::tcp::ConnectionPtr conn) {
-        std::lock_guard<std::mutex> lock(m_mutex);
         try {
             std::string receiverNicknameHash = json[RECEIVER_NICKNAME_HASH].get<std::string>();
             std::string senderNicknameHash = json[SENDER_NICKNAME_HASH].get<std::string>();
@@ -700,8 +1089,9 @@ namespace server
             auto sender = m_userRepository.findUserByNickname(senderNicknameHash);
             auto receiver = m_userRepository.findUserByNickname(receiverNicknameHash);
             if (!sender || sender->getTcpConnection() != conn) return;
+            const std::vector<unsigned char> body = toBytes(json.dump());
 
-            std::vector<unsigned char> body = toBytes(json.dump());
+            auto stateLock = m_stateLocks.lock(nullptr, { sender.get(), receiver.get() });
             if (receiver && !receiver->isConnectionDown())
                 sendTcpToUserIfConnected(receiverNicknameHash, static_cast<uint32_t>(PacketType::CALL_DECLINE), body);
 
@@ -723,7 +1113,6 @@ namespace server
     }
 
     void Server::handleEndCall(const nlohmann::json& json, network::tcp::ConnectionPtr conn) {
-        std::lock_guard<std::mutex> lock(m_mutex);
         try {
             std::string senderNicknameHash = json[SENDER_NICKNAME_HASH].get<std::string>();
 
@@ -732,8 +1121,12 @@ namespace server
             if (!sender->isInCall()) return;
 
             auto receiver = sender->getCallPartner();
+            const std::vector<unsigned char> body = toBytes(json.dump());
+
+            auto stateLock = m_stateLocks.lock(nullptr, { sender.get(), receiver.get() });
+            // Ended by the partner since the lookup above.
+            if (!sender->isInCall() || sender->getCallPartner() != receiver) return;
 
-            std::vector<unsigned char> body = toBytes(json.dump());
             if (receiver && !receiver->isConnectionDown())
                 sendTcpToUserIfConnected(receiver->getNicknameHash(), static_cast<uint32_t>(PacketType::CALL_END), body);
 
@@ -741,12 +1134,17 @@ namespace server
             if (receiver) {
                 std::string rp = receiver->getNicknameHash().length() >= 5 ? receiver->getNicknameHash().substr(0, 5) : receiver->getNicknameHash();
                 LOG_INFO("Call ended: {} ended call with {}", sp, rp);
-                m_receiverAbrStates.erase(receiver->getNicknameHash());
                 receiver->resetCall();
             }
             m_callManager.endCall(sender->getCall());
-            m_receiverAbrStates.erase(senderNicknameHash);
             sender->resetCall();
+            {
+                std::lock_guard<std::shared_mutex> abrLock(m_abrMutex);
+                if (receiver) {
+                    m_receiverAbrStates.erase(receiver->getNicknameHash());
+                }
+                m_receiverAbrStates.erase(senderNicknameHash);
+            }
         }
         catch (const std::exception& e) {
             LOG_ERROR("End call error: {}", e.what());
@@ -755,35 +1153,16 @@ namespace server
 
     void Server::handleMeetingCreate(const nlohmann::json& json, network::tcp::ConnectionPtr conn)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
         try {
             std::string senderNicknameHash = json[SENDER_NICKNAME_HASH].get<std::string>();
-            auto sender = m_userRepository.findUserByNickname(senderNicknameHash);
-            if (!sender || sender->getTcpConnection() != conn) {
-                return;
-            }
-            if (sender->isInCall() || sender->isInMeeting()) {
-                auto packet = PacketFactory::getMeetingCreateResultPacket(false);
-                sendTcp(conn, static_cast<uint32_t>(PacketType::MEETING_CREATE_RESULT), packet);
-                return;
-            }
-
-            const std::string meetingId = crypto::generateUID();
-            const std::string meetingIdHash = crypto::calculateHash(meetingId);
-            auto meeting = m_meetingManager.createMeeting(meetingId, meetingIdHash, sender);
-            if (!meeting) {
-                auto packet = PacketFactory::getMeetingCreateResultPacket(false);
-                sendTcp(conn, static_cast<uint32_t>(PacketType::MEETING_CREATE_RESULT), packet);
-                return;
-            }
-
-            sender->setMeeting(meeting);
             std::string encryptedNickname;
             if (json.contains(ENCRYPTED_NICKNAME) && json[ENCRYPTED_NICKNAME].is_string()) {
                 encryptedNickname = json[ENCRYPTED_NICKNAME].get<std::string>();
             }
-            meeting->addParticipant(sender, encryptedNickname);
-
+            std::optional<std::size_t> lastN;
+            if (json.contains(LAST_N) && json[LAST_N].is_number_unsigned()) {
+                lastN = json[LAST_N].get<std::size_t>();
+            }
             std::optional<std::string> encryptedMeetingKey;
             if (json.contains(ENCRYPTED_MEETING_KEY) && json[ENCRYPTED_MEETING_KEY].is_string()) {
                 encryptedMeetingKey = json[ENCRYPTED_MEETING_KEY].get<std::string>();
@@ -793,8 +1172,37 @@ namespace server
                 packetKey = json[PACKET_KEY].get<std::string>();
             }
 
+            auto sender = m_userRepository.findUserByNickname(senderNicknameHash);
+            if (!sender || sender->getTcpConnection() != conn) {
+                return;
+            }
+            const std::string meetingId = crypto::generateUID();
+            const std::string meetingIdHash = crypto::calculateHash(meetingId);
+
+            MeetingPtr meeting;
+            {
+                auto stateLock = m_stateLocks.lock(nullptr, { sender.get() });
+                if (!sender->isInCall() && !sender->isInMeeting()) {
+                    meeting = m_meetingManager.createMeeting(meetingId, meetingIdHash, sender);
+                }
+                if (meeting) {
+                    sender->setMeeting(meeting);
+                    meeting->addParticipant(sender, encryptedNickname);
+                    if (lastN) {
+                        meeting->setLastN(*lastN);
+                    }
+                }
+            }
+
+            if (!meeting) {
+                auto packet = PacketFactory::getMeetingCreateResultPacket(false);
+                sendTcp(conn, static_cast<uint32_t>(PacketType::MEETING_CREATE_RESULT), packet);
+                return;
+            }
+
             auto packet = PacketFactory::getMeetingCreateResultPacket(true, meetingId, encryptedMeetingKey, packetKey);
             sendTcp(conn, static_cast<uint32_t>(PacketType::MEETING_CREATE_RESULT), packet);
+            updateMeetingFrameFormat(meeting, sender);
         } 
         catch (const std::exception& e) {
             LOG_ERROR("Meeting create error: {}", e.what());
@@ -803,7 +1211,6 @@ namespace server
 
     void Server::handleGetMeetingInfo(const nlohmann::json& json, network::tcp::ConnectionPtr conn)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
         try {
             const std::string meetingIdHash = json[MEETING_ID_HASH].get<std::string>();
             auto meeting = m_meetingManager.findByIdHash(meetingIdHash);
@@ -830,7 +1237,6 @@ namespace server
 
     void Server::handleMeetingJoinRequest(const nlohmann::json& json, network::tcp::ConnectionPtr conn)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
         try {
             const std::string senderNicknameHash = json[SENDER_NICKNAME_HASH].get<std::string>();
             const std::string meetingIdHash = json[MEETING_ID_HASH].get<std::string>();
@@ -839,63 +1245,69 @@ namespace server
             if (!sender || !meeting || sender->getTcpConnection() != conn) {
                 return;
             }
-            if (!canJoinMeetingLocked(sender) || sender->hasPendingMeetingJoinRequest()) {
-                auto packet = PacketFactory::getMeetingJoinRejectedPacket("invalid_state");
-                sendTcp(conn, static_cast<uint32_t>(PacketType::MEETING_JOIN_REJECTED), packet);
-                return;
-            }
+            const std::vector<unsigned char> requestBody = toBytes(json.dump());
 
-            auto owner = meeting->getOwner();
-            if (!owner) {
-                auto packet = PacketFactory::getMeetingJoinRejectedPacket("meeting_not_found");
-                sendTcp(conn, static_cast<uint32_t>(PacketType::MEETING_JOIN_REJECTED), packet);
-                return;
-            }
-            if (owner->isConnectionDown()) {
-                auto packet = PacketFactory::getMeetingJoinRejectedPacket("owner_unavailable");
-                sendTcp(conn, static_cast<uint32_t>(PacketType::MEETING_JOIN_REJECTED), packet);
-                return;
-            }
-            if (meeting->getPendingJoinRequest(senderNicknameHash)) {
-                return;
-            }
-
-            std::weak_ptr<User> weakSender = sender;
-            std::weak_ptr<Meeting> weakMeeting = meeting;
-            auto pending = std::make_shared<PendingMeetingJoinRequest>(sender, meeting, [this, weakSender, weakMeeting]() {
-                std::lock_guard<std::mutex> innerLock(m_mutex);
-                auto requester = weakSender.lock();
-                auto meetingFromWeak = weakMeeting.lock();
-                if (!requester || !meetingFromWeak) {
-                    return;
+            std::string rejectReason;
+            {
+                auto stateLock = m_stateLocks.lock(meeting.get(), { sender.get() });
+                auto owner = meeting->getOwner();
+                if (!canJoinMeetingLocked(sender) || sender->hasPendingMeetingJoinRequest()) {
+                    rejectReason = "invalid_state";
                 }
-
-                auto existingPending = requester->getPendingMeetingJoinRequest();
-                if (!existingPending) {
+                else if (!owner) {
+                    rejectReason = "meeting_not_found";
+                }
+                else if (owner->isConnectionDown()) {
+                    rejectReason = "owner_unavailable";
+                }
+                else if (meeting->getPendingJoinRequest(senderNicknameHash)) {
                     return;
                 }
+                else {
+                    std::weak_ptr<User> weakSender = sender;
+                    std::weak_ptr<Meeting> weakMeeting = meeting;
+                    auto pending = std::make_shared<PendingMeetingJoinRequest>(sender, meeting, [this, weakSender, weakMeeting]() {
+                        auto requester = weakSender.lock();
+                        auto meetingFromWeak = weakMeeting.lock();
+                        if (!requester || !meetingFromWeak) {
+                            return;
+                        }
+                        auto rejectPacket = PacketFactory::getMeetingJoinRejectedPacket("request_timeout");
 
-                meetingFromWeak->removePendingJoinRequest(requester->getNicknameHash());
-                m_meetingManager.removePendingJoinRequest(existingPending);
-                requester->resetPendingMeetingJoinRequest();
+                        {
+                            auto timeoutLock = m_stateLocks.lock(meetingFromWeak.get(), { requester.get() });
+                            auto existingPending = requester->getPendingMeetingJoinRequest();
+                            if (!existingPending || existingPending->getMeeting() != meetingFromWeak) {
+                                return;
+                            }
 
-                auto rejectPacket = PacketFactory::getMeetingJoinRejectedPacket("request_timeout");
-                sendTcpToUserIfConnected(requester->getNicknameHash(), static_cast<uint32_t>(PacketType::MEETING_JOIN_REJECTED), rejectPacket);
-            });
+                            meetingFromWeak->removePendingJoinRequest(requester->getNicknameHash());
+                            m_meetingManager.removePendingJoinRequest(existingPending);
+                            requester->resetPendingMeetingJoinRequest();
+                        }
 
-            sender->setPendingMeetingJoinRequest(pending);
-            meeting->addPendingJoinRequest(pending);
-            m_meetingManager.addPendingJoinRequest(pending);
+                        sendTcpToUserIfConnected(requester->getNicknameHash(), static_cast<uint32_t>(PacketType::MEETING_JOIN_REJECTED), rejectPacket);
+                    });
 
-            bool delivered = sendTcpToUserIfConnected(owner->getNicknameHash(), static_cast<uint32_t>(PacketType::MEETING_JOIN_REQUEST), toBytes(json.dump()));
-            if (!delivered) {
-                auto removed = meeting->removePendingJoinRequest(senderNicknameHash);
-                if (removed) {
-                    removed->stop();
-                    m_meetingManager.removePendingJoinRequest(removed);
+                    sender->setPendingMeetingJoinRequest(pending);
+                    meeting->addPendingJoinRequest(pending);
+                    m_meetingManager.addPendingJoinRequest(pending);
+
+                    bool delivered = sendTcpToUserIfConnected(owner->getNicknameHash(), static_cast<uint32_t>(PacketType::MEETING_JOIN_REQUEST), requestBody);
+                    if (!delivered) {
+                        auto removed = meeting->removePendingJoinRequest(senderNicknameHash);
+                        if (removed) {
+                            removed->stop();
+                            m_meetingManager.removePendingJoinRequest(removed);
+                        }
+                        sender->resetPendingMeetingJoinRequest();
+                        rejectReason = "owner_unavailable";
+                    }
                 }
-                sender->resetPendingMeetingJoinRequest();
-                auto packet = PacketFactory::getMeetingJoinRejectedPacket("owner_unavailable");
+            }
+
+            if (!rejectReason.empty()) {
+                auto packet = PacketFactory::getMeetingJoinRejectedPacket(rejectReason);
                 sendTcp(conn, static_cast<uint32_t>(PacketType::MEETING_JOIN_REJECTED), packet);
             }
         }
@@ -906,7 +1318,6 @@ namespace server
 
     void Server::handleMeetingJoinCancel(const nlohmann::json& json, network::tcp::ConnectionPtr conn)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
         try {
             const std::string senderNicknameHash = json[SENDER_NICKNAME_HASH].get<std::string>();
             auto sender = m_userRepository.findUserByNickname(senderNicknameHash);
@@ -916,6 +1327,13 @@ namespace server
 
             auto pending = sender->getPendingMeetingJoinRequest();
             auto meeting = pending ? pending->getMeeting() : nullptr;
+            const std::vector<unsigned char> cancelBody = toBytes(json.dump());
+
+            auto stateLock = m_stateLocks.lock(meeting.get(), { sender.get() });
+            // Accepted, declined or timed out since the lookup above.
+            if (sender->getPendingMeetingJoinRequest() != pending) {
+                return;
+            }
             if (!meeting) {
                 sender->resetPendingMeetingJoinRequest();
                 return;
@@ -923,7 +1341,7 @@ namespace server
 
             auto owner = meeting->getOwner();
             if (owner && !owner->isConnectionDown()) {
-                sendTcpToUserIfConnected(owner->getNicknameHash(), static_cast<uint32_t>(PacketType::MEETING_JOIN_CANCEL), toBytes(json.dump()));
+                sendTcpToUserIfConnected(owner->getNicknameHash(), static_cast<uint32_t>(PacketType::MEETING_JOIN_CANCEL), cancelBody);
             }
 
             auto removed = meeting->removePendingJoinRequest(senderNicknameHash);
@@ -945,21 +1363,23 @@ namespace server
             const std::string requesterNicknameHash = json[REQUESTER_NICKNAME_HASH].get<std::string>();
             const std::string encryptedNickname = json[ENCRYPTED_NICKNAME].get<std::string>();
 
-            MeetingPtr meeting;
-            UserPtr requester;
-            {
-                std::lock_guard<std::mutex> lock(m_mutex);
-                auto owner = m_userRepository.findUserByNickname(ownerNicknameHash);
-                requester = m_userRepository.findUserByNickname(requesterNicknameHash);
-                if (!owner || !requester || owner->getTcpConnection() != conn) {
-                    return;
-                }
+            auto owner = m_userRepository.findUserByNickname(ownerNicknameHash);
+            auto requester = m_userRepository.findUserByNickname(requesterNicknameHash);
+            if (!owner || !requester || owner->getTcpConnection() != conn) {
+                return;
+            }
+            auto meeting = owner->getMeeting();
+            if (!meeting || !meeting->isOwner(ownerNicknameHash)) {
+                return;
+            }
+            const std::vector<unsigned char> acceptBody = toBytes(json.dump());
 
-                meeting = owner->getMeeting();
-                if (!meeting || !meeting->isOwner(ownerNicknameHash)) {
+            {
+                auto stateLock = m_stateLocks.lock(meeting.get(), { requester.get() });
+                // Ended since the lookup above.
+                if (owner->getMeeting() != meeting) {
                     return;
                 }
-
                 auto pending = meeting->getPendingJoinRequest(requesterNicknameHash);
                 if (!pending || requester->getPendingMeetingJoinRequest() != pending) {
                     return;
@@ -971,25 +1391,14 @@ namespace server
                         m_meetingManager.removePendingJoinRequest(removed);
                     }
                     requester->resetPendingMeetingJoinRequest();
+                    stateLock.unlock();
+
                     auto rejectPacket = PacketFactory::getMeetingJoinRejectedPacket("invalid_state");
                     sendTcpToUserIfConnected(requesterNicknameHash, static_cast<uint32_t>(PacketType::MEETING_JOIN_REJECTED), rejectPacket);
                     return;
                 }
-            }
-
-            const bool delivered = sendTcpToUserIfConnected(requesterNicknameHash, static_cast<uint32_t>(PacketType::MEETING_JOIN_ACCEPT), toBytes(json.dump()));
-            if (!delivered) {
-                return;
-            }
 
-            {
-                std::lock_guard<std::mutex> lock(m_mutex);
-                // Re-validate before committing state transition.
-                if (!requester || !meeting || !canJoinMeetingLocked(requester)) {
-                    return;
-                }
-                auto pending = meeting->getPendingJoinRequest(requesterNicknameHash);
-                if (!pending || requester->getPendingMeetingJoinRequest() != pending) {
+                if (!sendTcpToUserIfConnected(requesterNicknameHash, static_cast<uint32_t>(PacketType::MEETING_JOIN_ACCEPT), acceptBody)) {
                     return;
                 }
 
@@ -1007,6 +1416,12 @@ namespace server
                 encryptedNickname,
                 crypto::serializePublicKey(requester->getPublicKey()));
             broadcastToMeeting(meeting, requesterNicknameHash, static_cast<uint32_t>(PacketType::MEETING_PARTICIPANT_JOINED), joinedPacket);
+            if (requester->getMediaSessionId() != 0) {
+                broadcastToMeeting(meeting, requesterNicknameHash, static_cast<uint32_t>(PacketType::MEETING_SESSION_MAP),
+                    PacketFactory::getMeetingSessionMapPacket({ { requesterNicknameHash, requester->getMediaSessionId() } }));
+            }
+            sendMeetingSessionMapToUser(meeting, requester);
+            updateMeetingFrameFormat(meeting, requester);
 
             // Send the current media sharing state to the newly joined participant.
             for (const auto& sharerHash : meeting->getScreenSharers()) {
@@ -1033,6 +1448,8 @@ namespace server
                 sendTcpToUserIfConnected(requesterNicknameHash, static_cast<uint32_t>(PacketType::MUTE_BEGIN), beginPacket);
             }
             sendMeetingConnectionDownStateToUser(meeting, requesterNicknameHash);
+            replayKeyframesToSubscriber(meeting, requester);
+            requestKeyframesForSubscriber(meeting, requesterNicknameHash);
         }
         catch (const std::exception& e) {
             LOG_ERROR("Meeting join accept error: {}", e.what());
@@ -1060,9 +1477,56 @@ namespace server
         }
     }
 
+    void Server::sendMeetingSessionMapToUser(const MeetingPtr& meeting, const UserPtr& receiver)
+    {
+        if (!meeting || !receiver || receiver->getMediaSessionId() == 0) {
+            return;
+        }
+
+        std::vector<std::pair<std::string, uint32_t>> sessions;
+        for (const auto& participant : meeting->getParticipants()) {
+            if (!participant.user || participant.user == receiver || participant.user->getMediaSessionId() == 0) {
+                continue;
+            }
+            sessions.emplace_back(participant.user->getNicknameHash(), participant.user->getMediaSessionId());
+        }
+        if (sessions.empty()) {
+            return;
+        }
+        sendTcpToUserIfConnected(receiver->getNicknameHash(), static_cast<uint32_t>(PacketType::MEETING_SESSION_MAP),
+            PacketFactory::getMeetingSessionMapPacket(sessions));
+    }
+
+    void Server::updateMeetingFrameFormat(const MeetingPtr& meeting, const UserPtr& joiner)
+    {
+        if (!meeting) {
+            return;
+        }
+
+        // A v1 participant cannot parse v2 frames and the server does not translate them, so one
+        // legacy joiner switches every sender back to v1 until it leaves.
+        if (auto changed = meeting->updateCompactMediaFrames()) {
+            for (const auto& participant : meeting->getParticipants()) {
+                sendMediaFrameFormatToUser(participant.user, *changed);
+            }
+            return;
+        }
+        if (joiner && meeting->usesCompactMediaFrames()) {
+            sendMediaFrameFormatToUser(joiner, true);
+        }
+    }
+
+    void Server::sendMediaFrameFormatToUser(const UserPtr& receiver, bool compactFrames)
+    {
+        if (!receiver || receiver->getMediaSessionId() == 0) {
+            return;
+        }
+        sendTcpToUserIfConnected(receiver->getNicknameHash(), static_cast<uint32_t>(PacketType::MEDIA_FRAME_FORMAT),
+            PacketFactory::getMediaFrameFormatPacket(compactFrames));
+    }
+
     void Server::handleMeetingJoinDecline(const nlohmann::json& json, network::tcp::ConnectionPtr conn)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
         try {
             const std::string ownerNicknameHash = json[SENDER_NICKNAME_HASH].get<std::string>();
             const std::string requesterNicknameHash = json[REQUESTER_NICKNAME_HASH].get<std::string>();
@@ -1077,8 +1541,15 @@ namespace server
             if (!meeting || !meeting->isOwner(ownerNicknameHash)) {
                 return;
             }
+            const std::vector<unsigned char> declineBody = toBytes(json.dump());
+
+            auto stateLock = m_stateLocks.lock(meeting.get(), { requester.get() });
+            // Ended since the lookup above.
+            if (owner->getMeeting() != meeting) {
+                return;
+            }
 
-            sendTcpToUserIfConnected(requesterNicknameHash, static_cast<uint32_t>(PacketType::MEETING_JOIN_DECLINE), toBytes(json.dump()));
+            sendTcpToUserIfConnected(requesterNicknameHash, static_cast<uint32_t>(PacketType::MEETING_JOIN_DECLINE), declineBody);
 
             auto removed = meeting->removePendingJoinRequest(requesterNicknameHash);
             if (removed) {
@@ -1094,7 +1565,6 @@ namespace server
 
     void Server::handleMeetingLeave(const nlohmann::json& json, network::tcp::ConnectionPtr conn)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
         try {
             const std::string senderNicknameHash = json[SENDER_NICKNAME_HASH].get<std::string>();
             auto sender = m_userRepository.findUserByNickname(senderNicknameHash);
@@ -1106,7 +1576,19 @@ namespace server
             if (!meeting || meeting->isOwner(senderNicknameHash)) {
                 return;
             }
-            removeMeetingParticipant(meeting, sender);
+            const DeparturePackets departure = makeDeparturePackets(senderNicknameHash);
+
+            {
+                auto stateLock = m_stateLocks.lock(meeting.get(), { sender.get() });
+                // Ended since the lookup above.
+                if (sender->getMeeting() != meeting) {
+                    return;
+                }
+                if (!removeMeetingParticipantLocked(meeting, sender, departure)) {
+                    return;
+                }
+            }
+            updateMeetingFrameFormat(meeting);
         }
         catch (const std::exception& e) {
             LOG_ERROR("Meeting leave error: {}", e.what());
@@ -1115,7 +1597,6 @@ namespace server
 
     void Server::handleMeetingEnd(const nlohmann::json& json, network::tcp::ConnectionPtr conn)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
         try {
             const std::string senderNicknameHash = json[SENDER_NICKNAME_HASH].get<std::string>();
             auto sender = m_userRepository.findUserByNickname(senderNicknameHash);
@@ -1127,8 +1608,27 @@ namespace server
             if (!meeting || !meeting->isOwner(senderNicknameHash)) {
                 return;
             }
+            const auto joinRejectedPacket = PacketFactory::getMeetingJoinRejectedPacket("meeting_ended");
+            const auto meetingEndedPacket = PacketFactory::getMeetingEndedPacket();
 
-            endMeetingCleanup(meeting);
+            auto stateLock = m_stateLocks.lock(meeting.get(), {});
+            if (sender->getMeeting() != meeting) {
+                return;
+            }
+            // Participants and join requesters only change under the meeting's lock, so the set read
+            // here is the set to lock.
+            std::vector<const User*> members;
+            for (const auto& participant : meeting->getParticipants()) {
+                members.push_back(participant.user.get());
+            }
+            for (const auto& pending : meeting->getPendingJoinRequests()) {
+                if (pending) {
+                    members.push_back(pending->getRequester().get());
+                }
+            }
+            stateLock.lockUsers(members);
+
+            endMeetingLocked(meeting, joinRejectedPacket, meetingEndedPacket);
         }
         catch (const std::exception& e) {
             LOG_ERROR("Meeting end error: {}", e.what());
@@ -1137,7 +1637,7 @@ namespace server
 
     void Server::handleMediaReceiverStats(const nlohmann::json& json, network::tcp::ConnectionPtr conn)
     {
-        std::lock_guard<std::mutex> lock(m_mutex);
+        // Only this receiver's ABR entry is written; meeting layer bookkeeping has its own lock.
         try {
             const std::string receiverHash = json[SENDER_NICKNAME_HASH].get<std::string>();
             auto receiver = m_userRepository.findUserByNickname(receiverHash);
@@ -1152,64 +1652,76 @@ namespace server
             const double measuredLoss = std::max(0.0, json.value(LOSS_PCT, 0.0));
             const double measuredRtt = static_cast<double>(std::max(0, json.value(RTT_MS, 0)));
 
-            auto& state = m_receiverAbrStates[receiverHash];
-            const auto now = std::chrono::steady_clock::now();
-            state.lastStatsAt = now;
-            if (!state.initialized) {
-                state.initialized = true;
-                state.lossEwma = measuredLoss;
-                state.rttEwma = measuredRtt;
-                state.currentLayer = inMeeting ? constant::kReconnectConservativeMeetingLayer :
-                    (inCall ? constant::kReconnectConservativeCallLayer : profile.maxLayerCap);
-                state.fastProbeUntil = now + std::chrono::milliseconds(constant::kFastProbeHoldMs);
-            } else {
-                state.lossEwma = profile.ewmaAlpha * measuredLoss + (1.0 - profile.ewmaAlpha) * state.lossEwma;
-                state.rttEwma = profile.ewmaAlpha * measuredRtt + (1.0 - profile.ewmaAlpha) * state.rttEwma;
-            }
-
-            const int thresholdLayer = computeTargetLayerFromThresholds(state.lossEwma, state.rttEwma, profile);
-            int nextLayer = std::min(state.currentLayer, profile.maxLayerCap);
-            const int effectiveUpgradeHoldMs = (state.fastProbeUntil.time_since_epoch().count() != 0 && now < state.fastProbeUntil)
-                ? constant::kFastProbeHoldMs
-                : profile.upgradeHoldMs;
-
-            const int previousLayer = state.currentLayer;
-            if (thresholdLayer < nextLayer) {
-                // Fast downgrade.
-                nextLayer = thresholdLayer;
-                state.upgradeCandidateActive = false;
-            } else if (thresholdLayer > nextLayer) {
-                // Slow upgrade with hold period.
-                bool allowUpgrade = false;
-                const int candidate = nextLayer + 1;
-                if (candidate == 1) {
-                    allowUpgrade = shouldKeepLayer1(state.lossEwma, state.rttEwma, profile);
+            const int recvBitrateKbps = std::max(0, json.value(RECV_BITRATE_KBPS, 0));
+            if (recvBitrateKbps > 0) {
+                const int pacingKbps = std::max(constant::kMinPacingBitrateKbps,
+                    static_cast<int>(recvBitrateKbps * constant::kPacingHeadroom));
+                m_networkController.setUdpPacingRate(receiver->getEndpoint(), static_cast<uint32_t>(pacingKbps));
+            }
+
+            int currentLayer = 0;
+            {
+                std::lock_guard<std::shared_mutex> abrLock(m_abrMutex);
+                auto& state = m_receiverAbrStates[receiverHash];
+                const auto now = std::chrono::steady_clock::now();
+                state.lastStatsAt = now;
+                if (!state.initialized) {
+                    state.initialized = true;
+                    state.lossEwma = measuredLoss;
+                    state.rttEwma = measuredRtt;
+                    state.currentLayer = inMeeting ? constant::kReconnectConservativeMeetingLayer :
+                        (inCall ? constant::kReconnectConservativeCallLayer : profile.maxLayerCap);
+                    state.fastProbeUntil = now + std::chrono::milliseconds(constant::kFastProbeHoldMs);
                 } else {
-                    allowUpgrade = shouldKeepLayer2(state.lossEwma, state.rttEwma, profile);
+                    state.lossEwma = profile.ewmaAlpha * measuredLoss + (1.0 - profile.ewmaAlpha) * state.lossEwma;
+                    state.rttEwma = profile.ewmaAlpha * measuredRtt + (1.0 - profile.ewmaAlpha) * state.rttEwma;
                 }
 
-                if (allowUpgrade) {
-                    if (!state.upgradeCandidateActive) {
-                        state.upgradeCandidateActive = true;
-                        state.upgradeCandidateSince = now;
-                    } else if (std::chrono::duration_cast<std::chrono::milliseconds>(now - state.upgradeCandidateSince).count() >= effectiveUpgradeHoldMs) {
-                        nextLayer = std::min(profile.maxLayerCap, candidate);
+                const int thresholdLayer = computeTargetLayerFromThresholds(state.lossEwma, state.rttEwma, profile);
+                int nextLayer = std::min(state.currentLayer, profile.maxLayerCap);
+                const int effectiveUpgradeHoldMs = (state.fastProbeUntil.time_since_epoch().count() != 0 && now < state.fastProbeUntil)
+                    ? constant::kFastProbeHoldMs
+                    : profile.upgradeHoldMs;
+
+                const int previousLayer = state.currentLayer;
+                if (thresholdLayer < nextLayer) {
+                    // Fast downgrade.
+                    nextLayer = thresholdLayer;
+                    state.upgradeCandidateActive = false;
+                } else if (thresholdLayer > nextLayer) {
+                    // Slow upgrade with hold period.
+                    bool allowUpgrade = false;
+                    const int candidate = nextLayer + 1;
+                    if (candidate == 1) {
+                        allowUpgrade = shouldKeepLayer1(state.lossEwma, state.rttEwma, profile);
+                    } else {
+                        allowUpgrade = shouldKeepLayer2(state.lossEwma, state.rttEwma, profile);
+                    }
+
+                    if (allowUpgrade) {
+                        if (!state.upgradeCandidateActive) {
+                            state.upgradeCandidateActive = true;
+                            state.upgradeCandidateSince = now;
+                        } else if (std::chrono::duration_cast<std::chrono::milliseconds>(now - state.upgradeCandidateSince).count() >= effectiveUpgradeHoldMs) {
+                            nextLayer = std::min(profile.maxLayerCap, candidate);
+                            state.upgradeCandidateActive = false;
+                        }
+                    } else {
                         state.upgradeCandidateActive = false;
                     }
                 } else {
                     state.upgradeCandidateActive = false;
                 }
-            } else {
-                state.upgradeCandidateActive = false;
-            }
-            state.currentLayer = nextLayer;
-
-            if (state.currentLayer != previousLayer) {
-                LOG_INFO("[ABR] layer-change receiver={} context={} {} -> {}",
-                    receiverHash.substr(0, std::min<size_t>(8, receiverHash.size())),
-                    inMeeting ? "meeting" : (inCall ? "call" : "other"),
-                    previousLayer,
-                    state.currentLayer);
+                state.currentLayer = nextLayer;
+
+                if (state.currentLayer != previousLayer) {
+                    LOG_INFO("[ABR] layer-change receiver={} context={} {} -> {}",
+                        receiverHash.substr(0, std::min<size_t>(8, receiverHash.size())),
+                        inMeeting ? "meeting" : (inCall ? "call" : "other"),
+                        previousLayer,
+                        state.currentLayer);
+                }
+                currentLayer = state.currentLayer;
             }
 
             if (inMeeting) {
@@ -1220,7 +1732,7 @@ namespace server
                         if (!participant.user) continue;
                         const std::string senderHash = participant.user->getNicknameHash();
                         if (senderHash == receiverHash) continue;
-                        meeting->setCameraSubscriptionLayer(receiverHash, senderHash, static_cast<uint8_t>(state.currentLayer));
+                        meeting->setCameraSubscriptionLayer(receiverHash, senderHash, static_cast<uint8_t>(currentLayer));
                     }
 
                     // Sender-side encode cap is computed independently as max required layer.
@@ -1245,7 +1757,7 @@ namespace server
                     if (senderConn) {
                         nlohmann::json adaptToSender{
                             { RESULT, true },
-                            { MAX_LAYER, state.currentLayer }
+                            { MAX_LAYER, currentLayer }
                         };
                         sendTcp(senderConn, static_cast<uint32_t>(PacketType::MEDIA_ADAPT_COMMAND), toBytes(adaptToSender.dump()));
                     }
@@ -1272,13 +1784,248 @@ namespace server
         }
     }
 
+    void Server::handleMediaKeyframeRequest(const nlohmann::json& json, network::tcp::ConnectionPtr conn)
+    {
+        try {
+            const std::string requesterHash = json[SENDER_NICKNAME_HASH].get<std::string>();
+            const std::string targetHash = json[RECEIVER_NICKNAME_HASH].get<std::string>();
+            const uint8_t mediaKind = json.value(MEDIA_KIND, static_cast<uint8_t>(0));
+            const uint8_t layerId = json.value(LAYER_ID, static_cast<uint8_t>(0));
+
+            auto requester = m_userRepository.findUserByNickname(requesterHash);
+            if (!requester || requester->getTcpConnection() != conn || requesterHash == targetHash) {
+                return;
+            }
+            auto target = m_userRepository.findUserByNickname(targetHash);
+            if (!target) {
+                return;
+            }
+
+            bool sharesSession = false;
+            if (requester->isInCall()) {
+                auto partner = requester->getCallPartner();
+                sharesSession = partner && partner->getNicknameHash() == targetHash;
+            }
+            else if (requester->isInMeeting()) {
+                auto meeting = requester->getMeeting();
+                sharesSession = meeting && target->getMeeting() == meeting;
+            }
+            if (!sharesSession) {
+                return;
+            }
+            requestKeyframe(target, mediaKind, layerId);
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR("Media keyframe request error: {}", e.what());
+        }
+    }
+
+    void Server::handleMeetingVideoConfig(const nlohmann::json& json, network::tcp::ConnectionPtr conn)
+    {
+        // Pins and last-N live behind the meeting's own lock; no state lock is taken.
+        try {
+            const std::string senderHash = json[SENDER_NICKNAME_HASH].get<std::string>();
+            std::optional<std::vector<std::string>> pinnedHashes;
+            if (json.contains(PINNED_NICKNAME_HASHES) && json[PINNED_NICKNAME_HASHES].is_array()) {
+                pinnedHashes.emplace();
+                for (const auto& pinnedHash : json[PINNED_NICKNAME_HASHES]) {
+                    if (pinnedHash.is_string()) {
+                        pinnedHashes->push_back(pinnedHash.get<std::string>());
+                    }
+                }
+            }
+            std::optional<std::size_t> lastN;
+            if (json.contains(LAST_N) && json[LAST_N].is_number_unsigned()) {
+                lastN = json[LAST_N].get<std::size_t>();
+            }
+
+            auto sender = m_userRepository.findUserByNickname(senderHash);
+            if (!sender || sender->getTcpConnection() != conn || !sender->isInMeeting()) {
+                return;
+            }
+            auto meeting = sender->getMeeting();
+            if (!meeting) {
+                return;
+            }
+
+            if (pinnedHashes) {
+                meeting->setVideoPins(senderHash, *pinnedHashes);
+            }
+
+            if (lastN) {
+                if (!meeting->isOwner(senderHash)) {
+                    LOG_WARN("Meeting video config: last-N change from non-owner {}", senderHash.substr(0, 5));
+                    return;
+                }
+                meeting->setLastN(*lastN);
+            }
+        }
+        catch (const std::exception& e) {
+            LOG_ERROR("Meeting video config error: {}", e.what());
+        }
+    }
+
+    void Server::requestKeyframe(const UserPtr& sender, uint8_t mediaKind, uint8_t layerId)
+    {
+        const auto slot = keyframeStreamSlot(mediaKind, layerId);
+        if (!sender || !slot || sender->isConnectionDown()) {
+            return;
+        }
+        auto senderConn = sender->getTcpConnection();
+        if (!senderConn) {
+            return;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> keyframeLock(m_keyframeRequestMutex);
+            auto& lastRequestAt = m_keyframeRequestTimes[sender->getNicknameHash()][*slot];
+            if (lastRequestAt.time_since_epoch().count() != 0
+                && now - lastRequestAt < std::chrono::milliseconds(constant::kKeyframeRequestMinIntervalMs)) {
+                return;
+            }
+            lastRequestAt = now;
+        }
+
+        nlohmann::json request{
+            { RESULT, true },
+            { MEDIA_KIND, mediaKind },
+            { LAYER_ID, layerId }
+        };
+        sendTcp(senderConn, static_cast<uint32_t>(PacketType::MEDIA_KEYFRAME_REQUEST), toBytes(request.dump()));
+    }
+
+    void Server::requestKeyframesForSubscriber(const MeetingPtr& meeting, const std::string& subscriberHash)
+    {
+        if (!meeting) {
+            return;
+        }
+
+        // A new subscriber has no reference frames, so ask every sharer for an IDR right away
+        // instead of leaving it on a black tile until the next periodic keyframe.
+        for (const auto& sharerHash : meeting->getScreenSharers()) {
+            if (sharerHash != subscriberHash) {
+                requestKeyframe(m_userRepository.findUserByNickname(sharerHash), 1, 0);
+            }
+        }
+        for (const auto& sharerHash : meeting->getCameraSharers()) {
+            if (sharerHash != subscriberHash && meeting->isCameraForwarded(subscriberHash, sharerHash)) {
+                requestKeyframe(m_userRepository.findUserByNickname(sharerHash), 2,
+                    meeting->getCameraSubscriptionLayer(subscriberHash, sharerHash));
+            }
+        }
+    }
+
+    void Server::replayKeyframesToSubscriber(const MeetingPtr& meeting, const UserPtr& subscriber)
+    {
+        if (!meeting || !subscriber) {
+            return;
+        }
+
+        const std::string subscriberHash = subscriber->getNicknameHash();
+        // Keyframes cached before a v1 participant joined may be v2 frames it cannot parse.
+        const auto replayable = [this, &subscriber](const std::string& sharerHash) {
+            if (subscriber->getMediaSessionId() != 0) {
+                return true;
+            }
+            auto sharer = m_userRepository.findUserByNickname(sharerHash);
+            return sharer && sharer->getMediaSessionId() == 0;
+        };
+        std::vector<std::string> screenSharers;
+        std::vector<std::string> cameraSharers;
+        for (auto& sharerHash : meeting->getScreenSharers()) {
+            if (sharerHash != subscriberHash && replayable(sharerHash)) {
+                screenSharers.push_back(std::move(sharerHash));
+            }
+        }
+        for (auto& sharerHash : meeting->getCameraSharers()) {
+            if (sharerHash != subscriberHash && meeting->isCameraForwarded(subscriberHash, sharerHash) && replayable(sharerHash)) {
+                cameraSharers.push_back(std::move(sharerHash));
+            }
+        }
+        if (screenSharers.empty() && cameraSharers.empty()) {
+            return;
+        }
+
+        const auto joinedAt = std::chrono::steady_clock::now();
+        {
+            std::lock_guard<std::mutex> lock(m_keyframeWaitMutex);
+            m_keyframeWaits[subscriberHash] = joinedAt;
+        }
+
+        // The cached keyframe gives the joiner a picture before the sender answers the keyframe request.
+        // Camera and screen forwarding to a new receiver still start on a live keyframe, so no P-frames
+        // follow the replayed one without a reference.
+        const auto endpoint = subscriber->getEndpoint();
+        bool replayed = false;
+        for (const auto& sharerHash : screenSharers) {
+            if (auto key = keyframeCacheKey(sharerHash, 1, 0)) {
+                replayed |= m_networkController.replayUdpKeyframe(*key, endpoint);
+            }
+        }
+        for (const auto& sharerHash : cameraSharers) {
+            // Paused upper layers have nothing cached; fall back to the best lower one.
+            for (int layerId = meeting->getCameraSubscriptionLayer(subscriberHash, sharerHash); layerId >= 0; --layerId) {
+                auto key = keyframeCacheKey(sharerHash, 2, static_cast<uint8_t>(layerId));
+                if (key && m_networkController.replayUdpKeyframe(*key, endpoint)) {
+                    replayed = true;
+                    break;
+                }
+            }
+        }
+        if (replayed) {
+            std::lock_guard<std::mutex> lock(m_keyframeWaitMutex);
+            recordKeyframeQueuedLocked(subscriberHash, std::chrono::steady_clock::now());
+        }
+    }
+
+    void Server::dropCachedKeyframes(const std::string& senderHash, uint8_t mediaKind)
+    {
+        // A restarted encoder must not be preceded by a keyframe of its previous session.
+        const uint8_t layerCount = mediaKind == 2 ? 3 : 1;
+        for (uint8_t layerId = 0; layerId < layerCount; ++layerId) {
+            if (auto key = keyframeCacheKey(senderHash, mediaKind, layerId)) {
+                m_networkController.dropUdpKeyframe(*key);
+            }
+        }
+    }
+
+    void Server::recordKeyframesQueued(const Meeting::ForwardingSnapshot& snapshot, const Meeting::ForwardingSnapshot::SlotList& receiverSlots,
+        std::chrono::steady_clock::time_point now)
+    {
+        if (receiverSlots.empty()) {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_keyframeWaitMutex);
+        if (m_keyframeWaits.empty()) {
+            return;
+        }
+        for (std::size_t slot : receiverSlots) {
+            recordKeyframeQueuedLocked(snapshot.receivers[slot].nicknameHash, now);
+        }
+    }
+
+    void Server::recordKeyframeQueuedLocked(const std::string& receiverHash, std::chrono::steady_clock::time_point now)
+    {
+        auto it = m_keyframeWaits.find(receiverHash);
+        if (it == m_keyframeWaits.end()) {
+            return;
+        }
+        const auto waitedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - it->second).count();
+        const uint64_t queuedAfterMs = waitedMs > 0 ? static_cast<uint64_t>(waitedMs) : 0U;
+        m_keyframeWaits.erase(it);
+        ++m_joinKeyframeQueuedCount;
+        m_joinKeyframeQueuedTotalMs += queuedAfterMs;
+        m_joinKeyframeQueuedMaxMs = std::max(m_joinKeyframeQueuedMaxMs, queuedAfterMs);
+    }
+
     void Server::redirectPacket(const nlohmann::json& json, PacketType type, network::tcp::ConnectionPtr conn) {
         std::vector<network::tcp::ConnectionPtr> targets;
         std::vector<unsigned char> body;
         std::string partnerHash;
 
         {
-            std::lock_guard<std::mutex> lock(m_mutex);
             if (!json.contains(SENDER_NICKNAME_HASH)) return;
             std::string senderHash = json[SENDER_NICKNAME_HASH].get<std::string>();
             auto sender = m_userRepository.findUserByNickname(senderHash);
@@ -1286,11 +2033,14 @@ namespace server
 
             body = toBytes(json.dump());
 
+            const MeetingPtr senderMeeting = sender->getMeeting();
+            auto stateLock = m_stateLocks.lock(senderMeeting.get(), { sender.get() });
             if (sender->isInMeeting()) {
                 auto meeting = sender->getMeeting();
-                if (!meeting) return;
+                // Moved to another meeting since the lookup above.
+                if (!meeting || meeting != senderMeeting) return;
 
-                // Gather recipients while holding server lock; perform actual sends after unlock.
+                // Gather recipients while holding the state locks; perform actual sends after unlock.
                 for (const auto& participant : meeting->getParticipants()) {
                     if (!participant.user) continue;
                     if (participant.user->getNicknameHash() == senderHash) continue;
@@ -1317,12 +2067,14 @@ namespace server
                     break;
                 case PacketType::SCREEN_SHARING_END:
                     meeting->removeScreenSharer(senderHash);
+                    dropCachedKeyframes(senderHash, 1);
                     break;
                 case PacketType::CAMERA_SHARING_BEGIN:
                     meeting->addCameraSharer(senderHash);
                     break;
                 case PacketType::CAMERA_SHARING_END:
                     meeting->removeCameraSharer(senderHash);
+                    dropCachedKeyframes(senderHash, 2);
                     break;
                 case PacketType::MUTE_BEGIN:
                     meeting->addMutedParticipant(senderHash);
@@ -1348,7 +2100,7 @@ namespace server
             }
         }
 
-        // Perform I/O outside the global server mutex to avoid head-of-line blocking.
+        // Perform I/O outside the state locks to avoid head-of-line blocking.
         if (!targets.empty()) {
             for (auto& c : targets) {
                 sendTcp(c, static_cast<uint32_t>(type), body);
@@ -1361,9 +2113,11 @@ namespace server
         }
     }
 
-    void Server::processConnectionDown(const UserPtr& user) {
+    void Server::processConnectionDownLocked(const UserPtr& user, const std::vector<unsigned char>& connectionDownPacket,
+        const std::vector<unsigned char>& joinCancelBody, const DeparturePackets& departure,
+        const std::vector<unsigned char>& joinRejectedPacket) {
         if (user) {
-            m_receiverAbrStates.erase(user->getNicknameHash());
+            dropMediaStateForUser(user->getNicknameHash());
         }
         if (user->hasOutgoingPendingCall()) {
             auto out = user->getOutgoingPendingCall();
@@ -1371,8 +2125,7 @@ namespace server
             if (m_userRepository.containsUser(receiver->getNicknameHash())) {
                 auto rec = m_userRepository.findUserByNickname(receiver->getNicknameHash());
                 if (rec && !rec->isConnectionDown()) {
-                    auto [_, p] = PacketFactory::getConnectionDownWithUserPacket(user->getNicknameHash());
-                    sendTcpToUserIfConnected(receiver->getNicknameHash(), static_cast<uint32_t>(PacketType::CONNECTION_DOWN_WITH_USER), p);
+                    sendTcpToUserIfConnected(receiver->getNicknameHash(), static_cast<uint32_t>(PacketType::CONNECTION_DOWN_WITH_USER), connectionDownPacket);
                 }
                 if (rec) removeIncomingPendingCall(rec, out);
             }
@@ -1385,8 +2138,7 @@ namespace server
             if (m_userRepository.containsUser(initiator->getNicknameHash())) {
                 auto init = m_userRepository.findUserByNickname(initiator->getNicknameHash());
                 if (init && !init->isConnectionDown()) {
-                    auto [_, p] = PacketFactory::getConnectionDownWithUserPacket(user->getNicknameHash());
-                    sendTcpToUserIfConnected(initiator->getNicknameHash(), static_cast<uint32_t>(PacketType::CONNECTION_DOWN_WITH_USER), p);
+                    sendTcpToUserIfConnected(initiator->getNicknameHash(), static_cast<uint32_t>(PacketType::CONNECTION_DOWN_WITH_USER), connectionDownPacket);
                 }
                 if (init) resetOutgoingPendingCall(init);
             }
@@ -1398,8 +2150,7 @@ namespace server
             if (partner && m_userRepository.containsUser(partner->getNicknameHash())) {
                 auto pInRepo = m_userRepository.findUserByNickname(partner->getNicknameHash());
                 if (pInRepo && !pInRepo->isConnectionDown()) {
-                    auto [_, p] = PacketFactory::getConnectionDownWithUserPacket(user->getNicknameHash());
-                    sendTcpToUserIfConnected(partner->getNicknameHash(), static_cast<uint32_t>(PacketType::CONNECTION_DOWN_WITH_USER), p);
+                    sendTcpToUserIfConnected(partner->getNicknameHash(), static_cast<uint32_t>(PacketType::CONNECTION_DOWN_WITH_USER), connectionDownPacket);
                 }
             }
             // Keep call state while user is temporarily offline.
@@ -1414,10 +2165,7 @@ namespace server
             if (meeting) {
                 auto owner = meeting->getOwner();
                 if (owner && !owner->isConnectionDown()) {
-                    nlohmann::json cancelJson;
-                    cancelJson[UID] = crypto::generateUID();
-                    cancelJson[SENDER_NICKNAME_HASH] = user->getNicknameHash();
-                    sendTcpToUserIfConnected(owner->getNicknameHash(), static_cast<uint32_t>(PacketType::MEETING_JOIN_CANCEL), toBytes(cancelJson.dump()));
+                    sendTcpToUserIfConnected(owner->getNicknameHash(), static_cast<uint32_t>(PacketType::MEETING_JOIN_CANCEL), joinCancelBody);
                 }
                 auto removed = meeting->removePendingJoinRequest(user->getNicknameHash());
                 if (removed) {
@@ -1433,34 +2181,30 @@ namespace server
             if (!meeting) {
                 return;
             }
-            {
-                auto [_, p] = PacketFactory::getConnectionDownWithUserPacket(user->getNicknameHash());
-                broadcastToMeeting(meeting, user->getNicknameHash(), static_cast<uint32_t>(PacketType::CONNECTION_DOWN_WITH_USER), p);
-            }
+            broadcastToMeeting(meeting, user->getNicknameHash(), static_cast<uint32_t>(PacketType::CONNECTION_DOWN_WITH_USER), connectionDownPacket);
             const std::string disconnectedHash = user->getNicknameHash();
             {
                 auto screenSharers = meeting->getScreenSharers();
                 if (std::find(screenSharers.begin(), screenSharers.end(), disconnectedHash) != screenSharers.end()) {
-                    auto endPacket = PacketFactory::getMediaSharingEndPacket(disconnectedHash);
-                    broadcastToMeeting(meeting, disconnectedHash, static_cast<uint32_t>(PacketType::SCREEN_SHARING_END), endPacket);
+                    broadcastToMeeting(meeting, disconnectedHash, static_cast<uint32_t>(PacketType::SCREEN_SHARING_END), departure.sharingEnd);
                     meeting->removeScreenSharer(disconnectedHash);
+                    dropCachedKeyframes(disconnectedHash, 1);
                 }
                 auto cameraSharers = meeting->getCameraSharers();
                 if (std::find(cameraSharers.begin(), cameraSharers.end(), disconnectedHash) != cameraSharers.end()) {
-                    auto endPacket = PacketFactory::getMediaSharingEndPacket(disconnectedHash);
-                    broadcastToMeeting(meeting, disconnectedHash, static_cast<uint32_t>(PacketType::CAMERA_SHARING_END), endPacket);
+                    broadcastToMeeting(meeting, disconnectedHash, static_cast<uint32_t>(PacketType::CAMERA_SHARING_END), departure.sharingEnd);
                     meeting->removeCameraSharer(disconnectedHash);
+                    dropCachedKeyframes(disconnectedHash, 2);
                 }
                 auto mutedParticipants = meeting->getMutedParticipants();
                 if (std::find(mutedParticipants.begin(), mutedParticipants.end(), disconnectedHash) != mutedParticipants.end()) {
-                    auto unmutePacket = PacketFactory::getMuteEndPacket(disconnectedHash);
-                    broadcastToMeeting(meeting, disconnectedHash, static_cast<uint32_t>(PacketType::MUTE_END), unmutePacket);
+                    broadcastToMeeting(meeting, disconnectedHash, static_cast<uint32_t>(PacketType::MUTE_END), departure.muteEnd);
                     meeting->removeMutedParticipant(disconnectedHash);
                 }
             }
 
             if (meeting->isOwner(user->getNicknameHash())) {
-                rejectAllPendingJoinRequests(meeting, "owner_unavailable");
+                rejectAllPendingJoinRequestsLocked(meeting, joinRejectedPacket);
                 return;
             }
 
@@ -1473,93 +2217,107 @@ namespace server
     }
 
     void Server::processUserLogout(const UserPtr& user) {
-        if (!user || !m_userRepository.containsUser(user->getNicknameHash())) return;
+        if (!user) return;
         std::string nicknameHash = user->getNicknameHash();
-        m_receiverAbrStates.erase(nicknameHash);
         std::string prefix = nicknameHash.length() >= 5 ? nicknameHash.substr(0, 5) : nicknameHash;
-        LOG_INFO("User logout: {}", prefix);
+        auto [_, logoutPacket] = PacketFactory::getUserLogoutPacket(nicknameHash);
+        const DeparturePackets departure = makeDeparturePackets(nicknameHash);
+        const auto joinRejectedPacket = PacketFactory::getMeetingJoinRejectedPacket("meeting_ended");
+        const auto meetingEndedPacket = PacketFactory::getMeetingEndedPacket();
 
-        auto conn = user->getTcpConnection();
-        if (conn)
-            m_connToUser.erase(conn);
+        MeetingPtr leftMeeting;
+        {
+            // Touches the user's call, pending calls and meeting at once.
+            auto stateLock = m_stateLocks.lockAll();
+            if (!m_userRepository.containsUser(nicknameHash)) return;
+            dropMediaStateForUser(nicknameHash);
+            LOG_INFO("User logout: {}", prefix);
 
-        if (user->isInCall()) {
-            auto partner = user->getCallPartner();
-            m_callManager.endCall(user->getCall());
-            if (partner && m_userRepository.containsUser(partner->getNicknameHash())) {
-                auto partnerInRepo = m_userRepository.findUserByNickname(partner->getNicknameHash());
-                if (partnerInRepo) {
-                    std::string pp = partnerInRepo->getNicknameHash().length() >= 5 ? partnerInRepo->getNicknameHash().substr(0, 5) : partnerInRepo->getNicknameHash();
-                    LOG_INFO("Call ended due to logout: {} ended call with {}", prefix, pp);
-                    if (!partnerInRepo->isConnectionDown()) {
-                        auto [_, p] = PacketFactory::getUserLogoutPacket(nicknameHash);
-                        sendTcpToUserIfConnected(partner->getNicknameHash(), static_cast<uint32_t>(PacketType::USER_LOGOUT), p);
-                    }
-                    partnerInRepo->resetCall();
-                }
+            auto conn = user->getTcpConnection();
+            if (conn) {
+                std::lock_guard<std::mutex> connLock(m_connToUserMutex);
+                m_connToUser.erase(conn);
             }
-            user->resetCall();
-        }
 
-        if (user->hasOutgoingPendingCall()) {
-            auto out = user->getOutgoingPendingCall();
-            auto pendingPartner = user->getOutgoingPendingCallPartner();
-            if (pendingPartner && m_userRepository.containsUser(pendingPartner->getNicknameHash())) {
-                auto pp = m_userRepository.findUserByNickname(pendingPartner->getNicknameHash());
-                std::string ppPrefix = pp->getNicknameHash().length() >= 5 ? pp->getNicknameHash().substr(0, 5) : pp->getNicknameHash();
-                LOG_INFO("Outgoing/Incoming call ended due to logout: {} <-> {}", prefix, ppPrefix);
-                if (!pp->isConnectionDown()) {
-                    auto [_, p] = PacketFactory::getUserLogoutPacket(nicknameHash);
-                    sendTcpToUserIfConnected(pendingPartner->getNicknameHash(), static_cast<uint32_t>(PacketType::USER_LOGOUT), p);
+            if (user->isInCall()) {
+                auto partner = user->getCallPartner();
+                m_callManager.endCall(user->getCall());
+                if (partner && m_userRepository.containsUser(partner->getNicknameHash())) {
+                    auto partnerInRepo = m_userRepository.findUserByNickname(partner->getNicknameHash());
+                    if (partnerInRepo) {
+                        std::string pp = partnerInRepo->getNicknameHash().length() >= 5 ? partnerInRepo->getNicknameHash().substr(0, 5) : partnerInRepo->getNicknameHash();
+                        LOG_INFO("Call ended due to logout: {} ended call with {}", prefix, pp);
+                        if (!partnerInRepo->isConnectionDown()) {
+                            sendTcpToUserIfConnected(partner->getNicknameHash(), static_cast<uint32_t>(PacketType::USER_LOGOUT), logoutPacket);
+                        }
+                        partnerInRepo->resetCall();
+                    }
+                }
+                user->resetCall();
+            }
+
+            if (user->hasOutgoingPendingCall()) {
+                auto out = user->getOutgoingPendingCall();
+                auto pendingPartner = user->getOutgoingPendingCallPartner();
+                if (pendingPartner && m_userRepository.containsUser(pendingPartner->getNicknameHash())) {
+                    auto pp = m_userRepository.findUserByNickname(pendingPartner->getNicknameHash());
+                    std::string ppPrefix = pp->getNicknameHash().length() >= 5 ? pp->getNicknameHash().substr(0, 5) : pp->getNicknameHash();
+                    LOG_INFO("Outgoing/Incoming call ended due to logout: {} <-> {}", prefix, ppPrefix);
+                    if (!pp->isConnectionDown()) {
+                        sendTcpToUserIfConnected(pendingPartner->getNicknameHash(), static_cast<uint32_t>(PacketType::USER_LOGOUT), logoutPacket);
+                    }
+                    removeIncomingPendingCall(pp, out);
                 }
-                removeIncomingPendingCall(pp, out);
+                resetOutgoingPendingCall(user);
             }
-            resetOutgoingPendingCall(user);
-        }
 
-        auto incomingCopy = user->getIncomingPendingCalls();
-        for (auto& pc : incomingCopy) {
-            auto initiator = pc->getInitiator();
-            if (initiator && m_userRepository.containsUser(initiator->getNicknameHash())) {
-                auto init = m_userRepository.findUserByNickname(initiator->getNicknameHash());
-                std::string ip = init->getNicknameHash().length() >= 5 ? init->getNicknameHash().substr(0, 5) : init->getNicknameHash();
-                LOG_INFO("Incoming/Outgoing call ended due to logout: {} <-> {}", ip, prefix);
-                if (!init->isConnectionDown()) {
-                    auto [_, p] = PacketFactory::getUserLogoutPacket(nicknameHash);
-                    sendTcpToUserIfConnected(initiator->getNicknameHash(), static_cast<uint32_t>(PacketType::USER_LOGOUT), p);
+            auto incomingCopy = user->getIncomingPendingCalls();
+            for (auto& pc : incomingCopy) {
+                auto initiator = pc->getInitiator();
+                if (initiator && m_userRepository.containsUser(initiator->getNicknameHash())) {
+                    auto init = m_userRepository.findUserByNickname(initiator->getNicknameHash());
+                    std::string ip = init->getNicknameHash().length() >= 5 ? init->getNicknameHash().substr(0, 5) : init->getNicknameHash();
+                    LOG_INFO("Incoming/Outgoing call ended due to logout: {} <-> {}", ip, prefix);
+                    if (!init->isConnectionDown()) {
+                        sendTcpToUserIfConnected(initiator->getNicknameHash(), static_cast<uint32_t>(PacketType::USER_LOGOUT), logoutPacket);
+                    }
+                    resetOutgoingPendingCall(init);
                 }
-                resetOutgoingPendingCall(init);
+                removeIncomingPendingCall(user, pc);
             }
-            removeIncomingPendingCall(user, pc);
-        }
-        user->resetAllPendingCalls();
+            user->resetAllPendingCalls();
 
-        if (user->hasPendingMeetingJoinRequest()) {
-            auto pending = user->getPendingMeetingJoinRequest();
-            auto meeting = pending ? pending->getMeeting() : nullptr;
-            if (meeting) {
-                auto removed = meeting->removePendingJoinRequest(user->getNicknameHash());
-                if (removed) {
-                    removed->stop();
-                    m_meetingManager.removePendingJoinRequest(removed);
+            if (user->hasPendingMeetingJoinRequest()) {
+                auto pending = user->getPendingMeetingJoinRequest();
+                auto meeting = pending ? pending->getMeeting() : nullptr;
+                if (meeting) {
+                    auto removed = meeting->removePendingJoinRequest(user->getNicknameHash());
+                    if (removed) {
+                        removed->stop();
+                        m_meetingManager.removePendingJoinRequest(removed);
+                    }
                 }
+                user->resetPendingMeetingJoinRequest();
             }
-            user->resetPendingMeetingJoinRequest();
-        }
 
-        if (user->isInMeeting()) {
-            auto meeting = user->getMeeting();
-            if (meeting) {
-                if (meeting->isOwner(nicknameHash)) {
-                    endMeetingCleanup(meeting);
-                }
-                else {
-                    removeMeetingParticipant(meeting, user);
+            if (user->isInMeeting()) {
+                auto meeting = user->getMeeting();
+                if (meeting) {
+                    if (meeting->isOwner(nicknameHash)) {
+                        endMeetingLocked(meeting, joinRejectedPacket, meetingEndedPacket);
+                    }
+                    else if (removeMeetingParticipantLocked(meeting, user, departure)) {
+                        leftMeeting = meeting;
+                    }
                 }
             }
+
+            m_userRepository.removeUser(nicknameHash);
         }
 
-        m_userRepository.removeUser(nicknameHash);
+        if (leftMeeting) {
+            updateMeetingFrameFormat(leftMeeting);
+        }
     }
 
     void Server::broadcastToMeeting(const MeetingPtr& meeting, const std::string& excludeNicknameHash, uint32_t type, const std::vector<unsigned char>& body)
@@ -1580,13 +2338,12 @@ namespace server
         }
     }
 
-    void Server::rejectAllPendingJoinRequests(const MeetingPtr& meeting, const std::string& reason)
+    void Server::rejectAllPendingJoinRequestsLocked(const MeetingPtr& meeting, const std::vector<unsigned char>& rejectPacket)
     {
         if (!meeting) {
             return;
         }
 
-        const auto rejectPacket = PacketFactory::getMeetingJoinRejectedPacket(reason);
         auto pendingRequests = meeting->getPendingJoinRequests();
         for (const auto& pending : pendingRequests) {
             if (!pending) {
@@ -1608,10 +2365,19 @@ namespace server
         }
     }
 
-    void Server::removeMeetingParticipant(const MeetingPtr& meeting, const UserPtr& user)
+    Server::DeparturePackets Server::makeDeparturePackets(const std::string& nicknameHash)
+    {
+        DeparturePackets packets;
+        packets.sharingEnd = PacketFactory::getMediaSharingEndPacket(nicknameHash);
+        packets.muteEnd = PacketFactory::getMuteEndPacket(nicknameHash);
+        packets.participantLeft = PacketFactory::getMeetingParticipantLeftPacket(nicknameHash);
+        return packets;
+    }
+
+    bool Server::removeMeetingParticipantLocked(const MeetingPtr& meeting, const UserPtr& user, const DeparturePackets& packets)
     {
         if (!meeting || !user) {
-            return;
+            return false;
         }
 
         const std::string senderHash = user->getNicknameHash();
@@ -1620,43 +2386,47 @@ namespace server
         if (meeting->isParticipant(senderHash)) {
             auto screenSharers = meeting->getScreenSharers();
             if (std::find(screenSharers.begin(), screenSharers.end(), senderHash) != screenSharers.end()) {
-                auto packet = PacketFactory::getMediaSharingEndPacket(senderHash);
-                broadcastToMeeting(meeting, senderHash, static_cast<uint32_t>(PacketType::SCREEN_SHARING_END), packet);
+                broadcastToMeeting(meeting, senderHash, static_cast<uint32_t>(PacketType::SCREEN_SHARING_END), packets.sharingEnd);
                 meeting->removeScreenSharer(senderHash);
+                dropCachedKeyframes(senderHash, 1);
             }
             auto cameraSharers = meeting->getCameraSharers();
             if (std::find(cameraSharers.begin(), cameraSharers.end(), senderHash) != cameraSharers.end()) {
-                auto packet = PacketFactory::getMediaSharingEndPacket(senderHash);
-                broadcastToMeeting(meeting, senderHash, static_cast<uint32_t>(PacketType::CAMERA_SHARING_END), packet);
+                broadcastToMeeting(meeting, senderHash, static_cast<uint32_t>(PacketType::CAMERA_SHARING_END), packets.sharingEnd);
                 meeting->removeCameraSharer(senderHash);
+                dropCachedKeyframes(senderHash, 2);
             }
             auto mutedParticipants = meeting->getMutedParticipants();
             if (std::find(mutedParticipants.begin(), mutedParticipants.end(), senderHash) != mutedParticipants.end()) {
-                auto packet = PacketFactory::getMuteEndPacket(senderHash);
-                broadcastToMeeting(meeting, senderHash, static_cast<uint32_t>(PacketType::MUTE_END), packet);
+                broadcastToMeeting(meeting, senderHash, static_cast<uint32_t>(PacketType::MUTE_END), packets.muteEnd);
                 meeting->removeMutedParticipant(senderHash);
             }
         }
 
+        {
+            std::lock_guard<std::mutex> keyframeWaitLock(m_keyframeWaitMutex);
+            m_keyframeWaits.erase(senderHash);
+        }
+
         if (!meeting->removeParticipant(senderHash).has_value()) {
             user->resetMeeting();
-            return;
+            return false;
         }
 
         user->resetMeeting();
-        auto leftPacket = PacketFactory::getMeetingParticipantLeftPacket(senderHash);
-        broadcastToMeeting(meeting, senderHash, static_cast<uint32_t>(PacketType::MEETING_PARTICIPANT_LEFT), leftPacket);
+        broadcastToMeeting(meeting, senderHash, static_cast<uint32_t>(PacketType::MEETING_PARTICIPANT_LEFT), packets.participantLeft);
+        return true;
     }
 
-    void Server::endMeetingCleanup(const MeetingPtr& meeting)
+    void Server::endMeetingLocked(const MeetingPtr& meeting, const std::vector<unsigned char>& joinRejectedPacket,
+        const std::vector<unsigned char>& meetingEndedPacket)
     {
         if (!meeting) {
             return;
         }
 
-        rejectAllPendingJoinRequests(meeting, "meeting_ended");
+        rejectAllPendingJoinRequestsLocked(meeting, joinRejectedPacket);
 
-        auto endedPacket = PacketFactory::getMeetingEndedPacket();
         auto participants = meeting->getParticipants();
         std::string ownerHash;
         auto owner = meeting->getOwner();
@@ -1673,7 +2443,7 @@ namespace server
                 participant.user->resetMeeting();
                 continue;
             }
-            sendTcpToUserIfConnected(participantHash, static_cast<uint32_t>(PacketType::MEETING_ENDED), endedPacket);
+            sendTcpToUserIfConnected(participantHash, static_cast<uint32_t>(PacketType::MEETING_ENDED), meetingEndedPacket);
             participant.user->resetMeeting();
         }
 
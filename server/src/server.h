@@ -7,16 +7,23 @@
 #include <chrono>
 #include <thread>
 #include <mutex>
+#include <shared_mutex>
 #include <functional>
+#include <optional>
 
 #include "models/user.h"
 #include "models/call.h"
 #include "models/pendingCall.h"
 #include "network/networkController.h"
+#include "serverConfig.h"
 #include "constants/packetType.h"
 #include "logic/userRepository.h"
 #include "logic/callManager.h"
 #include "logic/meetingManager.h"
+#include "logic/mediaWorkerPool.h"
+#include "logic/stateLocks.h"
+#include "utilities/metricsSampler.h"
+#include "network/metricsEndpoint.h"
 
 #include <nlohmann/json.hpp>
 
@@ -24,19 +31,47 @@ namespace server
 {
     class Server {
     public:
-        Server(const std::string& tcpPort, const std::string& udpPort);
+        explicit Server(const ServerConfig& config);
+        // Works on the given repositories instead of empty ones of its own, so users and meetings can
+        // be set up directly rather than through the control protocol (benchmarks, load tests).
+        Server(const ServerConfig& config, std::shared_ptr<logic::UserRepository> userRepository,
+            std::shared_ptr<logic::MeetingManager> meetingManager);
         void run();
         void stop();
 
+        // Entry point of every reassembled media packet from the UDP receivers: queues it for the
+        // media worker that owns the sender's meeting or call.
+        void handleReceiveUdp(const unsigned char* data, int size, uint32_t type, const asio::ip::udp::endpoint& endpointFrom,
+            const std::array<unsigned char, 32>& senderNicknameHash);
+        // Routes the queued media packets on the calling thread; only while run() was not called.
+        std::size_t runPendingMediaJobs();
+        // With ServerConfig::udpHoldSending, drops what routing queued for the sockets and returns
+        // the number of entries (one packet for one receiver each).
+        std::size_t discardQueuedUdpSends();
+
     private:
         using TcpPacketHandler = std::function<void(const nlohmann::json&, network::tcp::ConnectionPtr)>;
 
+        // What a meeting is told when one participant leaves or drops, built before the state locks
+        // are taken so the locked part only sends it.
+        struct DeparturePackets {
+            std::vector<unsigned char> sharingEnd;
+            std::vector<unsigned char> muteEnd;
+            std::vector<unsigned char> participantLeft;
+        };
+        static DeparturePackets makeDeparturePackets(const std::string& nicknameHash);
+
         void registerHandlers();
 
-        void handleReceiveUdp(const unsigned char* data, int size, uint32_t type, const asio::ip::udp::endpoint& endpointFrom,
-            const std::array<unsigned char, 32>& senderNicknameHash);
+        void dispatchMediaJob(const unsigned char* data, std::size_t size, uint32_t type, const asio::ip::udp::endpoint& endpointFrom,
+            const std::array<unsigned char, 32>& senderNicknameHash, std::optional<network::ForwardTicket> ticket);
+        void processMediaJob(logic::MediaJob& job);
+        std::size_t mediaAffinityKey(const std::array<unsigned char, 32>& senderNicknameHash) const;
+        network::ForwardTargets selectUdpReceivers(const unsigned char* data, std::size_t size, uint32_t type,
+            const asio::ip::udp::endpoint& endpointFrom, const std::array<unsigned char, 32>& senderNicknameHash);
         void handleReceiveTcp(network::tcp::OwnedPacket&& owned);
         void handleConnectionWithUserDown(network::tcp::ConnectionPtr conn);
+        std::string renderMetrics();
 
         void sendTcp(network::tcp::ConnectionPtr conn, uint32_t type, const std::vector<unsigned char>& body);
         void sendTcpToUser(const std::string& receiverNicknameHash, uint32_t type, const std::string& jsonBody);
@@ -62,18 +97,40 @@ namespace server
         void handleMeetingEnd(const nlohmann::json& json, network::tcp::ConnectionPtr conn);
         void handleMediaReceiverStats(const nlohmann::json& json, network::tcp::ConnectionPtr conn);
         void handleMediaRttPing(const nlohmann::json& json, network::tcp::ConnectionPtr conn);
+        void handleMediaKeyframeRequest(const nlohmann::json& json, network::tcp::ConnectionPtr conn);
+        void handleMeetingVideoConfig(const nlohmann::json& json, network::tcp::ConnectionPtr conn);
         void redirectPacket(const nlohmann::json& json, constant::PacketType type, network::tcp::ConnectionPtr conn);
 
+        // Takes the exclusive state lock itself.
         void processUserLogout(const UserPtr& user);
         bool resetOutgoingPendingCall(const UserPtr& user);
         void removeIncomingPendingCall(const UserPtr& user, const PendingCallPtr& pendingCall);
         void broadcastToMeeting(const MeetingPtr& meeting, const std::string& excludeNicknameHash, uint32_t type, const std::vector<unsigned char>& body);
-        void rejectAllPendingJoinRequests(const MeetingPtr& meeting, const std::string& reason);
-        void removeMeetingParticipant(const MeetingPtr& meeting, const UserPtr& user);
-        void endMeetingCleanup(const MeetingPtr& meeting);
-        void processConnectionDown(const UserPtr& user);
+        // The *Locked helpers run with the meeting's and the affected users' state locks held and
+        // only send packets their caller built. removeMeetingParticipantLocked returns whether the
+        // user was a participant; the caller then runs updateMeetingFrameFormat after unlocking.
+        void rejectAllPendingJoinRequestsLocked(const MeetingPtr& meeting, const std::vector<unsigned char>& rejectPacket);
+        bool removeMeetingParticipantLocked(const MeetingPtr& meeting, const UserPtr& user, const DeparturePackets& packets);
+        void endMeetingLocked(const MeetingPtr& meeting, const std::vector<unsigned char>& joinRejectedPacket,
+            const std::vector<unsigned char>& meetingEndedPacket);
+        void processConnectionDownLocked(const UserPtr& user, const std::vector<unsigned char>& connectionDownPacket,
+            const std::vector<unsigned char>& joinCancelBody, const DeparturePackets& departure,
+            const std::vector<unsigned char>& joinRejectedPacket);
+        void requestKeyframe(const UserPtr& sender, uint8_t mediaKind, uint8_t layerId);
+        void requestKeyframesForSubscriber(const MeetingPtr& meeting, const std::string& subscriberHash);
+        void replayKeyframesToSubscriber(const MeetingPtr& meeting, const UserPtr& subscriber);
+        void dropCachedKeyframes(const std::string& senderHash, uint8_t mediaKind);
+        void recordKeyframesQueued(const Meeting::ForwardingSnapshot& snapshot, const Meeting::ForwardingSnapshot::SlotList& receiverSlots,
+            std::chrono::steady_clock::time_point now);
+        void recordKeyframeQueuedLocked(const std::string& receiverHash, std::chrono::steady_clock::time_point now);
         void resetAbrStateForUser(const std::string& receiverHash, bool inMeeting, bool inCall);
+        void dropMediaStateForUser(const std::string& nicknameHash);
         void sendMeetingConnectionDownStateToUser(const MeetingPtr& meeting, const std::string& receiverNicknameHash);
+        void sendMeetingSessionMapToUser(const MeetingPtr& meeting, const UserPtr& receiver);
+        // Tells the meeting's v2 participants which meeting frame version to send when a join or leave
+        // changed it; joiner is told the current one either way.
+        void updateMeetingFrameFormat(const MeetingPtr& meeting, const UserPtr& joiner = nullptr);
+        void sendMediaFrameFormatToUser(const UserPtr& receiver, bool compactFrames);
         bool canStartCallLocked(const UserPtr& sender, const UserPtr& receiver) const;
         bool canAcceptCallLocked(const UserPtr& callee, const UserPtr& caller) const;
         bool canJoinMeetingLocked(const UserPtr& user) const;
@@ -91,16 +148,45 @@ namespace server
             std::chrono::steady_clock::time_point fastProbeUntil{};
         };
 
-        mutable std::mutex m_mutex;
+        // Serializes call and meeting state transitions per meeting and per user; StateLocks documents
+        // the lock order. Handlers parse their request and build their packets before taking it, and
+        // handlers that only read that state or touch one table below do not take it. The table
+        // mutexes come after it, at most one at a time.
+        logic::StateLocks m_stateLocks;
 
         server::network::NetworkController m_networkController;
 
-        server::logic::UserRepository m_userRepository;
+        // Owned by the server unless they were handed to the constructor.
+        std::shared_ptr<server::logic::UserRepository> m_userRepositoryOwner;
+        std::shared_ptr<server::logic::MeetingManager> m_meetingManagerOwner;
+        server::logic::UserRepository& m_userRepository;
         server::logic::CallManager m_callManager;
-        server::logic::MeetingManager m_meetingManager;
+        server::logic::MeetingManager& m_meetingManager;
 
         std::unordered_map<constant::PacketType, TcpPacketHandler> m_packetHandlers;
+        std::mutex m_connToUserMutex;
         std::unordered_map<network::tcp::ConnectionPtr, UserPtr> m_connToUser;
+        // Written by receiver stats, read by the media workers for every layered camera frame.
+        std::shared_mutex m_abrMutex;
         std::unordered_map<std::string, ReceiverAbrState> m_receiverAbrStates;
+        // Last keyframe request forwarded per sender: screen, then camera layers 0..2.
+        std::mutex m_keyframeRequestMutex;
+        std::unordered_map<std::string, std::array<std::chrono::steady_clock::time_point, 4>> m_keyframeRequestTimes;
+
+        // Meeting joins still waiting for a video keyframe, and the time from join until one was queued to
+        // the joiner (cached replay or live), over the joins that got one. Socket send time is not included.
+        std::mutex m_keyframeWaitMutex;
+        std::unordered_map<std::string, std::chrono::steady_clock::time_point> m_keyframeWaits;
+        uint64_t m_joinKeyframeQueuedCount = 0;
+        uint64_t m_joinKeyframeQueuedTotalMs = 0;
+        uint64_t m_joinKeyframeQueuedMaxMs = 0;
+
+        server::utilities::MetricsSampler m_metricsSampler;
+
+        // Declared after the routing state so its threads stop before anything they route with is destroyed.
+        server::logic::MediaWorkerPool m_mediaWorkers;
+
+        // Reads the members above on every scrape, so it is torn down first. Null when disabled.
+        std::unique_ptr<network::MetricsEndpoint> m_metricsEndpoint;
     };
 }
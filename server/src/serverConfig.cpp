@@ -0,0 +1,77 @@
+#include "serverConfig.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <exception>
+#include <string>
+#include <thread>
+
+#include "utilities/logger.h"
+
+namespace server
+{
+    namespace
+    {
+        const char* readEnv(const char* name) {
+            const char* value = std::getenv(name);
+            return (value && *value) ? value : nullptr;
+        }
+
+        std::string readStringEnv(const char* name, const std::string& defaultValue) {
+            const char* value = readEnv(name);
+            return value ? std::string(value) : defaultValue;
+        }
+
+        std::size_t readSizeEnv(const char* name, std::size_t defaultValue) {
+            const char* value = readEnv(name);
+            if (!value) {
+                return defaultValue;
+            }
+            try {
+                return static_cast<std::size_t>(std::stoul(value));
+            }
+            catch (const std::exception&) {
+                LOG_WARN("Invalid {} value '{}', using {}", name, value, defaultValue);
+                return defaultValue;
+            }
+        }
+
+        bool readBoolEnv(const char* name, bool defaultValue) {
+            const char* value = readEnv(name);
+            if (!value) {
+                return defaultValue;
+            }
+            const std::string text(value);
+            if (text == "1" || text == "true" || text == "on") return true;
+            if (text == "0" || text == "false" || text == "off") return false;
+            LOG_WARN("Invalid {} value '{}', using {}", name, text, defaultValue);
+            return defaultValue;
+        }
+    }
+
+    ServerConfig ServerConfig::fromEnvironment() {
+        ServerConfig config;
+
+        // CALLIFORNIA_CONTROL_WORKERS=0 means one control handler thread per hardware thread.
+        config.controlWorkerCount = readSizeEnv("CALLIFORNIA_CONTROL_WORKERS", config.controlWorkerCount);
+        if (config.controlWorkerCount == 0) {
+            config.controlWorkerCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        // CALLIFORNIA_UDP_WORKERS=0 means one media socket per hardware thread.
+        config.udpWorkerCount = readSizeEnv("CALLIFORNIA_UDP_WORKERS", config.udpWorkerCount);
+        if (config.udpWorkerCount == 0) {
+            config.udpWorkerCount = std::max(1u, std::thread::hardware_concurrency());
+        }
+        config.udpCutThrough = readBoolEnv("CALLIFORNIA_UDP_CUT_THROUGH", config.udpCutThrough);
+        config.udpRetransmitWindowMs = readSizeEnv("CALLIFORNIA_UDP_RETRANSMIT_MS", config.udpRetransmitWindowMs);
+        config.udpSegmentationOffload = readBoolEnv("CALLIFORNIA_UDP_OFFLOAD", config.udpSegmentationOffload);
+        // CALLIFORNIA_MEDIA_WORKERS=0 means one routing thread per hardware thread.
+        config.mediaWorkerCount = readSizeEnv("CALLIFORNIA_MEDIA_WORKERS", config.mediaWorkerCount);
+        config.metricsSampleIntervalMs = readSizeEnv("CALLIFORNIA_METRICS_INTERVAL_MS", config.metricsSampleIntervalMs);
+        config.metricsHistoryWindowMs = readSizeEnv("CALLIFORNIA_METRICS_HISTORY_MS", config.metricsHistoryWindowMs);
+        config.metricsAddress = readStringEnv("CALLIFORNIA_METRICS_ADDRESS", config.metricsAddress);
+        config.metricsPort = readStringEnv("CALLIFORNIA_METRICS_PORT", config.metricsPort);
+
+        return config;
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace server
+{
+    struct ServerConfig {
+        std::string tcpPort = "8081";
+        std::string udpPort = "8081";
+
+        // Threads that run control packet handlers; each client connection stays on one of them.
+        std::size_t controlWorkerCount = 1;
+
+        // Number of SO_REUSEPORT media sockets, each with its own I/O thread.
+        std::size_t udpWorkerCount = 1;
+
+        // Relay media chunk by chunk instead of reassembling whole frames first.
+        bool udpCutThrough = true;
+
+        // How long forwarded video stays available for NACK retransmission; 0 disables it.
+        std::size_t udpRetransmitWindowMs = 500;
+
+        // Linux UDP GSO/GRO: send chunk trains in one syscall and take coalesced receives.
+        bool udpSegmentationOffload = true;
+
+        // Routed media is only queued, never handed to the sockets; Server::discardQueuedUdpSends
+        // empties the queues. For measuring the media path without sending, never for a real server.
+        bool udpHoldSending = false;
+
+        // Threads that route media, each owning a disjoint set of meetings and calls.
+        std::size_t mediaWorkerCount = 1;
+
+        // How often the background sampler reads CPU, memory and socket figures, and how much
+        // of that history GET_METRICS returns.
+        std::size_t metricsSampleIntervalMs = 1000;
+        std::size_t metricsHistoryWindowMs = 60000;
+
+        // Prometheus text scrape endpoint (GET /metrics); an empty or "0" port disables it.
+        std::string metricsAddress = "127.0.0.1";
+        std::string metricsPort = "8083";
+
+        static ServerConfig fromEnvironment();
+    };
+}
@@ -1,6 +1,8 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <optional>
 #include <string>
 #include "rsa.h" 
 #include "hex.h" 
@@ -33,6 +35,8 @@ namespace server
         std::string calculateHash(const std::string& text);
         /// Converts 32 bytes to hex string (64 chars).
         std::string binaryToHex(const unsigned char* data, size_t size);
+        /// Converts a 64-char hex hash back to its 32 bytes.
+        std::optional<std::array<unsigned char, 32>> hashToBinary(const std::string& hexHash);
         std::string generateUID();
         uint64_t scramble(uint64_t inputNumber);
         }
@@ -1,13 +1,13 @@
 #pragma once
 
-#include <chrono>
+#include <algorithm>
 #include <cstdint>
 #include <utility>
 #include <string>
-#include <thread>
 
 #ifdef _WIN32
 #include <windows.h>
+#include <psapi.h>
 #elif defined(__linux__)
 #include <fstream>
 #include <sstream>
@@ -15,6 +15,32 @@
 
 namespace server::utilities
 {
+    // Cumulative CPU time counters; usage is the busy share of the difference between two reads.
+    struct CpuTimes {
+        uint64_t total = 0;
+        uint64_t idle = 0;
+    };
+
+    struct ProcessStats {
+        uint64_t residentBytes = 0;
+        uint32_t threadCount = 0;
+    };
+
+    // Kernel queues of the UDP sockets bound to one local port (all SO_REUSEPORT workers together).
+    struct UdpSocketStats {
+        uint64_t receiveQueueBytes = 0;
+        uint64_t sendQueueBytes = 0;
+        uint64_t drops = 0;
+    };
+
+    inline double getCpuUsagePercent(const CpuTimes& before, const CpuTimes& after) {
+        if (after.total <= before.total)
+            return 0.0;
+        const uint64_t diffTotal = after.total - before.total;
+        const uint64_t diffIdle = after.idle > before.idle ? after.idle - before.idle : 0;
+        return 100.0 * (1.0 - static_cast<double>(std::min(diffIdle, diffTotal)) / static_cast<double>(diffTotal));
+    }
+
 #ifdef _WIN32
     namespace
     {
@@ -23,29 +49,14 @@ namespace server::utilities
         }
     }
 
-    inline double getCpuUsagePercent() {
-        FILETIME idle1, kernel1, user1, idle2, kernel2, user2;
-        if (!GetSystemTimes(&idle1, &kernel1, &user1))
-            return 0.0;
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        if (!GetSystemTimes(&idle2, &kernel2, &user2))
-            return 0.0;
-
-        uint64_t uIdle1 = fileTimeToUint64(idle1);
-        uint64_t uKernel1 = fileTimeToUint64(kernel1);
-        uint64_t uUser1 = fileTimeToUint64(user1);
-        uint64_t uIdle2 = fileTimeToUint64(idle2);
-        uint64_t uKernel2 = fileTimeToUint64(kernel2);
-        uint64_t uUser2 = fileTimeToUint64(user2);
-
-        uint64_t diffIdle = uIdle2 - uIdle1;
-        uint64_t diffKernel = uKernel2 - uKernel1;
-        uint64_t diffUser = uUser2 - uUser1;
-        uint64_t diffTotal = diffKernel + diffUser;
-
-        if (diffTotal == 0)
-            return 0.0;
-        return 100.0 * (1.0 - static_cast<double>(diffIdle) / static_cast<double>(diffTotal));
+    inline bool readCpuTimes(CpuTimes& times) {
+        FILETIME idle, kernel, user;
+        if (!GetSystemTimes(&idle, &kernel, &user))
+            return false;
+        // Kernel time already includes idle time.
+        times.total = fileTimeToUint64(kernel) + fileTimeToUint64(user);
+        times.idle = fileTimeToUint64(idle);
+        return true;
     }
 
     inline std::pair<uint64_t, uint64_t> getMemoryUsedAndAvailable() {
@@ -58,38 +69,30 @@ namespace server::utilities
         uint64_t usedPhys = totalPhys - availPhys;
         return {usedPhys, availPhys};
     }
-#elif defined(__linux__)
-    inline double getCpuUsagePercent() {
-        std::ifstream stat1("/proc/stat");
-        if (!stat1) return 0.0;
-        std::string line;
-        if (!std::getline(stat1, line) || line.compare(0, 4, "cpu ") != 0)
-            return 0.0;
-        stat1.close();
 
-        uint64_t user1 = 0, nice1 = 0, system1 = 0, idle1 = 0, iowait1 = 0, irq1 = 0, softirq1 = 0, steal1 = 0;
-        std::istringstream iss1(line.substr(4));
-        iss1 >> user1 >> nice1 >> system1 >> idle1 >> iowait1 >> irq1 >> softirq1 >> steal1;
-        uint64_t total1 = user1 + nice1 + system1 + idle1 + iowait1 + irq1 + softirq1 + steal1;
-        uint64_t idleTotal1 = idle1 + iowait1;
-
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-
-        std::ifstream stat2("/proc/stat");
-        if (!stat2) return 0.0;
-        if (!std::getline(stat2, line) || line.compare(0, 4, "cpu ") != 0)
-            return 0.0;
+    inline ProcessStats getProcessStats() {
+        ProcessStats stats;
+        PROCESS_MEMORY_COUNTERS counters = {};
+        if (K32GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            stats.residentBytes = counters.WorkingSetSize;
+        return stats;
+    }
 
-        uint64_t user2 = 0, nice2 = 0, system2 = 0, idle2 = 0, iowait2 = 0, irq2 = 0, softirq2 = 0, steal2 = 0;
-        std::istringstream iss2(line.substr(4));
-        iss2 >> user2 >> nice2 >> system2 >> idle2 >> iowait2 >> irq2 >> softirq2 >> steal2;
-        uint64_t total2 = user2 + nice2 + system2 + idle2 + iowait2 + irq2 + softirq2 + steal2;
-        uint64_t idleTotal2 = idle2 + iowait2;
+    inline UdpSocketStats getUdpSocketStats(uint16_t) { return {}; }
+#elif defined(__linux__)
+    inline bool readCpuTimes(CpuTimes& times) {
+        std::ifstream stat("/proc/stat");
+        if (!stat) return false;
+        std::string line;
+        if (!std::getline(stat, line) || line.compare(0, 4, "cpu ") != 0)
+            return false;
 
-        uint64_t diffTotal = total2 - total1;
-        uint64_t diffIdle = idleTotal2 - idleTotal1;
-        if (diffTotal == 0) return 0.0;
-        return 100.0 * (1.0 - static_cast<double>(diffIdle) / static_cast<double>(diffTotal));
+        uint64_t user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+        std::istringstream iss(line.substr(4));
+        iss >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal;
+        times.total = user + nice + system + idle + iowait + irq + softirq + steal;
+        times.idle = idle + iowait;
+        return true;
     }
 
     inline std::pair<uint64_t, uint64_t> getMemoryUsedAndAvailable() {
@@ -101,8 +104,8 @@ namespace server::utilities
         while (std::getline(meminfo, line)) {
             if (line.compare(0, 9, "MemTotal:") == 0)
                 memTotalKb = std::stoull(line.substr(9));
-            else if (line.compare(0, 14, "MemAvailable:") == 0)
-                memAvailableKb = std::stoull(line.substr(14));
+            else if (line.compare(0, 13, "MemAvailable:") == 0)
+                memAvailableKb = std::stoull(line.substr(13));
             else if (line.compare(0, 8, "MemFree:") == 0)
                 memFreeKb = std::stoull(line.substr(8));
         }
@@ -113,8 +116,53 @@ namespace server::utilities
         uint64_t usedBytes = totalBytes > availBytes ? totalBytes - availBytes : 0;
         return {usedBytes, availBytes};
     }
+
+    inline ProcessStats getProcessStats() {
+        ProcessStats stats;
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line)) {
+            if (line.compare(0, 6, "VmRSS:") == 0)
+                stats.residentBytes = std::stoull(line.substr(6)) * 1024;
+            else if (line.compare(0, 8, "Threads:") == 0)
+                stats.threadCount = static_cast<uint32_t>(std::stoul(line.substr(8)));
+        }
+        return stats;
+    }
+
+    inline UdpSocketStats getUdpSocketStats(uint16_t localPort) {
+        UdpSocketStats stats;
+        for (const char* path : { "/proc/net/udp", "/proc/net/udp6" }) {
+            std::ifstream table(path);
+            std::string line;
+            std::getline(table, line);
+            while (std::getline(table, line)) {
+                // sl local_address rem_address st tx_queue:rx_queue ... drops
+                std::istringstream iss(line);
+                std::string slot, local, remote, state, queues, token, drops;
+                if (!(iss >> slot >> local >> remote >> state >> queues))
+                    continue;
+                while (iss >> token)
+                    drops = token;
+
+                const auto portAt = local.rfind(':');
+                const auto queueAt = queues.find(':');
+                if (portAt == std::string::npos || queueAt == std::string::npos)
+                    continue;
+                if (std::stoul(local.substr(portAt + 1), nullptr, 16) != localPort)
+                    continue;
+                stats.sendQueueBytes += std::stoull(queues.substr(0, queueAt), nullptr, 16);
+                stats.receiveQueueBytes += std::stoull(queues.substr(queueAt + 1), nullptr, 16);
+                if (!drops.empty())
+                    stats.drops += std::stoull(drops);
+            }
+        }
+        return stats;
+    }
 #else
-    inline double getCpuUsagePercent() { return 0.0; }
+    inline bool readCpuTimes(CpuTimes&) { return false; }
     inline std::pair<uint64_t, uint64_t> getMemoryUsedAndAvailable() { return {0, 0}; }
+    inline ProcessStats getProcessStats() { return {}; }
+    inline UdpSocketStats getUdpSocketStats(uint16_t) { return {}; }
 #endif
 }
@@ -0,0 +1,236 @@
+#include "utilities/metricsRegistry.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <stdexcept>
+
+namespace server::utilities
+{
+    namespace
+    {
+        constexpr std::array<double, 4> kQuantiles = { 0.5, 0.9, 0.99, 0.999 };
+
+        std::string joinLabels(const std::string& labels, const std::string& extra) {
+            if (labels.empty()) return extra;
+            if (extra.empty()) return labels;
+            return labels + "," + extra;
+        }
+
+        void appendSample(std::string& out, const std::string& name, const std::string& labels, const std::string& value) {
+            out += name;
+            if (!labels.empty()) {
+                out += '{';
+                out += labels;
+                out += '}';
+            }
+            out += ' ';
+            out += value;
+            out += '\n';
+        }
+
+        void appendHeader(std::string& out, const std::string& name, const std::string& help, const char* type) {
+            out += "# HELP " + name + " " + help + "\n";
+            out += "# TYPE " + name + " " + type + "\n";
+        }
+
+        std::string formatDouble(double value) {
+            std::string text = std::to_string(value);
+            // std::to_string always prints six decimals; drop the trailing zeros.
+            if (text.find('.') != std::string::npos) {
+                text.erase(text.find_last_not_of('0') + 1);
+                if (text.back() == '.') text.pop_back();
+            }
+            return text;
+        }
+    }
+
+    MetricsRegistry::Shard::~Shard() {
+        for (auto& cells : histograms) {
+            delete cells.load(std::memory_order_relaxed);
+        }
+    }
+
+    Counter queueDropCounter(const std::string& queue) {
+        return MetricsRegistry::shared().counter("callifornia_queue_dropped_total",
+            "Entries dropped because a bounded queue was full, by queue.", "queue=\"" + queue + "\"");
+    }
+
+    ShardLease::~ShardLease() {
+        if (shard) {
+            MetricsRegistry::shared().releaseShard(shard);
+        }
+    }
+
+    MetricsRegistry::MetricsRegistry() {
+        m_counters.push_back(Definition{});
+        m_histograms.push_back(Definition{});
+    }
+
+    MetricsRegistry& MetricsRegistry::shared() {
+        static MetricsRegistry* registry = new MetricsRegistry();
+        return *registry;
+    }
+
+    Counter MetricsRegistry::counter(const std::string& name, const std::string& help, const std::string& labels) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return Counter(findOrAdd(m_counters, m_maxCounters, name, help, labels));
+    }
+
+    CounterFamily MetricsRegistry::counterFamily(const std::string& name, const std::string& help, const std::string& labelName,
+        const std::vector<std::string>& labelValues)
+    {
+        if (labelValues.empty()) {
+            throw std::invalid_argument("Counter family " + name + " needs at least one label value");
+        }
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // Slots of one family must be contiguous, so an existing family is only reused whole.
+        const uint32_t first = findOrAdd(m_counters, m_maxCounters, name, help, labelName + "=\"" + labelValues[0] + "\"");
+        for (std::size_t i = 1; i < labelValues.size(); ++i) {
+            const uint32_t slot = findOrAdd(m_counters, m_maxCounters, name, help, labelName + "=\"" + labelValues[i] + "\"");
+            if (slot != first + i) {
+                throw std::logic_error("Counter family " + name + " registered with different label values");
+            }
+        }
+        return CounterFamily(first, static_cast<uint32_t>(labelValues.size()));
+    }
+
+    Histogram MetricsRegistry::histogram(const std::string& name, const std::string& help, const std::string& labels) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return Histogram(findOrAdd(m_histograms, m_maxHistograms, name, help, labels));
+    }
+
+    uint32_t MetricsRegistry::findOrAdd(std::vector<Definition>& definitions, std::size_t capacity,
+        const std::string& name, const std::string& help, const std::string& labels)
+    {
+        for (std::size_t i = 1; i < definitions.size(); ++i) {
+            if (definitions[i].name == name && definitions[i].labels == labels) {
+                return static_cast<uint32_t>(i);
+            }
+        }
+        if (definitions.size() >= capacity) {
+            throw std::length_error("Metrics registry is full, cannot add " + name);
+        }
+        definitions.push_back(Definition{ name, help, labels });
+        return static_cast<uint32_t>(definitions.size() - 1);
+    }
+
+    MetricsRegistry::Shard* MetricsRegistry::acquireShard() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_freeShards) {
+            Shard* shard = m_freeShards;
+            m_freeShards = shard->nextFree;
+            shard->nextFree = nullptr;
+            return shard;
+        }
+        m_shards.push_back(std::make_unique<Shard>());
+        return m_shards.back().get();
+    }
+
+    void MetricsRegistry::releaseShard(Shard* shard) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        shard->nextFree = m_freeShards;
+        m_freeShards = shard;
+    }
+
+    MetricsRegistry::HistogramCells* MetricsRegistry::allocateHistogram(Shard& shard, uint32_t slot) {
+        // Only the owning thread allocates its cells; the lock orders the store against renderText.
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto* cells = new HistogramCells();
+        shard.histograms[slot].store(cells, std::memory_order_release);
+        return cells;
+    }
+
+    uint64_t MetricsRegistry::bucketUpperBound(std::size_t index) {
+        if (index < m_subBuckets) {
+            return index;
+        }
+        const std::size_t shift = index / m_subBuckets - 1;
+        const uint64_t lower = static_cast<uint64_t>(m_subBuckets + index % m_subBuckets) << shift;
+        return lower + ((uint64_t{ 1 } << shift) - 1);
+    }
+
+    void MetricsRegistry::renderText(std::string& out) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // Samples of one metric must be adjacent, whatever order they were registered in.
+        std::vector<std::size_t> order(m_counters.size() - 1);
+        std::iota(order.begin(), order.end(), std::size_t{ 1 });
+        std::stable_sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) { return m_counters[a].name < m_counters[b].name; });
+
+        const std::string* previousName = nullptr;
+        for (std::size_t slot : order) {
+            const Definition& definition = m_counters[slot];
+            uint64_t total = 0;
+            for (const auto& shard : m_shards) {
+                total += shard->counters[slot].load(std::memory_order_relaxed);
+            }
+            if (!previousName || *previousName != definition.name) {
+                appendHeader(out, definition.name, definition.help, "counter");
+                previousName = &definition.name;
+            }
+            appendSample(out, definition.name, definition.labels, std::to_string(total));
+        }
+
+        order.assign(m_histograms.size() - 1, 0);
+        std::iota(order.begin(), order.end(), std::size_t{ 1 });
+        std::stable_sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) { return m_histograms[a].name < m_histograms[b].name; });
+
+        std::vector<uint64_t> buckets(m_bucketCount);
+        previousName = nullptr;
+        for (std::size_t slot : order) {
+            const Definition& definition = m_histograms[slot];
+            std::fill(buckets.begin(), buckets.end(), 0);
+            uint64_t count = 0;
+            uint64_t sum = 0;
+            for (const auto& shard : m_shards) {
+                const HistogramCells* cells = shard->histograms[slot].load(std::memory_order_acquire);
+                if (!cells) continue;
+                for (std::size_t i = 0; i < m_bucketCount; ++i) {
+                    buckets[i] += cells->buckets[i].load(std::memory_order_relaxed);
+                }
+                count += cells->count.load(std::memory_order_relaxed);
+                sum += cells->sum.load(std::memory_order_relaxed);
+            }
+
+            if (!previousName || *previousName != definition.name) {
+                appendHeader(out, definition.name, definition.help, "summary");
+                previousName = &definition.name;
+            }
+
+            // Buckets were read one by one while writers kept going, so rank against their own total.
+            const uint64_t bucketTotal = std::accumulate(buckets.begin(), buckets.end(), uint64_t{ 0 });
+            for (double quantile : kQuantiles) {
+                std::string value = "NaN";
+                if (bucketTotal != 0) {
+                    const auto rank = static_cast<uint64_t>(quantile * static_cast<double>(bucketTotal - 1)) + 1;
+                    uint64_t seen = 0;
+                    for (std::size_t i = 0; i < m_bucketCount; ++i) {
+                        seen += buckets[i];
+                        if (seen >= rank) {
+                            value = std::to_string(bucketUpperBound(i));
+                            break;
+                        }
+                    }
+                }
+                appendSample(out, definition.name, joinLabels(definition.labels, "quantile=\"" + formatDouble(quantile) + "\""), value);
+            }
+            appendSample(out, definition.name + "_sum", definition.labels, std::to_string(sum));
+            appendSample(out, definition.name + "_count", definition.labels, std::to_string(count));
+        }
+    }
+
+    void MetricsRegistry::appendGauge(std::string& out, const std::string& name, const std::string& help, double value) {
+        appendHeader(out, name, help, "gauge");
+        appendSample(out, name, {}, formatDouble(value));
+    }
+
+    void MetricsRegistry::appendGauge(std::string& out, const std::string& name, const std::string& help,
+        const std::vector<std::pair<std::string, double>>& labelledValues)
+    {
+        appendHeader(out, name, help, "gauge");
+        for (const auto& [labels, value] : labelledValues) {
+            appendSample(out, name, labels, formatDouble(value));
+        }
+    }
+}
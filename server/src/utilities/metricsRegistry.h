@@ -0,0 +1,184 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace server::utilities
+{
+    class MetricsRegistry;
+
+    // Handles are plain slot numbers: cheap to copy and safe to keep in statics. Recording
+    // touches only the calling thread's shard, so hot paths never share a cache line.
+    class Counter {
+    public:
+        Counter() = default;
+        void add(uint64_t amount = 1) const;
+
+    private:
+        friend class MetricsRegistry;
+        explicit Counter(uint32_t slot) : m_slot(slot) {}
+        uint32_t m_slot = 0;
+    };
+
+    // Counters registered under one name with one label taking each of a fixed set of values.
+    // An index past the end lands on the last value, so callers can reserve it for "other".
+    class CounterFamily {
+    public:
+        CounterFamily() = default;
+        void add(std::size_t index, uint64_t amount = 1) const;
+
+    private:
+        friend class MetricsRegistry;
+        CounterFamily(uint32_t firstSlot, uint32_t size) : m_firstSlot(firstSlot), m_size(size) {}
+        uint32_t m_firstSlot = 0;
+        uint32_t m_size = 1;
+    };
+
+    // Log-linear (HDR-style) histogram of non-negative integer values with ~12% relative error.
+    class Histogram {
+    public:
+        Histogram() = default;
+        void record(uint64_t value) const;
+
+    private:
+        friend class MetricsRegistry;
+        explicit Histogram(uint32_t slot) : m_slot(slot) {}
+        uint32_t m_slot = 0;
+    };
+
+    // Process-wide set of counters and histograms, rendered in the Prometheus text format.
+    // Slot 0 of each kind is a sink for default-constructed handles.
+    class MetricsRegistry {
+    public:
+        static constexpr std::size_t m_maxCounters = 512;
+        static constexpr std::size_t m_maxHistograms = 16;
+        static constexpr unsigned m_subBucketBits = 3;
+        static constexpr std::size_t m_subBuckets = std::size_t{ 1 } << m_subBucketBits;
+        static constexpr std::size_t m_bucketCount = (65 - m_subBucketBits) * m_subBuckets;
+
+        struct HistogramCells {
+            std::array<std::atomic<uint64_t>, m_bucketCount> buckets{};
+            std::atomic<uint64_t> count{ 0 };
+            std::atomic<uint64_t> sum{ 0 };
+        };
+
+        // Written by one thread at a time, read by the renderer. A shard outlives its thread and is
+        // handed to the next new thread, so totals never go backwards.
+        struct Shard {
+            std::array<std::atomic<uint64_t>, m_maxCounters> counters{};
+            std::array<std::atomic<HistogramCells*>, m_maxHistograms> histograms{};
+            Shard* nextFree = nullptr;
+            ~Shard();
+        };
+
+        MetricsRegistry(const MetricsRegistry&) = delete;
+        MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+        // Never destroyed, since handles in other statics and thread exits may outlive it.
+        static MetricsRegistry& shared();
+
+        // Registering the same name and labels again returns the existing handle.
+        // labels is the inside of the braces, e.g. queue="voice"; it may be empty.
+        Counter counter(const std::string& name, const std::string& help, const std::string& labels = {});
+        CounterFamily counterFamily(const std::string& name, const std::string& help, const std::string& labelName,
+            const std::vector<std::string>& labelValues);
+        // Rendered as a summary with quantiles 0.5, 0.9, 0.99 and 0.999.
+        Histogram histogram(const std::string& name, const std::string& help, const std::string& labels = {});
+
+        void renderText(std::string& out) const;
+        // Point-in-time values owned by the caller, appended after renderText.
+        static void appendGauge(std::string& out, const std::string& name, const std::string& help, double value);
+        static void appendGauge(std::string& out, const std::string& name, const std::string& help,
+            const std::vector<std::pair<std::string, double>>& labelledValues);
+
+        static std::size_t bucketIndex(uint64_t value);
+        // Highest value that falls into bucket index.
+        static uint64_t bucketUpperBound(std::size_t index);
+
+        static Shard& localShard();
+        static HistogramCells& localHistogram(uint32_t slot);
+
+    private:
+        struct Definition {
+            std::string name;
+            std::string help;
+            std::string labels;
+        };
+
+        MetricsRegistry();
+
+        Shard* acquireShard();
+        void releaseShard(Shard* shard);
+        HistogramCells* allocateHistogram(Shard& shard, uint32_t slot);
+        uint32_t findOrAdd(std::vector<Definition>& definitions, std::size_t capacity,
+            const std::string& name, const std::string& help, const std::string& labels);
+
+        mutable std::mutex m_mutex;
+        std::vector<Definition> m_counters;
+        std::vector<Definition> m_histograms;
+        std::vector<std::unique_ptr<Shard>> m_shards;
+        Shard* m_freeShards = nullptr;
+
+        friend struct ShardLease;
+    };
+
+    // Drops of one bounded queue, all reported as callifornia_queue_dropped_total{queue="..."}.
+    Counter queueDropCounter(const std::string& queue);
+
+    struct ShardLease {
+        MetricsRegistry::Shard* shard = nullptr;
+        ~ShardLease();
+    };
+
+    inline MetricsRegistry::Shard& MetricsRegistry::localShard() {
+        static thread_local ShardLease lease;
+        if (!lease.shard) {
+            lease.shard = shared().acquireShard();
+        }
+        return *lease.shard;
+    }
+
+    inline MetricsRegistry::HistogramCells& MetricsRegistry::localHistogram(uint32_t slot) {
+        Shard& shard = localShard();
+        HistogramCells* cells = shard.histograms[slot].load(std::memory_order_acquire);
+        return cells ? *cells : *shared().allocateHistogram(shard, slot);
+    }
+
+    inline std::size_t MetricsRegistry::bucketIndex(uint64_t value) {
+        if (value < m_subBuckets) {
+            return static_cast<std::size_t>(value);
+        }
+        // m_subBuckets linear buckets per power of two, placed by the bits below the leading one.
+        const unsigned shift = static_cast<unsigned>(std::bit_width(value)) - 1 - m_subBucketBits;
+        const std::size_t subBucket = static_cast<std::size_t>(value >> shift) & (m_subBuckets - 1);
+        return (shift + 1) * m_subBuckets + subBucket;
+    }
+
+    inline void Counter::add(uint64_t amount) const {
+        // Only the owning thread writes a shard, so a plain load and store is enough.
+        auto& cell = MetricsRegistry::localShard().counters[m_slot];
+        cell.store(cell.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    inline void CounterFamily::add(std::size_t index, uint64_t amount) const {
+        const uint32_t offset = static_cast<uint32_t>(index < m_size ? index : m_size - 1);
+        auto& cell = MetricsRegistry::localShard().counters[m_firstSlot + offset];
+        cell.store(cell.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    }
+
+    inline void Histogram::record(uint64_t value) const {
+        auto& cells = MetricsRegistry::localHistogram(m_slot);
+        auto& bucket = cells.buckets[MetricsRegistry::bucketIndex(value)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        cells.count.store(cells.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        cells.sum.store(cells.sum.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+}
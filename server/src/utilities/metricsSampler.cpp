@@ -0,0 +1,90 @@
+#include "utilities/metricsSampler.h"
+#include "utilities/logger.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace server::utilities
+{
+    MetricsSampler::MetricsSampler(std::chrono::milliseconds interval, std::chrono::milliseconds historyWindow, uint16_t udpPort)
+        : m_interval(std::max(interval, std::chrono::milliseconds(100)))
+        , m_historySize(std::max<std::size_t>(1, static_cast<std::size_t>(historyWindow / m_interval)))
+        , m_udpPort(udpPort)
+    {
+    }
+
+    MetricsSampler::~MetricsSampler() {
+        stop();
+    }
+
+    void MetricsSampler::start() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_running)
+                return;
+            m_running = true;
+        }
+        // The first snapshot is taken against zeroed counters, so its CPU figure is the average since boot.
+        sample();
+        m_thread = std::thread([this]() { run(); });
+    }
+
+    void MetricsSampler::stop() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (!m_running)
+                return;
+            m_running = false;
+        }
+        m_wakeUp.notify_all();
+        if (m_thread.joinable())
+            m_thread.join();
+    }
+
+    SystemSnapshot MetricsSampler::getLatest() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_history.empty() ? SystemSnapshot{} : m_history.back();
+    }
+
+    std::vector<SystemSnapshot> MetricsSampler::getHistory() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return std::vector<SystemSnapshot>(m_history.begin(), m_history.end());
+    }
+
+    void MetricsSampler::run() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while (m_running) {
+            if (m_wakeUp.wait_for(lock, m_interval, [this]() { return !m_running; }))
+                break;
+            lock.unlock();
+            sample();
+            lock.lock();
+        }
+    }
+
+    void MetricsSampler::sample() {
+        SystemSnapshot snapshot;
+        try {
+            snapshot.sampledAt = std::chrono::system_clock::now();
+            CpuTimes cpuTimes;
+            if (readCpuTimes(cpuTimes)) {
+                snapshot.cpuUsagePercent = getCpuUsagePercent(m_previousCpuTimes, cpuTimes);
+                m_previousCpuTimes = cpuTimes;
+            }
+            auto [memoryUsed, memoryAvailable] = getMemoryUsedAndAvailable();
+            snapshot.memoryUsedBytes = memoryUsed;
+            snapshot.memoryAvailableBytes = memoryAvailable;
+            snapshot.process = getProcessStats();
+            snapshot.udpSockets = getUdpSocketStats(m_udpPort);
+        }
+        catch (const std::exception& e) {
+            LOG_WARN("Metrics sample failed: {}", e.what());
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_history.push_back(snapshot);
+        while (m_history.size() > m_historySize)
+            m_history.pop_front();
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "utilities/metrics.h"
+
+namespace server::utilities
+{
+    struct SystemSnapshot {
+        std::chrono::system_clock::time_point sampledAt{};
+        double cpuUsagePercent = 0.0;
+        uint64_t memoryUsedBytes = 0;
+        uint64_t memoryAvailableBytes = 0;
+        ProcessStats process;
+        UdpSocketStats udpSockets;
+    };
+
+    // Reads host and process figures on its own thread, so GET_METRICS answers from the latest
+    // snapshot instead of sleeping between two CPU counter reads on a control thread.
+    class MetricsSampler {
+    public:
+        MetricsSampler(std::chrono::milliseconds interval, std::chrono::milliseconds historyWindow, uint16_t udpPort);
+        ~MetricsSampler();
+
+        void start();
+        void stop();
+
+        SystemSnapshot getLatest() const;
+        // Oldest first, covering at most the history window.
+        std::vector<SystemSnapshot> getHistory() const;
+
+    private:
+        void run();
+        void sample();
+
+        const std::chrono::milliseconds m_interval;
+        const std::size_t m_historySize;
+        const uint16_t m_udpPort;
+
+        CpuTimes m_previousCpuTimes;
+
+        mutable std::mutex m_mutex;
+        std::condition_variable m_wakeUp;
+        bool m_running = false;
+        std::deque<SystemSnapshot> m_history;
+        std::thread m_thread;
+    };
+}
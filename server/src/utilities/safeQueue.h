@@ -36,22 +36,29 @@ namespace server
         }
 
         /// Pushes item, evicting oldest if queue size >= maxSize. For media: drop oldest to keep latest.
-        void push_with_limit(const T& item, size_t maxSize) {
+        /// Returns how many items were evicted.
+        size_t push_with_limit(const T& item, size_t maxSize) {
             std::lock_guard<std::mutex> lock(m_mutex);
+            size_t evicted = 0;
             while (m_queue.size() >= maxSize && !m_queue.empty()) {
                 m_queue.pop();
+                ++evicted;
             }
             m_queue.push(item);
             m_cond.notify_one();
+            return evicted;
         }
         
-        void push_with_limit(T&& item, size_t maxSize) {
+        size_t push_with_limit(T&& item, size_t maxSize) {
             std::lock_guard<std::mutex> lock(m_mutex);
+            size_t evicted = 0;
             while (m_queue.size() >= maxSize && !m_queue.empty()) {
                 m_queue.pop();
+                ++evicted;
             }
             m_queue.push(std::move(item));
             m_cond.notify_one();
+            return evicted;
         }
 
         template<typename... Args>